@@ -1,4 +1,9 @@
+#include <PN532_features.h>
+
+#if PN532_FEATURE_MIFARE_CLASSIC
+
 #include "MifareClassic.h"
+#include <NdefView.h>
 
 #define BLOCK_SIZE 16
 #define LONG_TLV_SIZE 4
@@ -6,9 +11,26 @@
 
 #define MIFARE_CLASSIC ("Mifare Classic")
 
+#define MIFARE_CLASSIC_4K_SAK 0x18
+
+#define MAD_AID_NDEF    0x03E1
+#define MAD_GPB_DA      0x80    // General purpose byte: MAD available
+#define MAD_GPB_VERSION 0x03
+#define MAD_VERSION_2   0x02
+
+// What readMad() found; only MAD_VALID and MAD_ABSENT are cached
+#define MAD_VALID       0       // Read and CRC checked
+#define MAD_ABSENT      1       // The GPB says the card has no MAD
+#define MAD_PARTIAL     2       // MAD v1 read, the MAD v2 sector failed
+#define MAD_FAILED      3       // Authentication or a read failed, or the CRC did not match
+
+MifareClassic::MadCacheEntry MifareClassic::_madCache[MIFARE_MAD_CACHE_SIZE];
+uint8_t MifareClassic::_madCacheNext = 0;
+
 MifareClassic::MifareClassic(PN532& nfcShield)
 {
   _nfcShield = &nfcShield;
+  _lastError = PN532_OK;
 }
 
 MifareClassic::~MifareClassic()
@@ -18,11 +40,21 @@ MifareClassic::~MifareClassic()
 NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
 {
     uint8_t key[6] = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 };
-    int currentBlock = 4;
+    uint64_t sectors = ndefSectors(uid, uidLength);
+    uint8_t sector = nextSector(sectors, 1);
     int messageStartIndex = 0;
     int messageLength = 0;
     byte data[BLOCK_SIZE];
 
+    _lastError = PN532_OK;
+    if (sector >= MIFARE_CLASSIC_4K_SECTORS)
+    {
+        Serial.println(F("Tag has no NDEF sectors."));
+        _lastError = PN532_CARD_ERROR;
+        return NfcTag(uid, uidLength, MIFARE_CLASSIC);
+    }
+    int currentBlock = firstBlockOfSector(sector);
+
     // read first block to get message length
     int success = _nfcShield->mifareclassic_AuthenticateBlock(uid, uidLength, currentBlock, 0, key);
     if (success)
@@ -31,12 +63,14 @@ NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
         if (success)
         {
             if (!decodeTlv(data, messageLength, messageStartIndex)) {
+                _lastError = PN532_CARD_ERROR;
                 return NfcTag(uid, uidLength, "ERROR"); // TODO should the error message go in NfcTag?
             }
         }
         else
         {
             Serial.print(F("Error. Failed read block "));Serial.println(currentBlock);
+            _lastError = _nfcShield->lastError();
             return NfcTag(uid, uidLength, MIFARE_CLASSIC);
         }
     }
@@ -44,13 +78,16 @@ NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
     {
         Serial.println(F("Tag is not NDEF formatted."));
         // TODO set tag.isFormatted = false
+        _lastError = _nfcShield->lastError();
         return NfcTag(uid, uidLength, MIFARE_CLASSIC);
     }
 
-    // this should be nested in the message length loop
-    int index = 0;
-    int bufferSize = getBufferSize(messageLength);
+    // the TLVs up to the end of the message and the terminator, in whole blocks
+    int bufferSize = messageStartIndex + messageLength + 1;
+    bufferSize = ((bufferSize + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
     uint8_t buffer[bufferSize];
+    memcpy(buffer, data, BLOCK_SIZE);
+    int index = BLOCK_SIZE;
 
     #ifdef MIFARE_CLASSIC_DEBUG
     Serial.print(F("Message Length "));Serial.println(messageLength);
@@ -59,6 +96,23 @@ NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
 
     while (index < bufferSize)
     {
+        currentBlock++;
+
+        // skip the trailer block and any sector that holds no NDEF data
+        if (_nfcShield->mifareclassic_IsTrailerBlock(currentBlock))
+        {
+            #ifdef MIFARE_CLASSIC_DEBUG
+            Serial.print(F("Skipping block "));Serial.println(currentBlock);
+            #endif
+            sector = nextSector(sectors, sector + 1);
+            if (sector >= MIFARE_CLASSIC_4K_SECTORS)
+            {
+                Serial.println(F("Error. Message runs past the last NDEF sector"));
+                _lastError = PN532_CARD_ERROR;
+                return NfcTag(uid, uidLength, "ERROR");
+            }
+            currentBlock = firstBlockOfSector(sector);
+        }
 
         // authenticate on every sector
         if (_nfcShield->mifareclassic_IsFirstBlock(currentBlock))
@@ -67,7 +121,8 @@ NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
             if (!success)
             {
                 Serial.print(F("Error. Block Authentication failed for "));Serial.println(currentBlock);
-                // TODO error handling
+                _lastError = _nfcShield->lastError();
+                return NfcTag(uid, uidLength, MIFARE_CLASSIC);
             }
         }
 
@@ -83,23 +138,181 @@ NfcTag MifareClassic::read(byte *uid, unsigned int uidLength)
         else
         {
             Serial.print(F("Read failed "));Serial.println(currentBlock);
-            // TODO handle errors here
+            _lastError = _nfcShield->lastError();
+            return NfcTag(uid, uidLength, MIFARE_CLASSIC);
         }
 
         index += BLOCK_SIZE;
-        currentBlock++;
+    }
 
-        // skip the trailer block
-        if (_nfcShield->mifareclassic_IsTrailerBlock(currentBlock))
+    // One bounds-checked pass over the TLVs read, NdefMessage checks the records
+    uint32_t start, length;
+    if (NdefMessageView::findMessage(buffer, bufferSize, &start, &length) != NDEF_VALID)
+    {
+        Serial.println(F("Error. Message TLV runs past the data read"));
+        _lastError = PN532_CARD_ERROR;
+        return NfcTag(uid, uidLength, "ERROR");
+    }
+    return NfcTag(uid, uidLength, MIFARE_CLASSIC, &buffer[start], length);
+}
+
+// Sectors that hold NDEF data, as a bitmap. Read from the MAD the first time
+// a UID is seen, then served from a small cache. Cards without a valid MAD
+// are assumed to use the whole card after sector 0, as this library formats them.
+// Only a MAD that was read in full, or a card that says it has none, is cached:
+// after a failed authentication or read the card is asked again next time.
+uint64_t MifareClassic::ndefSectors(byte *uid, unsigned int uidLength)
+{
+    for (uint8_t i = 0; i < MIFARE_MAD_CACHE_SIZE; i++)
+    {
+        MadCacheEntry &entry = _madCache[i];
+        if (entry.uidLength == uidLength && memcmp(entry.uid, uid, uidLength) == 0)
         {
-            #ifdef MIFARE_CLASSIC_DEBUG
-            Serial.print(F("Skipping block "));Serial.println(currentBlock);
-            #endif
-            currentBlock++;
+            return entry.sectors;
+        }
+    }
+
+    uint64_t sectors = 0;
+    bool is4K = _nfcShield->target(0).selRes == MIFARE_CLASSIC_4K_SAK;
+    uint8_t mad = readMad(uid, uidLength, sectors, is4K);
+    if (mad == MAD_ABSENT || mad == MAD_FAILED)
+    {
+        uint8_t count = is4K ? MIFARE_CLASSIC_4K_SECTORS : MIFARE_CLASSIC_1K_SECTORS;
+        sectors = ((1ULL << count) - 1) & ~1ULL;
+    }
+
+    if ((mad == MAD_VALID || mad == MAD_ABSENT) && uidLength <= sizeof(_madCache[0].uid))
+    {
+        MadCacheEntry &entry = _madCache[_madCacheNext];
+        _madCacheNext = (_madCacheNext + 1) % MIFARE_MAD_CACHE_SIZE;
+        memcpy(entry.uid, uid, uidLength);
+        entry.uidLength = uidLength;
+        entry.sectors = sectors;
+    }
+
+    #ifdef MIFARE_CLASSIC_DEBUG
+    Serial.print(F("NDEF sectors 0x"));Serial.print((uint32_t)(sectors >> 32), HEX);Serial.println((uint32_t)sectors, HEX);
+    #endif
+
+    return sectors;
+}
+
+// Drop the cached sector map of a UID after its layout changed
+void MifareClassic::forgetSectors(byte *uid, unsigned int uidLength)
+{
+    for (uint8_t i = 0; i < MIFARE_MAD_CACHE_SIZE; i++)
+    {
+        MadCacheEntry &entry = _madCache[i];
+        if (entry.uidLength == uidLength && memcmp(entry.uid, uid, uidLength) == 0)
+        {
+            entry.uidLength = 0;
+        }
+    }
+}
+
+// MAD v1 lives in sector 0 blocks 1-2, MAD v2 adds sector 16 blocks 64-66 on 4K cards.
+// Each directory byte pair is the AID of one sector, least significant byte first.
+// Returns MAD_VALID, MAD_ABSENT, MAD_PARTIAL with the sectors of MAD v1, or MAD_FAILED.
+uint8_t MifareClassic::readMad(byte *uid, unsigned int uidLength, uint64_t &sectors, bool &is4K)
+{
+    uint8_t madKey[6] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+    uint8_t mad[3 * BLOCK_SIZE];
+    uint8_t trailer[BLOCK_SIZE];
+
+    if (!_nfcShield->mifareclassic_AuthenticateBlock(uid, uidLength, 0, 0, madKey) ||
+        !_nfcShield->mifareclassic_ReadDataBlock(1, mad) ||
+        !_nfcShield->mifareclassic_ReadDataBlock(2, mad + BLOCK_SIZE) ||
+        !_nfcShield->mifareclassic_ReadDataBlock(3, trailer))
+    {
+        reselect(uid);
+        return MAD_FAILED;
+    }
+
+    uint8_t gpb = trailer[9];
+    if (!(gpb & MAD_GPB_DA))
+    {
+        return MAD_ABSENT;
+    }
+    if (madCrc(mad + 1, 2 * BLOCK_SIZE - 1) != mad[0])
+    {
+        return MAD_FAILED;
+    }
+    for (uint8_t sector = 1; sector < MIFARE_CLASSIC_1K_SECTORS; sector++)
+    {
+        if ((mad[2 * sector] | (mad[2 * sector + 1] << 8)) == MAD_AID_NDEF)
+        {
+            sectors |= 1ULL << sector;
+        }
+    }
+
+    if ((gpb & MAD_GPB_VERSION) == MAD_VERSION_2)
+    {
+        is4K = true;
+        if (_nfcShield->mifareclassic_AuthenticateBlock(uid, uidLength, firstBlockOfSector(16), 0, madKey) &&
+            _nfcShield->mifareclassic_ReadDataBlock(64, mad) &&
+            _nfcShield->mifareclassic_ReadDataBlock(65, mad + BLOCK_SIZE) &&
+            _nfcShield->mifareclassic_ReadDataBlock(66, mad + 2 * BLOCK_SIZE) &&
+            madCrc(mad + 1, 3 * BLOCK_SIZE - 1) == mad[0])
+        {
+            for (uint8_t sector = 17; sector < MIFARE_CLASSIC_4K_SECTORS; sector++)
+            {
+                uint8_t offset = 2 * (sector - 16);
+                if ((mad[offset] | (mad[offset + 1] << 8)) == MAD_AID_NDEF)
+                {
+                    sectors |= 1ULL << sector;
+                }
+            }
+        }
+        else
+        {
+            Serial.println(F("Error. Can't read MAD v2, using sectors 1-15 only"));
+            reselect(uid);
+            return MAD_PARTIAL;
         }
     }
 
-    return NfcTag(uid, uidLength, MIFARE_CLASSIC, &buffer[messageStartIndex], messageLength);
+    return MAD_VALID;
+}
+
+// A failed authentication or read halts the card, select it again
+void MifareClassic::reselect(byte *uid)
+{
+    uint8_t length;
+    _nfcShield->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &length);
+}
+
+// CRC-8 of a MAD, polynomial 0x1D, preset 0xC7 (NXP AN10787)
+uint8_t MifareClassic::madCrc(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0xC7;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x1D : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// First sector at or after from whose bit is set, MIFARE_CLASSIC_4K_SECTORS if none
+uint8_t MifareClassic::nextSector(uint64_t sectors, uint8_t from)
+{
+    while (from < MIFARE_CLASSIC_4K_SECTORS && !(sectors & (1ULL << from)))
+    {
+        from++;
+    }
+    return from;
+}
+
+uint8_t MifareClassic::firstBlockOfSector(uint8_t sector)
+{
+    if (sector < 32)
+    {
+        return sector * 4;
+    }
+    return 128 + (sector - 32) * 16;
 }
 
 int MifareClassic::getBufferSize(int messageLength)
@@ -126,34 +339,8 @@ int MifareClassic::getBufferSize(int messageLength)
     return bufferSize;
 }
 
-// skip null tlvs (0x0) before the real message
-// technically unlimited null tlvs, but we assume
-// T & L of TLV in the first block we read
-int MifareClassic::getNdefStartIndex(byte *data)
-{
-
-    for (int i = 0; i < BLOCK_SIZE; i++)
-    {
-        if (data[i] == 0x0)
-        {
-            // do nothing, skip
-        }
-        else if (data[i] == 0x3)
-        {
-            return i;
-        }
-        else
-        {
-            Serial.print("Unknown TLV ");Serial.println(data[i], HEX);
-            return -2;
-        }
-    }
-
-    return -1;
-}
-
 // Decode the NDEF data length from the Mifare TLV
-// Leading null TLVs (0x0) are skipped
+// NULL, lock control and other TLVs before the message are skipped
 // Assuming T & L of TLV will be in the first block
 // messageLength and messageStartIndex written to the parameters
 // success or failure status is returned
@@ -162,27 +349,14 @@ int MifareClassic::getNdefStartIndex(byte *data)
 // { 0x3, 0xFF, LENGTH, LENGTH }
 bool MifareClassic::decodeTlv(byte *data, int &messageLength, int &messageStartIndex)
 {
-    int i = getNdefStartIndex(data);
-
-    if (i < 0 || data[i] != 0x3)
+    uint32_t start, length;
+    if (NdefMessageView::findMessageHeader(data, BLOCK_SIZE, &start, &length) != NDEF_VALID)
     {
         Serial.println(F("Error. Can't decode message length."));
         return false;
     }
-    else
-    {
-        if (data[i+1] == 0xFF)
-        {
-            messageLength = ((0xFF & data[i+2]) << 8) | (0xFF & data[i+3]);
-            messageStartIndex = i + LONG_TLV_SIZE;
-        }
-        else
-        {
-            messageLength = data[i+1];
-            messageStartIndex = i + SHORT_TLV_SIZE;
-        }
-    }
-
+    messageLength = length;
+    messageStartIndex = start;
     return true;
 }
 
@@ -195,16 +369,21 @@ boolean MifareClassic::formatNDEF(byte * uid, unsigned int uidLength)
     uint8_t sectorbuffer0[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
     uint8_t sectorbuffer4[16] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
+    forgetSectors(uid, uidLength);
+
+    _lastError = PN532_OK;
     boolean success = _nfcShield->mifareclassic_AuthenticateBlock (uid, uidLength, 0, 0, keya);
     if (!success)
     {
         Serial.println(F("Unable to authenticate block 0 to enable card formatting!"));
+        _lastError = _nfcShield->lastError();
         return false;
     }
     success = _nfcShield->mifareclassic_FormatNDEF();
     if (!success)
     {
         Serial.println(F("Unable to format the card for NDEF"));
+        _lastError = _nfcShield->lastError();
     }
     else
     {
@@ -241,6 +420,7 @@ boolean MifareClassic::formatNDEF(byte * uid, unsigned int uidLength)
             } else {
                 unsigned int iii=uidLength;
                 Serial.print(F("Unable to authenticate block "));Serial.println(i);
+                _lastError = _nfcShield->lastError();
                 _nfcShield->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, (uint8_t*)&iii);
             }
         }
@@ -270,6 +450,9 @@ boolean MifareClassic::formatMifare(byte * uid, unsigned int uidLength)
     uint8_t numOfSector = 16;                         // Assume Mifare Classic 1K for now (16 4-block sectors)
     boolean success = false;
 
+    forgetSectors(uid, uidLength);
+    _lastError = PN532_OK;
+
     for (idx = 0; idx < numOfSector; idx++)
     {
         // Step 1: Authenticate the current sector using key B 0xFF 0xFF 0xFF 0xFF 0xFF 0xFF
@@ -277,6 +460,7 @@ boolean MifareClassic::formatMifare(byte * uid, unsigned int uidLength)
         if (!success)
         {
             Serial.print(F("Authentication failed for sector ")); Serial.println(idx);
+            _lastError = _nfcShield->lastError();
             return false;
         }
 
@@ -358,8 +542,17 @@ boolean MifareClassic::write(NdefMessage& m, byte * uid, unsigned int uidLength)
 
     // Write to tag
     int index = 0;
-    int currentBlock = 4;
-    uint8_t key[6] = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 }; // this is Sector 1 - 15 key
+    uint64_t sectors = ndefSectors(uid, uidLength);
+    uint8_t sector = nextSector(sectors, 1);
+    _lastError = PN532_OK;
+    if (sector >= MIFARE_CLASSIC_4K_SECTORS)
+    {
+        Serial.println(F("Error. Tag has no NDEF sectors"));
+        _lastError = PN532_CARD_ERROR;
+        return false;
+    }
+    int currentBlock = firstBlockOfSector(sector);
+    uint8_t key[6] = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 }; // this is the NDEF sector key
 
     while (index < sizeof(buffer))
     {
@@ -370,6 +563,7 @@ boolean MifareClassic::write(NdefMessage& m, byte * uid, unsigned int uidLength)
             if (!success)
             {
                 Serial.print(F("Error. Block Authentication failed for "));Serial.println(currentBlock);
+                _lastError = _nfcShield->lastError();
                 return false;
             }
         }
@@ -385,21 +579,31 @@ boolean MifareClassic::write(NdefMessage& m, byte * uid, unsigned int uidLength)
         else
         {
             Serial.print(F("Write failed "));Serial.println(currentBlock);
+            _lastError = _nfcShield->lastError();
             return false;
         }
         index += BLOCK_SIZE;
         currentBlock++;
 
-        if (_nfcShield->mifareclassic_IsTrailerBlock(currentBlock))
+        if (_nfcShield->mifareclassic_IsTrailerBlock(currentBlock) && index < sizeof(buffer))
         {
-            // can't write to trailer block
+            // can't write to trailer block, continue in the next NDEF sector
             #ifdef MIFARE_CLASSIC_DEBUG
             Serial.print(F("Skipping block "));Serial.println(currentBlock);
             #endif
-            currentBlock++;
+            sector = nextSector(sectors, sector + 1);
+            if (sector >= MIFARE_CLASSIC_4K_SECTORS)
+            {
+                Serial.println(F("Error. Message does not fit the NDEF sectors"));
+                _lastError = PN532_NO_SPACE;
+                return false;
+            }
+            currentBlock = firstBlockOfSector(sector);
         }
 
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+#endif
@@ -6,6 +6,10 @@
 #include <Ndef.h>
 #include <NfcTag.h>
 
+#define MIFARE_CLASSIC_1K_SECTORS   16
+#define MIFARE_CLASSIC_4K_SECTORS   40      // 32 sectors of 4 blocks, then 8 of 16 blocks
+#define MIFARE_MAD_CACHE_SIZE       4       // UIDs whose NDEF sector map is remembered
+
 class MifareClassic
 {
     public:
@@ -15,10 +19,27 @@ class MifareClassic
         boolean write(NdefMessage& ndefMessage, byte *uid, unsigned int uidLength);
         boolean formatNDEF(byte * uid, unsigned int uidLength);
         boolean formatMifare(byte * uid, unsigned int uidLength);
+        uint64_t ndefSectors(byte *uid, unsigned int uidLength);
+        static uint8_t firstBlockOfSector(uint8_t sector);
+        int16_t lastError() const { return _lastError; }   // Why the last call failed, see PN532_errors.h
     private:
+        struct MadCacheEntry
+        {
+            uint8_t uid[7];
+            uint8_t uidLength;      // 0 marks a free entry
+            uint64_t sectors;       // bit n set: sector n holds NDEF data
+        };
+        static MadCacheEntry _madCache[MIFARE_MAD_CACHE_SIZE];
+        static uint8_t _madCacheNext;
+
         PN532* _nfcShield;
+        int16_t _lastError;
+        uint8_t readMad(byte *uid, unsigned int uidLength, uint64_t &sectors, bool &is4K);
+        void reselect(byte *uid);
+        void forgetSectors(byte *uid, unsigned int uidLength);
+        static uint8_t madCrc(const uint8_t *data, uint8_t length);
+        static uint8_t nextSector(uint64_t sectors, uint8_t from);
         int getBufferSize(int messageLength);
-        int getNdefStartIndex(byte *data);
         bool decodeTlv(byte *data, int &messageLength, int &messageStartIndex);
 };
 
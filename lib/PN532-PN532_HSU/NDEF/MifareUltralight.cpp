@@ -1,4 +1,9 @@
+#include <PN532_features.h>
+
+#if PN532_FEATURE_TYPE2
+
 #include <MifareUltralight.h>
+#include <NdefView.h>
 
 #define ULTRALIGHT_PAGE_SIZE 4
 #define ULTRALIGHT_READ_SIZE 4 // we should be able to read 16 bytes at a time
@@ -15,6 +20,7 @@ MifareUltralight::MifareUltralight(PN532& nfcShield)
     nfc = &nfcShield;
     ndefStartIndex = 0;
     messageLength = 0;
+    _lastError = PN532_OK;
 }
 
 MifareUltralight::~MifareUltralight()
@@ -23,14 +29,18 @@ MifareUltralight::~MifareUltralight()
 
 NfcTag MifareUltralight::read(byte * uid, unsigned int uidLength)
 {
+    _lastError = PN532_OK;
     if (isUnformatted())
     {
         Serial.println(F("WARNING: Tag is not formatted."));
         return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2);
     }
 
-    readCapabilityContainer(); // meta info for tag
-    findNdefMessage();
+    // meta info for tag
+    if (_lastError != PN532_OK || !readCapabilityContainer() || !findNdefMessage())
+    {
+        return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2);
+    }
     calculateBufferSize();
 
     if (messageLength == 0) { // data is 0x44 0x03 0x00 0xFE
@@ -39,38 +49,34 @@ NfcTag MifareUltralight::read(byte * uid, unsigned int uidLength)
         return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2, message);
     }
 
-    boolean success;
-    uint8_t page;
-    uint8_t index = 0;
+    // read whole pages until the message is in the buffer
+    uint8_t page = ULTRALIGHT_DATA_START_PAGE;
+    unsigned int index = 0;
     byte buffer[bufferSize];
-    for (page = ULTRALIGHT_DATA_START_PAGE; page < ULTRALIGHT_MAX_PAGE; page++)
+    while (index < ndefStartIndex + messageLength)
     {
-        // read the data
-        success = nfc->mifareultralight_ReadPage(page, &buffer[index]);
-        if (success)
-        {
-            #ifdef MIFARE_ULTRALIGHT_DEBUG
-            Serial.print(F("Page "));Serial.print(page);Serial.print(" ");
-            nfc->PrintHexChar(&buffer[index], ULTRALIGHT_PAGE_SIZE);
-            #endif
-        }
-        else
+        if (!nfc->mifareultralight_ReadPage(page, &buffer[index]))
         {
             Serial.print(F("Read failed "));Serial.println(page);
-            // TODO error handling
-            messageLength = 0;
-            break;
-        }
-
-        if (index >= (messageLength + ndefStartIndex))
-        {
-            break;
+            _lastError = nfc->lastError();
+            return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2);
         }
-
+        #ifdef MIFARE_ULTRALIGHT_DEBUG
+        Serial.print(F("Page "));Serial.print(page);Serial.print(" ");
+        nfc->PrintHexChar(&buffer[index], ULTRALIGHT_PAGE_SIZE);
+        #endif
+        page++;
         index += ULTRALIGHT_PAGE_SIZE;
     }
 
-    NdefMessage ndefMessage = NdefMessage(&buffer[ndefStartIndex], messageLength);
+    // One bounds-checked pass over the TLVs read, NdefMessage checks the records
+    uint32_t start, length;
+    if (NdefMessageView::findMessage(buffer, index, &start, &length) != NDEF_VALID)
+    {
+        _lastError = PN532_CARD_ERROR;
+        return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2);
+    }
+    NdefMessage ndefMessage = NdefMessage(&buffer[start], length);
     return NfcTag(uid, uidLength, NFC_FORUM_TAG_TYPE_2, ndefMessage);
 
 }
@@ -87,12 +93,13 @@ boolean MifareUltralight::isUnformatted()
     else
     {
         Serial.print(F("Error. Failed read page "));Serial.println(page);
+        _lastError = nfc->lastError();
         return false;
     }
 }
 
 // page 3 has tag capabilities
-void MifareUltralight::readCapabilityContainer()
+boolean MifareUltralight::readCapabilityContainer()
 {
     byte data[ULTRALIGHT_PAGE_SIZE];
     int success = nfc->mifareultralight_ReadPage (3, data);
@@ -106,10 +113,15 @@ void MifareUltralight::readCapabilityContainer()
 
         // TODO future versions should get lock information
     }
+    else
+    {
+        _lastError = nfc->lastError();
+    }
+    return success;
 }
 
 // read enough of the message to find the ndef message length
-void MifareUltralight::findNdefMessage()
+boolean MifareUltralight::findNdefMessage()
 {
     int page;
     byte data[12]; // 3 pages
@@ -129,23 +141,28 @@ void MifareUltralight::findNdefMessage()
 
     if (success)
     {
-        if (data[0] == 0x03)
-        {
-            messageLength = data[1];
-            ndefStartIndex = 2;
-        }
-        else if (data[5] == 0x3) // page 5 byte 1
+        // skips a lock control TLV before the message; the pages read must hold its T and L
+        uint32_t start, length;
+        if (NdefMessageView::findMessageHeader(data, data_ptr - data, &start, &length) != NDEF_VALID ||
+            start + length > (ULTRALIGHT_MAX_PAGE - ULTRALIGHT_DATA_START_PAGE) * ULTRALIGHT_PAGE_SIZE)
         {
-            // TODO should really read the lock control TLV to ensure byte[5] is correct
-            messageLength = data[6];
-            ndefStartIndex = 7;
+            Serial.println(F("Error. Can't decode message length."));
+            _lastError = PN532_CARD_ERROR;
+            return false;
         }
+        messageLength = length;
+        ndefStartIndex = start;
+    }
+    else
+    {
+        _lastError = nfc->lastError();
     }
 
     #ifdef MIFARE_ULTRALIGHT_DEBUG
     Serial.print(F("messageLength "));Serial.println(messageLength);
     Serial.print(F("ndefStartIndex "));Serial.println(ndefStartIndex);
     #endif
+    return success;
 }
 
 // buffer is larger than the message, need to handle some data before and after
@@ -164,12 +181,17 @@ void MifareUltralight::calculateBufferSize()
 
 boolean MifareUltralight::write(NdefMessage& m, byte * uid, unsigned int uidLength)
 {
+    _lastError = PN532_OK;
     if (isUnformatted())
     {
         Serial.println(F("WARNING: Tag is not formatted."));
+        _lastError = PN532_CARD_ERROR;
+        return false;
+    }
+    if (_lastError != PN532_OK || !readCapabilityContainer()) // meta info for tag
+    {
         return false;
     }
-    readCapabilityContainer(); // meta info for tag
 
     messageLength  = m.getEncodedSize();
     ndefStartIndex = messageLength < 0xFF ? 2 : 4;
@@ -179,6 +201,7 @@ boolean MifareUltralight::write(NdefMessage& m, byte * uid, unsigned int uidLeng
 	    #ifdef MIFARE_ULTRALIGHT_DEBUG
     	Serial.print(F("Encoded Message length exceeded tag Capacity "));Serial.println(tagCapacity);
     	#endif
+    	_lastError = PN532_NO_SPACE;
     	return false;
     }
 
@@ -215,7 +238,10 @@ boolean MifareUltralight::write(NdefMessage& m, byte * uid, unsigned int uidLeng
     while (position < bufferSize){ //bufferSize is always times pagesize so no "last chunk" check
         // write page
         if (!nfc->mifareultralight_WritePage(page, src))
+        {
+            _lastError = nfc->lastError();
             return false;
+        }
 		#ifdef MIFARE_ULTRALIGHT_DEBUG
         Serial.print(F("Wrote page "));Serial.print(page);Serial.print(F(" - "));
     	nfc->PrintHex(src,ULTRALIGHT_PAGE_SIZE);
@@ -231,7 +257,11 @@ boolean MifareUltralight::write(NdefMessage& m, byte * uid, unsigned int uidLeng
 // zero out tag data like the NXP Tag Write Android application
 boolean MifareUltralight::clean()
 {
-    readCapabilityContainer(); // meta info for tag
+    _lastError = PN532_OK;
+    if (!readCapabilityContainer()) // meta info for tag
+    {
+        return false;
+    }
 
     uint8_t pages = (tagCapacity / ULTRALIGHT_PAGE_SIZE) + ULTRALIGHT_DATA_START_PAGE;
 
@@ -244,8 +274,11 @@ boolean MifareUltralight::clean()
         nfc->PrintHex(data, ULTRALIGHT_PAGE_SIZE);
         #endif
         if (!nfc->mifareultralight_WritePage(i, data)) {
+            _lastError = nfc->lastError();
             return false;
         }
     }
     return true;
 }
+
+#endif
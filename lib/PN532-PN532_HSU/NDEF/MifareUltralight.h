@@ -13,15 +13,17 @@ class MifareUltralight
         NfcTag read(byte *uid, unsigned int uidLength);
         boolean write(NdefMessage& ndefMessage, byte *uid, unsigned int uidLength);
         boolean clean();
+        int16_t lastError() const { return _lastError; }   // Why the last call failed, see PN532_errors.h
     private:
         PN532* nfc;
+        int16_t _lastError;
         unsigned int tagCapacity;
         unsigned int messageLength;
         unsigned int bufferSize;
         unsigned int ndefStartIndex;
         boolean isUnformatted();
-        void readCapabilityContainer();
-        void findNdefMessage();
+        boolean readCapabilityContainer();
+        boolean findNdefMessage();
         void calculateBufferSize();
 };
 
@@ -0,0 +1,181 @@
+#ifndef NdefConst_h
+#define NdefConst_h
+
+/* Builds encoded NDEF messages at compile time, for payloads that never change:
+
+       static constexpr auto message = ndefMessage(ndefUriRecord(NDEF_URI_HTTPS, "example.com"),
+                                                   ndefTextRecord("Podium 3"));
+       nfc.setNdefFile(message.data(), message.size());
+
+   The result is a std::array in flash with the same bytes NdefMessage::encode()
+   writes for the same records, and ndefTlv() adds the NDEF Message TLV and
+   terminator that NfcAdapter::write() puts around it on a tag. Nothing is
+   encoded or allocated at runtime.
+
+   Needs C++17 and the standard library, so it is not available on AVR.
+   Record ID fields and chunked records are not supported.
+*/
+
+#if __cplusplus < 201703L
+#error "NdefConst.h needs C++17 (build_flags = -std=gnu++17)"
+#endif
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NDEF_TNF_WELL_KNOWN 0x01
+#define NDEF_TNF_MIME_MEDIA 0x02
+#define NDEF_TNF_EXTERNAL_TYPE 0x04
+
+// URI identifier codes, NFC Forum URI RTD
+#define NDEF_URI_NONE 0x00
+#define NDEF_URI_HTTP_WWW 0x01
+#define NDEF_URI_HTTPS_WWW 0x02
+#define NDEF_URI_HTTP 0x03
+#define NDEF_URI_HTTPS 0x04
+#define NDEF_URI_TEL 0x05
+#define NDEF_URI_MAILTO 0x06
+
+template <size_t TypeLength, size_t PayloadLength>
+struct NdefConstRecord
+{
+    uint8_t tnf;
+    std::array<uint8_t, TypeLength> type;
+    std::array<uint8_t, PayloadLength> payload;
+
+    // TNF byte, type length, payload length (1 byte for short records, else 4), type, payload
+    static constexpr size_t encodedSize = 2 + (PayloadLength > 0xFF ? 4 : 1) + TypeLength + PayloadLength;
+};
+
+// Copies a string literal, without its terminator, into out at offset
+template <size_t Size, size_t N>
+constexpr size_t ndefCopy(std::array<uint8_t, Size> &out, size_t offset, const char (&text)[N])
+{
+    for (size_t i = 0; i + 1 < N; i++)
+    {
+        out[offset++] = (uint8_t)text[i];
+    }
+    return offset;
+}
+
+template <size_t T, size_t P>
+constexpr NdefConstRecord<T - 1, P - 1> ndefRecord(uint8_t tnf, const char (&type)[T], const char (&payload)[P])
+{
+    NdefConstRecord<T - 1, P - 1> record{};
+    record.tnf = tnf;
+    ndefCopy(record.type, 0, type);
+    ndefCopy(record.payload, 0, payload);
+    return record;
+}
+
+// Same payload as NdefMessage::addTextRecord(text, language): language length, language, text
+template <size_t N, size_t L>
+constexpr NdefConstRecord<1, L + N - 1> ndefTextRecord(const char (&text)[N], const char (&language)[L])
+{
+    NdefConstRecord<1, L + N - 1> record{};
+    record.tnf = NDEF_TNF_WELL_KNOWN;
+    record.type[0] = 'T';
+    record.payload[0] = L - 1;
+    ndefCopy(record.payload, ndefCopy(record.payload, 1, language), text);
+    return record;
+}
+
+template <size_t N>
+constexpr NdefConstRecord<1, N + 2> ndefTextRecord(const char (&text)[N])
+{
+    return ndefTextRecord(text, "en");
+}
+
+// Identifier code, then the rest of the URI. ndefUriRecord(uri) matches NdefMessage::addUriRecord(uri).
+template <size_t N>
+constexpr NdefConstRecord<1, N> ndefUriRecord(uint8_t prefix, const char (&rest)[N])
+{
+    NdefConstRecord<1, N> record{};
+    record.tnf = NDEF_TNF_WELL_KNOWN;
+    record.type[0] = 'U';
+    record.payload[0] = prefix;
+    ndefCopy(record.payload, 1, rest);
+    return record;
+}
+
+template <size_t N>
+constexpr NdefConstRecord<1, N> ndefUriRecord(const char (&uri)[N])
+{
+    return ndefUriRecord(NDEF_URI_NONE, uri);
+}
+
+// Same as NdefMessage::addMimeMediaRecord(mimeType, payload)
+template <size_t T, size_t P>
+constexpr NdefConstRecord<T - 1, P - 1> ndefMimeRecord(const char (&mimeType)[T], const char (&payload)[P])
+{
+    return ndefRecord(NDEF_TNF_MIME_MEDIA, mimeType, payload);
+}
+
+template <size_t Size, size_t T, size_t P>
+constexpr size_t ndefEncodeRecord(std::array<uint8_t, Size> &out, size_t offset, const NdefConstRecord<T, P> &record,
+                                  bool first, bool last)
+{
+    // MB, ME and SR flags as NdefRecord::getTnfByte() sets them
+    out[offset++] = record.tnf | (first ? 0x80 : 0) | (last ? 0x40 : 0) | (P <= 0xFF ? 0x10 : 0);
+    out[offset++] = T;
+    if (P <= 0xFF)
+    {
+        out[offset++] = P;
+    }
+    else
+    {
+        out[offset++] = 0;
+        out[offset++] = 0;
+        out[offset++] = (P >> 8) & 0xFF;
+        out[offset++] = P & 0xFF;
+    }
+    for (size_t i = 0; i < T; i++)
+    {
+        out[offset++] = record.type[i];
+    }
+    for (size_t i = 0; i < P; i++)
+    {
+        out[offset++] = record.payload[i];
+    }
+    return offset;
+}
+
+// Encodes the records, in order, as one message
+template <class... Records>
+constexpr std::array<uint8_t, (Records::encodedSize + ...)> ndefMessage(const Records &... records)
+{
+    static_assert(sizeof...(Records) > 0, "an NDEF message needs at least one record");
+    std::array<uint8_t, (Records::encodedSize + ...)> out{};
+    size_t offset = 0, index = 0;
+    ((offset = ndefEncodeRecord(out, offset, records, index == 0, index + 1 == sizeof...(Records)), index++), ...);
+    return out;
+}
+
+// NDEF Message TLV (03h, 1 or 3 length bytes) and terminator TLV (FEh) around a message
+template <size_t N>
+constexpr std::array<uint8_t, N + (N < 0xFF ? 2 : 4) + 1> ndefTlv(const std::array<uint8_t, N> &message)
+{
+    static_assert(N <= 0xFFFE, "an NDEF message TLV holds at most 65534 bytes");
+    std::array<uint8_t, N + (N < 0xFF ? 2 : 4) + 1> out{};
+    size_t offset = 0;
+    out[offset++] = 0x03;
+    if (N < 0xFF)
+    {
+        out[offset++] = N;
+    }
+    else
+    {
+        out[offset++] = 0xFF;
+        out[offset++] = (N >> 8) & 0xFF;
+        out[offset++] = N & 0xFF;
+    }
+    for (size_t i = 0; i < N; i++)
+    {
+        out[offset++] = message[i];
+    }
+    out[offset] = 0xFE;
+    return out;
+}
+
+#endif
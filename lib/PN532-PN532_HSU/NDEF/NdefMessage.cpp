@@ -1,4 +1,5 @@
 #include <NdefMessage.h>
+#include <NdefView.h>
 
 NdefMessage::NdefMessage(void)
 {
@@ -15,65 +16,35 @@ NdefMessage::NdefMessage(const byte * data, const int numBytes)
 
     _recordCount = 0;
 
-    int index = 0;
-
-    while (index <= numBytes)
+    // One bounds-checked pass, then the records are copied out without further checks
+    NdefMessageView view;
+    if (numBytes < 0 || view.validate(data, numBytes) != NDEF_VALID)
     {
+        #ifdef NDEF_DEBUG
+        Serial.print(F("Invalid NDEF message, error "));Serial.println(view.getError());
+        #endif
+        return;
+    }
 
-        // decode tnf - first byte is tnf with bit flags
-        // see the NFDEF spec for more info
-        byte tnf_byte = data[index];
-        bool mb = (tnf_byte & 0x80) != 0;
-        bool me = (tnf_byte & 0x40) != 0;
-        bool cf = (tnf_byte & 0x20) != 0;
-        bool sr = (tnf_byte & 0x10) != 0;
-        bool il = (tnf_byte & 0x8) != 0;
-        byte tnf = (tnf_byte & 0x7);
-
-        NdefRecord record = NdefRecord();
-        record.setTnf(tnf);
-
-        index++;
-        int typeLength = data[index];
-
-        int payloadLength = 0;
-        if (sr)
-        {
-            index++;
-            payloadLength = data[index];
-        }
-        else
-        {
-            payloadLength =
-		((0xFF & data[++index]) << 24)
-		| ((0xFF & data[++index]) << 16)
-		| ((0xFF & data[++index]) << 8)
-		| (0xFF & data[++index]);
-        }
-
-        int idLength = 0;
-        if (il)
+    for (unsigned int i = 0; i < view.getRecordCount(); i++)
+    {
+        if (i == NDEF_VIEW_MAX_RECORDS)
         {
-            index++;
-            idLength = data[index];
+            Serial.println(F("WARNING: Too many records. Increase MAX_NDEF_RECORDS."));
+            break;
         }
+        const NdefRecordView& recordView = view.getRecord(i);
 
-        index++;
-        record.setType(&data[index], typeLength);
-        index += typeLength;
-
-        if (il)
+        NdefRecord record = NdefRecord();
+        record.setTnf(recordView.getTnf());
+        record.setType(recordView.type, recordView.typeLength);
+        if (recordView.header & NDEF_IL)
         {
-            record.setId(&data[index], idLength);
-            index += idLength;
+            record.setId(recordView.id, recordView.idLength);
         }
-
-        record.setPayload(&data[index], payloadLength);
-        index += payloadLength;
+        record.setPayload(recordView.payload, recordView.payloadLength);
 
         addRecord(record);
-
-        if (me) break; // last message
     }
 
 }
@@ -3,8 +3,7 @@
 
 #include <Ndef.h>
 #include <NdefRecord.h>
-
-#define MAX_NDEF_RECORDS 4
+#include <NdefView.h>
 
 class NdefMessage
 {
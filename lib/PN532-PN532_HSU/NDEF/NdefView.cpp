@@ -0,0 +1,179 @@
+#include <NdefView.h>
+#include <stddef.h>
+
+#define TLV_NULL 0x00
+#define TLV_NDEF_MESSAGE 0x03
+#define TLV_TERMINATOR 0xFE
+
+// Same values as NdefRecord.h, which cannot be included without Arduino
+#define TNF_EMPTY 0x0
+#define TNF_UNKNOWN 0x05
+#define TNF_UNCHANGED 0x06
+#define TNF_RESERVED 0x07
+
+NdefMessageView::NdefMessageView()
+{
+    _recordCount = 0;
+    _messageLength = 0;
+    _error = NDEF_ERROR_EMPTY;
+}
+
+// Checks the message in data[0, numBytes) and records where each field is.
+// Lengths are added in 64 bits so a 4 byte payload length cannot wrap the index.
+uint8_t NdefMessageView::validate(const uint8_t *data, uint32_t numBytes)
+{
+    _recordCount = 0;
+    _messageLength = 0;
+
+    if (data == NULL || numBytes == 0)
+    {
+        return _error = NDEF_ERROR_EMPTY;
+    }
+
+    uint64_t index = 0;
+    while (true)
+    {
+        // header, type length and the shortest payload length
+        if (index + 3 > numBytes)
+        {
+            return _error = NDEF_ERROR_TRUNCATED;
+        }
+
+        NdefRecordView record;
+        record.header = data[index++];
+        record.typeLength = data[index++];
+
+        bool first = _recordCount == 0;
+        if (((record.header & NDEF_MB) != 0) != first)
+        {
+            return _error = NDEF_ERROR_BEGIN;
+        }
+
+        if (record.header & NDEF_SR)
+        {
+            record.payloadLength = data[index++];
+        }
+        else
+        {
+            if (index + 4 > numBytes)
+            {
+                return _error = NDEF_ERROR_TRUNCATED;
+            }
+            record.payloadLength = ((uint32_t)data[index] << 24) | ((uint32_t)data[index + 1] << 16) |
+                                   ((uint32_t)data[index + 2] << 8) | data[index + 3];
+            index += 4;
+        }
+
+        record.idLength = 0;
+        if (record.header & NDEF_IL)
+        {
+            if (index + 1 > numBytes)
+            {
+                return _error = NDEF_ERROR_TRUNCATED;
+            }
+            record.idLength = data[index++];
+        }
+
+        if (index + record.typeLength + record.idLength + record.payloadLength > numBytes)
+        {
+            return _error = NDEF_ERROR_TRUNCATED;
+        }
+
+        // NDEF 1.0 section 3.2.6: fields that must be empty for some TNFs
+        uint8_t tnf = record.getTnf();
+        if (tnf == TNF_RESERVED ||
+            (tnf == TNF_EMPTY && (record.typeLength || record.idLength || record.payloadLength)) ||
+            ((tnf == TNF_UNKNOWN || tnf == TNF_UNCHANGED) && record.typeLength))
+        {
+            return _error = NDEF_ERROR_TNF;
+        }
+
+        record.type = &data[index];
+        index += record.typeLength;
+        record.id = &data[index];
+        index += record.idLength;
+        record.payload = &data[index];
+        index += record.payloadLength;
+
+        if (_recordCount < NDEF_VIEW_MAX_RECORDS)
+        {
+            _records[_recordCount] = record;
+        }
+        _recordCount++;
+
+        if (record.header & NDEF_ME)
+        {
+            break;
+        }
+    }
+
+    _messageLength = index;
+    return _error = NDEF_VALID;
+}
+
+// Finds the first NDEF message TLV in Type 2 tag or Mifare Classic data, skipping
+// NULL, lock control, memory control and proprietary TLVs.
+uint8_t NdefMessageView::findMessage(const uint8_t *data, uint32_t numBytes, uint32_t *messageStart, uint32_t *messageLength)
+{
+    uint32_t start, length;
+    uint8_t error = findMessageHeader(data, numBytes, &start, &length);
+    if (error != NDEF_VALID)
+    {
+        return error;
+    }
+    if ((uint64_t)start + length > numBytes)
+    {
+        return NDEF_ERROR_TLV;
+    }
+    *messageStart = start;
+    *messageLength = length;
+    return NDEF_VALID;
+}
+
+// Like findMessage(), but the data may end inside the message: only the TLVs before
+// it and its type and length have to be there. A reader uses it on the first block
+// or pages to learn how much to read, then checks the whole read with findMessage().
+uint8_t NdefMessageView::findMessageHeader(const uint8_t *data, uint32_t numBytes, uint32_t *messageStart, uint32_t *messageLength)
+{
+    uint64_t index = 0;
+    while (index < numBytes)
+    {
+        uint8_t tag = data[index++];
+        if (tag == TLV_NULL)
+        {
+            continue;
+        }
+        if (tag == TLV_TERMINATOR)
+        {
+            break;
+        }
+
+        if (index + 1 > numBytes)
+        {
+            return NDEF_ERROR_TLV;
+        }
+        uint32_t length = data[index++];
+        if (length == 0xFF)
+        {
+            if (index + 2 > numBytes)
+            {
+                return NDEF_ERROR_TLV;
+            }
+            length = ((uint32_t)data[index] << 8) | data[index + 1];
+            index += 2;
+        }
+
+        if (tag == TLV_NDEF_MESSAGE)
+        {
+            *messageStart = index;
+            *messageLength = length;
+            return NDEF_VALID;
+        }
+        if (index + length > numBytes)
+        {
+            return NDEF_ERROR_TLV;
+        }
+        index += length;
+    }
+    return NDEF_ERROR_EMPTY;
+}
@@ -0,0 +1,68 @@
+#ifndef NdefView_h
+#define NdefView_h
+
+/* Bounds-checked view of an encoded NDEF message.
+
+   validate() walks the message once, checking every length field against the
+   buffer and the MB/ME/TNF rules. The records it returns point into the
+   caller's buffer, so once a message is valid its fields can be read without
+   further checks. This file has no Arduino dependency; the host fuzz target
+   and benchmark in tests/fuzz build it on its own.
+*/
+
+#include <stdint.h>
+
+#define MAX_NDEF_RECORDS 4          // Records an NdefMessage holds
+#define NDEF_VIEW_MAX_RECORDS MAX_NDEF_RECORDS  // Records kept; later ones are validated but not kept
+
+#define NDEF_VALID 0
+#define NDEF_ERROR_EMPTY 1          // No bytes, or no NDEF message TLV
+#define NDEF_ERROR_TRUNCATED 2      // A header or field runs past the end of the buffer
+#define NDEF_ERROR_BEGIN 3          // First record without MB, or MB on a later record
+#define NDEF_ERROR_TNF 4            // Type, ID or payload length not allowed for the TNF
+#define NDEF_ERROR_TLV 5            // TLV block runs past the end of the buffer
+
+#define NDEF_MB 0x80
+#define NDEF_ME 0x40
+#define NDEF_CF 0x20
+#define NDEF_SR 0x10
+#define NDEF_IL 0x08
+#define NDEF_TNF_MASK 0x07
+
+struct NdefRecordView
+{
+    uint8_t header;                 // MB, ME, CF, SR, IL and TNF bits
+    uint8_t typeLength;
+    uint8_t idLength;
+    uint32_t payloadLength;
+    const uint8_t *type;
+    const uint8_t *id;              // Only if IL is set
+    const uint8_t *payload;
+
+    uint8_t getTnf() const { return header & NDEF_TNF_MASK; }
+};
+
+class NdefMessageView
+{
+    public:
+        NdefMessageView();
+
+        uint8_t validate(const uint8_t *data, uint32_t numBytes);
+        static uint8_t findMessage(const uint8_t *data, uint32_t numBytes, uint32_t *messageStart, uint32_t *messageLength);
+        static uint8_t findMessageHeader(const uint8_t *data, uint32_t numBytes, uint32_t *messageStart, uint32_t *messageLength);
+
+        bool isValid() const { return _error == NDEF_VALID; }
+        uint8_t getError() const { return _error; }
+        unsigned int getRecordCount() const { return _recordCount; }
+        uint32_t getMessageLength() const { return _messageLength; }
+        // index < min(getRecordCount(), NDEF_VIEW_MAX_RECORDS), not checked
+        const NdefRecordView& getRecord(unsigned int index) const { return _records[index]; }
+
+    private:
+        NdefRecordView _records[NDEF_VIEW_MAX_RECORDS];
+        unsigned int _recordCount;
+        uint32_t _messageLength;
+        uint8_t _error;
+};
+
+#endif
@@ -1,8 +1,24 @@
+#include <PN532_features.h>
+
+#if PN532_FEATURE_MIFARE_CLASSIC && PN532_FEATURE_TYPE2
+
 #include <NfcAdapter.h>
 
 NfcAdapter::NfcAdapter(PN532Interface &interface)
 {
     shield = new PN532(interface);
+    uidLength = 0;
+    errorCode = PN532_OK;
+    arrivalHandler = 0;
+    removalHandler = 0;
+    ndefHandler = 0;
+    idleInterval = NFC_IDLE_POLL_MS;
+    presentInterval = NFC_PRESENT_POLL_MS;
+    nextPoll = 0;
+    present = false;
+    ndefPending = false;
+    misses = 0;
+    presentUidLength = 0;
 }
 
 NfcAdapter::~NfcAdapter(void)
@@ -45,6 +61,7 @@ boolean NfcAdapter::tagPresent(unsigned long timeout)
     {
         success = shield->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, (uint8_t*)&uidLength, timeout);
     }
+    errorCode = success ? PN532_OK : shield->lastError();
     return success;
 }
 
@@ -63,10 +80,12 @@ boolean NfcAdapter::format()
     {
         MifareClassic mifareClassic = MifareClassic(*shield);
         success = mifareClassic.formatNDEF(uid, uidLength);
+        errorCode = mifareClassic.lastError();
     }
     else
     {
         Serial.print(F("Unsupported Tag."));
+        errorCode = PN532_CARD_ERROR;
         success = false;
     }
     return success;
@@ -82,7 +101,9 @@ boolean NfcAdapter::clean()
         Serial.println(F("Cleaning Mifare Classic"));
         #endif
         MifareClassic mifareClassic = MifareClassic(*shield);
-        return mifareClassic.formatMifare(uid, uidLength);
+        boolean success = mifareClassic.formatMifare(uid, uidLength);
+        errorCode = mifareClassic.lastError();
+        return success;
     }
     else if (type == TAG_TYPE_2)
     {
@@ -90,11 +111,14 @@ boolean NfcAdapter::clean()
         Serial.println(F("Cleaning Mifare Ultralight"));
         #endif
         MifareUltralight ultralight = MifareUltralight(*shield);
-        return ultralight.clean();
+        boolean success = ultralight.clean();
+        errorCode = ultralight.lastError();
+        return success;
     }
     else
     {
         Serial.print(F("No driver for card type "));Serial.println(type);
+        errorCode = PN532_CARD_ERROR;
         return false;
     }
 
@@ -111,7 +135,9 @@ NfcTag NfcAdapter::read()
         Serial.println(F("Reading Mifare Classic"));
         #endif
         MifareClassic mifareClassic = MifareClassic(*shield);
-        return mifareClassic.read(uid, uidLength);
+        NfcTag tag = mifareClassic.read(uid, uidLength);
+        errorCode = mifareClassic.lastError();
+        return tag;
     }
     else if (type == TAG_TYPE_2)
     {
@@ -119,17 +145,21 @@ NfcTag NfcAdapter::read()
         Serial.println(F("Reading Mifare Ultralight"));
         #endif
         MifareUltralight ultralight = MifareUltralight(*shield);
-        return ultralight.read(uid, uidLength);
+        NfcTag tag = ultralight.read(uid, uidLength);
+        errorCode = ultralight.lastError();
+        return tag;
     }
     else if (type == TAG_TYPE_UNKNOWN)
     {
         Serial.print(F("Can not determine tag type"));
+        errorCode = PN532_CARD_ERROR;
         return NfcTag(uid, uidLength);
     }
     else
     {
         Serial.print(F("No driver for card type "));Serial.println(type);
         // TODO should set type here
+        errorCode = PN532_CARD_ERROR;
         return NfcTag(uid, uidLength);
     }
 
@@ -147,6 +177,7 @@ boolean NfcAdapter::write(NdefMessage& ndefMessage)
         #endif
         MifareClassic mifareClassic = MifareClassic(*shield);
         success = mifareClassic.write(ndefMessage, uid, uidLength);
+        errorCode = mifareClassic.lastError();
     }
     else if (type == TAG_TYPE_2)
     {
@@ -155,21 +186,99 @@ boolean NfcAdapter::write(NdefMessage& ndefMessage)
         #endif
         MifareUltralight mifareUltralight = MifareUltralight(*shield);
         success = mifareUltralight.write(ndefMessage, uid, uidLength);
+        errorCode = mifareUltralight.lastError();
     }
     else if (type == TAG_TYPE_UNKNOWN)
     {
         Serial.print(F("Can not determine tag type"));
+        errorCode = PN532_CARD_ERROR;
         success = false;
     }
     else
     {
         Serial.print(F("No driver for card type "));Serial.println(type);
+        errorCode = PN532_CARD_ERROR;
         success = false;
     }
 
     return success;
 }
 
+void NfcAdapter::onArrival(NfcTagHandler handler)
+{
+    arrivalHandler = handler;
+}
+
+void NfcAdapter::onRemoval(NfcTagHandler handler)
+{
+    removalHandler = handler;
+}
+
+void NfcAdapter::onNdef(NfcTagHandler handler)
+{
+    ndefHandler = handler;
+}
+
+void NfcAdapter::setPollInterval(unsigned long idleMillis, unsigned long presentMillis)
+{
+    idleInterval = idleMillis;
+    presentInterval = presentMillis;
+}
+
+// Runs at most one step of the event mode scheduler, so loop() stays responsive:
+//  - a pending NDEF read for the tag that just arrived, or
+//  - a detection when the poll interval is due. With no tag in the field this looks for one
+//    every idleInterval; with a tag it checks every presentInterval that the same tag is still there.
+// A tag is removed after NFC_REMOVAL_MISSES missed checks, or right away when another tag answers.
+void NfcAdapter::poll()
+{
+    if (ndefPending)
+    {
+        ndefPending = false;
+        NfcTag tag = read();
+        ndefHandler(tag);
+        return;
+    }
+
+    if ((long)(millis() - nextPoll) < 0)
+    {
+        return;
+    }
+
+    boolean found = tagPresent(NFC_DETECT_TIMEOUT_MS);
+    boolean sameTag = found && present && uidLength == presentUidLength && memcmp(uid, presentUid, uidLength) == 0;
+
+    if (sameTag)
+    {
+        misses = 0;
+    }
+    else if (present && (found || ++misses >= NFC_REMOVAL_MISSES))
+    {
+        present = false;
+        if (removalHandler)
+        {
+            NfcTag tag = NfcTag(presentUid, presentUidLength);
+            removalHandler(tag);
+        }
+    }
+
+    if (found && !present)
+    {
+        present = true;
+        misses = 0;
+        memcpy(presentUid, uid, uidLength);
+        presentUidLength = uidLength;
+        if (arrivalHandler)
+        {
+            NfcTag tag = NfcTag(uid, uidLength);
+            arrivalHandler(tag);
+        }
+        ndefPending = ndefHandler != 0;
+    }
+
+    nextPoll = millis() + (present ? presentInterval : idleInterval);
+}
+
 // TODO this should return a Driver MifareClassic, MifareUltralight, Type 4, Unknown
 // Guess Tag Type by looking at the ATQA and SAK values
 // Need to follow spec for Card Identification. Maybe AN1303, AN1305 and ???
@@ -192,3 +301,5 @@ unsigned int NfcAdapter::guessTagType()
         return TAG_TYPE_2;
     }
 }
+
+#endif
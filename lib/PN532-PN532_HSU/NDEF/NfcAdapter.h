@@ -3,6 +3,11 @@
 
 #include <PN532Interface.h>
 #include <PN532.h>
+
+#if !PN532_FEATURE_MIFARE_CLASSIC || !PN532_FEATURE_TYPE2
+#error "NfcAdapter needs PN532_FEATURE_MIFARE_CLASSIC and PN532_FEATURE_TYPE2"
+#endif
+
 #include <NfcTag.h>
 #include <Ndef.h>
 
@@ -20,6 +25,14 @@
 #define IRQ   (2)
 #define RESET (3)  // Not connected by default on the NFC Shield
 
+// Event mode scheduling, see poll()
+#define NFC_IDLE_POLL_MS (100)      // Detection cadence while no tag is in the field
+#define NFC_PRESENT_POLL_MS (250)   // Presence check cadence while a tag is in the field
+#define NFC_DETECT_TIMEOUT_MS (20)  // InListPassiveTarget timeout of one poll
+#define NFC_REMOVAL_MISSES (2)      // Missed presence checks before a tag counts as removed
+
+typedef void (*NfcTagHandler)(NfcTag& tag);
+
 class NfcAdapter {
     public:
         NfcAdapter(PN532Interface &interface);
@@ -35,11 +48,34 @@ class NfcAdapter {
         boolean format();
         // reset tag back to factory state
         boolean clean();
+        // why the last tagPresent(), read(), write(), format() or clean() failed, see PN532_errors.h
+        int16_t lastError() { return errorCode; }
+
+        // event mode: register handlers, then call poll() from loop() instead of tagPresent()
+        void onArrival(NfcTagHandler handler);
+        void onRemoval(NfcTagHandler handler);
+        // the NDEF message is only read when this handler is set
+        void onNdef(NfcTagHandler handler);
+        void setPollInterval(unsigned long idleMillis, unsigned long presentMillis);
+        void poll();
     private:
         PN532* shield;
         byte uid[7];  // Buffer to store the returned UID
         unsigned int uidLength; // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
         unsigned int guessTagType();
+        int16_t errorCode;
+
+        NfcTagHandler arrivalHandler;
+        NfcTagHandler removalHandler;
+        NfcTagHandler ndefHandler;
+        unsigned long idleInterval;
+        unsigned long presentInterval;
+        unsigned long nextPoll;
+        boolean present;
+        boolean ndefPending; // arrival seen, NDEF read left for the next poll()
+        uint8_t misses;
+        byte presentUid[7];
+        unsigned int presentUidLength;
 };
 
 #endif
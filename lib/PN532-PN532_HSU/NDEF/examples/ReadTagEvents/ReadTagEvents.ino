@@ -0,0 +1,48 @@
+// Reports tags as they arrive and leave, without a polling loop in the sketch.
+// Remove the onNdef() line and the NDEF message is never read.
+
+#if 0
+#include <SPI.h>
+#include <PN532_SPI.h>
+#include <PN532.h>
+#include <NfcAdapter.h>
+
+PN532_SPI pn532spi(SPI, 10);
+NfcAdapter nfc = NfcAdapter(pn532spi);
+#else
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+#include <NfcAdapter.h>
+
+PN532_I2C pn532_i2c(Wire);
+NfcAdapter nfc = NfcAdapter(pn532_i2c);
+#endif
+
+void tagArrived(NfcTag& tag) {
+    Serial.print("Arrived: "); Serial.println(tag.getUidString());
+}
+
+void tagRemoved(NfcTag& tag) {
+    Serial.print("Removed: "); Serial.println(tag.getUidString());
+}
+
+void ndefRead(NfcTag& tag) {
+    if (tag.hasNdefMessage()) {
+        tag.getNdefMessage().print();
+    }
+}
+
+void setup(void) {
+    Serial.begin(9600);
+    Serial.println("NDEF Reader, event mode");
+    nfc.begin();
+    nfc.onArrival(tagArrived);
+    nfc.onRemoval(tagRemoved);
+    nfc.onNdef(ndefRead);
+}
+
+void loop(void) {
+    nfc.poll();
+}
@@ -0,0 +1,229 @@
+#include <PN532.h>
+#include <MifareClassic.h>
+#include <ArduinoUnit.h>
+
+// Mifare Classic 4K image behind a fake PN532 transport. Answers the
+// InListPassiveTarget, authentication and read frames, and counts them.
+// Like a card, it halts after a failed authentication until it is selected again.
+class FakeClassic4K : public PN532Interface
+{
+public:
+    uint8_t mem[256][16];
+    uint8_t keyA[40][6];
+    uint8_t uidLast;        // Last UID byte, a new one per test keeps the MAD cache apart
+    int authSector;
+    int auths;
+    int reads;
+    int selects;
+    int failAuthBlock;      // The next authentication of this block fails, as on a card leaving the field
+    bool halted;
+
+    FakeClassic4K(uint8_t uid) : uidLast(uid), authSector(-1), auths(0), reads(0), selects(0), failAuthBlock(-1), halted(false)
+    {
+        memset(mem, 0, sizeof(mem));
+        memset(keyA, 0x11, sizeof(keyA));
+    }
+
+    static int sectorOf(int block) { return block < 128 ? block / 4 : 32 + (block - 128) / 16; }
+    static int firstBlock(int sector) { return sector < 32 ? sector * 4 : 128 + (sector - 32) * 16; }
+
+    void begin() {}
+    void wakeup() {}
+
+    int8_t writeCommand(const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0)
+    {
+        memcpy(cmd, header, hlen);
+        memcpy(cmd + hlen, body, blen);
+        return 0;
+    }
+
+    int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout = 1000)
+    {
+        if (cmd[0] == PN532_COMMAND_INLISTPASSIVETARGET)
+        {
+            const uint8_t target[] = { 1, 1, 0x00, 0x02, 0x18, 4, 0xDE, 0xAD, 0xBE, uidLast };
+            memcpy(buf, target, sizeof(target));
+            selects++;
+            halted = false;
+            authSector = -1;
+            return sizeof(target);
+        }
+        uint8_t block = cmd[3];
+        if (cmd[2] == MIFARE_CMD_AUTH_A)
+        {
+            auths++;
+            bool fail = halted || block == failAuthBlock || memcmp(cmd + 4, keyA[sectorOf(block)], 6) != 0;
+            if (block == failAuthBlock) { failAuthBlock = -1; }
+            authSector = fail ? -1 : sectorOf(block);
+            halted = fail;
+            buf[0] = fail ? 0x14 : 0x00;
+            return 1;
+        }
+        if (cmd[2] == MIFARE_CMD_READ)
+        {
+            reads++;
+            if (sectorOf(block) != authSector) { buf[0] = 0x14; return 1; }
+            buf[0] = 0x00;
+            memcpy(buf + 1, mem[block], 16);
+            return 17;
+        }
+        buf[0] = 0x27;
+        return 1;
+    }
+
+private:
+    uint8_t cmd[64];
+};
+
+uint8_t madCrc(const uint8_t *data, int length)
+{
+    uint8_t crc = 0xC7;
+    for (int i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) { crc = (crc & 0x80) ? (crc << 1) ^ 0x1D : (crc << 1); }
+    }
+    return crc;
+}
+
+// NDEF in sectors 5, 6, 20 and 33 (a 16-block sector), other applications everywhere else
+const int ndefSectors[] = { 5, 6, 20, 33 };
+uint8_t payload[200];
+
+void buildImage(FakeClassic4K &card)
+{
+    const uint8_t madKey[6] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+    const uint8_t ndefKey[6] = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 };
+    uint8_t mad1[32], mad2[48];
+    for (int i = 0; i < 32; i += 2) { mad1[i] = 0x01; mad1[i + 1] = 0x48; }
+    for (int i = 0; i < 48; i += 2) { mad2[i] = 0x01; mad2[i + 1] = 0x48; }
+
+    memcpy(card.keyA[0], madKey, 6);
+    memcpy(card.keyA[16], madKey, 6);
+    for (int s : ndefSectors)
+    {
+        memcpy(card.keyA[s], ndefKey, 6);
+        uint8_t *entry = s < 16 ? mad1 + 2 * s : mad2 + 2 * (s - 16);
+        entry[0] = 0xE1;
+        entry[1] = 0x03;
+    }
+    mad1[1] = 0x00;
+    mad1[0] = madCrc(mad1 + 1, 31);
+    mad2[1] = 0x00;
+    mad2[0] = madCrc(mad2 + 1, 47);
+    memcpy(card.mem[1], mad1, 32);
+    memcpy(card.mem[64], mad2, 48);
+    card.mem[3][9] = 0xC2;                          // GPB: MAD available, version 2
+
+    // One text record spread over the NDEF sectors
+    uint8_t tlv[210];
+    int n = 0;
+    payload[0] = 0x02; payload[1] = 'e'; payload[2] = 'n';
+    for (int i = 3; i < sizeof(payload); i++) { payload[i] = 'a' + i % 26; }
+    tlv[n++] = 0x03; tlv[n++] = 4 + sizeof(payload);
+    tlv[n++] = 0xD1; tlv[n++] = 1; tlv[n++] = sizeof(payload); tlv[n++] = 'T';
+    memcpy(tlv + n, payload, sizeof(payload)); n += sizeof(payload);
+    tlv[n++] = 0xFE;
+    int index = 0;
+    for (int s : ndefSectors)
+    {
+        int dataBlocks = s < 32 ? 3 : 15;
+        for (int b = 0; b < dataBlocks && index < n; b++, index += 16)
+        {
+            memcpy(card.mem[FakeClassic4K::firstBlock(s) + b], tlv + index, n - index < 16 ? n - index : 16);
+        }
+    }
+}
+
+void setup() {
+    Serial.begin(9600);
+}
+
+test(madDirectedRead)
+{
+    FakeClassic4K card(0x01);
+    buildImage(card);
+    PN532 nfc(card);
+    uint8_t uid[7], uidLength;
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    MifareClassic classic(nfc);
+
+    unsigned long start = micros();
+    NfcTag tag = classic.read(uid, uidLength);
+    unsigned long first = micros() - start;
+    assertTrue(tag.hasNdefMessage());
+    NdefRecord record = tag.getNdefMessage().getRecord(0);
+    assertEqual(sizeof(payload), record.getPayloadLength());
+    uint8_t read[sizeof(payload)];
+    record.getPayload(read);
+    assertEqual(0, memcmp(read, payload, sizeof(payload)));
+
+    // MAD v1 + v2 sectors, then only the 4 NDEF sectors
+    assertEqual(6, card.auths);
+    Serial.print(F("First read: ")); Serial.print(card.auths); Serial.print(F(" auths, "));
+    Serial.print(card.reads); Serial.print(F(" reads, ")); Serial.print(first); Serial.println(F(" us"));
+
+    // Second read of the same UID skips the MAD
+    card.auths = 0;
+    card.reads = 0;
+    start = micros();
+    NfcTag again = classic.read(uid, uidLength);
+    unsigned long cached = micros() - start;
+    assertTrue(again.hasNdefMessage());
+    assertEqual(4, card.auths);
+    Serial.print(F("Cached read: ")); Serial.print(card.auths); Serial.print(F(" auths, "));
+    Serial.print(card.reads); Serial.print(F(" reads, ")); Serial.print(cached); Serial.println(F(" us"));
+}
+
+test(madFailureNotCached)
+{
+    FakeClassic4K card(0x02);
+    buildImage(card);
+    PN532 nfc(card);
+    uint8_t uid[7], uidLength;
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    MifareClassic classic(nfc);
+
+    // The MAD authentication fails once: this read guesses the sectors and misses
+    card.failAuthBlock = 0;
+    NfcTag tag = classic.read(uid, uidLength);
+    assertFalse(tag.hasNdefMessage());
+    assertEqual(2, card.selects);
+
+    // The guess was not cached, so the next read asks the MAD again
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    card.auths = 0;
+    NfcTag again = classic.read(uid, uidLength);
+    assertTrue(again.hasNdefMessage());
+    assertEqual(6, card.auths);
+}
+
+test(madV2FailureReselects)
+{
+    FakeClassic4K card(0x03);
+    buildImage(card);
+    PN532 nfc(card);
+    uint8_t uid[7], uidLength;
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    MifareClassic classic(nfc);
+
+    // Sector 16 fails: the card is selected again and the MAD v1 sectors 5 and 6 still
+    // authenticate, but the message runs on into sector 20
+    card.failAuthBlock = 64;
+    card.reads = 0;
+    NfcTag tag = classic.read(uid, uidLength);
+    assertFalse(tag.hasNdefMessage());
+    assertEqual(2, card.selects);
+    assertEqual(9, card.reads);                     // MAD v1 blocks 1-3, then sectors 5 and 6
+
+    // Not cached: the next read gets the whole MAD
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    card.auths = 0;
+    NfcTag again = classic.read(uid, uidLength);
+    assertTrue(again.hasNdefMessage());
+    assertEqual(6, card.auths);
+}
+
+void loop() {
+    Test::run();
+}
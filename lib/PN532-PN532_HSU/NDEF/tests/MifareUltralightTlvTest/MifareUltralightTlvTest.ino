@@ -0,0 +1,114 @@
+#include <PN532.h>
+#include <MifareUltralight.h>
+#include <ArduinoUnit.h>
+
+// NFC Forum Type 2 tag behind a fake PN532 transport. Answers the InListPassiveTarget
+// and page read frames, and counts the reads.
+class FakeType2 : public PN532Interface
+{
+public:
+    uint8_t mem[64][4];
+    int reads;
+
+    FakeType2() : reads(0)
+    {
+        memset(mem, 0, sizeof(mem));
+        const uint8_t cc[4] = { 0xE1, 0x10, 0x12, 0x00 };   // 144 bytes of data
+        memcpy(mem[3], cc, 4);
+    }
+
+    void begin() {}
+    void wakeup() {}
+
+    int8_t writeCommand(const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0)
+    {
+        memcpy(cmd, header, hlen);
+        if (blen) { memcpy(cmd + hlen, body, blen); }
+        return 0;
+    }
+
+    int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout = 1000)
+    {
+        if (cmd[0] == PN532_COMMAND_INLISTPASSIVETARGET)
+        {
+            const uint8_t target[] = { 1, 1, 0x00, 0x44, 0x00, 7, 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+            memcpy(buf, target, sizeof(target));
+            return sizeof(target);
+        }
+        if (cmd[2] == MIFARE_CMD_READ)
+        {
+            reads++;
+            buf[0] = 0x00;
+            for (int i = 0; i < 4; i++) { memcpy(buf + 1 + 4 * i, mem[(cmd[3] + i) & 63], 4); }
+            return 17;
+        }
+        buf[0] = 0x27;
+        return 1;
+    }
+
+private:
+    uint8_t cmd[64];
+};
+
+// Writes the TLV area from page 4 on
+void writeData(FakeType2 &tag, const uint8_t *data, int length)
+{
+    memcpy(tag.mem[4], data, length);
+}
+
+void setup() {
+    Serial.begin(9600);
+}
+
+test(lockControlBeforeMessage)
+{
+    // Lock control TLV, then a text record whose TLV ends inside a page
+    FakeType2 tag;
+    uint8_t data[40];
+    int n = 0;
+    const uint8_t lock[] = { 0x01, 0x03, 0xA0, 0x0C, 0x34 };
+    memcpy(data, lock, sizeof(lock)); n += sizeof(lock);
+    data[n++] = 0x03; data[n++] = 4 + 8;
+    data[n++] = 0xD1; data[n++] = 1; data[n++] = 8; data[n++] = 'T';
+    memcpy(data + n, "\x02" "enhello", 8); n += 8;
+    data[n++] = 0xFE;
+    writeData(tag, data, n);
+
+    PN532 nfc(tag);
+    uint8_t uid[7], uidLength;
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    MifareUltralight ultralight(nfc);
+    tag.reads = 0;
+    NfcTag read = ultralight.read(uid, uidLength);
+    assertTrue(read.hasNdefMessage());
+    NdefRecord record = read.getNdefMessage().getRecord(0);
+    assertEqual(8, record.getPayloadLength());
+    uint8_t payload[8];
+    record.getPayload(payload);
+    assertEqual(0, memcmp(payload, "\x02" "enhello", 8));
+
+    // Format check, CC, 2 pages for the TLV header, then the 19 bytes up to the end of the message
+    assertEqual(4 + 5, tag.reads);
+}
+
+test(messageLongerThanTag)
+{
+    // A long TLV claiming more than the tag holds is refused before any data is read
+    FakeType2 tag;
+    const uint8_t data[] = { 0x03, 0xFF, 0x0F, 0xFF, 0xD1, 0x01, 0x01, 'T', 0x00, 0xFE };
+    writeData(tag, data, sizeof(data));
+
+    PN532 nfc(tag);
+    uint8_t uid[7], uidLength;
+    assertTrue(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength));
+    MifareUltralight ultralight(nfc);
+    tag.reads = 0;
+    NfcTag read = ultralight.read(uid, uidLength);
+    assertFalse(read.hasNdefMessage());
+    assertEqual(PN532_CARD_ERROR, ultralight.lastError());
+    assertEqual(4, tag.reads);
+}
+
+void loop() {
+    Test::run();
+}
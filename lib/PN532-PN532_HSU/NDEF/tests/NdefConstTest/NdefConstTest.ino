@@ -0,0 +1,104 @@
+#include <Wire.h>
+#include <PN532.h>
+#include <NdefMessage.h>
+#include <NdefRecord.h>
+#include <NdefConst.h>
+#include <ArduinoUnit.h>
+
+// Parity of the compile-time builder with NdefMessage::encode().
+// NdefConst.h needs C++17, so run these on an ESP32 rather than an Uno.
+
+static constexpr auto uriMessage = ndefMessage(ndefUriRecord("http://www.elechouse.com"));
+static constexpr auto textMessage = ndefMessage(ndefTextRecord("Unit Test"));
+static constexpr auto longMessage = ndefMessage(ndefTextRecord(
+    "We the People of the United States, in Order to form a more perfect Union, establish Justice, "
+    "insure domestic Tranquility, provide for the common defence, promote the general Welfare, and "
+    "secure the Blessings of Liberty to ourselves and our Posterity, do ordain and establish this "
+    "Constitution for the United States of America."));
+static constexpr auto multiMessage = ndefMessage(ndefTextRecord("Podium", "de"),
+                                                 ndefUriRecord("https://example.com/p/3"),
+                                                 ndefMimeRecord("text/plain", "cue 12"));
+
+// Built by the compiler, not at startup
+static_assert(uriMessage[0] == 0xD1 && uriMessage[3] == 'U', "short well known record, MB and ME");
+static_assert(longMessage[0] == 0xC1 && longMessage[2] == 0 && longMessage[3] == 0, "long record, 4 length bytes");
+static_assert(ndefTlv(textMessage)[0] == 0x03 && ndefTlv(textMessage).back() == 0xFE, "TLV wrapper");
+
+template <size_t N>
+void assertEncodesLike(NdefMessage &runtime, const std::array<uint8_t, N> &built)
+{
+    assertEqual(runtime.getEncodedSize(), (int)N);
+    uint8_t encoded[N];
+    runtime.encode(encoded);
+    for (size_t i = 0; i < N; i++) {
+        assertEqual(encoded[i], built[i]);
+    }
+}
+
+void setup() {
+    Serial.begin(9600);
+}
+
+test(uriParity)
+{
+    NdefMessage m;
+    m.addUriRecord("http://www.elechouse.com");
+    assertEncodesLike(m, uriMessage);
+}
+
+test(textParity)
+{
+    NdefMessage m;
+    m.addTextRecord("Unit Test");
+    assertEncodesLike(m, textMessage);
+}
+
+test(longRecordParity)
+{
+    NdefMessage m;
+    m.addTextRecord("We the People of the United States, in Order to form a more perfect Union, establish Justice, "
+                    "insure domestic Tranquility, provide for the common defence, promote the general Welfare, and "
+                    "secure the Blessings of Liberty to ourselves and our Posterity, do ordain and establish this "
+                    "Constitution for the United States of America.");
+    assertEncodesLike(m, longMessage);
+}
+
+test(multipleRecordParity)
+{
+    NdefMessage m;
+    m.addTextRecord("Podium", "de");
+    m.addUriRecord("https://example.com/p/3");
+    m.addMimeMediaRecord("text/plain", "cue 12");
+    assertEncodesLike(m, multiMessage);
+}
+
+test(prefixCode)
+{
+    // The identifier code replaces "https://", as the podium's served URI does
+    NdefRecord r;
+    r.setTnf(TNF_WELL_KNOWN);
+    uint8_t type[] = { 'U' };
+    r.setType(type, sizeof(type));
+    uint8_t payload[] = { 0x04, 'e', 'x', 'a', 'm', 'p', 'l', 'e', '.', 'c', 'o', 'm' };
+    r.setPayload(payload, sizeof(payload));
+    NdefMessage m;
+    m.addRecord(r);
+    assertEncodesLike(m, ndefMessage(ndefUriRecord(NDEF_URI_HTTPS, "example.com")));
+}
+
+test(tlvParity)
+{
+    // Same framing as MifareUltralight::write()
+    constexpr auto tlv = ndefTlv(textMessage);
+    assertEqual(tlv.size(), textMessage.size() + 3);
+    assertEqual(tlv[1], textMessage.size());
+    constexpr auto longTlv = ndefTlv(longMessage);
+    assertEqual(longTlv[1], 0xFF);
+    assertEqual((longTlv[2] << 8) | longTlv[3], (int)longMessage.size());
+    assertEqual(longTlv[4], longMessage[0]);
+    assertEqual(longTlv.back(), 0xFE);
+}
+
+void loop() {
+    Test::run();
+}
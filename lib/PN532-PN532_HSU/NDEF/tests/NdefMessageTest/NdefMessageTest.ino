@@ -218,6 +218,42 @@ test(doublePayload)
   assertEqual(0, (start-end));
 }
 
+test(decodeMalformed)
+{
+  // payload length runs past the buffer
+  uint8_t longPayload[] = { 0xD1, 0x01, 0x40, 0x54, 0x02, 0x65, 0x6E };
+  // 4 byte payload length that wraps a 16 bit index
+  uint8_t wrapPayload[] = { 0xC1, 0x01, 0xFF, 0xFF, 0xFF, 0xF0, 0x54 };
+  // no record has ME
+  uint8_t noEnd[] = { 0x91, 0x01, 0x01, 0x54, 0x00 };
+  // second record has MB
+  uint8_t twoBegins[] = { 0x91, 0x01, 0x01, 0x54, 0x00, 0xD1, 0x01, 0x01, 0x54, 0x00 };
+  // empty record with a type
+  uint8_t emptyWithType[] = { 0xD0, 0x01, 0x00, 0x54 };
+
+  assertEqual(0, NdefMessage(longPayload, sizeof(longPayload)).getRecordCount());
+  assertEqual(0, NdefMessage(wrapPayload, sizeof(wrapPayload)).getRecordCount());
+  assertEqual(0, NdefMessage(noEnd, sizeof(noEnd)).getRecordCount());
+  assertEqual(0, NdefMessage(twoBegins, sizeof(twoBegins)).getRecordCount());
+  assertEqual(0, NdefMessage(emptyWithType, sizeof(emptyWithType)).getRecordCount());
+  assertEqual(0, NdefMessage(longPayload, 0).getRecordCount());
+}
+
+test(decodeValid)
+{
+  NdefMessage m1 = NdefMessage();
+  m1.addTextRecord("Foo");
+  m1.addUriRecord("http://arduino.cc");
+  int size = m1.getEncodedSize();
+  byte encoded[size + 4];
+  m1.encode(encoded);
+  memset(encoded + size, 0xFE, 4); // trailing bytes after the ME record are ignored
+
+  NdefMessage m2 = NdefMessage(encoded, sizeof(encoded));
+  assertEqual(2, m2.getRecordCount());
+  assertEqual(m1.getRecord(1).getPayloadLength(), m2.getRecord(1).getPayloadLength());
+}
+
 test(aaa_printFreeMemoryAtStart)  //  warning: relies on fact tests are run in alphabetical order
 {
   Serial.println(F("---------------------"));
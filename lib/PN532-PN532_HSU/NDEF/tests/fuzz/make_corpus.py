@@ -0,0 +1,70 @@
+"""Writes the seed corpus for ndef_view_fuzz: NDEF messages as common tag
+writers and phones store them, each inside the TLV and terminator they sit in
+on a Type 2 tag.
+
+    python3 make_corpus.py corpus
+"""
+
+import os
+import sys
+
+
+def record(tnf, rtype, payload, mb, me, rid=b""):
+    sr = len(payload) < 256
+    header = (0x80 if mb else 0) | (0x40 if me else 0) | (0x10 if sr else 0) | (0x08 if rid else 0) | tnf
+    out = bytes([header, len(rtype)])
+    out += bytes([len(payload)]) if sr else len(payload).to_bytes(4, "big")
+    if rid:
+        out += bytes([len(rid)])
+    return out + rtype + rid + payload
+
+
+def message(*records):
+    out = b""
+    for i, (tnf, rtype, payload, *rid) in enumerate(records):
+        out += record(tnf, rtype, payload, i == 0, i == len(records) - 1, *rid)
+    return out
+
+
+def tlv(msg, lock=False):
+    prefix = bytes([0x01, 0x03, 0xA0, 0x0C, 0x34]) if lock else b""    # Lock control TLV of an NTAG216
+    length = bytes([len(msg)]) if len(msg) < 0xFF else bytes([0xFF]) + len(msg).to_bytes(2, "big")
+    return prefix + b"\x03" + length + msg + b"\xFE"
+
+
+def text(s, lang=b"en"):
+    return bytes([len(lang)]) + lang + s.encode()
+
+
+vcard = (b"BEGIN:VCARD\r\nVERSION:3.0\r\nN:Chappangathil;Anoof\r\nTEL:+971500000000\r\n"
+         b"EMAIL:podium@example.com\r\nEND:VCARD\r\n")
+wifi = bytes.fromhex("100e0032100100013f1045000a506f6469756d4e657400"
+                     "10030002002010200006ffffffffffff100f000200011027000870617373776f7264")
+smart_poster = message((1, b"U", b"\x04nfc-forum.org"), (1, b"T", text("NFC Forum")))
+
+SEEDS = {
+    "uri_https.ndef": tlv(message((1, b"U", b"\x04anoof.dev/podium"))),
+    "text_en.ndef": tlv(message((1, b"T", text("CUBE-07")))),
+    "text_utf16.ndef": tlv(message((1, b"T", b"\x82en" + "Würfel".encode("utf-16-be")))),
+    "smart_poster.ndef": tlv(message((1, b"Sp", smart_poster)), lock=True),
+    "android_app.ndef": tlv(message((1, b"U", b"\x03podium.example"), (4, b"android.com:pkg", b"com.example.podium"))),
+    "vcard.ndef": tlv(message((2, b"text/vcard", vcard))),
+    "wifi_handover.ndef": tlv(message((2, b"application/vnd.wfa.wsc", wifi))),
+    "empty.ndef": tlv(message((0, b"", b""))),
+    "with_id.ndef": tlv(message((1, b"T", text("ID"), b"cube-1"))),
+    "long_record.ndef": tlv(message((2, b"application/octet-stream", bytes(range(256)) * 2)), lock=True),
+    "five_records.ndef": tlv(message(*[(1, b"T", text("R%d" % i)) for i in range(5)])),
+}
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else "corpus"
+    os.makedirs(out, exist_ok=True)
+    for name, data in sorted(SEEDS.items()):
+        with open(os.path.join(out, name), "wb") as f:
+            f.write(data)
+    print("%d seeds written to %s" % (len(SEEDS), out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,55 @@
+// Time NdefMessageView::validate takes per record over the seed corpus.
+// validate() reads only the record headers and skips payloads, so a bytes
+// per second figure would count payload bytes it never touches.
+//
+//   g++ -O2 -I../.. ndef_view_bench.cpp ../../NdefView.cpp -o ndef_view_bench
+//   ./ndef_view_bench corpus/*
+
+#include <NdefView.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    std::vector<std::vector<uint8_t> > messages;
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) { perror(argv[i]); return 1; }
+        std::vector<uint8_t> data;
+        int c;
+        while ((c = fgetc(f)) != EOF) { data.push_back(c); }
+        fclose(f);
+
+        uint32_t start, length;
+        if (NdefMessageView::findMessage(data.data(), data.size(), &start, &length) != NDEF_VALID)
+        {
+            fprintf(stderr, "%s: no NDEF message TLV\n", argv[i]);
+            continue;
+        }
+        messages.push_back(std::vector<uint8_t>(data.begin() + start, data.begin() + start + length));
+    }
+    if (messages.empty()) { fprintf(stderr, "usage: %s <corpus files>\n", argv[0]); return 1; }
+
+    NdefMessageView view;
+    unsigned long records = 0;
+    const int rounds = 200000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (size_t m = 0; m < messages.size(); m++)
+        {
+            if (view.validate(messages[m].data(), messages[m].size()) != NDEF_VALID)
+            {
+                fprintf(stderr, "message %zu invalid: error %d\n", m, view.getError());
+                return 1;
+            }
+            records += view.getRecordCount();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("%zu messages, %lu records in %.2f s: %.1f ns/record\n", messages.size(), records, seconds,
+           seconds * 1e9 / records);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Fuzz target for NdefMessageView.
+//
+// With libFuzzer:
+//   clang++ -g -O1 -fsanitize=fuzzer,address -I../.. ndef_view_fuzz.cpp ../../NdefView.cpp -o ndef_view_fuzz
+//   ./ndef_view_fuzz corpus
+//
+// Without it, a built-in driver replays the corpus and then random mutations of it:
+//   g++ -g -O1 -fsanitize=address,undefined -DNDEF_FUZZ_STANDALONE -I../.. ndef_view_fuzz.cpp ../../NdefView.cpp -o ndef_view_fuzz
+//   ./ndef_view_fuzz corpus/* [-runs=1000000]
+//
+// Every input is copied to a buffer of exactly its size, so AddressSanitizer
+// reports any read past the end.
+
+#include <NdefView.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void touch(const uint8_t *data, uint32_t length, volatile uint8_t *sink)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        *sink ^= data[i];
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t *buffer = (uint8_t *)malloc(size ? size : 1);
+    if (size > 0) { memcpy(buffer, data, size); }   // data may be NULL when size is 0
+    volatile uint8_t sink = 0;
+
+    // as a raw message, then as tag data holding a message TLV
+    NdefMessageView view;
+    view.validate(buffer, size);
+    uint32_t start, length;
+    if (NdefMessageView::findMessage(buffer, size, &start, &length) == NDEF_VALID)
+    {
+        if (start + length > size) { abort(); }
+        view.validate(buffer + start, length);
+    }
+    if (NdefMessageView::findMessageHeader(buffer, size, &start, &length) == NDEF_VALID && start > size) { abort(); }
+
+    if (view.isValid())
+    {
+        unsigned int count = view.getRecordCount();
+        for (unsigned int i = 0; i < count && i < NDEF_VIEW_MAX_RECORDS; i++)
+        {
+            const NdefRecordView& record = view.getRecord(i);
+            touch(record.type, record.typeLength, &sink);
+            if (record.header & NDEF_IL) { touch(record.id, record.idLength, &sink); }
+            touch(record.payload, record.payloadLength, &sink);
+        }
+    }
+
+    free(buffer);
+    return 0;
+}
+
+#ifdef NDEF_FUZZ_STANDALONE
+#include <stdio.h>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    long runs = 1000000;
+    std::vector<std::vector<uint8_t> > corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-runs=", 6) == 0) { runs = atol(argv[i] + 6); continue; }
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) { perror(argv[i]); return 1; }
+        std::vector<uint8_t> input;
+        int c;
+        while ((c = fgetc(f)) != EOF) { input.push_back(c); }
+        fclose(f);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        corpus.push_back(input);
+    }
+    if (corpus.empty()) { corpus.push_back(std::vector<uint8_t>(1, 0xD1)); }
+
+    // byte flips, length byte bumps, truncation and splicing of corpus entries
+    srand(1);
+    for (long run = 0; run < runs; run++)
+    {
+        std::vector<uint8_t> input = corpus[rand() % corpus.size()];
+        int mutations = 1 + rand() % 4;
+        for (int m = 0; m < mutations && !input.empty(); m++)
+        {
+            size_t at = rand() % input.size();
+            switch (rand() % 5)
+            {
+                case 0: input[at] ^= 1 << (rand() % 8); break;
+                case 1: input[at] = rand(); break;
+                case 2: input[at] += (rand() % 2) ? 1 : -1; break;
+                case 3: input.resize(at); break;
+                default:
+                {
+                    const std::vector<uint8_t>& other = corpus[rand() % corpus.size()];
+                    input.insert(input.begin() + at, other.begin(), other.begin() + rand() % (other.size() + 1));
+                }
+            }
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("%zu seeds, %ld mutated runs, no faults\n", corpus.size(), runs);
+    return 0;
+}
+#endif
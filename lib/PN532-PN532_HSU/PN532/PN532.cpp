@@ -16,6 +16,9 @@
 PN532::PN532(PN532Interface &interface)
 {
     _interface = &interface;
+    inListedTag = 1;
+    memset(_targets, 0, sizeof(_targets));
+    _lastError = PN532_OK;
 }
 
 /**************************************************************************/
@@ -29,6 +32,80 @@ void PN532::begin()
     HAL(wakeup)();
 }
 
+/**************************************************************************/
+/*!
+    @brief  Sends the command in pn532_packetbuffer and reads its response
+            back into it. Records why it failed for lastError().
+
+    @param  hlen     Length of the command in pn532_packetbuffer
+    @param  body     Data sent after the command
+    @param  blen     Length of body
+    @param  timeout  Max time to wait for the response in ms
+
+    @returns Length of the response, or a PN532Interface.h error
+*/
+/**************************************************************************/
+int16_t PN532::transceive(uint8_t hlen, const uint8_t *body, uint8_t blen, uint16_t timeout)
+{
+    int8_t sent = HAL(writeCommand)(pn532_packetbuffer, hlen, body, blen);
+    if (sent) {
+        _lastError = sent < 0 ? sent : PN532_INVALID_ACK;
+        return _lastError;
+    }
+
+    int16_t length = HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout);
+    _lastError = length < 0 ? length : PN532_OK;
+    return length;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks the status byte that starts the response of InSelect,
+            InDeselect and InDataExchange
+
+    @param  length  What transceive() returned
+
+    @returns true if the target executed the command
+*/
+/**************************************************************************/
+bool PN532::statusOk(int16_t length)
+{
+    if (length < 0) {
+        return false;
+    }
+    if (length < 1) {
+        _lastError = PN532_INVALID_RESPONSE;
+        return false;
+    }
+    if (pn532_packetbuffer[0] & 0x3F) {
+        DMSG("Status code indicates an error\n");
+        _lastError = PN532_STATUS_ERROR(pn532_packetbuffer[0]);
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks a session before a command is sent for it. A session
+            that was never listed or was released has Tg 0, which
+            InRelease and InDeselect take as "all targets".
+
+    @param  target  Session passed to a command
+
+    @returns true if the session names a listed target
+*/
+/**************************************************************************/
+bool PN532::sessionOk(const PN532Target &target)
+{
+    if (target.tg == 0) {
+        DMSG("No target in this session\n");
+        _lastError = PN532_BAD_PARAMETER;
+        return false;
+    }
+    return true;
+}
+
 /**************************************************************************/
 /*!
     @brief  Prints a hexadecimal value in plain characters
@@ -119,13 +196,12 @@ uint32_t PN532::getFirmwareVersion(void)
 
     pn532_packetbuffer[0] = PN532_COMMAND_GETFIRMWAREVERSION;
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 1)) {
+    int16_t length = transceive(1);
+    if (length < 0) {
         return 0;
     }
-
-    // read data packet
-    int16_t status = HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer));
-    if (0 > status) {
+    if (length < 4) {
+        _lastError = PN532_INVALID_RESPONSE;
         return 0;
     }
 
@@ -206,6 +282,127 @@ uint32_t PN532::writeRegister(uint16_t reg, uint8_t val)
     return 1;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Read a list of PN532 registers with one command per
+            PN532_REGISTER_BATCH_MAX registers.
+
+    @param  regs    the CIU registers, see PN532_registers.h. Other
+                    addresses go through readRegister/writeRegister.
+    @param  count   number of registers.
+    @param  values  receives one value per register.
+
+    @returns  true on success.
+*/
+/**************************************************************************/
+bool PN532::readRegisters(const PN532Register *regs, uint8_t count, uint8_t *values)
+{
+    while (count) {
+        uint8_t n = count < PN532_REGISTER_BATCH_MAX ? count : PN532_REGISTER_BATCH_MAX;
+
+        pn532_packetbuffer[0] = PN532_COMMAND_READREGISTER;
+        for (uint8_t i = 0; i < n; i++) {
+            pn532_packetbuffer[1 + 2 * i] = (regs[i] >> 8) & 0xFF;
+            pn532_packetbuffer[2 + 2 * i] = regs[i] & 0xFF;
+        }
+
+        // read data packet, one value per address
+        int16_t status = transceive(1 + 2 * n);
+        if (status < 0) {
+            return false;
+        }
+        if (status < n) {
+            _lastError = PN532_INVALID_RESPONSE;
+            return false;
+        }
+        memcpy(values, pn532_packetbuffer, n);
+
+        regs += n;
+        values += n;
+        count -= n;
+    }
+
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a list of PN532 registers with one command per
+            PN532_REGISTER_BATCH_MAX registers.
+
+    @param  regs    the CIU registers, see PN532_registers.h. Other
+                    addresses go through readRegister/writeRegister.
+    @param  values  the 8-bit value for each register.
+    @param  count   number of registers.
+
+    @returns  true on success.
+*/
+/**************************************************************************/
+bool PN532::writeRegisters(const PN532Register *regs, const uint8_t *values, uint8_t count)
+{
+    while (count) {
+        uint8_t n = count < PN532_REGISTER_BATCH_MAX ? count : PN532_REGISTER_BATCH_MAX;
+
+        pn532_packetbuffer[0] = PN532_COMMAND_WRITEREGISTER;
+        for (uint8_t i = 0; i < n; i++) {
+            pn532_packetbuffer[1 + 3 * i] = (regs[i] >> 8) & 0xFF;
+            pn532_packetbuffer[2 + 3 * i] = regs[i] & 0xFF;
+            pn532_packetbuffer[3 + 3 * i] = values[i];
+        }
+
+        if (transceive(1 + 3 * n) < 0) {
+            return false;
+        }
+
+        regs += n;
+        values += n;
+        count -= n;
+    }
+
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read-modify-write a list of PN532 registers: only the bits set
+            in each mask are changed. Costs one batched read and one
+            batched write per PN532_REGISTER_BATCH_MAX registers.
+
+    @param  regs    the CIU registers, see PN532_registers.h. Other
+                    addresses go through readRegister/writeRegister.
+    @param  masks   bits to change in each register.
+    @param  values  new value of the masked bits.
+    @param  count   number of registers.
+
+    @returns  true on success.
+*/
+/**************************************************************************/
+bool PN532::modifyRegisters(const PN532Register *regs, const uint8_t *masks, const uint8_t *values, uint8_t count)
+{
+    uint8_t current[PN532_REGISTER_BATCH_MAX];
+
+    while (count) {
+        uint8_t n = count < PN532_REGISTER_BATCH_MAX ? count : PN532_REGISTER_BATCH_MAX;
+
+        if (!readRegisters(regs, n, current)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            current[i] = (current[i] & ~masks[i]) | (values[i] & masks[i]);
+        }
+        if (!writeRegisters(regs, current, n)) {
+            return false;
+        }
+
+        regs += n;
+        masks += n;
+        values += n;
+        count -= n;
+    }
+
+    return true;
+}
+
 /**************************************************************************/
 /*!
     Writes an 8-bit value that sets the state of the PN532's GPIO pins
@@ -245,7 +442,8 @@ bool PN532::writeGPIO(uint8_t pinstate)
     if (HAL(writeCommand)(pn532_packetbuffer, 3))
         return 0;
 
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    // the response has no data, a length of 0 is success
+    return (0 <= HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
 }
 
 /**************************************************************************/
@@ -304,10 +502,8 @@ bool PN532::SAMConfig(void)
 
     DMSG("SAMConfig\n");
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 4))
-        return false;
-
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    // the response has no data
+    return transceive(4) >= 0;
 }
 
 /**************************************************************************/
@@ -328,10 +524,7 @@ bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
     pn532_packetbuffer[3] = 0x01; // MxRtyPSL (default = 0x01)
     pn532_packetbuffer[4] = maxRetries;
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 5))
-        return 0x0;  // no ACK
-
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    return transceive(5) >= 0;
 }
 
 /**************************************************************************/
@@ -357,11 +550,7 @@ bool PN532::setRFField(uint8_t autoRFCA, uint8_t rFOnOff)
     pn532_packetbuffer[1] = 1;
     pn532_packetbuffer[2] = 0x00 | autoRFCA | rFOnOff;  
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 3)) {
-        return 0x0;  // command failed
-    }
-
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    return transceive(3) >= 0;
 }
 
 /***** ISO14443A Commands ******/
@@ -381,54 +570,189 @@ bool PN532::setRFField(uint8_t autoRFCA, uint8_t rFOnOff)
 /**************************************************************************/
 bool PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t *uid, uint8_t *uidLength, uint16_t timeout)
 {
+    if (inListPassiveTargets(cardbaudrate, 1, timeout) != 1) {
+        return 0;
+    }
+
+    *uidLength = _targets[0].uidLen;
+    memcpy(uid, _targets[0].uid, _targets[0].uidLen);
+
+    return 1;
+}
+
+/**************************************************************************/
+/*!
+    Lists up to two ISO14443A targets and keeps their descriptors as
+    sessions. The first listed target becomes the current one.
+
+    @param  cardBaudRate  Baud rate of the card (PN532_MIFARE_ISO14443A)
+    @param  maxTargets    Targets to list, 1 or 2
+    @param  timeout       Max time to wait in ms
+
+    @returns Number of targets listed, their sessions are target(0) and target(1)
+*/
+/**************************************************************************/
+uint8_t PN532::inListPassiveTargets(uint8_t cardbaudrate, uint8_t maxTargets, uint16_t timeout)
+{
+    memset(_targets, 0, sizeof(_targets));
+    if (maxTargets > PN532_MAX_TARGETS) {
+        maxTargets = PN532_MAX_TARGETS;
+    }
+
     pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
-    pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this to 2 later)
+    pn532_packetbuffer[1] = maxTargets;
     pn532_packetbuffer[2] = cardbaudrate;
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 3)) {
-        return 0x0;  // command failed
+    // read data packet, a timeout only means no target came in range
+    int16_t length = transceive(3, 0, 0, timeout);
+    if (length == PN532_TIMEOUT) {
+        _lastError = PN532_NO_TARGET;
     }
-
-    // read data packet
-    if (HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout) < 0) {
-        return 0x0;
+    if (length < 0) {
+        return 0;
+    }
+    if (length < 1) {
+        _lastError = PN532_INVALID_RESPONSE;
+        return 0;
     }
 
-    // check some basic stuff
     /* ISO14443A card response should be in the following format:
 
       byte            Description
       -------------   ------------------------------------------
       b0              Tags Found
-      b1              Tag Number (only one used in this example)
-      b2..3           SENS_RES
-      b4              SEL_RES
-      b5              NFCID Length
-      b6..NFCIDLen    NFCID
+      then per tag:
+      b0              Tag Number
+      b1..2           SENS_RES
+      b3              SEL_RES
+      b4              NFCID Length
+      b5..NFCIDLen    NFCID
+      ATS             only if SEL_RES bit 5 is set, first byte is its length
     */
 
-    if (pn532_packetbuffer[0] != 1)
-        return 0;
+    uint8_t found = pn532_packetbuffer[0];
+    uint8_t listed = 0;
+    uint8_t pos = 1;
+    while (listed < found && listed < maxTargets && pos + 5 <= length) {
+        PN532Target &target = _targets[listed];
+        uint8_t uidLen = pn532_packetbuffer[pos + 4];
+        if (uidLen > sizeof(target.uid) || pos + 5 + uidLen > length) {
+            break;
+        }
+        target.tg = pn532_packetbuffer[pos];
+        target.sensRes = (pn532_packetbuffer[pos + 1] << 8) | pn532_packetbuffer[pos + 2];
+        target.selRes = pn532_packetbuffer[pos + 3];
+        target.uidLen = uidLen;
+        memcpy(target.uid, pn532_packetbuffer + pos + 5, uidLen);
+        pos += 5 + uidLen;
+        if ((target.selRes & 0x20) && pos < length) {
+            pos += pn532_packetbuffer[pos];
+        }
 
-    uint16_t sens_res = pn532_packetbuffer[2];
-    sens_res <<= 8;
-    sens_res |= pn532_packetbuffer[3];
+        DMSG("Tg: ");  DMSG_HEX(target.tg);
+        DMSG("ATQA: 0x");  DMSG_HEX(target.sensRes);
+        DMSG("SAK: 0x");  DMSG_HEX(target.selRes);
+        DMSG("\n");
+        listed++;
+    }
 
-    DMSG("ATQA: 0x");  DMSG_HEX(sens_res);
-    DMSG("SAK: 0x");  DMSG_HEX(pn532_packetbuffer[4]);
-    DMSG("\n");
+    if (listed) {
+        inListedTag = _targets[0].tg;  // target used by inDataExchange()
+    } else {
+        _lastError = found ? PN532_INVALID_RESPONSE : PN532_NO_TARGET;
+    }
+    return listed;
+}
 
-    /* Card appears to be Mifare Classic */
-    *uidLength = pn532_packetbuffer[5];
+/**************************************************************************/
+/*!
+    Makes a listed target the current one, so the PN532 does not have to
+    re-enumerate the field to talk to it
+
+    @param  target  Session returned by target()
 
-    for (uint8_t i = 0; i < pn532_packetbuffer[5]; i++) {
-        uid[i] = pn532_packetbuffer[6 + i];
+    @returns true if the target answered the selection
+*/
+/**************************************************************************/
+bool PN532::inSelect(const PN532Target &target)
+{
+    if (!sessionOk(target)) {
+        return false;
     }
 
-    return 1;
+    pn532_packetbuffer[0] = PN532_COMMAND_INSELECT;
+    pn532_packetbuffer[1] = target.tg;
+
+    if (!statusOk(transceive(2))) {
+        return false;
+    }
+
+    inListedTag = target.tg;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    Deselects a listed target (HLTA), keeping it in the PN532 target list
+
+    @param  target  Session returned by target()
+
+    @returns true on success
+*/
+/**************************************************************************/
+bool PN532::inDeselect(const PN532Target &target)
+{
+    if (!sessionOk(target)) {
+        return false;
+    }
+
+    pn532_packetbuffer[0] = PN532_COMMAND_INDESELECT;
+    pn532_packetbuffer[1] = target.tg;
+
+    return statusOk(transceive(2));
+}
+
+/**************************************************************************/
+/*!
+    Releases a listed target and ends its session
+
+    @param  target  Session returned by target()
+
+    @returns the InRelease response length, PN532_BAD_PARAMETER for a
+             session that is already released, or another error
+*/
+/**************************************************************************/
+int16_t PN532::inRelease(const PN532Target &target)
+{
+    if (!sessionOk(target)) {
+        return _lastError;
+    }
+
+    uint8_t tg = target.tg;
+    for (uint8_t i = 0; i < PN532_MAX_TARGETS; i++) {
+        if (_targets[i].tg == tg) {
+            _targets[i].tg = 0;
+        }
+    }
+    return inRelease(tg);
+}
+
+/**************************************************************************/
+/*!
+    Session of the target selected last, for the functions without an
+    explicit target
+*/
+/**************************************************************************/
+PN532Target PN532::listedTarget() const
+{
+    PN532Target target;
+    memset(&target, 0, sizeof(target));
+    target.tg = inListedTag;
+    return target;
 }
 
 
+#if PN532_FEATURE_MIFARE_CLASSIC
 /***** Mifare Classic Functions ******/
 
 /**************************************************************************/
@@ -481,6 +805,15 @@ bool PN532::mifareclassic_IsTrailerBlock (uint32_t uiBlock)
 /**************************************************************************/
 uint8_t PN532::mifareclassic_AuthenticateBlock (uint8_t *uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t *keyData)
 {
+    return mifareclassic_AuthenticateBlock(listedTarget(), uid, uidLen, blockNumber, keyNumber, keyData);
+}
+
+uint8_t PN532::mifareclassic_AuthenticateBlock (const PN532Target &target, uint8_t *uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t *keyData)
+{
+    if (!sessionOk(target)) {
+        return 0;
+    }
+
     uint8_t i;
 
     // Hang on to the key and uid data
@@ -490,7 +823,7 @@ uint8_t PN532::mifareclassic_AuthenticateBlock (uint8_t *uid, uint8_t uidLen, ui
 
     // Prepare the authentication command //
     pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;   /* Data Exchange Header */
-    pn532_packetbuffer[1] = 1;                              /* Max card numbers */
+    pn532_packetbuffer[1] = target.tg;                      /* Card number */
     pn532_packetbuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
     pn532_packetbuffer[3] = blockNumber;                    /* Block Number (1K = 0..63, 4K = 0..255 */
     memcpy (pn532_packetbuffer + 4, _key, 6);
@@ -498,16 +831,9 @@ uint8_t PN532::mifareclassic_AuthenticateBlock (uint8_t *uid, uint8_t uidLen, ui
         pn532_packetbuffer[10 + i] = _uid[i];              /* 4 bytes card ID */
     }
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 10 + _uidLen))
-        return 0;
-
-    // Read the response packet
-    HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer));
-
-    // Check if the response is valid and we are authenticated???
-    // for an auth success it should be bytes 5-7: 0xD5 0x41 0x00
-    // Mifare auth error is technically byte 7: 0x14 but anything other and 0x00 is not good
-    if (pn532_packetbuffer[0] != 0x00) {
+    // Send the command and read the response packet
+    // for an auth success the status byte is 0x00, a wrong key gives 0x14
+    if (!statusOk(transceive(10 + _uidLen))) {
         DMSG("Authentification failed\n");
         return 0;
     }
@@ -530,25 +856,31 @@ uint8_t PN532::mifareclassic_AuthenticateBlock (uint8_t *uid, uint8_t uidLen, ui
 /**************************************************************************/
 uint8_t PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t *data)
 {
+    return mifareclassic_ReadDataBlock(listedTarget(), blockNumber, data);
+}
+
+uint8_t PN532::mifareclassic_ReadDataBlock (const PN532Target &target, uint8_t blockNumber, uint8_t *data)
+{
+    if (!sessionOk(target)) {
+        return 0;
+    }
+
     DMSG("Trying to read 16 bytes from block ");
     DMSG_INT(blockNumber);
 
     /* Prepare the command */
     pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-    pn532_packetbuffer[1] = 1;                      /* Card number */
+    pn532_packetbuffer[1] = target.tg;              /* Card number */
     pn532_packetbuffer[2] = MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
     pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
 
-    /* Send the command */
-    if (HAL(writeCommand)(pn532_packetbuffer, 4)) {
+    /* Send the command and read the response packet */
+    int16_t length = transceive(4);
+    if (!statusOk(length)) {
         return 0;
     }
-
-    /* Read the response packet */
-    HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer));
-
-    /* If byte 8 isn't 0x00 we probably have an error */
-    if (pn532_packetbuffer[0] != 0x00) {
+    if (length < 17) {
+        _lastError = PN532_CARD_ERROR;      /* NAK instead of the block */
         return 0;
     }
 
@@ -573,20 +905,24 @@ uint8_t PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t *data)
 /**************************************************************************/
 uint8_t PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t *data)
 {
+    return mifareclassic_WriteDataBlock(listedTarget(), blockNumber, data);
+}
+
+uint8_t PN532::mifareclassic_WriteDataBlock (const PN532Target &target, uint8_t blockNumber, uint8_t *data)
+{
+    if (!sessionOk(target)) {
+        return 0;
+    }
+
     /* Prepare the first command */
     pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-    pn532_packetbuffer[1] = 1;                      /* Card number */
+    pn532_packetbuffer[1] = target.tg;              /* Card number */
     pn532_packetbuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write command = 0xA0 */
     pn532_packetbuffer[3] = blockNumber;            /* Block Number (0..63 for 1K, 0..255 for 4K) */
     memcpy (pn532_packetbuffer + 4, data, 16);        /* Data Payload */
 
-    /* Send the command */
-    if (HAL(writeCommand)(pn532_packetbuffer, 20)) {
-        return 0;
-    }
-
-    /* Read the response packet */
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    /* Send the command and read the response packet */
+    return statusOk(transceive(20));
 }
 
 /**************************************************************************/
@@ -697,6 +1033,9 @@ uint8_t PN532::mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIden
     return 1;
 }
 
+#endif // PN532_FEATURE_MIFARE_CLASSIC
+
+#if PN532_FEATURE_TYPE2
 /***** Mifare Ultralight Functions ******/
 
 /**************************************************************************/
@@ -710,37 +1049,44 @@ uint8_t PN532::mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIden
 /**************************************************************************/
 uint8_t PN532::mifareultralight_ReadPage (uint8_t page, uint8_t *buffer)
 {
+    return mifareultralight_ReadPage(listedTarget(), page, buffer);
+}
+
+uint8_t PN532::mifareultralight_ReadPage (const PN532Target &target, uint8_t page, uint8_t *buffer)
+{
+    if (!sessionOk(target)) {
+        return 0;
+    }
+
     if (page >= 64) {
         DMSG("Page value out of range\n");
+        _lastError = PN532_BAD_PARAMETER;
         return 0;
     }
 
     /* Prepare the command */
     pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-    pn532_packetbuffer[1] = 1;                   /* Card number */
+    pn532_packetbuffer[1] = target.tg;           /* Card number */
     pn532_packetbuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
     pn532_packetbuffer[3] = page;                /* Page Number (0..63 in most cases) */
 
-    /* Send the command */
-    if (HAL(writeCommand)(pn532_packetbuffer, 4)) {
+    /* Send the command and read the response packet */
+    int16_t length = transceive(4);
+    if (!statusOk(length)) {
         return 0;
     }
-
-    /* Read the response packet */
-    HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer));
-
-    /* If byte 8 isn't 0x00 we probably have an error */
-    if (pn532_packetbuffer[0] == 0x00) {
-        /* Copy the 4 data bytes to the output buffer         */
-        /* Block content starts at byte 9 of a valid response */
-        /* Note that the command actually reads 16 bytes or 4  */
-        /* pages at a time ... we simply discard the last 12  */
-        /* bytes                                              */
-        memcpy (buffer, pn532_packetbuffer + 1, 4);
-    } else {
+    if (length < 5) {
+        _lastError = PN532_CARD_ERROR;      /* NAK instead of the pages */
         return 0;
     }
 
+    /* Copy the 4 data bytes to the output buffer         */
+    /* Block content starts at byte 9 of a valid response */
+    /* Note that the command actually reads 16 bytes or 4  */
+    /* pages at a time ... we simply discard the last 12  */
+    /* bytes                                              */
+    memcpy (buffer, pn532_packetbuffer + 1, 4);
+
     // Return OK signal
     return 1;
 }
@@ -758,22 +1104,28 @@ uint8_t PN532::mifareultralight_ReadPage (uint8_t page, uint8_t *buffer)
 /**************************************************************************/
 uint8_t PN532::mifareultralight_WritePage (uint8_t page, uint8_t *buffer)
 {
+    return mifareultralight_WritePage(listedTarget(), page, buffer);
+}
+
+uint8_t PN532::mifareultralight_WritePage (const PN532Target &target, uint8_t page, uint8_t *buffer)
+{
+    if (!sessionOk(target)) {
+        return 0;
+    }
+
     /* Prepare the first command */
     pn532_packetbuffer[0] = PN532_COMMAND_INDATAEXCHANGE;
-    pn532_packetbuffer[1] = 1;                           /* Card number */
+    pn532_packetbuffer[1] = target.tg;                   /* Card number */
     pn532_packetbuffer[2] = MIFARE_CMD_WRITE_ULTRALIGHT; /* Mifare UL Write cmd = 0xA2 */
     pn532_packetbuffer[3] = page;                        /* page Number (0..63) */
     memcpy (pn532_packetbuffer + 4, buffer, 4);          /* Data Payload */
 
-    /* Send the command */
-    if (HAL(writeCommand)(pn532_packetbuffer, 8)) {
-        return 0;
-    }
-
-    /* Read the response packet */
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    /* Send the command and read the response packet */
+    return statusOk(transceive(8));
 }
 
+#endif // PN532_FEATURE_TYPE2
+
 /**************************************************************************/
 /*!
     @brief  Exchanges an APDU with the currently inlisted peer
@@ -782,44 +1134,44 @@ uint8_t PN532::mifareultralight_WritePage (uint8_t page, uint8_t *buffer)
     @param  sendLength      Length of the data to send
     @param  response        Pointer to response data
     @param  responseLength  Pointer to the response data length
+
+    @returns false on failure, see lastError(). A response longer than
+             *responseLength fails with PN532_NO_SPACE.
 */
 /**************************************************************************/
 bool PN532::inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength)
 {
-    uint8_t i;
-
-    pn532_packetbuffer[0] = 0x40; // PN532_COMMAND_INDATAEXCHANGE;
-    pn532_packetbuffer[1] = inListedTag;
+    return inDataExchange(listedTarget(), send, sendLength, response, responseLength);
+}
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 2, send, sendLength)) {
+bool PN532::inDataExchange(const PN532Target &target, uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength)
+{
+    if (!sessionOk(target)) {
         return false;
     }
 
-    int16_t status = HAL(readResponse)(response, *responseLength, 1000);
-    if (status < 0) {
-        return false;
-    }
+    pn532_packetbuffer[0] = 0x40; // PN532_COMMAND_INDATAEXCHANGE;
+    pn532_packetbuffer[1] = target.tg;
 
-    if ((response[0] & 0x3f) != 0) {
-        DMSG("Status code indicates an error\n");
+    // read into the packet buffer, the response also carries a status byte
+    int16_t status = transceive(2, send, sendLength);
+    if (!statusOk(status)) {
         return false;
     }
 
-    uint8_t length = status;
-    length -= 1;
-
+    uint8_t length = status - 1;
     if (length > *responseLength) {
-        length = *responseLength; // silent truncation...
+        _lastError = PN532_NO_SPACE;
+        return false;
     }
 
-    for (uint8_t i = 0; i < length; i++) {
-        response[i] = response[i + 1];
-    }
+    memcpy(response, pn532_packetbuffer + 1, length);
     *responseLength = length;
 
     return true;
 }
 
+#if PN532_FEATURE_ISODEP
 /**************************************************************************/
 /*!
     @brief  'InLists' a passive target. PN532 acting as reader/initiator,
@@ -852,6 +1204,9 @@ bool PN532::inListPassiveTarget()
     return true;
 }
 
+#endif // PN532_FEATURE_ISODEP
+
+#if PN532_FEATURE_TARGET
 int8_t PN532::tgInitAsTarget(const uint8_t* command, const uint8_t len, const uint16_t timeout){
   
   int8_t status = HAL(writeCommand)(command, len);
@@ -954,6 +1309,8 @@ bool PN532::tgSetData(const uint8_t *header, uint8_t hlen, const uint8_t *body,
     return true;
 }
 
+#endif // PN532_FEATURE_TARGET
+
 int16_t PN532::inRelease(const uint8_t relevantTarget){
 
     pn532_packetbuffer[0] = PN532_COMMAND_INRELEASE;
@@ -968,6 +1325,7 @@ int16_t PN532::inRelease(const uint8_t relevantTarget){
 }
 
 
+#if PN532_FEATURE_FELICA
 /***** FeliCa Functions ******/
 /**************************************************************************/
 /*!
@@ -1047,6 +1405,104 @@ int8_t PN532::felica_Polling(uint16_t systemCode, uint8_t requestCode, uint8_t *
   return 1;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Polls for several FeliCa cards with one Polling command.
+
+    The Polling command's time slot number lets each card answer in a
+    random one of timeSlots slots, so cards that would collide in a single
+    slot are told apart. The PN532 lists at most PN532_MAX_TARGETS of them;
+    with more cards in the field, successive polls return different ones.
+
+    @param[in]  systemCode   System Code to poll for, FFFFh for all cards
+    @param[in]  requestCode  Request Data, as for felica_Polling()
+    @param[in]  timeSlots    Number of time slots: 1, 2, 4, 8 or 16
+    @param[out] targets      Listed cards, maxTargets entries
+    @param[in]  maxTargets   1 or 2
+    @return                  >= 0: Number of cards listed
+                             < 0: error
+*/
+/**************************************************************************/
+int8_t PN532::felica_PollTargets(uint16_t systemCode, uint8_t requestCode, uint8_t timeSlots, FelicaTarget *targets, uint8_t maxTargets, uint16_t timeout)
+{
+  if (timeSlots == 0 || timeSlots > 16 || (timeSlots & (timeSlots - 1)) != 0) {
+    DMSG("Time slots must be 1, 2, 4, 8 or 16\n");
+    _lastError = PN532_BAD_PARAMETER;
+    return -1;
+  }
+  if (maxTargets == 0 || maxTargets > PN532_MAX_TARGETS) {
+    maxTargets = PN532_MAX_TARGETS;
+  }
+
+  pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
+  pn532_packetbuffer[1] = maxTargets;
+  pn532_packetbuffer[2] = 1;
+  pn532_packetbuffer[3] = FELICA_CMD_POLLING;
+  pn532_packetbuffer[4] = (systemCode >> 8) & 0xFF;
+  pn532_packetbuffer[5] = systemCode & 0xFF;
+  pn532_packetbuffer[6] = requestCode;
+  pn532_packetbuffer[7] = timeSlots - 1;
+
+  // a timeout only means no card came in range
+  int16_t status = transceive(8, 0, 0, timeout);
+  if (status == PN532_TIMEOUT) {
+    _lastError = PN532_NO_TARGET;
+  }
+  if (status < 0) {
+    DMSG("Could not send Polling command or receive response\n");
+    return -2;
+  }
+  if (status < 1) {
+    DMSG("Empty response\n");
+    _lastError = PN532_INVALID_RESPONSE;
+    return -3;
+  }
+
+  // Each target: Tg, POL_RES length (counting itself), 01h, IDm, PMm, optional System Code
+  uint8_t count = pn532_packetbuffer[0];
+  if (count > maxTargets) {
+    DMSG("Unhandled number of targets inlisted\n");
+    _lastError = PN532_INVALID_RESPONSE;
+    return -4;
+  }
+  if (count == 0) {
+    _lastError = PN532_NO_TARGET;
+  }
+  uint8_t offset = 1;
+  for (uint8_t t = 0; t < count; t++) {
+    uint8_t length = pn532_packetbuffer[offset + 1];
+    if ((length != 18 && length != 20) || offset + 1 + length > status) {
+      DMSG("Wrong response length\n");
+      _lastError = PN532_INVALID_RESPONSE;
+      return -5;
+    }
+    targets[t].tg = pn532_packetbuffer[offset];
+    memcpy(targets[t].idm, &pn532_packetbuffer[offset + 3], 8);
+    memcpy(targets[t].pmm, &pn532_packetbuffer[offset + 11], 8);
+    targets[t].systemCode = (length == 20) ? (uint16_t)((pn532_packetbuffer[offset + 19] << 8) + pn532_packetbuffer[offset + 20]) : 0;
+    offset += 1 + length;
+  }
+
+  if (count) {
+    felica_Select(targets[0]);
+  }
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes a card listed by felica_PollTargets() the one the other
+            felica_ commands address. FeliCa has no selection state, so
+            no frame is sent.
+*/
+/**************************************************************************/
+void PN532::felica_Select(const FelicaTarget &target)
+{
+  inListedTag = target.tg;
+  memcpy(_felicaIDm, target.idm, 8);
+  memcpy(_felicaPMm, target.pmm, 8);
+}
+
 /**************************************************************************/
 /*!
     @brief  Sends FeliCa command to the currently inlisted peer
@@ -1063,6 +1519,7 @@ int8_t PN532::felica_SendCommand (const uint8_t *command, uint8_t commandlength,
 {
   if (commandlength > 0xFE) {
     DMSG("Command length too long\n");
+    _lastError = PN532_BAD_PARAMETER;
     return -1;
   }
 
@@ -1070,30 +1527,23 @@ int8_t PN532::felica_SendCommand (const uint8_t *command, uint8_t commandlength,
   pn532_packetbuffer[1] = inListedTag;
   pn532_packetbuffer[2] = commandlength + 1;
 
-  if (HAL(writeCommand)(pn532_packetbuffer, 3, command, commandlength)) {
-    DMSG("Could not send FeliCa command\n");
-    return -2;
-  }
-
   // Wait card response
-  int16_t status = HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), 200);
+  int16_t status = transceive(3, command, commandlength, 200);
   if (status < 0) {
-    DMSG("Could not receive response\n");
-    return -3;
+    DMSG("Could not send FeliCa command or receive response\n");
+    return -2;
   }
 
   // Check status (pn532_packetbuffer[0])
-  if ((pn532_packetbuffer[0] & 0x3F)!=0) {
-    DMSG("Status code indicates an error: ");
-    DMSG_HEX(pn532_packetbuffer[0]);
-    DMSG("\n");
+  if (!statusOk(status)) {
     return -4;
   }
 
   // length check
   *responseLength = pn532_packetbuffer[1] - 1;
-  if ( (status - 2) != *responseLength) {
+  if (status < 2 || (status - 2) != *responseLength) {
     DMSG("Wrong response length\n");
+    _lastError = PN532_INVALID_RESPONSE;
     return -5;
   }
 
@@ -1197,6 +1647,7 @@ int8_t PN532::felica_RequestResponse(uint8_t * mode)
     @param[in]  blockList          Block List (Big Endian, This API only accepts 2-byte block list element)
     @param[out] blockData          Block Data
     @return                        = 1: Success
+                                   = -5: The card answered with a status flag error, e.g. a block past its last one
                                    < 0: error
 */
 /**************************************************************************/
@@ -1236,21 +1687,22 @@ int8_t PN532::felica_ReadWithoutEncryption (uint8_t numService, const uint16_t *
     return -3;
   }
 
+  // status flag check, first: an error response ends after the flags, without
+  // the number of blocks and the block data
+  if ( responseLength >= 11 && (response[9] != 0 || response[10] != 0) ) {
+    DMSG("Read Without Encryption command failed (Status Flag: ");
+    DMSG_HEX(response[9]);
+    DMSG_HEX(response[10]);
+    DMSG(")\n");
+    return -5;
+  }
+
   // length check
   if ( responseLength != 12+16*numBlock ) {
     DMSG("Read Without Encryption command failed (wrong response length)\n");
     return -4;
   }
 
-  // status flag check
-  if ( response[9] != 0 || response[10] != 0 ) {
-    DMSG("Read Without Encryption command failed (Status Flag: ");
-    DMSG_HEX(pn532_packetbuffer[9]);
-    DMSG_HEX(pn532_packetbuffer[10]);
-    DMSG(")\n");
-    return -5;
-  }
-
   k = 12;
   for(i=0; i<numBlock; i++ ) {
     for(j=0; j<16; j++ ) {
@@ -1409,3 +1861,5 @@ int8_t PN532::felica_Release()
 
   return 1;
 }
+
+#endif // PN532_FEATURE_FELICA
@@ -11,6 +11,9 @@
 
 #include <stdint.h>
 #include "PN532Interface.h"
+#include "PN532_errors.h"
+#include "PN532_features.h"
+#include "PN532_registers.h"
 
 // PN532 Commands
 #define PN532_COMMAND_DIAGNOSE              (0x00)
@@ -124,6 +127,34 @@
 #define FELICA_WRITE_MAX_BLOCK_NUM          10 // for typical FeliCa card
 #define FELICA_REQ_SERVICE_MAX_NODE_NUM     32
 
+#define PN532_MAX_TARGETS                   (2)
+
+// Registers per ReadRegister/WriteRegister frame, longer lists are split.
+// A write frame is 3 bytes per register and must fit the packet buffer
+// and the transport (32-byte Wire buffer on AVR: use 7).
+#ifndef PN532_REGISTER_BATCH_MAX
+#define PN532_REGISTER_BATCH_MAX            (16)
+#endif
+
+// ISO14443A target listed by InListPassiveTarget, used as a session handle
+struct PN532Target {
+    uint8_t tg;         // Logical target number assigned by the PN532, 0 if not listed
+    uint16_t sensRes;   // ATQA
+    uint8_t selRes;     // SAK
+    uint8_t uidLen;
+    uint8_t uid[7];
+};
+
+#if PN532_FEATURE_FELICA
+// FeliCa card listed by felica_PollTargets()
+struct FelicaTarget {
+    uint8_t tg;           // Logical target number, for felica_Select()
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    uint16_t systemCode;  // 0 unless requestCode 01h asked for it
+};
+#endif
+
 class PN532
 {
 public:
@@ -131,16 +162,23 @@ public:
 
     void begin(void);
 
+    // Why the last generic, ISO14443A or MIFARE command failed, PN532_OK if it did not
+    int16_t lastError() const { return _lastError; }
+
     // Generic PN532 functions
     bool SAMConfig(void);
     uint32_t getFirmwareVersion(void);
     uint32_t readRegister(uint16_t reg);
     uint32_t writeRegister(uint16_t reg, uint8_t val);
+    bool readRegisters(const PN532Register *regs, uint8_t count, uint8_t *values);
+    bool writeRegisters(const PN532Register *regs, const uint8_t *values, uint8_t count);
+    bool modifyRegisters(const PN532Register *regs, const uint8_t *masks, const uint8_t *values, uint8_t count);
     bool writeGPIO(uint8_t pinstate);
     uint8_t readGPIO(void);
     bool setPassiveActivationRetries(uint8_t maxRetries);
     bool setRFField(uint8_t autoRFCA, uint8_t rFOnOff);
 
+#if PN532_FEATURE_TARGET
     /**
     * @brief    Init PN532 as a target
     * @param    timeout max time to wait, 0 means no timeout
@@ -153,29 +191,53 @@ public:
 
     int16_t tgGetData(uint8_t *buf, uint8_t len);
     bool tgSetData(const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0);
+#endif
 
     int16_t inRelease(const uint8_t relevantTarget = 0);
 
     // ISO14443A functions
+#if PN532_FEATURE_ISODEP
     bool inListPassiveTarget();
+#endif
     bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t *uid, uint8_t *uidLength, uint16_t timeout = 1000);
     bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
 
+    // Target sessions: list up to two targets once, then switch between them.
+    // A session without a target (Tg 0) fails with PN532_BAD_PARAMETER, nothing is sent
+    uint8_t inListPassiveTargets(uint8_t cardbaudrate, uint8_t maxTargets = PN532_MAX_TARGETS, uint16_t timeout = 1000);
+    const PN532Target &target(uint8_t index) const { return _targets[index]; }
+    bool inSelect(const PN532Target &target);
+    bool inDeselect(const PN532Target &target);
+    int16_t inRelease(const PN532Target &target);
+    bool inDataExchange(const PN532Target &target, uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
+
+#if PN532_FEATURE_MIFARE_CLASSIC
     // Mifare Classic functions
     bool mifareclassic_IsFirstBlock (uint32_t uiBlock);
     bool mifareclassic_IsTrailerBlock (uint32_t uiBlock);
     uint8_t mifareclassic_AuthenticateBlock (uint8_t *uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t *keyData);
+    uint8_t mifareclassic_AuthenticateBlock (const PN532Target &target, uint8_t *uid, uint8_t uidLen, uint32_t blockNumber, uint8_t keyNumber, uint8_t *keyData);
     uint8_t mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t *data);
+    uint8_t mifareclassic_ReadDataBlock (const PN532Target &target, uint8_t blockNumber, uint8_t *data);
     uint8_t mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t *data);
+    uint8_t mifareclassic_WriteDataBlock (const PN532Target &target, uint8_t blockNumber, uint8_t *data);
     uint8_t mifareclassic_FormatNDEF (void);
     uint8_t mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIdentifier, const char *url);
+#endif
 
+#if PN532_FEATURE_TYPE2
     // Mifare Ultralight functions
     uint8_t mifareultralight_ReadPage (uint8_t page, uint8_t *buffer);
+    uint8_t mifareultralight_ReadPage (const PN532Target &target, uint8_t page, uint8_t *buffer);
     uint8_t mifareultralight_WritePage (uint8_t page, uint8_t *buffer);
+    uint8_t mifareultralight_WritePage (const PN532Target &target, uint8_t page, uint8_t *buffer);
+#endif
 
+#if PN532_FEATURE_FELICA
     // FeliCa Functions
     int8_t felica_Polling(uint16_t systemCode, uint8_t requestCode, uint8_t *idm, uint8_t *pmm, uint16_t *systemCodeResponse, uint16_t timeout=1000);
+    int8_t felica_PollTargets(uint16_t systemCode, uint8_t requestCode, uint8_t timeSlots, FelicaTarget *targets, uint8_t maxTargets = PN532_MAX_TARGETS, uint16_t timeout=1000);
+    void felica_Select(const FelicaTarget &target);
     int8_t felica_SendCommand (const uint8_t * command, uint8_t commandlength, uint8_t * response, uint8_t * responseLength);
     int8_t felica_RequestService(uint8_t numNode, uint16_t *nodeCodeList, uint16_t *keyVersions) ;
     int8_t felica_RequestResponse(uint8_t *mode);
@@ -183,6 +245,7 @@ public:
     int8_t felica_WriteWithoutEncryption (uint8_t numService, const uint16_t *serviceCodeList, uint8_t numBlock, const uint16_t *blockList, uint8_t blockData[][16]);
     int8_t felica_RequestSystemCode(uint8_t *numSystemCode, uint16_t *systemCodeList);
     int8_t felica_Release();
+#endif
 
     // Help functions to display formatted text
     static void PrintHex(const uint8_t *data, const uint32_t numBytes);
@@ -194,14 +257,25 @@ public:
     };
 
 private:
+    PN532Target listedTarget() const;
+    int16_t transceive(uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0, uint16_t timeout = 1000);
+    bool statusOk(int16_t length);
+    bool sessionOk(const PN532Target &target);
+
     uint8_t _uid[7];  // ISO14443A uid
     uint8_t _uidLen;  // uid len
+#if PN532_FEATURE_MIFARE_CLASSIC
     uint8_t _key[6];  // Mifare Classic key
+#endif
     uint8_t inListedTag; // Tg number of inlisted tag.
+    PN532Target _targets[PN532_MAX_TARGETS]; // Sessions of the last inListPassiveTargets()
+#if PN532_FEATURE_FELICA
     uint8_t _felicaIDm[8]; // FeliCa IDm (NFCID2)
     uint8_t _felicaPMm[8]; // FeliCa PMm (PAD)
+#endif
 
     uint8_t pn532_packetbuffer[64];
+    int16_t _lastError;
 
     PN532Interface *_interface;
 };
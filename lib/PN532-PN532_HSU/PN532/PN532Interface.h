@@ -4,6 +4,7 @@
 #define __PN532_INTERFACE_H__
 
 #include <stdint.h>
+#include "PN532_errors.h"
 
 #define PN532_PREAMBLE                (0x00)
 #define PN532_STARTCODE1              (0x00)
@@ -15,11 +16,6 @@
 
 #define PN532_ACK_WAIT_TIME           (10)  // ms, timeout of waiting for ACK
 
-#define PN532_INVALID_ACK             (-1)
-#define PN532_TIMEOUT                 (-2)
-#define PN532_INVALID_FRAME           (-3)
-#define PN532_NO_SPACE                (-4)
-
 #define REVERSE_BITS_ORDER(b)         b = (b & 0xF0) >> 4 | (b & 0x0F) << 4; \
                                       b = (b & 0xCC) >> 2 | (b & 0x33) << 2; \
                                       b = (b & 0xAA) >> 1 | (b & 0x55) << 1
@@ -0,0 +1,49 @@
+/**************************************************************************/
+/*!
+    @file     PN532_features.h
+    @brief    Compile-time selection of the PN532 library components
+
+    Every component is enabled unless the build disables it, e.g. with
+    build_flags = -DPN532_FEATURE_FELICA=0. A disabled component is not
+    compiled at all, so it costs no flash, no RAM in the PN532 object and
+    no start-up time. Using its API is a compile error.
+*/
+/**************************************************************************/
+
+#ifndef __PN532_FEATURES_H__
+#define __PN532_FEATURES_H__
+
+// Mifare Classic (authentication, block read/write, NDEF formatting)
+#ifndef PN532_FEATURE_MIFARE_CLASSIC
+#define PN532_FEATURE_MIFARE_CLASSIC    1
+#endif
+
+// NFC Forum Type 2 / Mifare Ultralight page read/write
+#ifndef PN532_FEATURE_TYPE2
+#define PN532_FEATURE_TYPE2             1
+#endif
+
+// FeliCa polling and commands
+#ifndef PN532_FEATURE_FELICA
+#define PN532_FEATURE_FELICA            1
+#endif
+
+// ISO-DEP (ISO14443-4) target activation for APDU exchange
+#ifndef PN532_FEATURE_ISODEP
+#define PN532_FEATURE_ISODEP            1
+#endif
+
+// Peer-to-peer: MAC link, LLCP and SNEP
+#ifndef PN532_FEATURE_P2P
+#define PN532_FEATURE_P2P               1
+#endif
+
+// Card emulation of an NDEF Type 4 tag
+#ifndef PN532_FEATURE_EMULATION
+#define PN532_FEATURE_EMULATION         1
+#endif
+
+// Target mode is shared by peer-to-peer and card emulation
+#define PN532_FEATURE_TARGET            (PN532_FEATURE_P2P || PN532_FEATURE_EMULATION)
+
+#endif
@@ -0,0 +1,75 @@
+/**************************************************************************/
+/*!
+    @file     PN532_registers.h
+    @brief    Addresses of the PN532 CIU (Contactless Interface Unit)
+              registers, for readRegisters/writeRegisters/modifyRegisters
+
+    Names follow the PN532 user manual, section 8.6.
+*/
+/**************************************************************************/
+
+#ifndef __PN532_REGISTERS_H__
+#define __PN532_REGISTERS_H__
+
+#include <stdint.h>
+
+enum PN532Register : uint16_t {
+    PN532_CIU_MODE              = 0x6301,   // Defines general modes for transmitting and receiving
+    PN532_CIU_TXMODE            = 0x6302,   // Defines the transmission data rate and framing
+    PN532_CIU_RXMODE            = 0x6303,   // Defines the receive data rate and framing
+    PN532_CIU_TXCONTROL         = 0x6304,   // Controls the antenna driver pins TX1 and TX2
+    PN532_CIU_TXAUTO            = 0x6305,   // Controls the antenna driver settings
+    PN532_CIU_TXSEL             = 0x6306,   // Selects the internal sources for the antenna driver
+    PN532_CIU_RXSEL             = 0x6307,   // Selects internal receiver settings
+    PN532_CIU_RXTHRESHOLD       = 0x6308,   // Selects thresholds for the bit decoder
+    PN532_CIU_DEMOD             = 0x6309,   // Defines demodulator settings
+    PN532_CIU_FELNFC1           = 0x630A,   // Defines the length of the valid range for the received frame
+    PN532_CIU_FELNFC2           = 0x630B,   // Defines the length of the valid range for the received frame
+    PN532_CIU_MIFNFC            = 0x630C,   // Controls the communication in ISO/IEC 14443/MIFARE and NFC target mode at 106 kbit/s
+    PN532_CIU_MANUALRCV         = 0x630D,   // Allows manual fine tuning of the internal receiver
+    PN532_CIU_TYPEB             = 0x630E,   // Configure the ISO/IEC 14443 type B
+    PN532_CIU_CRCRESULTMSB      = 0x6311,   // Shows the actual MSB values of the CRC calculation
+    PN532_CIU_CRCRESULTLSB      = 0x6312,   // Shows the actual LSB values of the CRC calculation
+    PN532_CIU_GSNOFF            = 0x6313,   // Selects the conductance of the antenna driver pins when no RF is transmitted
+    PN532_CIU_MODWIDTH          = 0x6314,   // Controls the setting of the width of the Miller pause
+    PN532_CIU_TXBITPHASE        = 0x6315,   // Bit synchronization at 106 kbit/s
+    PN532_CIU_RFCFG             = 0x6316,   // Configures the receiver gain and RF level
+    PN532_CIU_GSNON             = 0x6317,   // Selects the conductance of the antenna driver pins when RF is transmitted
+    PN532_CIU_CWGSP             = 0x6318,   // Selects the conductance of the antenna driver pin TX1/TX2 for continuous wave
+    PN532_CIU_MODGSP            = 0x6319,   // Selects the conductance of the antenna driver pin TX1/TX2 for modulation
+    PN532_CIU_TMODE             = 0x631A,   // Defines settings for the internal timer
+    PN532_CIU_TPRESCALER        = 0x631B,   // Defines settings for the internal timer
+    PN532_CIU_TRELOADVAL_HI     = 0x631C,   // Describes the 16-bit long timer reload value (high byte)
+    PN532_CIU_TRELOADVAL_LO     = 0x631D,   // Describes the 16-bit long timer reload value (low byte)
+    PN532_CIU_TCOUNTERVAL_HI    = 0x631E,   // Describes the 16-bit long timer actual value (high byte)
+    PN532_CIU_TCOUNTERVAL_LO    = 0x631F,   // Describes the 16-bit long timer actual value (low byte)
+    PN532_CIU_TESTSEL1          = 0x6321,   // General test signal configuration
+    PN532_CIU_TESTSEL2          = 0x6322,   // General test signal configuration and PRBS control
+    PN532_CIU_TESTPINEN         = 0x6323,   // Enables test signals output on pins
+    PN532_CIU_TESTPINVALUE      = 0x6324,   // Defines the values for the 8-bit parallel bus when it is used as I/O bus
+    PN532_CIU_TESTBUS           = 0x6325,   // Shows the status of the internal test bus
+    PN532_CIU_AUTOTEST          = 0x6326,   // Controls the digital self-test
+    PN532_CIU_VERSION           = 0x6327,   // Shows the CIU version
+    PN532_CIU_ANALOGTEST        = 0x6328,   // Controls the pins AUX1 and AUX2
+    PN532_CIU_TESTDAC1          = 0x6329,   // Defines the test value for the TestDAC1
+    PN532_CIU_TESTDAC2          = 0x632A,   // Defines the test value for the TestDAC2
+    PN532_CIU_TESTADC           = 0x632B,   // Show the actual value of ADC I and Q
+    PN532_CIU_RFLEVELDET        = 0x632F,   // Power down of the RF level detector
+    PN532_CIU_SIC_CLK_EN        = 0x6330,   // Enables the use of secure IC clock on P34 / SIC_CLK
+    PN532_CIU_COMMAND           = 0x6331,   // Starts and stops the command execution
+    PN532_CIU_COMMIEN           = 0x6332,   // Control bits to enable and disable the passing of interrupt requests
+    PN532_CIU_DIVIEN            = 0x6333,   // Controls bits to enable and disable the passing of interrupt requests
+    PN532_CIU_COMMIRQ           = 0x6334,   // Contains common CIU interrupt request flags
+    PN532_CIU_DIVIRQ            = 0x6335,   // Contains miscellaneous interrupt request flags
+    PN532_CIU_ERROR             = 0x6336,   // Error flags showing the error status of the last command executed
+    PN532_CIU_STATUS1           = 0x6337,   // Contains status flags of the CRC, Interrupt Request System and FIFO buffer
+    PN532_CIU_STATUS2           = 0x6338,   // Contain status flags of the receiver, transmitter and Data Mode Detector
+    PN532_CIU_FIFODATA          = 0x6339,   // In- and output of 64 byte FIFO buffer
+    PN532_CIU_FIFOLEVEL         = 0x633A,   // Indicates the number of bytes stored in the FIFO
+    PN532_CIU_WATERLEVEL        = 0x633B,   // Defines the thresholds for FIFO under- and overflow warning
+    PN532_CIU_CONTROL           = 0x633C,   // Contains miscellaneous control bits
+    PN532_CIU_BITFRAMING        = 0x633D,   // Adjustments for bit oriented frames
+    PN532_CIU_COLL              = 0x633E,   // Defines the first bit collision detected on the RF interface
+};
+
+#endif
@@ -6,6 +6,10 @@
 */
 /**************************************************************************/
 
+#include "PN532_features.h"
+
+#if PN532_FEATURE_EMULATION
+
 #include "emulatetag.h"
 #include "PN532_debug.h"
 
@@ -253,3 +257,5 @@ void EmulateTag::setResponse(responseCommand cmd, uint8_t* buf, uint8_t* sendlen
     break;
   }
 }
+
+#endif // PN532_FEATURE_EMULATION
@@ -13,6 +13,10 @@
 
 #include "PN532.h"
 
+#if !PN532_FEATURE_EMULATION
+#error "emulatetag.h needs PN532_FEATURE_EMULATION"
+#endif
+
 #define NDEF_MAX_LENGTH 128  // altough ndef can handle up to 0xfffe in size, arduino cannot.
 typedef enum {COMMAND_COMPLETE, TAG_NOT_FOUND, FUNCTION_NOT_SUPPORTED, MEMORY_FAILURE, END_OF_FILE_BEFORE_REACHED_LE_BYTES} responseCommand;
 
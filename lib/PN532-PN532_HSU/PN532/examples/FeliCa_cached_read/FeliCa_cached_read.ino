@@ -0,0 +1,73 @@
+/**************************************************************************/
+/*!
+    This example reads the first blocks of a FeliCa Lite-S read-only
+    service through a FelicaCache and prints how long each placement took,
+    polling included, with the number of discovery frames sent.
+
+    The first placement of a card discovers it: Request System Code,
+    Request Service and a binary search for the block count. Placing the
+    same card again skips all of that and goes straight to Read Without
+    Encryption, so the two lines show the time saved per repeat read.
+*/
+/**************************************************************************/
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+#include <felica_cache.h>
+
+PN532_I2C pn532i2c(Wire);
+PN532 nfc(pn532i2c);
+FelicaCache cache(nfc);
+
+const uint16_t services[] = { 0x000B };   // Lite-S: read without encryption
+uint8_t prevIDm[8];
+
+void setup(void) {
+  Serial.begin(115200);
+
+  nfc.begin();
+  if (!nfc.getFirmwareVersion()) {
+    Serial.print("Didn't find PN53x board");
+    while (1); // halt
+  }
+  nfc.setPassiveActivationRetries(0x10);
+  nfc.SAMConfig();
+  cache.setServices(services, 1);
+}
+
+void loop(void) {
+  uint8_t idm[8], pmm[8];
+  uint16_t systemCode;
+  unsigned long start = micros();
+  if (nfc.felica_Polling(0xFFFF, 0x01, idm, pmm, &systemCode, 200) != 1) {
+    memset(prevIDm, 0, sizeof(prevIDm));
+    return;
+  }
+  if (memcmp(idm, prevIDm, 8) == 0) {     // Still on the reader
+    delay(100);
+    return;
+  }
+  memcpy(prevIDm, idm, 8);
+
+  uint32_t misses = cache.misses();
+  const FelicaCardLayout *card = cache.discover(idm, pmm);
+  if (card == 0) {
+    Serial.println("Discovery failed");
+    return;
+  }
+  uint8_t blockData[4][16];
+  uint8_t numBlock = card->blockCounts[0] < 4 ? card->blockCounts[0] : 4;
+  int8_t ret = cache.readBlocks(0, 0, numBlock, blockData);
+  unsigned long elapsed = micros() - start;
+
+  nfc.PrintHex(idm, 8);
+  Serial.print(cache.misses() != misses ? "  discovered: " : "  cached:     ");
+  Serial.print(elapsed); Serial.print(" us, ");
+  Serial.print(cache.lastDiscoveryFrames()); Serial.print(" discovery frames, ");
+  Serial.print(card->blockCounts[0]); Serial.print(" blocks, system codes ");
+  for (uint8_t i = 0; i < card->numSystemCode; i++) {
+    Serial.print(card->systemCodes[i], HEX); Serial.print(' ');
+  }
+  Serial.println(ret == 1 ? "" : "(read failed)");
+}
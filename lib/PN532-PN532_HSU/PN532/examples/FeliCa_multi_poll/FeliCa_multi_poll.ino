@@ -0,0 +1,106 @@
+/**************************************************************************/
+/*!
+    This example tracks several FeliCa cards in the field at once.
+
+    Send 'b' to benchmark: with the cards resting on the reader, it times
+    how long repeated felica_Polling() calls (one time slot, one target)
+    and felica_PollTargets() with 4 time slots take to list every card
+    at least once. Otherwise it polls continuously and prints cards as
+    they arrive and depart.
+
+    tools/felica/poll_model.cpp models the same comparison off the
+    hardware, for 1 to 4 cards and other slot counts.
+*/
+/**************************************************************************/
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+#include <felica_presence.h>
+
+PN532_I2C pn532i2c(Wire);
+PN532 nfc(pn532i2c);
+FelicaPresence presence;
+
+#define TIME_SLOTS  4
+#define MAX_POLLS   200
+
+void arrived(const FelicaPresentCard &card) {
+  Serial.print("Arrived: ");
+  nfc.PrintHex(card.idm, 8);
+}
+
+void departed(const FelicaPresentCard &card) {
+  Serial.print("Departed after "); Serial.print(card.polls); Serial.print(" polls: ");
+  nfc.PrintHex(card.idm, 8);
+}
+
+// Polls until `cards` distinct IDms were listed, returns the time in microseconds
+unsigned long timeToList(uint8_t cards, bool slotted, uint16_t *polls) {
+  uint8_t seen[8][8];
+  uint8_t numSeen = 0;
+  unsigned long start = micros();
+  for (*polls = 0; numSeen < cards && *polls < MAX_POLLS; (*polls)++) {
+    FelicaTarget targets[PN532_MAX_TARGETS];
+    int8_t count;
+    if (slotted) {
+      count = nfc.felica_PollTargets(0xFFFF, 0x00, TIME_SLOTS, targets, PN532_MAX_TARGETS, 100);
+    } else {
+      uint16_t systemCode;
+      count = nfc.felica_Polling(0xFFFF, 0x00, targets[0].idm, targets[0].pmm, &systemCode, 100);
+    }
+    for (int8_t t = 0; t < count; t++) {
+      bool known = false;
+      for (uint8_t i = 0; i < numSeen; i++) {
+        known = known || memcmp(seen[i], targets[t].idm, 8) == 0;
+      }
+      if (!known && numSeen < 8) {
+        memcpy(seen[numSeen++], targets[t].idm, 8);
+      }
+    }
+  }
+  return micros() - start;
+}
+
+void benchmark() {
+  uint8_t cards = presence.count();
+  if (cards == 0) {
+    Serial.println("Place the cards on the reader first");
+    return;
+  }
+  uint16_t polls;
+  unsigned long single = timeToList(cards, false, &polls);
+  Serial.print(cards); Serial.print(" cards, felica_Polling: ");
+  Serial.print(single); Serial.print(" us in "); Serial.print(polls); Serial.print(" polls");
+  Serial.println(polls == MAX_POLLS ? " (gave up)" : "");
+  unsigned long slotted = timeToList(cards, true, &polls);
+  Serial.print(cards); Serial.print(" cards, felica_PollTargets: ");
+  Serial.print(slotted); Serial.print(" us in "); Serial.print(polls); Serial.print(" polls");
+  Serial.println(polls == MAX_POLLS ? " (gave up)" : "");
+}
+
+void setup(void) {
+  Serial.begin(115200);
+
+  nfc.begin();
+  if (!nfc.getFirmwareVersion()) {
+    Serial.print("Didn't find PN53x board");
+    while (1); // halt
+  }
+  nfc.setPassiveActivationRetries(0x01);
+  nfc.SAMConfig();
+
+  // Two cards are listed per poll, so with three or four a present card
+  // can go unlisted for several polls in a row
+  presence.setMissLimit(10);
+  presence.attach(arrived, departed);
+}
+
+void loop(void) {
+  if (Serial.read() == 'b') {
+    benchmark();
+  }
+  FelicaTarget targets[PN532_MAX_TARGETS];
+  int8_t count = nfc.felica_PollTargets(0xFFFF, 0x00, TIME_SLOTS, targets, PN532_MAX_TARGETS, 100);
+  presence.update(targets, count > 0 ? count : 0);
+}
@@ -0,0 +1,70 @@
+/**************************************************************************/
+/*!
+    This example lists two ISO14443A tags at once and measures what it
+    costs to alternate between them:
+
+    - re-list: a full InListPassiveTarget before every read, as needed
+      when only one target is tracked
+    - session: list both once, then InSelect the other target and read
+
+    Place two Type 2 tags (NTAG / Ultralight) on the antenna.
+*/
+/**************************************************************************/
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+
+PN532_I2C pn532i2c(Wire);
+PN532 nfc(pn532i2c);
+
+#define ROUNDS 50
+
+void setup(void) {
+  Serial.begin(115200);
+
+  nfc.begin();
+  if (!nfc.getFirmwareVersion()) {
+    Serial.print("Didn't find PN53x board");
+    while (1); // halt
+  }
+  nfc.SAMConfig();
+  Serial.println("Waiting for two ISO14443A tags");
+}
+
+void loop(void) {
+  uint8_t page[4];
+
+  if (nfc.inListPassiveTargets(PN532_MIFARE_ISO14443A, 2) != 2) {
+    delay(500);
+    return;
+  }
+
+  // Session switching: both targets stay listed
+  unsigned long start = micros();
+  uint8_t errors = 0;
+  for (uint8_t i = 0; i < ROUNDS; i++) {
+    const PN532Target &target = nfc.target(i & 1);
+    if (!nfc.inSelect(target) || !nfc.mifareultralight_ReadPage(target, 0, page)) {
+      errors++;
+    }
+  }
+  unsigned long session = (micros() - start) / ROUNDS;
+
+  // Re-enumeration before every read
+  start = micros();
+  for (uint8_t i = 0; i < ROUNDS; i++) {
+    if (nfc.inListPassiveTargets(PN532_MIFARE_ISO14443A, 2) != 2 || !nfc.mifareultralight_ReadPage(nfc.target(i & 1), 0, page)) {
+      errors++;
+    }
+  }
+  unsigned long relist = (micros() - start) / ROUNDS;
+
+  Serial.print("Switch + read, session: "); Serial.print(session); Serial.print(" us");
+  Serial.print(", re-list: "); Serial.print(relist); Serial.print(" us");
+  Serial.print(", errors: "); Serial.println(errors);
+
+  nfc.inRelease(nfc.target(0));
+  nfc.inRelease(nfc.target(1));
+  delay(1000);
+}
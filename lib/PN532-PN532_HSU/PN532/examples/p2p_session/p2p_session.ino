@@ -0,0 +1,68 @@
+// send NDEF messages to Android over one LLCP link, and time them
+//
+// SNEP::write() activates the PN532, connects, sends one message and disconnects,
+// so the phone has to be re-tapped for each one. Here the session is opened once
+// and every message goes over the same SNEP connection while the phone stays on
+// the reader. Prints the setup time and the latency and throughput per batch.
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <snep.h>
+#include <NdefMessage.h>
+
+#define MESSAGES 20
+
+PN532_I2C pn532i2c(Wire);
+LLCPSession session(pn532i2c);
+SNEPClient snep(session);
+uint8_t ndefBuf[LLCP_SESSION_MIU - 6];
+
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println("-------Peer to Peer session--------");
+}
+
+void loop()
+{
+    Serial.println("Put a phone on the reader");
+    if (session.open(5000) <= 0) {
+        return;
+    }
+
+    NdefMessage message = NdefMessage();
+    message.addUriRecord("http://www.seeedstudio.com");
+    int messageSize = message.getEncodedSize();
+    message.encode(ndefBuf);
+
+    unsigned long start = micros();
+    int sent = 0;
+    for (int i = 0; i < MESSAGES; i++) {
+        if (snep.put(ndefBuf, messageSize) <= 0) {
+            break;
+        }
+        sent++;
+    }
+    unsigned long elapsed = micros() - start;
+
+    Serial.print("setup ");
+    Serial.print(session.setupMicros() / 1000.0);
+    Serial.print(" ms, ");
+    Serial.print(sent);
+    Serial.print(" messages in ");
+    Serial.print(elapsed / 1000.0);
+    Serial.print(" ms, avg ");
+    Serial.print(session.avgLatency() / 1000.0);
+    Serial.print(" ms, max ");
+    Serial.print(session.maxLatency() / 1000.0);
+    Serial.print(" ms, ");
+    Serial.print(elapsed ? sent * messageSize * 1000000.0 / elapsed : 0);
+    Serial.print(" B/s, turns ");
+    Serial.print(session.turns());
+    Serial.print(" (idle ");
+    Serial.print(session.idleTurns());
+    Serial.println(")");
+
+    session.close();
+    delay(3000);
+}
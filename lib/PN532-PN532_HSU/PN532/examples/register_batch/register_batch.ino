@@ -0,0 +1,68 @@
+/**************************************************************************/
+/*!
+    This example applies a 12-register RF profile to the CIU twice, one
+    register per command and as a batch, and prints how long each took.
+    It then raises the receiver gain with a read-modify-write that keeps
+    the other RFCfg bits.
+
+    The profile is read from the PN532 first, so applying it leaves the
+    RF front end unchanged.
+*/
+/**************************************************************************/
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+
+PN532_I2C pn532i2c(Wire);
+PN532 nfc(pn532i2c);
+
+const PN532Register profileRegs[] = {
+  PN532_CIU_TXMODE, PN532_CIU_RXMODE, PN532_CIU_TXCONTROL, PN532_CIU_TXAUTO,
+  PN532_CIU_RXTHRESHOLD, PN532_CIU_DEMOD, PN532_CIU_MODWIDTH, PN532_CIU_RFCFG,
+  PN532_CIU_GSNON, PN532_CIU_CWGSP, PN532_CIU_MODGSP, PN532_CIU_GSNOFF
+};
+#define PROFILE_SIZE (sizeof(profileRegs) / sizeof(profileRegs[0]))
+uint8_t profileValues[PROFILE_SIZE];
+
+void setup(void) {
+  Serial.begin(115200);
+
+  nfc.begin();
+  if (!nfc.getFirmwareVersion()) {
+    Serial.print("Didn't find PN53x board");
+    while (1); // halt
+  }
+  nfc.SAMConfig();
+
+  if (!nfc.readRegisters(profileRegs, PROFILE_SIZE, profileValues)) {
+    Serial.println("Reading the profile failed");
+    return;
+  }
+
+  unsigned long start = micros();
+  for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+    nfc.writeRegister(profileRegs[i], profileValues[i]);
+  }
+  unsigned long single = micros() - start;
+
+  start = micros();
+  bool ok = nfc.writeRegisters(profileRegs, profileValues, PROFILE_SIZE);
+  unsigned long batched = micros() - start;
+
+  Serial.print("Profile of "); Serial.print(PROFILE_SIZE); Serial.print(" registers, one by one: ");
+  Serial.print(single); Serial.print(" us, batched: "); Serial.print(batched);
+  Serial.println(ok ? " us" : " us (failed)");
+
+  // RxGain is bits 6..4 of RFCfg, 0x70 is the maximum of 48 dB
+  const PN532Register gainReg[] = { PN532_CIU_RFCFG };
+  const uint8_t gainMask[] = { 0x70 };
+  const uint8_t gainValue[] = { 0x70 };
+  uint8_t rfcfg;
+  if (nfc.modifyRegisters(gainReg, gainMask, gainValue, 1) && nfc.readRegisters(gainReg, 1, &rfcfg)) {
+    Serial.print("RFCfg: 0x"); Serial.println(rfcfg, HEX);
+  }
+}
+
+void loop(void) {
+}
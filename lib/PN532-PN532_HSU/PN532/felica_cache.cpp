@@ -0,0 +1,244 @@
+/**************************************************************************/
+/*!
+    @file     felica_cache.cpp
+    @brief    Per-IDm cache of FeliCa system codes, service key versions and
+              block counts
+*/
+/**************************************************************************/
+
+#include "PN532_features.h"
+
+#if PN532_FEATURE_FELICA
+
+#include "felica_cache.h"
+#include "PN532_debug.h"
+
+FelicaCache::FelicaCache(PN532 &nfc)
+  : _nfc(nfc), _current(0), _numService(0), _matchPmm(false), _clock(0), _hits(0), _pmmHits(0), _misses(0),
+    _lastFrames(0)
+{
+  clear();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the services discover() probes and readBlocks() reads
+
+    @param  serviceCodes  Service codes, e.g. 0x000B for the FeliCa Lite-S
+                          read-only service
+    @param  count         Number of services, at most FELICA_CACHE_MAX_SERVICES
+    @return               false if there are too many services
+*/
+/**************************************************************************/
+bool FelicaCache::setServices(const uint16_t *serviceCodes, uint8_t count)
+{
+  if (count > FELICA_CACHE_MAX_SERVICES) {
+    return false;
+  }
+  memcpy(_serviceCodes, serviceCodes, count * sizeof(uint16_t));
+  _numService = count;
+  clear();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Looks up the card found by the last felica_Polling(), discovering
+            it on a miss
+
+    Must be called while the card is still the inlisted target, since the
+    discovery commands are addressed to it.
+
+    @param  idm  IDm returned by felica_Polling()
+    @param  pmm  PMm returned by felica_Polling()
+    @return      The card's layout, 0 if discovery failed
+*/
+/**************************************************************************/
+const FelicaCardLayout *FelicaCache::discover(const uint8_t *idm, const uint8_t *pmm)
+{
+  _lastFrames = 0;
+  FelicaCardLayout *card = find(idm, false);
+  if (card) {
+    _hits++;
+  } else if (_matchPmm && (card = find(pmm, true)) != 0) {
+    FelicaCardLayout layout = *card;
+    card = replaceable();
+    *card = layout;
+    memcpy(card->idm, idm, 8);
+    _pmmHits++;
+  } else {
+    _misses++;
+    card = replaceable();
+    memcpy(card->idm, idm, 8);
+    memcpy(card->pmm, pmm, 8);
+    if (!probe(*card)) {
+      card->lastUsed = 0;
+      _current = 0;
+      return 0;
+    }
+  }
+  card->lastUsed = ++_clock;
+  _current = card;
+  return card;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads blocks of one service from the current card, without any
+            discovery frames
+
+    A failed read forgets the card, so its next placement discovers it again
+    in case its layout changed.
+
+    @param  service     Index into the services given to setServices()
+    @param  firstBlock  First block number
+    @param  numBlock    Number of blocks, at most FELICA_READ_MAX_BLOCK_NUM
+    @param  blockData   Block data
+    @return             = 1: Success
+                        = 0: Blocks beyond the card's block count, nothing sent
+                        < 0: error
+*/
+/**************************************************************************/
+int8_t FelicaCache::readBlocks(uint8_t service, uint8_t firstBlock, uint8_t numBlock, uint8_t blockData[][16])
+{
+  if (_current == 0 || service >= _numService || numBlock > FELICA_READ_MAX_BLOCK_NUM) {
+    return -1;
+  }
+  if ((uint16_t)firstBlock + numBlock > _current->blockCounts[service]) {
+    return 0;
+  }
+
+  uint16_t blockList[FELICA_READ_MAX_BLOCK_NUM];
+  for (uint8_t i = 0; i < numBlock; i++) {
+    blockList[i] = 0x8000 | (uint8_t)(firstBlock + i);
+  }
+  int8_t ret = _nfc.felica_ReadWithoutEncryption(1, &_serviceCodes[service], numBlock, blockList, blockData);
+  if (ret != 1) {
+    _current->lastUsed = 0;
+    _current = 0;
+  }
+  return ret;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drops a card, e.g. after the application rewrote its services
+*/
+/**************************************************************************/
+void FelicaCache::forget(const uint8_t *idm)
+{
+  FelicaCardLayout *card = find(idm, false);
+  if (card) {
+    card->lastUsed = 0;
+    if (card == _current) {
+      _current = 0;
+    }
+  }
+}
+
+void FelicaCache::clear()
+{
+  for (uint8_t i = 0; i < FELICA_CACHE_CARDS; i++) {
+    _cards[i].lastUsed = 0;
+  }
+  _current = 0;
+}
+
+FelicaCardLayout *FelicaCache::find(const uint8_t *id, bool byPmm)
+{
+  for (uint8_t i = 0; i < FELICA_CACHE_CARDS; i++) {
+    if (_cards[i].lastUsed && memcmp(byPmm ? _cards[i].pmm : _cards[i].idm, id, 8) == 0) {
+      return &_cards[i];
+    }
+  }
+  return 0;
+}
+
+// A free entry, or the least recently used one
+FelicaCardLayout *FelicaCache::replaceable()
+{
+  FelicaCardLayout *oldest = &_cards[0];
+  for (uint8_t i = 0; i < FELICA_CACHE_CARDS; i++) {
+    if (_cards[i].lastUsed < oldest->lastUsed) {
+      oldest = &_cards[i];
+    }
+  }
+  return oldest;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Discovers system codes, key versions and block counts of the
+            inlisted card
+*/
+/**************************************************************************/
+bool FelicaCache::probe(FelicaCardLayout &card)
+{
+  uint16_t systemCodes[16];
+  uint8_t numSystemCode;
+  _lastFrames++;
+  if (_nfc.felica_RequestSystemCode(&numSystemCode, systemCodes) != 1) {
+    DMSG("Request System Code failed\n");
+    return false;
+  }
+  card.numSystemCode = numSystemCode < FELICA_CACHE_MAX_SYSTEM_CODES ? numSystemCode : FELICA_CACHE_MAX_SYSTEM_CODES;
+  memcpy(card.systemCodes, systemCodes, card.numSystemCode * sizeof(uint16_t));
+
+  if (_numService == 0) {
+    return true;
+  }
+  _lastFrames++;
+  if (_nfc.felica_RequestService(_numService, _serviceCodes, card.keyVersions) != 1) {
+    DMSG("Request Service failed\n");
+    return false;
+  }
+  for (uint8_t i = 0; i < _numService; i++) {
+    int16_t count = (card.keyVersions[i] == FELICA_KEY_VERSION_MISSING) ? 0 : blockCount(i);
+    if (count < 0) {
+      DMSG("Block count probe failed\n");
+      return false;
+    }
+    card.blockCounts[i] = count;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of blocks of a service readable without encryption
+
+    Binary search with one-block reads, 1 + log2(FELICA_CACHE_MAX_BLOCKS)
+    frames. The card answers a read past the last block with an error
+    status flag (-5); any other failure is a lost frame, and guessing a
+    count from it would cache a truncated layout.
+
+    @return  Number of blocks, or < 0 if a frame was lost
+*/
+/**************************************************************************/
+int16_t FelicaCache::blockCount(uint8_t service)
+{
+  uint8_t data[1][16];
+  uint16_t block = 0x8000;
+  _lastFrames++;
+  int8_t status = _nfc.felica_ReadWithoutEncryption(1, &_serviceCodes[service], 1, &block, data);
+  if (status != 1) {
+    return (status == -5) ? 0 : -1;
+  }
+  uint16_t readable = 0, unreadable = FELICA_CACHE_MAX_BLOCKS;
+  while (unreadable - readable > 1) {
+    uint16_t middle = (readable + unreadable) / 2;
+    block = 0x8000 | middle;
+    _lastFrames++;
+    status = _nfc.felica_ReadWithoutEncryption(1, &_serviceCodes[service], 1, &block, data);
+    if (status == 1) {
+      readable = middle;
+    } else if (status == -5) {
+      unreadable = middle;
+    } else {
+      return -1;
+    }
+  }
+  return readable + 1;
+}
+
+#endif
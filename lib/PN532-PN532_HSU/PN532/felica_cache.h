@@ -0,0 +1,85 @@
+/**************************************************************************/
+/*!
+    @file     felica_cache.h
+    @brief    Per-IDm cache of FeliCa system codes, service key versions and
+              block counts
+
+    Discovering a card costs a Request System Code, a Request Service and a
+    binary search of Read Without Encryption frames per service for the block
+    count. The result is kept in a small LRU table keyed by IDm, so a card
+    that comes back is read straight away with no discovery frames at all.
+*/
+/**************************************************************************/
+
+#ifndef __FELICA_CACHE_H__
+#define __FELICA_CACHE_H__
+
+#include "PN532.h"
+
+#if !PN532_FEATURE_FELICA
+#error "felica_cache.h needs PN532_FEATURE_FELICA"
+#endif
+
+// Cards remembered, the least recently used one is replaced
+#ifndef FELICA_CACHE_CARDS
+#define FELICA_CACHE_CARDS                  (8)
+#endif
+#define FELICA_CACHE_MAX_SYSTEM_CODES       (4)
+#define FELICA_CACHE_MAX_SERVICES           (4)
+// Block counts are probed up to this many blocks (2-byte block list elements reach 256)
+#define FELICA_CACHE_MAX_BLOCKS             (128)
+#define FELICA_KEY_VERSION_MISSING          (0xFFFF)
+
+// What discovery learned about one card
+struct FelicaCardLayout {
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    uint8_t numSystemCode;
+    uint16_t systemCodes[FELICA_CACHE_MAX_SYSTEM_CODES];
+    uint16_t keyVersions[FELICA_CACHE_MAX_SERVICES];  // FELICA_KEY_VERSION_MISSING if the card lacks the service
+    uint8_t blockCounts[FELICA_CACHE_MAX_SERVICES];   // Readable without encryption, 0 if none
+    uint32_t lastUsed;                                // 0 marks a free entry
+};
+
+class FelicaCache
+{
+public:
+    FelicaCache(PN532 &nfc);
+
+    // Services the application reads, in the order readBlocks() indexes them. Clears the cache.
+    bool setServices(const uint16_t *serviceCodes, uint8_t count);
+    // Reuse the layout of a cached card with the same PMm for a new IDm, for venues
+    // that issue a single card stock. Saves the discovery of every first placement.
+    void setMatchPmm(bool match) { _matchPmm = match; }
+
+    const FelicaCardLayout *discover(const uint8_t *idm, const uint8_t *pmm);
+    int8_t readBlocks(uint8_t service, uint8_t firstBlock, uint8_t numBlock, uint8_t blockData[][16]);
+    void forget(const uint8_t *idm);
+    void clear();
+
+    uint32_t hits() const { return _hits; }
+    uint32_t pmmHits() const { return _pmmHits; }
+    uint32_t misses() const { return _misses; }
+    // Frames sent by the last discover(), 0 on a hit
+    uint8_t lastDiscoveryFrames() const { return _lastFrames; }
+
+private:
+    FelicaCardLayout *find(const uint8_t *idm, bool byPmm);
+    FelicaCardLayout *replaceable();
+    bool probe(FelicaCardLayout &card);
+    int16_t blockCount(uint8_t service);
+
+    PN532 &_nfc;
+    FelicaCardLayout _cards[FELICA_CACHE_CARDS];
+    FelicaCardLayout *_current;
+    uint16_t _serviceCodes[FELICA_CACHE_MAX_SERVICES];
+    uint8_t _numService;
+    bool _matchPmm;
+    uint32_t _clock;
+    uint32_t _hits;
+    uint32_t _pmmHits;
+    uint32_t _misses;
+    uint8_t _lastFrames;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**************************************************************************/
+/*!
+    @file     felica_presence.cpp
+    @brief    Tracks which FeliCa cards are in the field across polls
+*/
+/**************************************************************************/
+
+#include "PN532_features.h"
+
+#if PN532_FEATURE_FELICA
+
+#include "felica_presence.h"
+#include "PN532_debug.h"
+
+/**************************************************************************/
+/*!
+    @brief  Records the cards listed by one poll
+
+    @param  targets  Cards returned by felica_PollTargets()
+    @param  count    Its return value, 0 if the poll found nothing
+    @return          Number of cards that arrived or departed
+*/
+/**************************************************************************/
+uint8_t FelicaPresence::update(const FelicaTarget *targets, uint8_t count)
+{
+  uint8_t changes = 0;
+  _polls++;
+  for (uint8_t i = 0; i < FELICA_PRESENCE_CARDS; i++) {
+    if (_cards[i].present) {
+      _cards[i].missed++;
+      _cards[i].polls++;
+    }
+  }
+
+  for (uint8_t t = 0; t < count; t++) {
+    FelicaPresentCard *unused = 0, *card = 0;
+    for (uint8_t i = 0; i < FELICA_PRESENCE_CARDS && card == 0; i++) {
+      if (!_cards[i].present) {
+        if (unused == 0) {
+          unused = &_cards[i];
+        }
+      } else if (memcmp(_cards[i].idm, targets[t].idm, 8) == 0) {
+        card = &_cards[i];
+      }
+    }
+    if (card) {
+      card->missed = 0;
+      continue;
+    }
+    if (unused == 0) {
+      DMSG("Too many FeliCa cards to track\n");
+      continue;
+    }
+    memcpy(unused->idm, targets[t].idm, 8);
+    memcpy(unused->pmm, targets[t].pmm, 8);
+    unused->missed = 0;
+    unused->polls = 0;
+    unused->present = true;
+    _count++;
+    changes++;
+    if (_arrived) {
+      _arrived(*unused);
+    }
+  }
+
+  for (uint8_t i = 0; i < FELICA_PRESENCE_CARDS; i++) {
+    if (_cards[i].present && _cards[i].missed >= _missLimit) {
+      _cards[i].present = false;
+      _count--;
+      changes++;
+      if (_departed) {
+        _departed(_cards[i]);
+      }
+    }
+  }
+  return changes;
+}
+
+bool FelicaPresence::present(const uint8_t *idm) const
+{
+  for (uint8_t i = 0; i < FELICA_PRESENCE_CARDS; i++) {
+    if (_cards[i].present && memcmp(_cards[i].idm, idm, 8) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FelicaPresence::clear()
+{
+  for (uint8_t i = 0; i < FELICA_PRESENCE_CARDS; i++) {
+    _cards[i].present = false;
+  }
+  _count = 0;
+}
+
+#endif
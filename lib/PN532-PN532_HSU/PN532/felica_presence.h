@@ -0,0 +1,68 @@
+/**************************************************************************/
+/*!
+    @file     felica_presence.h
+    @brief    Tracks which FeliCa cards are in the field across polls
+
+    Feed it the cards of each felica_PollTargets(). A card arrives the
+    first time it is listed and departs after missLimit polls in a row
+    without it. With more cards in the field than the PN532 lists per poll,
+    a present card is not listed by every poll, so the limit has to cover
+    a few polls.
+*/
+/**************************************************************************/
+
+#ifndef __FELICA_PRESENCE_H__
+#define __FELICA_PRESENCE_H__
+
+#include "PN532.h"
+
+#if !PN532_FEATURE_FELICA
+#error "felica_presence.h needs PN532_FEATURE_FELICA"
+#endif
+
+#ifndef FELICA_PRESENCE_CARDS
+#define FELICA_PRESENCE_CARDS               (8)
+#endif
+#define FELICA_PRESENCE_MISS_LIMIT          (4)
+
+struct FelicaPresentCard {
+    uint8_t idm[8];
+    uint8_t pmm[8];
+    uint8_t missed;     // Polls in a row without the card
+    bool present;
+    uint32_t polls;     // Polls since the card arrived
+};
+
+class FelicaPresence
+{
+public:
+    FelicaPresence() : _missLimit(FELICA_PRESENCE_MISS_LIMIT), _count(0), _polls(0), _arrived(0), _departed(0) {
+        clear();
+    }
+
+    void setMissLimit(uint8_t polls) { _missLimit = polls ? polls : 1; }
+    void attach(void (*arrived)(const FelicaPresentCard &card), void (*departed)(const FelicaPresentCard &card)) {
+        _arrived = arrived;
+        _departed = departed;
+    }
+
+    uint8_t update(const FelicaTarget *targets, uint8_t count);
+    void clear();
+
+    // Cards present now
+    uint8_t count() const { return _count; }
+    bool present(const uint8_t *idm) const;
+    // Entry 0 .. FELICA_PRESENCE_CARDS - 1, in use if its present flag is set
+    const FelicaPresentCard &card(uint8_t index) const { return _cards[index]; }
+    uint32_t polls() const { return _polls; }
+
+private:
+    FelicaPresentCard _cards[FELICA_PRESENCE_CARDS];
+    uint8_t _missLimit;
+    uint8_t _count;
+    uint32_t _polls;
+    void (*_arrived)(const FelicaPresentCard &card);
+    void (*_departed)(const FelicaPresentCard &card);
+};
+
+#endif
@@ -1,34 +1,13 @@
 
+#include "PN532_features.h"
+
+#if PN532_FEATURE_P2P
+
 #include "llcp.h"
 #include "PN532_debug.h"
 
-// LLCP PDU Type Values
-#define PDU_SYMM    0x00
-#define PDU_PAX     0x01
-#define PDU_CONNECT 0x04
-#define PDU_DISC    0x05
-#define PDU_CC      0x06
-#define PDU_DM      0x07
-#define PDU_I       0x0c
-#define PDU_RR      0x0d
-
 uint8_t LLCP::SYMM_PDU[2] = {0, 0};
 
-inline uint8_t getPType(const uint8_t *buf)
-{
-    return ((buf[0] & 0x3) << 2) + (buf[1] >> 6);
-}
-
-inline uint8_t getSSAP(const uint8_t *buf)
-{
-    return  buf[1] & 0x3f;
-}
-
-inline uint8_t getDSAP(const uint8_t *buf)
-{
-    return buf[0] >> 2;
-}
-
 int8_t LLCP::activate(uint16_t timeout)
 {
     return link.activateAsTarget(timeout);
@@ -307,3 +286,5 @@ int16_t LLCP::read(uint8_t *buf, uint8_t length)
 
     return len;
 }
+
+#endif // PN532_FEATURE_P2P
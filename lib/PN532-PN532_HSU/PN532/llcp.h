@@ -8,6 +8,34 @@
 #define LLCP_DEFAULT_DSAP     0x04
 #define LLCP_DEFAULT_SSAP     0x20
 
+// LLCP PDU Type Values
+#define PDU_SYMM    0x00
+#define PDU_PAX     0x01
+#define PDU_AGF     0x02
+#define PDU_CONNECT 0x04
+#define PDU_DISC    0x05
+#define PDU_CC      0x06
+#define PDU_DM      0x07
+#define PDU_FRMR    0x08
+#define PDU_I       0x0c
+#define PDU_RR      0x0d
+#define PDU_RNR     0x0e
+
+static inline uint8_t getPType(const uint8_t *buf)
+{
+    return ((buf[0] & 0x3) << 2) + (buf[1] >> 6);
+}
+
+static inline uint8_t getSSAP(const uint8_t *buf)
+{
+    return  buf[1] & 0x3f;
+}
+
+static inline uint8_t getDSAP(const uint8_t *buf)
+{
+    return buf[0] >> 2;
+}
+
 class LLCP {
 public:
 	LLCP(PN532Interface &interface) : link(interface) {
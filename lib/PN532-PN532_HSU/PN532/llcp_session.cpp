@@ -0,0 +1,413 @@
+#include "PN532_features.h"
+
+#if PN532_FEATURE_P2P
+
+#include "llcp_session.h"
+#include "PN532_debug.h"
+
+#define DM_REASON_DISCONNECTED  0x00
+#define DM_REASON_NO_SERVICE    0x02
+#define PARAM_SN                0x06
+
+LLCPSession::LLCPSession(PN532Interface &interface)
+    : link(interface), isActive(false), refuseDsap(0), refuseSsap(0), openedMicros(0), setupTime(0),
+      turnCount(0), symmCount(0), ackCount(0), ackLast(0), ackMax(0), ackTotal(0)
+{
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        links[i].listening = false;
+        links[i].localSap = LLCP_SESSION_FIRST_SAP + i;
+        links[i].serviceName = 0;
+        reset(links[i]);
+    }
+}
+
+int8_t LLCPSession::open(uint16_t timeout)
+{
+    close();
+    openedMicros = micros();
+    setupTime = 0;
+    int8_t status = link.activateAsTarget(timeout);
+    isActive = status > 0;
+    return status;
+}
+
+/**
+ * Drops every data link connection. Listening links listen again after the next open().
+ */
+void LLCPSession::close()
+{
+    isActive = false;
+    refuseDsap = 0;
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        reset(links[i]);
+    }
+}
+
+int8_t LLCPSession::listen(uint8_t sap, const char *serviceName)
+{
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        if (links[i].state == LLCP_LINK_CLOSED && !links[i].listening) {
+            links[i].listening = true;
+            links[i].localSap = sap;
+            links[i].serviceName = serviceName;
+            reset(links[i]);
+            return i;
+        }
+    }
+    return -1;
+}
+
+int8_t LLCPSession::connect(const char *serviceName)
+{
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        Link &l = links[i];
+        if (l.state == LLCP_LINK_CLOSED && !l.listening) {
+            reset(l);
+            l.localSap = LLCP_SESSION_FIRST_SAP + i;
+            l.serviceName = serviceName;
+            // SNEP has a well-known SAP, anything else is resolved by the SDP
+            l.remoteSap = strcmp(serviceName, "urn:nfc:sn:snep") == 0 ? LLCP_SAP_SNEP : LLCP_SAP_SDP;
+            l.state = LLCP_LINK_CONNECTING;
+            l.connectDue = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool LLCPSession::disconnect(uint8_t index)
+{
+    Link &l = links[index];
+    if (l.state != LLCP_LINK_CONNECTED) {
+        return false;
+    }
+    l.state = LLCP_LINK_DISCONNECTING;
+    l.discDue = true;
+    return true;
+}
+
+void LLCPSession::release(uint8_t index)
+{
+    links[index].listening = false;
+    reset(links[index]);
+}
+
+bool LLCPSession::send(uint8_t index, const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8_t blen)
+{
+    Link &l = links[index];
+    if (l.state != LLCP_LINK_CONNECTED || l.txLength || hlen + blen == 0 || hlen + blen > LLCP_SESSION_MIU) {
+        return false;
+    }
+    memcpy(l.tx, header, hlen);
+    if (blen) {
+        memcpy(l.tx + hlen, body, blen);
+    }
+    l.txLength = hlen + blen;
+    l.queuedMicros = micros();
+    return true;
+}
+
+int16_t LLCPSession::receive(uint8_t index, uint8_t *buf, uint8_t len)
+{
+    Link &l = links[index];
+    if (l.rxLength == 0) {
+        return 0;
+    }
+    if (l.rxLength > len) {
+        return -1;
+    }
+    uint8_t length = l.rxLength;
+    memcpy(buf, l.rx, length);
+    l.rxLength = 0;
+    l.nr = (l.nr + 1) & 0x0F;
+    l.ackDue = true;
+    return length;
+}
+
+int8_t LLCPSession::turn()
+{
+    if (!isActive) {
+        return -1;
+    }
+    int16_t status = link.read(frame, sizeof(frame));
+    if (2 > status) {
+        DMSG("LLCP link lost\n");
+        close();
+        return -1;
+    }
+    turnCount++;
+
+    uint8_t type = getPType(frame);
+    if (PDU_AGF == type) {
+        for (int16_t offset = 2; offset + 2 <= status; ) {
+            uint16_t length = (frame[offset] << 8) + frame[offset + 1];
+            if (offset + 2 + length > status) {
+                break;
+            }
+            handle(frame + offset + 2, length);
+            offset += 2 + length;
+        }
+    } else {
+        handle(frame, status);
+    }
+
+    // Each PDU due goes into the frame after a 2-byte AGF length, leaving room for the AGF header
+    uint8_t length = 2, count = 0;
+    if (refuseDsap && (size_t)(length + 5) <= sizeof(frame)) {
+        uint8_t *pdu = frame + length + 2;
+        pdu[0] = (refuseDsap << 2) + (PDU_DM >> 2);
+        pdu[1] = ((PDU_DM & 0x3) << 6) + refuseSsap;
+        pdu[2] = DM_REASON_NO_SERVICE;
+        frame[length] = 0;
+        frame[length + 1] = 3;
+        length += 5;
+        count++;
+        refuseDsap = 0;
+    }
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        uint8_t pduLength;
+        while ((size_t)(length + 2) < sizeof(frame) && (pduLength = nextPdu(links[i], frame + length + 2, sizeof(frame) - length - 2))) {
+            frame[length] = 0;
+            frame[length + 1] = pduLength;
+            length += 2 + pduLength;
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        if (PDU_SYMM == type) {
+            symmCount++;
+        }
+        frame[0] = (0 << 2) + (PDU_SYMM >> 2);
+        frame[1] = 0;
+        length = 2;
+    } else if (count == 1) {
+        length = frame[3];
+        memmove(frame, frame + 4, length);
+    } else {
+        frame[0] = (0 << 2) + (PDU_AGF >> 2);
+        frame[1] = (PDU_AGF & 0x3) << 6;
+    }
+    if (!link.write(frame, length)) {
+        close();
+        return -2;
+    }
+    return 1;
+}
+
+int8_t LLCPSession::wait(uint8_t index, uint8_t until, uint16_t timeout)
+{
+    Link &l = links[index];
+    unsigned long start = millis();
+    while (1) {
+        if (LLCP_UNTIL_CONNECTED == until) {
+            if (l.state == LLCP_LINK_CONNECTED) {
+                return 1;
+            }
+            if (l.state != LLCP_LINK_CONNECTING && l.state != LLCP_LINK_LISTENING) {
+                return -3;
+            }
+        } else {
+            if ((LLCP_UNTIL_SENT == until && l.txLength == 0 && !l.unacked) || (LLCP_UNTIL_DATA == until && l.rxLength)) {
+                return 1;
+            }
+            if (l.state != LLCP_LINK_CONNECTED) {
+                return -3;
+            }
+        }
+        if (timeout && millis() - start >= timeout) {
+            return 0;
+        }
+        if (0 > turn()) {
+            return -1;
+        }
+    }
+}
+
+void LLCPSession::handle(const uint8_t *pdu, uint8_t length)
+{
+    if (length < 2) {
+        return;
+    }
+    uint8_t type = getPType(pdu);
+    uint8_t dsap = getDSAP(pdu);
+    uint8_t ssap = getSSAP(pdu);
+    Link *l = find(dsap);
+
+    switch (type) {
+    case PDU_CONNECT:
+        if (dsap == LLCP_SAP_SDP) {
+            // Connect by name: the SN parameter picks the listening link
+            l = 0;
+            for (uint8_t offset = 2; l == 0 && offset + 2 <= length; offset += 2 + pdu[offset + 1]) {
+                if (pdu[offset] != PARAM_SN || offset + 2 + pdu[offset + 1] > length) {
+                    continue;
+                }
+                for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+                    const char *name = links[i].serviceName;
+                    if (links[i].state == LLCP_LINK_LISTENING && name && strlen(name) == pdu[offset + 1] &&
+                        memcmp(name, pdu + offset + 2, pdu[offset + 1]) == 0) {
+                        l = &links[i];
+                        break;
+                    }
+                }
+            }
+        }
+        if (l == 0 || l->state != LLCP_LINK_LISTENING) {
+            refuseDsap = ssap;
+            refuseSsap = dsap;
+            return;
+        }
+        l->remoteSap = ssap;
+        l->state = LLCP_LINK_CONNECTED;
+        l->ccDue = true;
+        if (setupTime == 0) {
+            setupTime = micros() - openedMicros;
+        }
+        return;
+    case PDU_CC:
+        if (l && l->state == LLCP_LINK_CONNECTING) {
+            l->remoteSap = ssap;
+            l->state = LLCP_LINK_CONNECTED;
+            if (setupTime == 0) {
+                setupTime = micros() - openedMicros;
+            }
+        }
+        return;
+    }
+
+    if (l == 0 || l->remoteSap != ssap) {
+        return;
+    }
+    switch (type) {
+    case PDU_DM:
+        if (l->state == LLCP_LINK_CONNECTING || l->state == LLCP_LINK_DISCONNECTING) {
+            reset(*l);
+        }
+        break;
+    case PDU_DISC:
+        reset(*l);
+        l->remoteSap = ssap;
+        l->dmDue = true;
+        break;
+    case PDU_I:
+        if (length < 3 || l->state != LLCP_LINK_CONNECTED) {
+            break;
+        }
+        acknowledge(*l, pdu[2] & 0x0F);
+        if ((pdu[2] >> 4) != l->nr || l->rxLength || length - 3 > LLCP_SESSION_MIU) {
+            DMSG("I PDU out of sequence or not taken\n");
+            break;
+        }
+        memcpy(l->rx, pdu + 3, length - 3);
+        l->rxLength = length - 3;
+        break;
+    case PDU_RR:
+    case PDU_RNR:
+        if (length >= 3) {
+            acknowledge(*l, pdu[2] & 0x0F);
+            l->remoteBusy = PDU_RNR == type;
+        }
+        break;
+    }
+}
+
+void LLCPSession::acknowledge(Link &l, uint8_t nr)
+{
+    if (!l.unacked || nr != l.ns) {
+        return;
+    }
+    l.unacked = false;
+    uint32_t latency = micros() - l.queuedMicros;
+    ackCount++;
+    ackLast = latency;
+    ackTotal += latency;
+    if (latency > ackMax) {
+        ackMax = latency;
+    }
+}
+
+/**
+ * The next PDU due on a link: connection control first, then a queued SDU, which also
+ * acknowledges what was received, then an RR if only the acknowledgement is due.
+ */
+uint8_t LLCPSession::nextPdu(Link &l, uint8_t *out, uint8_t room)
+{
+    uint8_t type;
+    if (room < 3) {
+        return 0;
+    }
+    if (l.connectDue) {
+        uint8_t nameLength = strlen(l.serviceName);
+        if (room < 4 + nameLength) {
+            return 0;
+        }
+        l.connectDue = false;
+        out[0] = (l.remoteSap << 2) + (PDU_CONNECT >> 2);
+        out[1] = ((PDU_CONNECT & 0x3) << 6) + l.localSap;
+        out[2] = PARAM_SN;
+        out[3] = nameLength;
+        memcpy(out + 4, l.serviceName, nameLength);
+        return 4 + nameLength;
+    }
+    if (l.dmDue) {
+        l.dmDue = false;
+        out[0] = (l.remoteSap << 2) + (PDU_DM >> 2);
+        out[1] = ((PDU_DM & 0x3) << 6) + l.localSap;
+        out[2] = DM_REASON_DISCONNECTED;
+        return 3;
+    }
+    if (l.ccDue) {
+        type = PDU_CC;
+        l.ccDue = false;
+    } else if (l.discDue) {
+        type = PDU_DISC;
+        l.discDue = false;
+    } else if (l.state == LLCP_LINK_CONNECTED && l.txLength && !l.unacked && !l.remoteBusy && room >= 3 + l.txLength) {
+        out[0] = (l.remoteSap << 2) + (PDU_I >> 2);
+        out[1] = ((PDU_I & 0x3) << 6) + l.localSap;
+        out[2] = (l.ns << 4) + l.nr;
+        memcpy(out + 3, l.tx, l.txLength);
+        uint8_t length = 3 + l.txLength;
+        l.ns = (l.ns + 1) & 0x0F;
+        l.unacked = true;
+        l.ackDue = false;
+        l.txLength = 0;
+        return length;
+    } else if (l.ackDue) {
+        out[0] = (l.remoteSap << 2) + (PDU_RR >> 2);
+        out[1] = ((PDU_RR & 0x3) << 6) + l.localSap;
+        out[2] = l.nr;
+        l.ackDue = false;
+        return 3;
+    } else {
+        return 0;
+    }
+    out[0] = (l.remoteSap << 2) + (type >> 2);
+    out[1] = ((type & 0x3) << 6) + l.localSap;
+    return 2;
+}
+
+LLCPSession::Link *LLCPSession::find(uint8_t localSap)
+{
+    for (uint8_t i = 0; i < LLCP_SESSION_LINKS; i++) {
+        if (links[i].localSap == localSap && (links[i].state != LLCP_LINK_CLOSED || links[i].dmDue)) {
+            return &links[i];
+        }
+    }
+    return 0;
+}
+
+void LLCPSession::reset(Link &l)
+{
+    l.state = l.listening ? LLCP_LINK_LISTENING : LLCP_LINK_CLOSED;
+    l.ns = 0;
+    l.nr = 0;
+    l.connectDue = l.ccDue = l.dmDue = l.discDue = l.ackDue = false;
+    l.unacked = false;
+    l.remoteBusy = false;
+    l.txLength = 0;
+    l.rxLength = 0;
+}
+
+#endif // PN532_FEATURE_P2P
@@ -0,0 +1,133 @@
+#ifndef __LLCP_SESSION_H__
+#define __LLCP_SESSION_H__
+
+#include "llcp.h"
+
+#define LLCP_SESSION_LINKS      3       // Data link connections open at once
+#define LLCP_SESSION_MIU        128     // Information field of an I PDU, the LLCP default MIU
+#define LLCP_SESSION_FRAME_MAX  (LLCP_SESSION_MIU + 24)  // One I PDU and a few control PDUs per turn
+#define LLCP_SESSION_FIRST_SAP  0x20    // Local SAPs of outgoing connections
+
+#define LLCP_SAP_SDP            0x01
+#define LLCP_SAP_SNEP           0x04
+
+#define LLCP_LINK_CLOSED        0
+#define LLCP_LINK_LISTENING     1
+#define LLCP_LINK_CONNECTING    2
+#define LLCP_LINK_CONNECTED     3
+#define LLCP_LINK_DISCONNECTING 4
+
+#define LLCP_UNTIL_CONNECTED    0
+#define LLCP_UNTIL_SENT         1
+#define LLCP_UNTIL_DATA         2
+
+/**
+ * An LLCP link that stays up across any number of exchanges.
+ *
+ * LLCP and SNEP activate the PN532 as a target, connect, exchange one message and
+ * disconnect. A session activates once and then runs DEP turns: every PDU from the
+ * initiator is answered by the PDUs due on all data links, aggregated in an AGF when
+ * there are several, or by a SYMM when none is due. Received I PDUs are acknowledged
+ * by the N(R) of the next I PDU on the link where possible, by an RR otherwise.
+ * Links use a receive window of one, the LLCP default.
+ */
+class LLCPSession {
+public:
+    LLCPSession(PN532Interface &interface);
+
+    /**
+    * @brief    Activate PN532 as a target and bring the LLCP link up
+    * @param    timeout max time to wait, 0 means no timeout
+    * @return   > 0     success
+    *           = 0     timeout
+    *           < 0     failed
+    */
+    int8_t open(uint16_t timeout = 0);
+    void close();
+    bool active() const { return isActive; }
+
+    // Accept CONNECTs to sap, or by service name through the SDP. Returns the link index, < 0 if all are in use.
+    int8_t listen(uint8_t sap, const char *serviceName);
+    // Connect to a service by name. The CONNECT goes out on the next turn. Returns the link index.
+    int8_t connect(const char *serviceName);
+    bool disconnect(uint8_t index);
+    // Frees a closed link for connect() or listen()
+    void release(uint8_t index);
+    uint8_t state(uint8_t index) const { return links[index].state; }
+
+    /**
+    * @brief    queue one SDU on a link, sent on the next turn the peer can take it
+    * @return   false   the link is not connected, an SDU is still queued, or it exceeds the MIU
+    */
+    bool send(uint8_t index, const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0);
+
+    /**
+    * @brief    take the SDU received on a link; the peer may send the next one after this
+    * @return   >0      length of the SDU
+    *           =0      nothing received
+    *           <0      the buffer is too small
+    */
+    int16_t receive(uint8_t index, uint8_t *buf, uint8_t len);
+
+    /**
+    * @brief    run one DEP turn: read the initiator's PDU and answer it
+    * @return   > 0     success
+    *           < 0     the link is down
+    */
+    int8_t turn();
+
+    /**
+    * @brief    run turns until a link is connected, its SDU acknowledged or an SDU received
+    * @param    until   LLCP_UNTIL_CONNECTED, LLCP_UNTIL_SENT or LLCP_UNTIL_DATA
+    * @param    timeout max time to wait in ms, 0 means no timeout
+    * @return   > 0     done
+    *           = 0     timeout
+    *           < 0     the link or the data link connection closed
+    */
+    int8_t wait(uint8_t index, uint8_t until, uint16_t timeout = LLCP_DEFAULT_TIMEOUT);
+
+    uint32_t turns() const { return turnCount; }
+    uint32_t idleTurns() const { return symmCount; }          // SYMM answered with SYMM
+    uint32_t setupMicros() const { return setupTime; }        // open() to the first connected link
+    uint32_t messages() const { return ackCount; }            // SDUs sent and acknowledged
+    uint32_t lastLatency() const { return ackLast; }          // send() to acknowledgement, us
+    uint32_t maxLatency() const { return ackMax; }
+    uint32_t avgLatency() const { return ackCount ? ackTotal / ackCount : 0; }
+
+private:
+    struct Link {
+        uint8_t state;
+        bool listening;
+        uint8_t localSap;
+        uint8_t remoteSap;
+        const char *serviceName;
+        uint8_t ns;             // V(S)
+        uint8_t nr;             // V(R), advanced when the application takes the SDU
+        bool connectDue, ccDue, dmDue, discDue, ackDue;
+        bool unacked;           // I PDU sent, N(R) not yet seen
+        bool remoteBusy;        // RNR received
+        uint8_t txLength;       // Queued SDU, 0 if none
+        uint8_t rxLength;       // Received SDU not yet taken, 0 if none
+        uint32_t queuedMicros;
+        uint8_t tx[LLCP_SESSION_MIU];
+        uint8_t rx[LLCP_SESSION_MIU];
+    };
+
+    void handle(const uint8_t *pdu, uint8_t length);
+    void acknowledge(Link &l, uint8_t nr);
+    uint8_t nextPdu(Link &l, uint8_t *out, uint8_t room);
+    Link *find(uint8_t localSap);
+    void reset(Link &l);
+
+    MACLink link;
+    bool isActive;
+    Link links[LLCP_SESSION_LINKS];
+    uint8_t refuseDsap, refuseSsap;     // DM due for a CONNECT to an unknown service, 0 if none
+    uint8_t frame[LLCP_SESSION_FRAME_MAX + 1];
+    uint32_t openedMicros;
+    uint32_t setupTime;
+    uint32_t turnCount, symmCount;
+    uint32_t ackCount, ackLast, ackMax, ackTotal;
+};
+
+#endif // __LLCP_SESSION_H__
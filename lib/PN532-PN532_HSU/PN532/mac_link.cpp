@@ -1,4 +1,8 @@
 
+#include "PN532_features.h"
+
+#if PN532_FEATURE_P2P
+
 #include "mac_link.h"
 #include "PN532_debug.h"
 
@@ -18,3 +22,5 @@ int16_t MACLink::read(uint8_t *buf, uint8_t len)
 {
     return pn532.tgGetData(buf, len);
 }
+
+#endif // PN532_FEATURE_P2P
@@ -5,6 +5,10 @@
 
 #include "PN532.h"
 
+#if !PN532_FEATURE_P2P
+#error "mac_link.h needs PN532_FEATURE_P2P"
+#endif
+
 class MACLink {
 public:
     MACLink(PN532Interface &interface) : pn532(interface) {
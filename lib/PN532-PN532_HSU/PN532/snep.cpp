@@ -1,4 +1,8 @@
 
+#include "PN532_features.h"
+
+#if PN532_FEATURE_P2P
+
 #include "snep.h"
 #include "PN532_debug.h"
 
@@ -104,3 +108,68 @@ int16_t SNEP::read(uint8_t *buf, uint8_t len, uint16_t timeout)
 
 	return length;
 }
+
+int8_t SNEPClient::put(const uint8_t *buf, uint8_t len, uint16_t timeout)
+{
+	if (len > LLCP_SESSION_MIU - 6) {
+		return -1;
+	}
+	if (linkIndex < 0 || session.state(linkIndex) != LLCP_LINK_CONNECTED) {
+		if (linkIndex >= 0) {
+			session.release(linkIndex);
+		}
+		linkIndex = session.connect("urn:nfc:sn:snep");
+		if (linkIndex < 0) {
+			return -2;
+		}
+		int8_t status = session.wait(linkIndex, LLCP_UNTIL_CONNECTED, timeout);
+		if (0 >= status) {
+			DMSG("failed to set up a connection\n");
+			return status;
+		}
+		unanswered = 0;
+	}
+
+	// Responses come in order, so one that is queued or still on its way answers a PUT
+	// whose put() timed out, not this one
+	uint8_t response[LLCP_SESSION_MIU];
+	if (0 < session.receive(linkIndex, response, sizeof(response)) && unanswered) {
+		unanswered--;
+	}
+
+	unsigned long start = micros();
+	uint8_t header[6] = { SNEP_DEFAULT_VERSION, SNEP_REQUEST_PUT, 0, 0, 0, len };
+	if (!session.send(linkIndex, header, sizeof(header), buf, len)) {
+		return -3;
+	}
+	unanswered++;
+	int16_t length;
+	do {
+		uint16_t left = timeout;
+		if (timeout) {
+			unsigned long spent = (micros() - start) / 1000;
+			if (spent >= timeout) {
+				return 0;
+			}
+			left = timeout - spent;
+		}
+		int8_t status = session.wait(linkIndex, LLCP_UNTIL_DATA, left);
+		if (0 >= status) {
+			return status;
+		}
+		length = session.receive(linkIndex, response, sizeof(response));
+		unanswered--;
+	} while (unanswered);
+
+	if (6 > length) {
+		return -4;
+	}
+	if (SNEP_DEFAULT_VERSION != response[0] || SNEP_RESPONSE_SUCCESS != response[1]) {
+		DMSG("Expect a success response\n");
+		return -4;
+	}
+	latency = micros() - start;
+	return 1;
+}
+
+#endif // PN532_FEATURE_P2P
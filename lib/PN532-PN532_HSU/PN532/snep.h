@@ -4,6 +4,7 @@
 #define __SNEP_H__
 
 #include "llcp.h"
+#include "llcp_session.h"
 
 #define SNEP_DEFAULT_VERSION	0x10	// Major: 1, Minor: 0
 
@@ -46,4 +47,33 @@ private:
 	uint8_t headerBufLen;
 };
 
+/**
+ * SNEP client on an LLCPSession: the connection to the peer's SNEP server is made on
+ * the first put() and kept, so later messages cost only their own exchange.
+ */
+class SNEPClient {
+public:
+	SNEPClient(LLCPSession &session) : session(session), linkIndex(-1), unanswered(0), latency(0) {}
+
+	/**
+    * @brief    send a PUT request and wait for the response
+    * @param    buf     NDEF message, at most LLCP_SESSION_MIU - 6 bytes
+    * @param    len     length of the message
+    * @param    timeout max time to wait in ms, 0 means no timeout
+    * @return   >0      success
+    *           =0      timeout
+    *           <0      failed
+    */
+	int8_t put(const uint8_t *buf, uint8_t len, uint16_t timeout = LLCP_DEFAULT_TIMEOUT);
+
+	// PUT request to success response of the last put(), in us
+	uint32_t lastLatency() const { return latency; }
+
+private:
+	LLCPSession &session;
+	int8_t linkIndex;
+	uint8_t unanswered;     // PUTs sent on the link whose response has not been taken
+	uint32_t latency;
+};
+
 #endif // __SNEP_H__
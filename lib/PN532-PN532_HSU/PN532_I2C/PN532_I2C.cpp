@@ -90,7 +90,7 @@ int16_t PN532_I2C::getResponseLength(uint8_t buf[], uint8_t len, uint16_t timeou
         delay(1);
         time++;
         if ((0 != timeout) && (time > timeout)) {
-            return -1;
+            return PN532_TIMEOUT;
         }
     } while (1); 
     
@@ -117,9 +117,12 @@ int16_t PN532_I2C::getResponseLength(uint8_t buf[], uint8_t len, uint16_t timeou
 int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout)
 {
     uint16_t time = 0;
-    uint8_t length;
+    int16_t length;
 
     length = getResponseLength(buf, len, timeout);
+    if (length < 0) {
+        return length;
+    }
 
     // [RDY] 00 00 FF LEN LCS (TFI PD0 ... PDn) DCS 00
     do {
@@ -132,7 +135,7 @@ int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout)
         delay(1);
         time++;
         if ((0 != timeout) && (time > timeout)) {
-            return -1;
+            return PN532_TIMEOUT;
         }
     } while (1); 
     
@@ -146,7 +149,7 @@ int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout)
     
     length = read();
 
-    if (0 != (uint8_t)(length + read())) {   // checksum of length
+    if (0 != (uint8_t)(length + read()) || length < 2) {   // checksum of length, TFI and command
         return PN532_INVALID_FRAME;
     }
     
@@ -0,0 +1,142 @@
+/**************************************************************************/
+/*!
+    @file     PN532_errors.h
+    @brief    Why a PN532 command failed, and what a caller can do about it
+
+    Transports return PN532_INVALID_ACK to PN532_NO_SPACE. PN532 keeps the
+    cause of the last failed command for lastError(): a transport error,
+    one of the codes below, or PN532_STATUS_ERROR() of the error byte the
+    PN532 answered with. pn532ErrorClass() sorts them by the
+    reaction they call for, see PN532RetryPolicy.
+
+    The codes and the retry policy are a library of their own, so a
+    reader on another driver can report them without the PN532 core.
+*/
+/**************************************************************************/
+
+#ifndef __PN532_ERRORS_H__
+#define __PN532_ERRORS_H__
+
+#include <stdint.h>
+
+#define PN532_OK                        (0)
+#define PN532_INVALID_ACK               (-1)    // Transport errors
+#define PN532_TIMEOUT                   (-2)
+#define PN532_INVALID_FRAME             (-3)
+#define PN532_NO_SPACE                  (-4)
+#define PN532_INVALID_RESPONSE          (-5)    // Response too short for the command
+#define PN532_CARD_ERROR                (-6)    // The card refused the command, or its content is invalid
+#define PN532_NO_TARGET                 (-7)    // No target answered the poll
+#define PN532_BAD_PARAMETER             (-8)    // Rejected before anything was sent
+
+#define PN532_STATUS_BASE               (-0x40)
+#define PN532_STATUS_ERROR(status)      (PN532_STATUS_BASE - ((status) & 0x3F))
+
+// Error byte of a PN532 response, user manual section 7.1
+#define PN532_STATUS_TIMEOUT            (0x01)  // The target did not answer
+#define PN532_STATUS_CRC                (0x02)
+#define PN532_STATUS_PARITY             (0x03)
+#define PN532_STATUS_BIT_COUNT          (0x04)  // Erroneous bit count in anticollision or MIFARE select
+#define PN532_STATUS_FRAMING            (0x05)
+#define PN532_STATUS_COLLISION          (0x06)
+#define PN532_STATUS_BUFFER_SIZE        (0x07)  // Communication buffer too small
+#define PN532_STATUS_RF_BUFFER          (0x09)
+#define PN532_STATUS_RF_FIELD           (0x0A)  // The peer's field did not come up in time
+#define PN532_STATUS_RF_PROTOCOL        (0x0B)
+#define PN532_STATUS_TEMPERATURE        (0x0D)  // Antenna drivers switched off on overheating
+#define PN532_STATUS_INTERNAL_BUFFER    (0x0E)
+#define PN532_STATUS_PARAMETER          (0x10)
+#define PN532_STATUS_DEP_COMMAND        (0x12)
+#define PN532_STATUS_DEP_FORMAT         (0x13)
+#define PN532_STATUS_AUTH               (0x14)  // MIFARE authentication failed
+#define PN532_STATUS_UID_CHECK          (0x23)  // Wrong UID check byte in ISO14443-3 anticollision
+#define PN532_STATUS_DEP_STATE          (0x25)
+#define PN532_STATUS_NOT_ALLOWED        (0x26)
+#define PN532_STATUS_CONTEXT            (0x27)  // Command not acceptable in the current context
+#define PN532_STATUS_RELEASED           (0x29)  // The target released the PN532 as initiator
+#define PN532_STATUS_CARD_SWAPPED       (0x2A)  // Another card answered than the one listed
+#define PN532_STATUS_CARD_GONE          (0x2B)  // The activated card left the field
+#define PN532_STATUS_NFCID3             (0x2C)
+#define PN532_STATUS_OVERCURRENT        (0x2D)
+#define PN532_STATUS_NAD                (0x2E)  // NAD missing in a DEP frame
+
+enum PN532ErrorClass : uint8_t {
+    PN532_CLASS_NONE,           // Success
+    PN532_CLASS_RETRY,          // A frame was corrupted on the bus or over RF: send the command again
+    PN532_CLASS_BUSY,           // The PN532 did not answer in time: send again, the next command aborts the last
+    PN532_CLASS_CARD_GONE,      // No card, or not the one listed: poll again before talking to it
+    PN532_CLASS_AUTH,           // Wrong key: the same key will fail again, and the card must be selected again
+    PN532_CLASS_CARD,           // The card refused the command or sent unusable data
+    PN532_CLASS_CALLER,         // Buffer too small, or a command the PN532 cannot take now
+    PN532_CLASS_FATAL,          // Overheating or overcurrent: stop using the RF field
+    PN532_CLASS_COUNT
+};
+
+static inline PN532ErrorClass pn532ErrorClass(int16_t error)
+{
+    if (error >= 0) {
+        return PN532_CLASS_NONE;
+    }
+    if (error <= PN532_STATUS_BASE) {
+        switch (PN532_STATUS_BASE - error) {
+            case PN532_STATUS_CRC:
+            case PN532_STATUS_PARITY:
+            case PN532_STATUS_BIT_COUNT:
+            case PN532_STATUS_FRAMING:
+            case PN532_STATUS_COLLISION:
+            case PN532_STATUS_RF_BUFFER:
+            case PN532_STATUS_RF_FIELD:
+            case PN532_STATUS_RF_PROTOCOL:
+            case PN532_STATUS_DEP_FORMAT:
+            case PN532_STATUS_UID_CHECK:
+            case PN532_STATUS_NAD:
+                return PN532_CLASS_RETRY;
+            case PN532_STATUS_TIMEOUT:
+            case PN532_STATUS_RELEASED:
+            case PN532_STATUS_CARD_SWAPPED:
+            case PN532_STATUS_CARD_GONE:
+            case PN532_STATUS_NFCID3:
+                return PN532_CLASS_CARD_GONE;
+            case PN532_STATUS_AUTH:
+                return PN532_CLASS_AUTH;
+            case PN532_STATUS_BUFFER_SIZE:
+            case PN532_STATUS_PARAMETER:
+            case PN532_STATUS_DEP_COMMAND:
+            case PN532_STATUS_DEP_STATE:
+            case PN532_STATUS_NOT_ALLOWED:
+            case PN532_STATUS_CONTEXT:
+                return PN532_CLASS_CALLER;
+            case PN532_STATUS_TEMPERATURE:
+            case PN532_STATUS_INTERNAL_BUFFER:
+            case PN532_STATUS_OVERCURRENT:
+                return PN532_CLASS_FATAL;
+            default:
+                return PN532_CLASS_CARD;
+        }
+    }
+    switch (error) {
+        case PN532_INVALID_ACK:
+        case PN532_INVALID_FRAME:
+        case PN532_INVALID_RESPONSE:
+            return PN532_CLASS_RETRY;
+        case PN532_TIMEOUT:
+            return PN532_CLASS_BUSY;
+        case PN532_NO_TARGET:
+            return PN532_CLASS_CARD_GONE;
+        case PN532_NO_SPACE:
+        case PN532_BAD_PARAMETER:
+            return PN532_CLASS_CALLER;
+        default:
+            return PN532_CLASS_CARD;
+    }
+}
+
+static inline const char *pn532ErrorClassName(PN532ErrorClass errorClass)
+{
+    static const char *const names[PN532_CLASS_COUNT] = {
+        "NONE", "RETRY", "BUSY", "CARD GONE", "AUTH", "CARD", "CALLER", "FATAL"
+    };
+    return errorClass < PN532_CLASS_COUNT ? names[errorClass] : "?";
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**************************************************************************/
+/*!
+    @file     retry_policy.cpp
+    @brief    Retries a PN532 command only when its error can clear up
+*/
+/**************************************************************************/
+
+#include "Arduino.h"
+#include "retry_policy.h"
+#include <string.h>
+
+PN532RetryPolicy::PN532RetryPolicy(uint16_t budgetMs, uint8_t maxAttempts)
+{
+    _budgetMs = budgetMs;
+    _maxAttempts = maxAttempts ? maxAttempts : 1;
+    _retryable = PN532_RETRY_DEFAULT;
+    _attempts = 0;
+    _start = 0;
+    _attemptStart = 0;
+    resetStats();
+}
+
+void PN532RetryPolicy::resetStats()
+{
+    memset(_errors, 0, sizeof(_errors));
+    _retries = 0;
+    _recovered = 0;
+    _exhausted = 0;
+    _gaveUp = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts the attempts of one command
+*/
+/**************************************************************************/
+void PN532RetryPolicy::begin()
+{
+    _attempts = 1;
+    _start = millis();
+    _attemptStart = _start;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Decides whether a failed attempt is sent again
+
+    The next attempt is expected to take as long as the last one, so it is
+    only started if it can end within the budget.
+
+    @param  error  lastError() of the failed attempt
+    @return        true to send the command again
+*/
+/**************************************************************************/
+bool PN532RetryPolicy::again(int16_t error)
+{
+    PN532ErrorClass errorClass = pn532ErrorClass(error);
+    _errors[errorClass]++;
+
+    unsigned long now = millis();
+    unsigned long attemptMs = now - _attemptStart;
+    _attemptStart = now;
+
+    if (!(_retryable & PN532_RETRY_CLASS(errorClass))) {
+        _gaveUp++;
+        return false;
+    }
+    if (_attempts >= _maxAttempts || now - _start + attemptMs > _budgetMs) {
+        _exhausted++;
+        return false;
+    }
+    _attempts++;
+    _retries++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Ends the attempts of one command
+
+    @param  ok  Result of the last attempt
+    @return     ok
+*/
+/**************************************************************************/
+bool PN532RetryPolicy::finish(bool ok)
+{
+    if (ok && _attempts > 1) {
+        _recovered++;
+    }
+    return ok;
+}
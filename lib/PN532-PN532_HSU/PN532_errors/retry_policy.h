@@ -0,0 +1,71 @@
+/**************************************************************************/
+/*!
+    @file     retry_policy.h
+    @brief    Retries a PN532 command only when its error can clear up
+
+    A blind retry loop resends after every failure: it wastes the time of
+    a full command on a card that left the field or on a wrong key, and it
+    gives up on a CRC error after a fixed count however much time is left.
+    PN532RetryPolicy looks at lastError(): it resends only errors of the
+    retryable classes (PN532_errors.h), while attempts and the latency
+    budget last, and counts every error by class.
+
+        policy.begin();
+        bool ok;
+        do {
+            ok = nfc.mifareultralight_ReadPage(page, data);
+        } while (!ok && policy.again(nfc.lastError()));
+        return policy.finish(ok);
+*/
+/**************************************************************************/
+
+#ifndef __RETRY_POLICY_H__
+#define __RETRY_POLICY_H__
+
+#include <stdint.h>
+#include "PN532_errors.h"
+
+#define PN532_RETRY_BUDGET_MS       (50)    // Time for all attempts of one command
+#define PN532_RETRY_ATTEMPTS        (3)
+#define PN532_RETRY_CLASS(c)        ((uint16_t)1 << (c))
+#define PN532_RETRY_DEFAULT         (PN532_RETRY_CLASS(PN532_CLASS_RETRY) | PN532_RETRY_CLASS(PN532_CLASS_BUSY))
+
+class PN532RetryPolicy
+{
+public:
+    PN532RetryPolicy(uint16_t budgetMs = PN532_RETRY_BUDGET_MS, uint8_t maxAttempts = PN532_RETRY_ATTEMPTS);
+
+    void setBudget(uint16_t ms) { _budgetMs = ms; }
+    void setMaxAttempts(uint8_t attempts) { _maxAttempts = attempts ? attempts : 1; }
+    // Classes to resend, PN532_RETRY_CLASS() of each
+    void setRetryable(uint16_t classes) { _retryable = classes; }
+
+    void begin();
+    bool again(int16_t error);
+    bool finish(bool ok);
+
+    // Errors seen by again(), by class
+    uint32_t errors(PN532ErrorClass errorClass) const { return errorClass < PN532_CLASS_COUNT ? _errors[errorClass] : 0; }
+    uint32_t retries() const { return _retries; }
+    uint32_t recovered() const { return _recovered; }   // Commands that succeeded after a retry
+    uint32_t exhausted() const { return _exhausted; }   // Retryable errors left when attempts or budget ran out
+    uint32_t gaveUp() const { return _gaveUp; }         // Errors not worth a retry
+    void resetStats();
+
+private:
+    uint16_t _budgetMs;
+    uint8_t _maxAttempts;
+    uint16_t _retryable;
+
+    uint8_t _attempts;              // Of the current command
+    unsigned long _start;           // millis() at begin()
+    unsigned long _attemptStart;
+
+    uint32_t _errors[PN532_CLASS_COUNT];
+    uint32_t _retries;
+    uint32_t _recovered;
+    uint32_t _exhausted;
+    uint32_t _gaveUp;
+};
+
+#endif
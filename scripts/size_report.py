@@ -0,0 +1,41 @@
+"""Adds the "footprint" target: pio run -e <env> -t footprint
+
+Prints the flash and RAM used by each section of the firmware, then the size of
+every library archive of the build. Archive sizes are before section garbage
+collection; compare the firmware totals between environments to see what a
+feature flag really saves.
+"""
+
+import os
+import subprocess
+
+Import("env")
+
+
+def footprint(target, source, env):
+    size = env.subst("$SIZETOOL")
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+
+    print("Firmware sections:")
+    subprocess.call([size, "-A", "-d", elf])
+
+    print("Library archives:")
+    print("%10s %10s %10s  %s" % ("text", "data", "bss", "archive"))
+    build_dir = env.subst("$BUILD_DIR")
+    for root, _, files in sorted(os.walk(build_dir)):
+        for name in sorted(files):
+            if not name.endswith(".a"):
+                continue
+            path = os.path.join(root, name)
+            out = subprocess.check_output([size, "-t", path]).decode()
+            totals = out.strip().splitlines()[-1].split()
+            print("%10s %10s %10s  %s" % (totals[0], totals[1], totals[2], os.path.relpath(path, build_dir)))
+
+
+env.AddCustomTarget(
+    name="footprint",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=footprint,
+    title="Footprint",
+    description="Flash and RAM per firmware section and per library",
+)
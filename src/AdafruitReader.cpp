@@ -0,0 +1,45 @@
+/**
+ * @file    AdafruitReader.cpp
+ * @brief   NfcReader on the Adafruit PN532 library, built with -DNFC_READER_ADAFRUIT
+ */
+
+#include "AdafruitReader.h"
+
+#ifdef NFC_READER_ADAFRUIT
+
+AdafruitReader::AdafruitReader(uint8_t irq, uint8_t reset) : _pn532(irq, reset), _lastError(PN532_OK) {
+}
+
+void AdafruitReader::begin() {
+  _pn532.begin();
+}
+
+uint32_t AdafruitReader::getFirmwareVersion() {
+  return _pn532.getFirmwareVersion();
+}
+
+bool AdafruitReader::SAMConfig() {
+  return _pn532.SAMConfig();
+}
+
+bool AdafruitReader::readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout) {
+  bool found = _pn532.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, timeout);
+  _lastError = found ? PN532_OK : PN532_NO_TARGET;
+  return found;
+}
+
+bool AdafruitReader::inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength) {
+  // The driver does not say why an exchange failed. Most often the card left the field, and
+  // retrying a card that is gone only burns the budget, so count it as that and do not retry
+  bool exchanged = _pn532.inDataExchange(send, sendLength, response, responseLength);
+  _lastError = exchanged ? PN532_OK : PN532_NO_TARGET;
+  return exchanged;
+}
+
+bool AdafruitReader::setRFField(bool on) {
+  // RFConfiguration, item 1: RF field. The driver keeps the response reader private; the next command discards it.
+  uint8_t command[] = { PN532_COMMAND_RFCONFIGURATION, 0x01, (uint8_t)(on ? 0x01 : 0x00) };
+  return _pn532.sendCommandCheckAck(command, sizeof(command));
+}
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file    AdafruitReader.h
+ * @brief   NfcReader on the Adafruit PN532 library, built with -DNFC_READER_ADAFRUIT
+ *
+ * Kept for A/B latency comparisons against the in-tree driver, see the
+ * esp32dev_adafruit environment.
+ */
+
+#ifndef ADAFRUIT_READER_H
+#define ADAFRUIT_READER_H
+
+#ifdef NFC_READER_ADAFRUIT
+
+#include <Adafruit_PN532.h>
+#include "NfcReader.h"
+
+class AdafruitReader : public NfcReader {
+public:
+  AdafruitReader(uint8_t irq, uint8_t reset);
+
+  void begin();
+  uint32_t getFirmwareVersion();
+  bool SAMConfig();
+  bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout);
+  bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
+  bool setRFField(bool on);
+  int16_t lastError() { return _lastError; }
+  const char *name() { return "Adafruit_PN532"; }
+
+private:
+  Adafruit_PN532 _pn532;
+  int16_t _lastError;                 // The driver only reports success, see lastError()
+};
+
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file    ClockSync.cpp
+ * @brief   NTP-style clock synchronization with the show-control host
+ */
+
+#include "ClockSync.h"
+#include <esp_timer.h>
+
+ClockSync::ClockSync()
+  : _link(NULL), _state(SYNC_IDLE), _sent(0), _received(0), _lastSentAt(0), _burstEndedAt(0),
+    _bestDelay(0), _bestOffset(0), _bestLocal(0), _lastDelay(0), _residual(0), _estimateCount(0), _estimateNext(0),
+    _refLocal(0), _refOffset(0), _drift(0) {
+}
+
+/**
+ * @brief Starts a sync burst on the link the host asked from.
+ *
+ * @param link Stream the "Y" request came in on; requests are sent back on it.
+ */
+void ClockSync::start(Stream &link) {
+  _link = &link;
+  _state = SYNC_BURST;
+  _sent = 0;
+  _received = 0;
+  _bestDelay = INT64_MAX;
+}
+
+/**
+ * @brief Sends the next request of a burst, closes finished bursts and schedules the next one.
+ *
+ * Call from loop(). Never blocks; replies are fed back through handleReply().
+ */
+void ClockSync::poll() {
+  unsigned long now = millis();
+  switch (_state) {
+    case SYNC_IDLE:
+      return;
+    case SYNC_BURST:
+      if (_sent == CLOCK_SYNC_BURST) {
+        if (now - _lastSentAt >= CLOCK_SYNC_GRACE_MS) { finishBurst(); }
+        return;
+      }
+      if (_sent == 0 || now - _lastSentAt >= CLOCK_SYNC_SPACING_MS) {
+        char request[24];
+        _sentT1[_sent] = esp_timer_get_time();
+        snprintf(request, sizeof(request), "Y%lld", (long long)_sentT1[_sent]);
+        _link->println(request);
+        _lastSentAt = now;
+        _sent++;
+      }
+      return;
+    case SYNC_WAIT:
+      if (now - _burstEndedAt >= CLOCK_SYNC_PERIOD_MS) { start(*_link); }
+      return;
+  }
+}
+
+/**
+ * @brief Consumes a host reply "Y<t1>,<t2>,<t3>" and keeps it if it has the lowest round trip so far.
+ *
+ * @param data The reply line, without the trailing newline.
+ * @return false if the line is not a well-formed reply to a request of ours.
+ */
+bool ClockSync::handleReply(const String &data) {
+  int64_t t4 = esp_timer_get_time();
+  if (_state != SYNC_BURST) { return false; }
+
+  const char *p = data.c_str() + 1;
+  char *end;
+  int64_t t1 = strtoll(p, &end, 10);
+  if (*end != ',') { return false; }
+  int64_t t2 = strtoll(end + 1, &end, 10);
+  if (*end != ',') { return false; }
+  int64_t t3 = strtoll(end + 1, &end, 10);
+  uint8_t i = 0;
+  while (i < _sent && _sentT1[i] != t1) { i++; }
+  if (i == _sent || t1 == 0) { return false; }          // Another podium's, or already answered
+
+  int64_t delay = (t4 - t1) - (t3 - t2);
+  if (delay < 0) { return false; }
+  _sentT1[i] = 0;
+  _received++;
+  if (delay < _bestDelay) {
+    _bestDelay = delay;
+    _bestOffset = ((t2 - t1) + (t3 - t4)) / 2;
+    _bestLocal = t1 + (t4 - t1) / 2;
+  }
+  return true;
+}
+
+/**
+ * @brief Whether the last request is still waiting for its reply, for at most CLOCK_SYNC_REPLY_WAIT_MS.
+ *
+ * loop() holds reader polls back meanwhile, so the reply is parsed, and t4 taken, as it arrives.
+ */
+bool ClockSync::awaitingReply() {
+  return _state == SYNC_BURST && _sent > 0 && _sentT1[_sent - 1] != 0 &&
+         millis() - _lastSentAt < CLOCK_SYNC_REPLY_WAIT_MS;
+}
+
+/**
+ * @brief Bound on the error of hostTimeNow(), from the samples.
+ *
+ * Half the round trip of the best sample bounds the error of its offset, whatever the split
+ * between the two directions; the largest residual of the drift fit adds what the model does
+ * not explain.
+ *
+ * @return The bound in microseconds, or UINT32_MAX before the first successful burst.
+ */
+uint32_t ClockSync::errorBoundUs() {
+  if (!synced()) { return UINT32_MAX; }
+  int64_t bound = _lastDelay / 2 + _residual;
+  return bound < UINT32_MAX ? (uint32_t)bound : UINT32_MAX;
+}
+
+/**
+ * @brief Converts a local esp_timer time to host time.
+ *
+ * @param localMicros Local time from esp_timer_get_time().
+ * @return Host time in microseconds, or 0 before the first successful burst.
+ */
+int64_t ClockSync::hostTime(int64_t localMicros) {
+  if (!synced()) { return 0; }
+  return localMicros + _refOffset + (int64_t)(_drift * (double)(localMicros - _refLocal));
+}
+
+int64_t ClockSync::hostTimeNow() {
+  return hostTime(esp_timer_get_time());
+}
+
+/**
+ * @brief Prints sync state, current offset, drift and the round trip of the last burst.
+ */
+void ClockSync::printStatus(Print &out) {
+  char line[96];
+  snprintf(line, sizeof(line), "SYNC: %s ESTIMATES: %u", _state == SYNC_IDLE ? "IDLE" : "ACTIVE", _estimateCount);
+  out.println(line);
+  if (!synced()) { return; }
+  snprintf(line, sizeof(line), "OFFSET US: %lld DRIFT PPM: %.2f RTT US: %lld ERROR US: %lu", (long long)_refOffset,
+           _drift * 1e6, (long long)_lastDelay, (unsigned long)errorBoundUs());
+  out.println(line);
+}
+
+/**
+ * @brief Turns the best sample of a burst into an estimate, or stops syncing if the host never answered.
+ */
+void ClockSync::finishBurst() {
+  _burstEndedAt = millis();
+  if (_received == 0) {
+    _state = SYNC_IDLE;                                 // Host no longer speaks the protocol
+    return;
+  }
+  _estLocal[_estimateNext] = _bestLocal;
+  _estOffset[_estimateNext] = _bestOffset;
+  _lastDelay = _bestDelay;
+  _estimateNext = (_estimateNext + 1) % CLOCK_SYNC_ESTIMATES;
+  if (_estimateCount < CLOCK_SYNC_ESTIMATES) { _estimateCount++; }
+  fitModel();
+  _state = SYNC_WAIT;
+}
+
+/**
+ * @brief Least-squares fit of offset against local time over the kept estimates.
+ *
+ * The fitted line is anchored at the newest estimate; with a single estimate the drift is 0.
+ */
+void ClockSync::fitModel() {
+  uint8_t newest = (_estimateNext + CLOCK_SYNC_ESTIMATES - 1) % CLOCK_SYNC_ESTIMATES;
+  _refLocal = _estLocal[newest];
+  _refOffset = _estOffset[newest];
+  _drift = 0;
+  _residual = 0;
+  if (_estimateCount < 2) { return; }
+
+  // Work relative to the newest estimate so the doubles keep microsecond precision
+  double meanX = 0, meanY = 0;
+  for (uint8_t i = 0; i < _estimateCount; i++) {
+    meanX += (double)(_estLocal[i] - _refLocal);
+    meanY += (double)(_estOffset[i] - _refOffset);
+  }
+  meanX /= _estimateCount;
+  meanY /= _estimateCount;
+  double sxy = 0, sxx = 0;
+  for (uint8_t i = 0; i < _estimateCount; i++) {
+    double dx = (double)(_estLocal[i] - _refLocal) - meanX;
+    sxy += dx * ((double)(_estOffset[i] - _refOffset) - meanY);
+    sxx += dx * dx;
+  }
+  if (sxx <= 0) { return; }
+  _drift = sxy / sxx;
+  _refOffset += (int64_t)(meanY - _drift * meanX);      // Fitted offset at the newest estimate
+  for (uint8_t i = 0; i < _estimateCount; i++) {
+    int64_t residual = _estOffset[i] - hostTime(_estLocal[i]) + _estLocal[i];
+    if (residual < 0) { residual = -residual; }
+    if (residual > _residual) { _residual = residual; }
+  }
+}
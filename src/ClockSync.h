@@ -0,0 +1,79 @@
+/**
+ * @file    ClockSync.h
+ * @brief   NTP-style clock synchronization with the show-control host
+ *
+ * The host starts a sync by sending "Y". The podium then sends a burst of
+ * requests "Y<t1>" and the host answers each with "Y<t1>,<t2>,<t3>", where t2
+ * and t3 are its receive and transmit times in microseconds. The sample with the
+ * smallest round trip of each burst gives an offset estimate, and a least-squares
+ * fit over the last estimates gives the drift. Bursts repeat every
+ * CLOCK_SYNC_PERIOD_MS for as long as the host keeps answering.
+ *
+ * Podiums on a shared link see each other's replies, so a reply only counts if its
+ * t1 is exactly one this podium sent in the current burst and has not been answered yet.
+ *
+ * t4 is taken when the reply is parsed, so a reply that waits in the receive buffer
+ * while the reader polls looks like a slow return path and biases the offset. loop()
+ * therefore skips reader polls while awaitingReply(), for at most CLOCK_SYNC_REPLY_WAIT_MS,
+ * and the min-RTT filter drops the replies that arrive later. errorBoundUs() is what
+ * the samples prove about the remaining error; tools/clocksync/sim measures it.
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <Arduino.h>
+
+#define CLOCK_SYNC_BURST          (8)       // Requests per burst
+#define CLOCK_SYNC_SPACING_MS     (50)      // Gap between requests in a burst
+#define CLOCK_SYNC_GRACE_MS       (250)     // Wait for late replies after the last request
+#define CLOCK_SYNC_REPLY_WAIT_MS  (50)      // Reader polls held back for a reply
+#define CLOCK_SYNC_PERIOD_MS      (60000)   // Gap between bursts
+#define CLOCK_SYNC_ESTIMATES      (8)       // Burst estimates kept for the drift fit
+
+class ClockSync {
+public:
+  ClockSync();
+
+  void start(Stream &link);
+  void poll();
+  bool handleReply(const String &data);
+
+  bool synced() { return _estimateCount > 0; }
+  bool awaitingReply();
+  uint32_t errorBoundUs();
+  int64_t hostTime(int64_t localMicros);
+  int64_t hostTimeNow();
+  void printStatus(Print &out);
+
+private:
+  enum State { SYNC_IDLE, SYNC_BURST, SYNC_WAIT };
+
+  Stream *_link;
+  State _state;
+  uint8_t _sent;                    // Requests sent in the current burst
+  uint8_t _received;                // Replies received in the current burst
+  unsigned long _lastSentAt;
+  unsigned long _burstEndedAt;
+  int64_t _sentT1[CLOCK_SYNC_BURST];  // t1 of each request in the current burst, 0 once answered
+
+  int64_t _bestDelay;               // Smallest round trip seen in the current burst
+  int64_t _bestOffset;
+  int64_t _bestLocal;
+  int64_t _lastDelay;               // Round trip of the estimate behind the current model
+  int64_t _residual;                // Largest distance of a kept estimate from the fitted model
+
+  int64_t _estLocal[CLOCK_SYNC_ESTIMATES];
+  int64_t _estOffset[CLOCK_SYNC_ESTIMATES];
+  uint8_t _estimateCount;
+  uint8_t _estimateNext;
+
+  int64_t _refLocal;                // Model: host = local + refOffset + drift * (local - refLocal)
+  int64_t _refOffset;
+  double _drift;
+
+  void finishBurst();
+  void fitModel();
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file    CommandTemplate.cpp
+ * @brief   Command templates compiled once to opcodes and rendered without allocation
+ */
+
+#include "CommandTemplate.h"
+#include <string.h>
+
+CommandTemplate::CommandTemplate() : _length(0) {
+}
+
+/**
+ * @brief Compiles a command into this template.
+ *
+ * @return false if the compiled command did not fit and was cut short.
+ */
+bool CommandTemplate::compile(const char *text, size_t length) {
+  size_t compiled = compile(text, length, _code, sizeof(_code));
+  _length = compiled > sizeof(_code) ? sizeof(_code) : compiled;
+  return compiled <= sizeof(_code);
+}
+
+/**
+ * @brief Compiles command text to opcodes.
+ *
+ * Unknown placeholders are kept as typed. Control bytes in the text are dropped, they
+ * would read as opcodes.
+ *
+ * @param code Output, size bytes.
+ * @return Length of the compiled command; if more than size, only size bytes were written.
+ */
+size_t CommandTemplate::compile(const char *text, size_t length, uint8_t *code, size_t size) {
+  size_t n = 0;
+  for (size_t i = 0; i < length; i++) {
+    uint8_t c = text[i];
+    if (c < 0x20) { continue; }
+    if (c == '%' && i + 1 < length) {
+      switch (text[i + 1]) {
+        case 'U': c = TEMPLATE_OP_UID; i++; break;
+        case 'S': c = TEMPLATE_OP_SLOT; i++; break;
+        case 'D': c = TEMPLATE_OP_DWELL; i++; break;
+        case 'N': c = TEMPLATE_OP_SEQ; i++; break;
+        case '%': i++; break;
+      }
+    }
+    if (n < size) { code[n] = c; }
+    n++;
+  }
+  return n;
+}
+
+/**
+ * @brief Writes the decimal digits of value, or nothing if they do not fit.
+ */
+static size_t renderNumber(uint32_t value, char *out, size_t room) {
+  char digits[10];
+  size_t n = 0;
+  do { digits[n++] = '0' + value % 10; value /= 10; } while (value);
+  if (n > room) { return 0; }
+  for (size_t i = 0; i < n; i++) { out[i] = digits[n - 1 - i]; }
+  return n;
+}
+
+/**
+ * @brief Renders compiled opcodes for one event.
+ *
+ * Literal runs are copied with memcpy, placeholders formatted in place. Output that does
+ * not fit is cut at a placeholder or literal boundary.
+ *
+ * @param out  Buffer of size bytes, not terminated.
+ * @return Bytes written.
+ */
+size_t CommandTemplate::render(const uint8_t *code, size_t length, const CommandContext &context, char *out, size_t size) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < length) {
+    size_t run = i;
+    while (run < length && (code[run] == 0 || code[run] > TEMPLATE_OP_LAST)) { run++; }
+    if (run > i) {
+      if (run - i > size - n) { return n; }
+      memcpy(out + n, code + i, run - i);
+      n += run - i;
+      i = run;
+      continue;
+    }
+    switch (code[i++]) {
+      case TEMPLATE_OP_UID:
+        if (context.uidLength > size - n) { return n; }
+        memcpy(out + n, context.uid, context.uidLength);
+        n += context.uidLength;
+        break;
+      case TEMPLATE_OP_SLOT:  n += renderNumber(context.slot, out + n, size - n); break;
+      case TEMPLATE_OP_DWELL: n += renderNumber(context.dwellMs, out + n, size - n); break;
+      case TEMPLATE_OP_SEQ:   n += renderNumber(context.seq, out + n, size - n); break;
+    }
+  }
+  return n;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file    CommandTemplate.h
+ * @brief   Command templates compiled once to opcodes and rendered without allocation
+ *
+ * A command may carry placeholders that are filled in for each event:
+ *    - %U - UID of the tag, upper-case hex
+ *    - %S - Slot: the tag's index as shown by T and C, or its tag table index + 1
+ *    - %D - Dwell time in ms, on remove commands; 0 on placement
+ *    - %N - Sequence number of the event in the journal
+ *    - %% - A literal %
+ * Eg: PLACE:%S:%U renders PLACE:3:04A1B2C3D4E5F6.
+ *
+ * Templates are compiled when the config is loaded: each placeholder becomes a
+ * single opcode byte below 0x20, which no typed command contains, and every
+ * other byte stands for itself. Rendering is one pass that copies literals and
+ * formats the opcodes straight into the output buffer. Flash tag table images
+ * are compiled the same way by tools/tagtable/build_image.py. The module has
+ * no Arduino dependency so the host benchmark can use it.
+ */
+
+#ifndef COMMAND_TEMPLATE_H
+#define COMMAND_TEMPLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TEMPLATE_OP_UID       (0x01)
+#define TEMPLATE_OP_SLOT      (0x02)
+#define TEMPLATE_OP_DWELL     (0x03)
+#define TEMPLATE_OP_SEQ       (0x04)
+#define TEMPLATE_OP_LAST      (0x04)
+
+#define TEMPLATE_CODE_MAX     (64)        // Compiled bytes of a console command
+#define TEMPLATE_OUTPUT_MAX   (320)       // Rendered command, a 255-byte table command with placeholders
+
+/**
+ * @brief What the placeholders of one event render to.
+ */
+struct CommandContext {
+  const char *uid;
+  uint8_t uidLength;
+  uint16_t slot;
+  uint32_t dwellMs;
+  uint32_t seq;
+};
+
+class CommandTemplate {
+public:
+  CommandTemplate();
+
+  bool compile(const char *text, size_t length);
+  size_t render(const CommandContext &context, char *out, size_t size) const {
+    return render(_code, _length, context, out, size);
+  }
+  bool empty() const { return _length == 0; }
+  const uint8_t *code() const { return _code; }
+  uint8_t length() const { return _length; }
+
+  static size_t compile(const char *text, size_t length, uint8_t *code, size_t size);
+  static size_t render(const uint8_t *code, size_t length, const CommandContext &context, char *out, size_t size);
+
+private:
+  uint8_t _code[TEMPLATE_CODE_MAX];
+  uint8_t _length;
+};
+
+#endif
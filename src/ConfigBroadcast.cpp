@@ -0,0 +1,122 @@
+/**
+ * @file    ConfigBroadcast.cpp
+ * @brief   Broadcast tag table push to chained podiums over Serial2
+ */
+
+#include "ConfigBroadcast.h"
+#include <rom/crc.h>
+
+ConfigBroadcast::ConfigBroadcast(TagTable &table)
+  : _table(table), _id(0), _state(CONFIG_STATE_IDLE), _version(0), _size(0), _chunks(0), _received(0),
+    _chunksBad(0), _chunksDuplicate(0), _startedAt(0), _installMillis(0) {
+  memset(_have, 0, sizeof(_have));
+}
+
+/**
+ * @brief Handles one "G" line from the controller.
+ *
+ * @param data  The line.
+ * @param reply Where acks go, the link the line came from.
+ */
+void ConfigBroadcast::handle(const String &data, Print &reply) {
+  if (data.startsWith("GD")) {
+    chunk(data);
+  } else if (data.startsWith("GB")) {
+    int comma = data.indexOf(',');
+    if (comma > 0) { begin(strtoul(data.c_str() + 2, NULL, 10), strtoul(data.c_str() + comma + 1, NULL, 10)); }
+  } else if (data.startsWith("GQ")) {
+    if (_id && data.substring(2).toInt() == _id) { ack(reply); }
+  } else if (data.startsWith("GC")) {
+    commit(strtoul(data.c_str() + 2, NULL, 10));
+  }
+}
+
+void ConfigBroadcast::begin(uint32_t version, uint32_t size) {
+  if (_state == CONFIG_STATE_RECEIVE && version == _version && size == _size) { return; }   // Repeated start
+  _version = version;
+  _size = size;
+  _chunks = (size + CONFIG_CHUNK_SIZE - 1) / CONFIG_CHUNK_SIZE;
+  _received = 0;
+  _startedAt = millis();
+  memset(_have, 0, sizeof(_have));
+  if (version == _table.configVersion() && version != 0) {
+    _state = CONFIG_STATE_DONE;                   // Already installed
+  } else if (_chunks <= CONFIG_MAX_CHUNKS && _table.beginUpdate(size)) {
+    _state = CONFIG_STATE_RECEIVE;
+  } else {
+    _state = CONFIG_STATE_FAILED;
+  }
+}
+
+/**
+ * @brief Decodes, checks and writes one chunk. Bad and duplicate chunks are dropped silently;
+ * the next ack reports what is still missing.
+ */
+void ConfigBroadcast::chunk(const String &data) {
+  if (_state != CONFIG_STATE_RECEIVE) { return; }
+  const char *line = data.c_str();
+  char *end;
+  uint32_t index = strtoul(line + 2, &end, 10);
+  if (*end != ',' || index >= _chunks) { _chunksBad++; return; }
+  if (has(index)) { _chunksDuplicate++; return; }
+
+  uint16_t expected = (index + 1 < _chunks) ? CONFIG_CHUNK_SIZE : _size - index * CONFIG_CHUNK_SIZE;
+  uint8_t bytes[CONFIG_CHUNK_SIZE];
+  const char *hex = end + 1;
+  for (uint16_t i = 0; i < expected; i++) {
+    char hi = hex[2 * i], lo = hi ? hex[2 * i + 1] : 0;
+    if (!isxdigit(hi) || !isxdigit(lo)) { _chunksBad++; return; }
+    bytes[i] = (hi <= '9' ? hi - '0' : (hi | 0x20) - 'a' + 10) << 4 | (lo <= '9' ? lo - '0' : (lo | 0x20) - 'a' + 10);
+  }
+  if (hex[2 * expected] != ',' || strtoul(hex + 2 * expected + 1, NULL, 16) != crc16_le(0, bytes, expected)) {
+    _chunksBad++;
+    return;
+  }
+
+  if (!_table.writeUpdateAt(index * CONFIG_CHUNK_SIZE, bytes, expected)) {
+    _state = CONFIG_STATE_FAILED;
+    return;
+  }
+  _have[index / 8] |= 1 << (index % 8);
+  _received++;
+}
+
+void ConfigBroadcast::commit(uint32_t version) {
+  if (_state != CONFIG_STATE_RECEIVE || version != _version || _received < _chunks) { return; }
+  _state = _table.commitUpdate() ? CONFIG_STATE_DONE : CONFIG_STATE_FAILED;
+  if (_state == CONFIG_STATE_DONE) { _installMillis = millis() - _startedAt; }
+}
+
+/**
+ * @brief Answers "GA<id>,<version>,<state>,<have>/<total>[,<missing>]".
+ */
+void ConfigBroadcast::ack(Print &reply) {
+  String line = "GA" + String(_id) + "," + String(_version) + "," + String(_state) + "," + String(_received) + "/" +
+                String(_chunks);
+  if (_state == CONFIG_STATE_RECEIVE && _received < _chunks) {
+    line += ",";
+    uint8_t ranges = 0;
+    for (uint16_t c = 0; c < _chunks; c++) {
+      if (has(c)) { continue; }
+      if (ranges == CONFIG_MAX_RANGES) { line += "+"; break; }
+      uint16_t last = c;
+      while (last + 1 < _chunks && !has(last + 1)) { last++; }
+      if (ranges++) { line += ";"; }
+      line += String(c);
+      if (last > c) { line += "-" + String(last); }
+      c = last;
+    }
+  }
+  reply.println(line);
+}
+
+/**
+ * @brief Prints the podium ID, push state and chunk counters.
+ */
+void ConfigBroadcast::printStats(Print &out) {
+  out.println("CONFIG ID: " + String(_id) + " STATE: " + String(_state) + " VERSION: " + String(_version) +
+              " ACTIVE: " + String(_table.configVersion()));
+  out.println("CHUNKS: " + String(_received) + "/" + String(_chunks) + " BAD: " + String(_chunksBad) +
+              " DUPLICATE: " + String(_chunksDuplicate));
+  if (_installMillis) { out.println("LAST INSTALL MS: " + String(_installMillis)); }
+}
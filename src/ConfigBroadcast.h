@@ -0,0 +1,70 @@
+/**
+ * @file    ConfigBroadcast.h
+ * @brief   Broadcast tag table push to chained podiums over Serial2
+ *
+ * The controller streams a tag table image (see TagTable.h) once to every
+ * podium on the Serial2 bus, then polls each podium for the chunks it missed
+ * and rebroadcasts only the union of those. Lines:
+ *
+ *   GB<version>,<size>          Controller: start of a push
+ *   GD<chunk>,<hex>,<crc16>     Controller: one chunk of CONFIG_CHUNK_SIZE bytes
+ *   GQ<id>                      Controller: ack request to podium <id>
+ *   GA<id>,<version>,<state>,<have>/<total>[,<missing>]
+ *                               Podium: state I(dle), R(eceiving), D(one) or F(ailed),
+ *                               missing chunks as "a-b;c" ranges, "+" if there are more
+ *   GC<version>                 Controller: install, on every podium holding all chunks
+ *
+ * Chunks are written to the inactive tag table slot as they arrive, in any
+ * order, and GC flips the slot, so every podium switches to the new config
+ * atomically or keeps the old one. A podium whose image already carries the
+ * pushed version skips the transfer. Only podiums with an ID ("I<id>") answer.
+ */
+
+#ifndef CONFIG_BROADCAST_H
+#define CONFIG_BROADCAST_H
+
+#include <Arduino.h>
+#include "TagTable.h"
+
+#define CONFIG_CHUNK_SIZE     (128)
+#define CONFIG_MAX_CHUNKS     (4096)    // 512 KB, a tag table slot
+#define CONFIG_MAX_RANGES     (32)      // Missing ranges in one ack
+#define CONFIG_RX_BUFFER      (4096)    // Serial2 receive buffer, a chunk line is ~270 bytes
+
+#define CONFIG_STATE_IDLE     'I'
+#define CONFIG_STATE_RECEIVE  'R'
+#define CONFIG_STATE_DONE     'D'
+#define CONFIG_STATE_FAILED   'F'
+
+class ConfigBroadcast {
+public:
+  ConfigBroadcast(TagTable &table);
+
+  void setId(uint8_t id) { _id = id; }
+  uint8_t id() const { return _id; }
+  void handle(const String &data, Print &reply);
+  void printStats(Print &out);
+
+private:
+  void begin(uint32_t version, uint32_t size);
+  void chunk(const String &data);
+  void commit(uint32_t version);
+  void ack(Print &reply);
+  bool has(uint16_t chunk) const { return _have[chunk / 8] & (1 << (chunk % 8)); }
+
+  TagTable &_table;
+  uint8_t _id;                      // 0 = no ID, never answers
+  char _state;
+  uint32_t _version;                // Version being received or last installed
+  uint32_t _size;
+  uint16_t _chunks;
+  uint16_t _received;
+  uint8_t _have[CONFIG_MAX_CHUNKS / 8];
+
+  uint32_t _chunksBad;              // Dropped for a bad CRC or length
+  uint32_t _chunksDuplicate;
+  unsigned long _startedAt;
+  unsigned long _installMillis;     // GB to installed, last push
+};
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file    ConsoleBaud.cpp
+ * @brief   Baud rate negotiation for the USB Serial console
+ */
+
+#include "ConsoleBaud.h"
+
+// Rates the host may ask for, stored in EEPROM by index
+static const uint32_t baudRates[] = { 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600 };
+#define BAUD_RATES (sizeof(baudRates) / sizeof(baudRates[0]))
+
+ConsoleBaud::ConsoleBaud(HardwareSerial &console)
+  : _console(console), _baud(BAUD_DEFAULT), _previousBaud(BAUD_DEFAULT), _pending(false), _switchedAt(0),
+    _emissions(0), _bytesEmitted(0), _blockedMicros(0), _fallbacks(0) {
+}
+
+/**
+ * @brief Opens the console at the stored rate.
+ *
+ * @param storedIndex Rate index read from EEPROM, BAUD_EEPROM_NONE or out of range for BAUD_DEFAULT.
+ */
+void ConsoleBaud::begin(uint8_t storedIndex) {
+  _baud = storedIndex < BAUD_RATES ? baudRates[storedIndex] : BAUD_DEFAULT;
+  _console.begin(_baud);
+}
+
+/**
+ * @brief Switches the console to a new rate, pending confirmation.
+ *
+ * The reply is printed and flushed at the current rate before switching.
+ *
+ * @param baud  One of the supported rates.
+ * @param reply Where to report, the link the request came from.
+ * @return false if the rate is not supported; nothing changes.
+ */
+bool ConsoleBaud::request(uint32_t baud, Print &reply) {
+  if (indexOf(baud) < 0) {
+    reply.println("BAUD: UNSUPPORTED " + String(baud));
+    return false;
+  }
+  reply.println("BAUD: SWITCHING " + String(baud) + ", CONFIRM WITH BOK");
+  if (!_pending) { _previousBaud = _baud; }
+  apply(baud);
+  _pending = baud != _previousBaud;
+  _switchedAt = millis();
+  return true;
+}
+
+/**
+ * @brief Handles "BOK" from the host at the new rate.
+ *
+ * @return true if a switch was pending; the caller stores index().
+ */
+bool ConsoleBaud::confirm() {
+  if (!_pending) { return false; }
+  _pending = false;
+  return true;
+}
+
+/**
+ * @brief Falls back to the previous rate if the host did not confirm in time. Call from loop().
+ */
+void ConsoleBaud::poll() {
+  if (_pending && millis() - _switchedAt >= BAUD_CONFIRM_MS) {
+    _pending = false;
+    _fallbacks++;
+    apply(_previousBaud);
+    _console.println("BAUD: FALLBACK " + String(_baud));
+  }
+}
+
+uint8_t ConsoleBaud::index() const {
+  int8_t i = indexOf(_baud);
+  return i < 0 ? BAUD_EEPROM_NONE : i;
+}
+
+int8_t ConsoleBaud::indexOf(uint32_t baud) {
+  for (uint8_t i = 0; i < BAUD_RATES; i++) {
+    if (baudRates[i] == baud) { return i; }
+  }
+  return -1;
+}
+
+/**
+ * @brief Records one command written to the console.
+ *
+ * @param bytes         Bytes written, line endings included.
+ * @param blockedMicros Time the write calls took.
+ */
+void ConsoleBaud::recordEmission(uint16_t bytes, unsigned long blockedMicros) {
+  _emissions++;
+  _bytesEmitted += bytes;
+  _blockedMicros += blockedMicros;
+}
+
+/**
+ * @brief Prints the console rate and the cost of command output: the time the write calls
+ * blocked, and the time the bytes take on the wire at this rate and at BAUD_DEFAULT.
+ */
+void ConsoleBaud::printStats(Print &out) {
+  out.println("BAUD: " + String(_baud) + (_pending ? " UNCONFIRMED" : "") + " FALLBACKS: " + String(_fallbacks));
+  String line = "COMMANDS: " + String(_emissions);
+  if (_emissions) {
+    float bytes = (float)_bytesEmitted / _emissions;
+    // 10 bits per byte with 8N1
+    line += " AVG BYTES: " + String(bytes, 1) + " BLOCKED US: " + String(_blockedMicros / _emissions) +
+            " WIRE US: " + String(bytes * 10e6f / _baud, 0) + " AT " + String(BAUD_DEFAULT) + ": " +
+            String(bytes * 10e6f / BAUD_DEFAULT, 0);
+  }
+  out.println(line);
+}
+
+void ConsoleBaud::apply(uint32_t baud) {
+  _console.flush();                               // Let the reply leave at the old rate
+  _console.updateBaudRate(baud);
+  _baud = baud;
+  delay(BAUD_SETTLE_MS);
+}
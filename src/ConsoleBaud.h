@@ -0,0 +1,57 @@
+/**
+ * @file    ConsoleBaud.h
+ * @brief   Baud rate negotiation for the USB Serial console
+ *
+ * At the boot rate of 9600 baud every character of a command takes about 1 ms
+ * to leave the podium. The host asks for a faster rate with "B<baud>"; the
+ * podium answers at the old rate, switches, and waits for "BOK" at the new one.
+ * Without it the console falls back to the old rate after BAUD_CONFIRM_MS, so
+ * a host or cable that cannot keep up never loses the console. Only a
+ * confirmed rate is stored and used at the next boot. "B" sent over Bluetooth
+ * changes the USB console too, which recovers a console set to a rate the
+ * host no longer uses.
+ */
+
+#ifndef CONSOLE_BAUD_H
+#define CONSOLE_BAUD_H
+
+#include <Arduino.h>
+
+#define BAUD_DEFAULT          (9600)      // Boot rate without a stored one, and monitor_speed
+#define BAUD_CONFIRM_MS       (2000)      // Wait for "BOK" at the new rate
+#define BAUD_SETTLE_MS        (20)        // Quiet time after switching, for the host to switch too
+#define BAUD_EEPROM_NONE      (0xFF)      // Erased EEPROM, use BAUD_DEFAULT
+
+class ConsoleBaud {
+public:
+  ConsoleBaud(HardwareSerial &console);
+
+  void begin(uint8_t storedIndex);
+  bool request(uint32_t baud, Print &reply);
+  bool confirm();
+  void poll();
+
+  uint32_t baud() const { return _baud; }
+  uint8_t index() const;
+
+  void recordEmission(uint16_t bytes, unsigned long blockedMicros);
+  void printStats(Print &out);
+
+  static int8_t indexOf(uint32_t baud);
+
+private:
+  HardwareSerial &_console;
+  uint32_t _baud;
+  uint32_t _previousBaud;
+  bool _pending;                    // Switched, waiting for "BOK"
+  unsigned long _switchedAt;
+
+  uint32_t _emissions;
+  uint32_t _bytesEmitted;
+  unsigned long _blockedMicros;     // Time the command output calls took
+  uint32_t _fallbacks;
+
+  void apply(uint32_t baud);
+};
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @file    EventJournal.cpp
+ * @brief   Persistent tag event journal in a dedicated flash partition
+ */
+
+#include "EventJournal.h"
+#include <rom/crc.h>
+#include <stddef.h>
+
+EventJournal::EventJournal()
+  : _partition(NULL), _sectorCount(0), _writeOffset(0), _nextSeq(1), _buffered(0), _oldestBufferedAt(0),
+    _eventsLogged(0), _pagesWritten(0), _sectorsErased(0), _flushMicros(0) {
+}
+
+/**
+ * @brief Locates the journal partition and recovers the write position.
+ *
+ * The first record of every sector is read to find the sector holding the newest
+ * sequence number, then that sector is scanned up to its first erased slot.
+ * Records with a bad CRC (torn writes) are skipped but do not stop the scan.
+ *
+ * @return false if the partition table has no journal partition; appends are then ignored.
+ */
+bool EventJournal::begin() {
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)JOURNAL_PARTITION_SUBTYPE,
+                                        JOURNAL_PARTITION_LABEL);
+  if (_partition == NULL) { return false; }
+  _sectorCount = _partition->size / SPI_FLASH_SEC_SIZE;
+
+  JournalRecord record;
+  int32_t newestSector = -1;
+  uint32_t newestSeq = 0;
+  for (uint32_t s = 0; s < _sectorCount; s++) {
+    if (readRecord(s * SPI_FLASH_SEC_SIZE, record) && (newestSector < 0 || record.seq > newestSeq)) {
+      newestSector = s;
+      newestSeq = record.seq;
+    }
+  }
+  if (newestSector < 0) { return true; }          // Empty journal
+
+  uint32_t offset = newestSector * SPI_FLASH_SEC_SIZE;
+  uint32_t sectorEnd = offset + SPI_FLASH_SEC_SIZE;
+  for (; offset < sectorEnd; offset += sizeof(JournalRecord)) {
+    esp_partition_read(_partition, offset, &record, sizeof(record));
+    if (record.seq == JOURNAL_SEQ_NONE) { break; }
+    if (record.crc == recordCrc(record) && record.seq >= newestSeq) { newestSeq = record.seq; }
+  }
+  _writeOffset = (offset >= _partition->size) ? 0 : offset;
+  _nextSeq = newestSeq + 1;
+  return true;
+}
+
+/**
+ * @brief Queues an event record, flushing when the current flash page is full.
+ *
+ * @param type  JOURNAL_EVENT_PLACE or JOURNAL_EVENT_REMOVE.
+ * @param slot  Tag table index the event was emitted for.
+ * @param tagID Tag UID as an upper-case hex string, as built by readNFC().
+ * @param hostTime Event time on the host clock in microseconds, 0 if unknown.
+ */
+void EventJournal::append(uint8_t type, uint8_t slot, const String &tagID, int64_t hostTime) {
+  if (_partition == NULL) { return; }
+
+  JournalRecord &record = _buffer[_buffered];
+  memset(&record, 0, sizeof(record));
+  record.seq  = _nextSeq++;
+  record.time = millis();
+  record.hostTime = hostTime;
+  record.type = type;
+  record.slot = slot;
+  uint8_t len = tagID.length() / 2;
+  if (len > sizeof(record.uid)) { len = sizeof(record.uid); }
+  for (uint8_t i = 0; i < len; i++) {
+    record.uid[i] = strtoul(tagID.substring(i * 2, i * 2 + 2).c_str(), NULL, 16);
+  }
+  record.uidLength = len;
+  record.crc = recordCrc(record);
+
+  if (_buffered++ == 0) { _oldestBufferedAt = millis(); }
+  _eventsLogged++;
+
+  // Batches never straddle a page, so a flush is always a single page program
+  uint32_t pageFree = JOURNAL_RECORDS_PER_PAGE - (_writeOffset / sizeof(JournalRecord)) % JOURNAL_RECORDS_PER_PAGE;
+  if (_buffered >= pageFree) { flush(); }
+}
+
+/**
+ * @brief Flushes buffered records that have waited longer than JOURNAL_FLUSH_MS.
+ *
+ * Call from loop() so a quiet podium does not keep its last events in RAM only.
+ */
+void EventJournal::poll() {
+  if (_buffered && (millis() - _oldestBufferedAt >= JOURNAL_FLUSH_MS)) { flush(); }
+}
+
+/**
+ * @brief Writes the RAM buffer to flash, erasing the next sector first when the ring enters it.
+ */
+void EventJournal::flush() {
+  if (_partition == NULL || _buffered == 0) { return; }
+
+  unsigned long start = micros();
+  if (_writeOffset % SPI_FLASH_SEC_SIZE == 0) {
+    esp_partition_erase_range(_partition, _writeOffset, SPI_FLASH_SEC_SIZE);
+    _sectorsErased++;
+  }
+  esp_partition_write(_partition, _writeOffset, _buffer, _buffered * sizeof(JournalRecord));
+  _writeOffset += _buffered * sizeof(JournalRecord);
+  if (_writeOffset >= _partition->size) { _writeOffset = 0; }
+  _buffered = 0;
+  _pagesWritten++;
+  _flushMicros += micros() - start;
+}
+
+/**
+ * @brief Prints every journaled event with a sequence number >= fromSeq, oldest first.
+ *
+ * Each event is printed as "EV:<seq>:<P|R>:<index>:<tag id>:<millis>:<host time us>".
+ * Sectors whose successor starts at or below fromSeq are skipped without being scanned.
+ *
+ * @param fromSeq First sequence number the host has not seen.
+ * @param out     Stream to replay to.
+ * @return Number of events replayed.
+ */
+uint32_t EventJournal::replay(uint32_t fromSeq, Print &out) {
+  if (_partition == NULL) { return 0; }
+  flush();
+
+  JournalRecord record;
+  uint32_t replayed = 0;
+  // A write position on a sector boundary means that sector still holds the previous lap
+  uint32_t oldest = _writeOffset / SPI_FLASH_SEC_SIZE;
+  if (_writeOffset % SPI_FLASH_SEC_SIZE) { oldest = (oldest + 1) % _sectorCount; }
+  for (uint32_t k = 0; k < _sectorCount; k++) {
+    uint32_t sector = (oldest + k) % _sectorCount;
+    if (k + 1 < _sectorCount) {
+      uint32_t next = (sector + 1) % _sectorCount;
+      if (readRecord(next * SPI_FLASH_SEC_SIZE, record) && record.seq <= fromSeq) { continue; }
+    }
+    uint32_t offset = sector * SPI_FLASH_SEC_SIZE;
+    for (uint32_t i = 0; i < JOURNAL_RECORDS_PER_SECTOR; i++, offset += sizeof(JournalRecord)) {
+      esp_partition_read(_partition, offset, &record, sizeof(record));
+      if (record.seq == JOURNAL_SEQ_NONE) { break; }
+      if (record.crc != recordCrc(record) || record.seq < fromSeq) { continue; }
+      printRecord(record, out);
+      replayed++;
+    }
+  }
+  return replayed;
+}
+
+/**
+ * @brief Prints journal counters: events, page programs, sector erases and flash wear.
+ */
+void EventJournal::printStats(Print &out) {
+  if (_partition == NULL) { out.println("JOURNAL: NO PARTITION"); return; }
+  out.println("JOURNAL NEXT SEQ: " + String(_nextSeq));
+  out.println("EVENTS: " + String(_eventsLogged) + " PAGES: " + String(_pagesWritten) +
+              " ERASES: " + String(_sectorsErased) + "/" + String(_sectorCount) + " SECTORS");
+  if (_eventsLogged) {
+    // Erase cycles each sector takes per million events, spread evenly by the ring
+    float wear = (float)_sectorsErased * 1000000.0f / ((float)_eventsLogged * _sectorCount);
+    out.println("WEAR PER 1M EVENTS: " + String(wear, 2) + " ERASES/SECTOR");
+  }
+  if (_pagesWritten) {
+    float usPerEvent = (float)_flushMicros / _eventsLogged;
+    out.println("FLASH US/EVENT: " + String(usPerEvent, 1) + " MAX EVENTS/S: " + String(1000000.0f / usPerEvent, 0));
+  }
+}
+
+bool EventJournal::readRecord(uint32_t offset, JournalRecord &record) {
+  if (esp_partition_read(_partition, offset, &record, sizeof(record)) != ESP_OK) { return false; }
+  return record.seq != JOURNAL_SEQ_NONE && record.crc == recordCrc(record);
+}
+
+void EventJournal::printRecord(const JournalRecord &record, Print &out) {
+  out.print("EV:"); out.print(record.seq);
+  out.print(record.type == JOURNAL_EVENT_REMOVE ? ":R:" : ":P:");
+  out.print(record.slot == JOURNAL_SLOT_TAG_TABLE ? 0 : record.slot + 1); out.print(':');
+  for (uint8_t i = 0; i < record.uidLength; i++) {
+    if (record.uid[i] < 0x10) { out.print('0'); }
+    out.print(record.uid[i], HEX);
+  }
+  char times[40];
+  snprintf(times, sizeof(times), ":%lu:%lld", (unsigned long)record.time, (long long)record.hostTime);
+  out.println(times);
+}
+
+uint16_t EventJournal::recordCrc(const JournalRecord &record) {
+  return crc16_le(0, (const uint8_t *)&record, offsetof(JournalRecord, crc));
+}
@@ -0,0 +1,80 @@
+/**
+ * @file    EventJournal.h
+ * @brief   Persistent tag event journal in a dedicated flash partition
+ *
+ * Every event emitted by the firmware is appended to a ring of fixed-size
+ * records in the "journal" data partition (see partitions.csv). Records are
+ * buffered in RAM and flushed one flash page at a time, and a sector is only
+ * erased when the ring wraps into it, so each sector sees one erase per lap.
+ * After a host reconnects it can ask for every event from a sequence number on.
+ */
+
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#define JOURNAL_PARTITION_LABEL   "journal"
+#define JOURNAL_PARTITION_SUBTYPE (0x40)
+#define JOURNAL_PAGE_SIZE         (256)         // Flash program page
+#define JOURNAL_FLUSH_MS          (2000)        // Max time an event may stay in RAM
+
+#define JOURNAL_EVENT_PLACE       (0x01)
+#define JOURNAL_EVENT_REMOVE      (0x02)
+
+#define JOURNAL_SLOT_TAG_TABLE    (0xFF)        // Tag found in the flash tag table, replayed as index 0
+
+#define JOURNAL_SEQ_NONE          (0xFFFFFFFF)  // Erased flash
+
+/**
+ * @brief One journal entry. 32 bytes, so a flash page holds 8 and a sector 128.
+ */
+struct JournalRecord {
+  uint32_t seq;           // Monotonic sequence number, never JOURNAL_SEQ_NONE
+  uint32_t time;          // millis() when the event was emitted
+  int64_t  hostTime;      // Host time in microseconds, 0 if the clock was not synced
+  uint8_t  type;          // JOURNAL_EVENT_*
+  uint8_t  slot;          // Tag table index
+  uint8_t  uidLength;
+  uint8_t  uid[7];
+  uint8_t  reserved[4];
+  uint16_t crc;           // CRC16 over all preceding bytes
+};
+
+#define JOURNAL_RECORDS_PER_PAGE   (JOURNAL_PAGE_SIZE / sizeof(JournalRecord))
+#define JOURNAL_RECORDS_PER_SECTOR (SPI_FLASH_SEC_SIZE / sizeof(JournalRecord))
+
+class EventJournal {
+public:
+  EventJournal();
+
+  bool begin();
+  void append(uint8_t type, uint8_t slot, const String &tagID, int64_t hostTime = 0);
+  void poll();
+  void flush();
+  uint32_t replay(uint32_t fromSeq, Print &out);
+  void printStats(Print &out);
+
+  uint32_t nextSeq() { return _nextSeq; }
+
+private:
+  const esp_partition_t *_partition;
+  uint32_t _sectorCount;
+  uint32_t _writeOffset;                          // Next free record slot in flash
+  uint32_t _nextSeq;
+  JournalRecord _buffer[JOURNAL_RECORDS_PER_PAGE];
+  uint8_t _buffered;
+  unsigned long _oldestBufferedAt;
+
+  uint32_t _eventsLogged;
+  uint32_t _pagesWritten;
+  uint32_t _sectorsErased;
+  unsigned long _flushMicros;                     // Total time spent writing flash
+
+  bool readRecord(uint32_t offset, JournalRecord &record);
+  void printRecord(const JournalRecord &record, Print &out);
+  static uint16_t recordCrc(const JournalRecord &record);
+};
+
+#endif
@@ -0,0 +1,167 @@
+/**
+ * @file    LoopProfiler.cpp
+ * @brief   Per-phase loop() timing with percentile histograms and worst-iteration capture
+ */
+
+#include "LoopProfiler.h"
+
+static const char *const phaseNames[LOOP_PHASES] = { "NFC", "BT", "SERIAL", "SERIAL2", "JOURNAL", "CLOCK" };
+
+LoopProfiler::LoopProfiler() {
+  reset();
+}
+
+/**
+ * @brief Clears all histograms and the worst iterations.
+ */
+void LoopProfiler::reset() {
+  memset(_phases, 0, sizeof(_phases));
+  memset(&_loop, 0, sizeof(_loop));
+  memset(_worst, 0, sizeof(_worst));
+  memset(&_current, 0, sizeof(_current));
+  _iterationStart = micros();
+  _phaseStart = _iterationStart;
+  _phase = LOOP_PHASES;
+  _siteDepth = 0;
+}
+
+/**
+ * @brief Call first thing in loop().
+ */
+void LoopProfiler::beginIteration() {
+  memset(&_current, 0, sizeof(_current));
+  _iterationStart = micros();
+  _phaseStart = _iterationStart;
+  _phase = LOOP_PHASES;
+}
+
+/**
+ * @brief Ends the running phase, if any, and starts the given one.
+ */
+void LoopProfiler::enter(uint8_t phase) {
+  unsigned long now = micros();
+  if (_phase < LOOP_PHASES) {
+    uint32_t elapsed = now - _phaseStart;
+    record(_phases[_phase], elapsed);
+    if (elapsed >= _current.phaseMicros) {
+      _current.phaseMicros = elapsed;
+      _current.phase = _phase;
+    }
+  }
+  _phase = phase;
+  _phaseStart = now;
+}
+
+/**
+ * @brief Call last thing in loop(). Keeps the iteration if it is among the LOOP_WORST slowest.
+ */
+void LoopProfiler::endIteration() {
+  enter(LOOP_PHASES);
+  _current.micros = micros() - _iterationStart;
+  _current.at = millis();
+  record(_loop, _current.micros);
+
+  uint8_t fastest = 0;
+  for (uint8_t i = 1; i < LOOP_WORST; i++) {
+    if (_worst[i].micros < _worst[fastest].micros) { fastest = i; }
+  }
+  if (_current.micros > _worst[fastest].micros) { _worst[fastest] = _current; }
+}
+
+void LoopProfiler::enterSite() {
+  if (_siteDepth < LOOP_SITE_DEPTH) {
+    _siteStart[_siteDepth] = micros();
+    _siteChildren[_siteDepth] = 0;
+  }
+  _siteDepth++;
+}
+
+/**
+ * @brief Closes the innermost site. Its self time is charged to the site; its whole time to the parent's children.
+ */
+void LoopProfiler::exitSite(const char *name) {
+  if (_siteDepth == 0) { return; }
+  _siteDepth--;
+  if (_siteDepth >= LOOP_SITE_DEPTH) { return; }
+  uint32_t elapsed = micros() - _siteStart[_siteDepth];
+  uint32_t self = elapsed - _siteChildren[_siteDepth];
+  if (_siteDepth > 0) { _siteChildren[_siteDepth - 1] += elapsed; }
+  if (self >= _current.siteMicros) {
+    _current.siteMicros = self;
+    _current.site = name;
+  }
+}
+
+/**
+ * @brief Prints count, p50, p90, p99 and max per phase and for the whole loop, then the
+ * slowest iterations with their slowest phase and call site, slowest first.
+ */
+void LoopProfiler::printReport(Print &out) {
+  for (uint8_t p = 0; p < LOOP_PHASES; p++) { printHistogram(out, phaseNames[p], _phases[p]); }
+  printHistogram(out, "LOOP", _loop);
+
+  bool printed[LOOP_WORST] = { false };
+  for (uint8_t n = 0; n < LOOP_WORST; n++) {
+    int8_t slowest = -1;
+    for (uint8_t i = 0; i < LOOP_WORST; i++) {
+      if (!printed[i] && _worst[i].micros && (slowest < 0 || _worst[i].micros > _worst[slowest].micros)) { slowest = i; }
+    }
+    if (slowest < 0) { break; }
+    printed[slowest] = true;
+    const Iteration &it = _worst[slowest];
+    String line = "WORST: " + String(it.micros) + " US AT " + String(it.at) + " MS " + String(phaseNames[it.phase]) +
+                  " " + String(it.phaseMicros) + " US";
+    if (it.site) { line += " SITE " + String(it.site) + " " + String(it.siteMicros) + " US"; }
+    out.println(line);
+  }
+}
+
+/**
+ * @brief Histogram bucket: exact below 4 us, then 4 buckets per power of two.
+ */
+uint8_t LoopProfiler::bucketOf(uint32_t micros) {
+  if (micros < 4) { return micros; }
+  uint8_t octave = 31 - __builtin_clz(micros);
+  uint8_t bucket = (octave - 1) * 4 + ((micros >> (octave - 2)) & 3);
+  return bucket < LOOP_BUCKETS ? bucket : LOOP_BUCKETS - 1;
+}
+
+/**
+ * @brief Largest value that falls in a bucket.
+ */
+uint32_t LoopProfiler::bucketLimit(uint8_t bucket) {
+  if (bucket < 4) { return bucket; }
+  uint8_t octave = bucket / 4 + 1;
+  return ((uint32_t)(4 + bucket % 4 + 1) << (octave - 2)) - 1;
+}
+
+void LoopProfiler::record(Histogram &histogram, uint32_t micros) {
+  histogram.count++;
+  histogram.buckets[bucketOf(micros)]++;
+  if (micros > histogram.microsMax) { histogram.microsMax = micros; }
+}
+
+/**
+ * @brief Upper bound of the bucket holding the given percentile, capped at the max seen.
+ */
+uint32_t LoopProfiler::percentile(const Histogram &histogram, uint8_t percent) {
+  uint32_t rank = ((uint64_t)histogram.count * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < LOOP_BUCKETS; b++) {
+    seen += histogram.buckets[b];
+    if (seen >= rank) {
+      uint32_t limit = bucketLimit(b);
+      return limit < histogram.microsMax ? limit : histogram.microsMax;
+    }
+  }
+  return histogram.microsMax;
+}
+
+void LoopProfiler::printHistogram(Print &out, const char *label, const Histogram &histogram) {
+  String line = String(label) + ": " + String(histogram.count);
+  if (histogram.count) {
+    line += " US P50: " + String(percentile(histogram, 50)) + " P90: " + String(percentile(histogram, 90)) +
+            " P99: " + String(percentile(histogram, 99)) + " MAX: " + String(histogram.microsMax);
+  }
+  out.println(line);
+}
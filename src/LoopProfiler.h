@@ -0,0 +1,95 @@
+/**
+ * @file    LoopProfiler.h
+ * @brief   Per-phase loop() timing with percentile histograms and worst-iteration capture
+ *
+ * The gap between a placement and its command is bounded by the longest loop()
+ * iteration, not the average one. Each phase of loop() is timed into a
+ * histogram with four buckets per power of two, so percentiles are within 25%
+ * up to 16 s. Blocking calls inside a phase are wrapped in a LoopSite and timed
+ * by self time, excluding nested sites, so the slowest iterations can be
+ * traced to the call that held them up. The "PS" report prints both.
+ */
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+
+#define LOOP_PHASE_NFC        (0)       // readNFC(), including command output, or an emulation window
+#define LOOP_PHASE_BT         (1)       // readBTSerial()
+#define LOOP_PHASE_SERIAL     (2)       // readSerial()
+#define LOOP_PHASE_SERIAL2    (3)       // readSerial2()
+#define LOOP_PHASE_JOURNAL    (4)       // journal.poll()
+#define LOOP_PHASE_CLOCK      (5)       // clockSync.poll() and consoleBaud.poll()
+#define LOOP_PHASES           (6)
+
+#define LOOP_BUCKETS          (92)      // 4 per power of two, up to 2^24 us
+#define LOOP_WORST            (8)       // Slowest iterations kept
+#define LOOP_SITE_DEPTH       (4)       // Nesting of LoopSite scopes
+
+class LoopProfiler {
+public:
+  LoopProfiler();
+
+  void beginIteration();
+  void enter(uint8_t phase);
+  void endIteration();
+
+  void enterSite();
+  void exitSite(const char *name);
+
+  void reset();
+  void printReport(Print &out);
+
+private:
+  struct Histogram {
+    uint32_t count;
+    uint32_t microsMax;
+    uint32_t buckets[LOOP_BUCKETS];
+  };
+
+  struct Iteration {
+    uint32_t micros;                // Whole iteration, 0 marks a free entry
+    uint32_t at;                    // millis() at the end of the iteration
+    uint32_t phaseMicros;           // Slowest phase
+    uint32_t siteMicros;            // Self time of the slowest site
+    const char *site;               // NULL if no site was entered
+    uint8_t phase;
+  };
+
+  static uint8_t bucketOf(uint32_t micros);
+  static uint32_t bucketLimit(uint8_t bucket);
+  static void record(Histogram &histogram, uint32_t micros);
+  static uint32_t percentile(const Histogram &histogram, uint8_t percent);
+  static void printHistogram(Print &out, const char *label, const Histogram &histogram);
+
+  Histogram _phases[LOOP_PHASES];
+  Histogram _loop;
+  Iteration _worst[LOOP_WORST];
+  Iteration _current;
+
+  unsigned long _iterationStart;
+  unsigned long _phaseStart;
+  uint8_t _phase;
+
+  uint8_t _siteDepth;
+  unsigned long _siteStart[LOOP_SITE_DEPTH];
+  uint32_t _siteChildren[LOOP_SITE_DEPTH];     // Time spent in nested sites
+};
+
+/**
+ * @brief Times the enclosing scope as a call site of the current loop phase.
+ *
+ * @param name A string literal naming the call, e.g. "EEPROM.commit".
+ */
+class LoopSite {
+public:
+  LoopSite(LoopProfiler &profiler, const char *name) : _profiler(profiler), _name(name) { _profiler.enterSite(); }
+  ~LoopSite() { _profiler.exitSite(_name); }
+
+private:
+  LoopProfiler &_profiler;
+  const char *_name;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file    NdefKeyReader.cpp
+ * @brief   Early-terminating read of the first NDEF text or URI record on a Type 2 tag
+ */
+
+#include "NdefKeyReader.h"
+
+#define TLV_NULL            (0x00)
+#define TLV_NDEF_MESSAGE    (0x03)
+#define TLV_TERMINATOR      (0xFE)
+
+#define NDEF_FLAG_SR        (0x10)
+#define NDEF_FLAG_IL        (0x08)
+#define NDEF_TNF_MASK       (0x07)
+#define NDEF_TNF_WELL_KNOWN (0x01)
+
+NdefKeyReader::NdefKeyReader(NdefBlockReader reader)
+  : _reader(reader), _blockStart(-1), _blocksRead(0) {
+}
+
+/**
+ * @brief Returns one byte of user memory, fetching its block if it is not the current one.
+ */
+bool NdefKeyReader::byteAt(uint32_t offset, uint8_t *value) {
+  if (offset >= NDEF_T2_MAX_BYTES) { return false; }
+  if (_blockStart < 0 || offset < (uint32_t)_blockStart || offset >= (uint32_t)_blockStart + NDEF_T2_BLOCK_SIZE) {
+    uint16_t start = offset & ~(uint32_t)(NDEF_T2_BLOCK_SIZE - 1);
+    if (!_reader(NDEF_T2_FIRST_PAGE + start / 4, _block)) { return false; }
+    _blockStart = start;
+    _blocksRead++;
+  }
+  *value = _block[offset - _blockStart];
+  return true;
+}
+
+/**
+ * @brief Reads a TLV length field, one byte or 0xFF followed by two bytes big endian.
+ */
+bool NdefKeyReader::lengthAt(uint32_t *offset, uint16_t *length) {
+  uint8_t b;
+  if (!byteAt((*offset)++, &b)) { return false; }
+  if (b != 0xFF) { *length = b; return true; }
+  uint8_t hi, lo;
+  if (!byteAt((*offset)++, &hi) || !byteAt((*offset)++, &lo)) { return false; }
+  *length = (hi << 8) | lo;
+  return true;
+}
+
+/**
+ * @brief Reads the payload of the first record if it is a well-known text or URI record.
+ *
+ * For text records the status byte and language code are skipped. URI records keep their
+ * prefix code, it is part of the identity.
+ *
+ * @param key       Buffer of NDEF_KEY_MAX bytes for the key.
+ * @param keyLength Set to the number of key bytes.
+ * Offsets are 32-bit so that no TLV or record length can wrap them back into memory already
+ * parsed; every offset past NDEF_T2_MAX_BYTES fails.
+ *
+ * @return false if the tag has no NDEF message, the first record is of another type or a read failed.
+ */
+bool NdefKeyReader::readKey(uint8_t *key, uint8_t *keyLength) {
+  uint32_t pos = 0;
+  uint16_t messageLength;
+  uint8_t b;
+
+  // Skip to the NDEF message TLV
+  while (true) {
+    if (!byteAt(pos++, &b)) { return false; }
+    if (b == TLV_NULL) { continue; }
+    if (b == TLV_TERMINATOR) { return false; }
+    uint16_t length;
+    if (!lengthAt(&pos, &length)) { return false; }
+    if (b == TLV_NDEF_MESSAGE) { messageLength = length; break; }
+    pos += length;                                    // Lock / memory control or proprietary TLV
+    if (pos >= NDEF_T2_MAX_BYTES) { return false; }
+  }
+  uint32_t messageEnd = pos + messageLength;
+  if (messageEnd > NDEF_T2_MAX_BYTES) { return false; }
+
+  // First record header
+  uint8_t flags, typeLength, idLength = 0, type;
+  uint32_t payloadLength = 0;
+  if (!byteAt(pos++, &flags) || !byteAt(pos++, &typeLength)) { return false; }
+  for (uint8_t i = 0; i < ((flags & NDEF_FLAG_SR) ? 1 : 4); i++) {
+    if (!byteAt(pos++, &b)) { return false; }
+    payloadLength = (payloadLength << 8) | b;
+  }
+  if ((flags & NDEF_FLAG_IL) && !byteAt(pos++, &idLength)) { return false; }
+  if ((flags & NDEF_TNF_MASK) != NDEF_TNF_WELL_KNOWN || typeLength != 1) { return false; }
+  if (!byteAt(pos, &type) || (type != 'T' && type != 'U')) { return false; }
+  pos += typeLength + idLength;
+  if (pos > messageEnd || payloadLength > messageEnd - pos) { return false; }
+
+  if (type == 'T') {
+    uint8_t status;
+    if (payloadLength == 0 || !byteAt(pos, &status)) { return false; }
+    uint8_t skip = 1 + (status & 0x3F);
+    if (skip > payloadLength) { return false; }
+    pos += skip;
+    payloadLength -= skip;
+  }
+
+  // Stop at the end of the payload, or earlier once the key is full
+  uint8_t length = payloadLength < NDEF_KEY_MAX ? payloadLength : NDEF_KEY_MAX;
+  for (uint8_t i = 0; i < length; i++) {
+    if (!byteAt(pos + i, &key[i])) { return false; }
+  }
+  *keyLength = length;
+  return length > 0;
+}
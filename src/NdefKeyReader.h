@@ -0,0 +1,43 @@
+/**
+ * @file    NdefKeyReader.h
+ * @brief   Early-terminating read of the first NDEF text or URI record on a Type 2 tag
+ *
+ * Used when tags are routed by content instead of UID. The NDEF TLV is parsed
+ * while blocks are fetched, and reading stops as soon as the first record's
+ * payload is complete, so a short record costs one or two READ commands
+ * instead of a dump of the whole user memory.
+ */
+
+#ifndef NDEF_KEY_READER_H
+#define NDEF_KEY_READER_H
+
+#include <Arduino.h>
+
+#define NDEF_KEY_MAX              (32)    // Longer payloads are truncated, the key only has to be unique
+#define NDEF_T2_BLOCK_SIZE        (16)    // One READ answers four pages
+#define NDEF_T2_FIRST_PAGE        (4)     // First page of user memory
+#define NDEF_T2_MAX_BYTES         (888)   // User memory of an NTAG216
+
+#define NTAG_CMD_READ             (0x30)
+
+// Reads the 16 bytes starting at page, returns false on error
+typedef bool (*NdefBlockReader)(uint8_t page, uint8_t *block);
+
+class NdefKeyReader {
+public:
+  NdefKeyReader(NdefBlockReader reader);
+
+  bool readKey(uint8_t *key, uint8_t *keyLength);
+  uint8_t blocksRead() const { return _blocksRead; }
+
+private:
+  bool byteAt(uint32_t offset, uint8_t *value);
+  bool lengthAt(uint32_t *offset, uint16_t *length);
+
+  NdefBlockReader _reader;
+  uint8_t _block[NDEF_T2_BLOCK_SIZE];
+  int16_t _blockStart;              // User memory offset of _block, -1 if empty
+  uint8_t _blocksRead;
+};
+
+#endif
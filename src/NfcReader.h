@@ -0,0 +1,36 @@
+/**
+ * @file    NfcReader.h
+ * @brief   Thin interface over the PN532 driver used by the podium
+ *
+ * The firmware only needs to detect ISO14443A tags and exchange frames with the
+ * tag in the field. Keeping that behind an interface lets the in-tree driver and
+ * the Adafruit driver be swapped with a build flag and compared on the same podium.
+ */
+
+#ifndef NFC_READER_H
+#define NFC_READER_H
+
+#include <Arduino.h>
+#include <PN532_errors.h>
+
+class NfcReader {
+public:
+  virtual ~NfcReader() {}
+
+  virtual void begin() = 0;
+  virtual uint32_t getFirmwareVersion() = 0;
+  virtual bool SAMConfig() = 0;
+
+  // Waits up to timeout ms for an ISO14443A tag and selects it
+  virtual bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout) = 0;
+  // Sends a frame to the selected tag; responseLength is the buffer size in, the answer length out
+  virtual bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength) = 0;
+  // Switches the RF field on or off; off also ends a poll the PN532 is still running after its timeout
+  virtual bool setRFField(bool on) = 0;
+  // Why the last detection or exchange failed, a PN532_errors.h code
+  virtual int16_t lastError() = 0;
+
+  virtual const char *name() = 0;
+};
+
+#endif
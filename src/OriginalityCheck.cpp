@@ -0,0 +1,92 @@
+/**
+ * @file    OriginalityCheck.cpp
+ * @brief   NTAG originality signature verification with a per-UID verdict cache
+ */
+
+#include "OriginalityCheck.h"
+
+// NXP originality public key for NTAG21x, x || y
+static const uint8_t NXP_NTAG21X_KEY[SECP128R1_KEY_SIZE] = {
+  0x49, 0x4E, 0x1A, 0x38, 0x6D, 0x3D, 0x3C, 0xFE, 0x3D, 0xC1, 0x0E, 0x5D, 0xE6, 0x8A, 0x49, 0x9B,
+  0x1C, 0x20, 0x2D, 0xB5, 0xB1, 0x32, 0x39, 0x3E, 0x89, 0xED, 0x19, 0xFE, 0x5B, 0xE8, 0xBC, 0x61
+};
+
+OriginalityCheck::OriginalityCheck()
+  : _nextVictim(0), _hits(0), _misses(0), _counterfeits(0), _readFailures(0), _verified(0), _verifyMicrosTotal(0),
+    _verifyMicrosMax(0) {
+  memset(_cache, 0, sizeof(_cache));
+}
+
+/**
+ * @brief Returns the cached verdict for a UID.
+ *
+ * @return ORIGINALITY_UNKNOWN if the UID has not been verified yet, otherwise the cached verdict.
+ */
+uint8_t OriginalityCheck::lookup(const uint8_t *uid, uint8_t uidLength) {
+  for (uint8_t i = 0; i < ORIGINALITY_CACHE_SIZE; i++) {
+    if (_cache[i].uidLength == uidLength && memcmp(_cache[i].uid, uid, uidLength) == 0) {
+      _hits++;
+      return _cache[i].verdict;
+    }
+  }
+  _misses++;
+  return ORIGINALITY_UNKNOWN;
+}
+
+/**
+ * @brief Verifies a READ_SIG answer against the NXP key and caches the verdict.
+ *
+ * @param uid           Tag UID (7 bytes for NTAG).
+ * @param uidLength     Length of the UID.
+ * @param signature     32-byte READ_SIG answer.
+ * @param signatureRead false if the tag answered READ_SIG with a NAK; the tag is then cached as unsupported.
+ *                      A READ_SIG that failed on the link goes to readFailed() instead.
+ * @return The verdict, one of ORIGINALITY_GENUINE, ORIGINALITY_COUNTERFEIT or ORIGINALITY_UNSUPPORTED.
+ */
+uint8_t OriginalityCheck::verify(const uint8_t *uid, uint8_t uidLength, const uint8_t *signature, bool signatureRead) {
+  if (uidLength > sizeof(_cache[0].uid)) { return ORIGINALITY_UNSUPPORTED; }
+
+  uint8_t verdict = ORIGINALITY_UNSUPPORTED;
+  if (signatureRead) {
+    unsigned long start = micros();
+    bool valid = secp128r1Verify(NXP_NTAG21X_KEY, uid, uidLength, signature);
+    unsigned long elapsed = micros() - start;
+    _verified++;
+    _verifyMicrosTotal += elapsed;
+    if (elapsed > _verifyMicrosMax) { _verifyMicrosMax = elapsed; }
+    verdict = valid ? ORIGINALITY_GENUINE : ORIGINALITY_COUNTERFEIT;
+  }
+  if (verdict != ORIGINALITY_GENUINE) { _counterfeits++; }
+
+  Entry &entry = _cache[_nextVictim];
+  _nextVictim = (_nextVictim + 1) % ORIGINALITY_CACHE_SIZE;
+  entry.uidLength = uidLength;
+  memcpy(entry.uid, uid, uidLength);
+  entry.verdict = verdict;
+  return verdict;
+}
+
+/**
+ * @brief Records a READ_SIG that failed on the link: an RF glitch, a tag pulled away or retries used up.
+ *
+ * Nothing is cached, so only this placement is rejected and the next one reads the signature again.
+ *
+ * @return ORIGINALITY_READ_FAILED.
+ */
+uint8_t OriginalityCheck::readFailed() {
+  _readFailures++;
+  return ORIGINALITY_READ_FAILED;
+}
+
+/**
+ * @brief Prints cache hit rate, rejected tags and signature verification time.
+ */
+void OriginalityCheck::printStats(Print &out) {
+  uint32_t lookups = _hits + _misses;
+  out.println("AUTH HITS: " + String(_hits) + " MISSES: " + String(_misses) +
+              " HIT RATE: " + String(lookups ? 100.0f * _hits / lookups : 0.0f, 1) + "%");
+  out.println("AUTH REJECTED: " + String(_counterfeits) + " READ FAILURES: " + String(_readFailures));
+  if (_verified) {
+    out.println("VERIFY US AVG: " + String(_verifyMicrosTotal / _verified) + " MAX: " + String(_verifyMicrosMax));
+  }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file    OriginalityCheck.h
+ * @brief   NTAG originality signature verification with a per-UID verdict cache
+ *
+ * NTAG21x tags answer READ_SIG with an NXP ECDSA signature over their UID.
+ * Verifying it costs far more than a placement is allowed to take, so the
+ * verdict is cached per UID and only the first placement of a cube pays for it.
+ */
+
+#ifndef ORIGINALITY_CHECK_H
+#define ORIGINALITY_CHECK_H
+
+#include <Arduino.h>
+#include "Secp128r1.h"
+
+#define ORIGINALITY_CACHE_SIZE    (16)
+
+#define NTAG_CMD_READ_SIG         (0x3C)
+
+#define ORIGINALITY_UNKNOWN       (0)     // Not in the cache
+#define ORIGINALITY_GENUINE       (1)
+#define ORIGINALITY_COUNTERFEIT   (2)     // Signature present but invalid
+#define ORIGINALITY_UNSUPPORTED   (3)     // Tag refused READ_SIG
+#define ORIGINALITY_READ_FAILED   (4)     // READ_SIG lost on the link, not cached
+
+class OriginalityCheck {
+public:
+  OriginalityCheck();
+
+  uint8_t lookup(const uint8_t *uid, uint8_t uidLength);
+  uint8_t verify(const uint8_t *uid, uint8_t uidLength, const uint8_t *signature, bool signatureRead);
+  uint8_t readFailed();
+  void printStats(Print &out);
+
+private:
+  struct Entry {
+    uint8_t uidLength;              // 0 marks a free entry
+    uint8_t uid[7];
+    uint8_t verdict;
+  };
+
+  Entry _cache[ORIGINALITY_CACHE_SIZE];
+  uint8_t _nextVictim;              // Round-robin replacement
+
+  uint32_t _hits;
+  uint32_t _misses;
+  uint32_t _counterfeits;
+  uint32_t _readFailures;           // Placements rejected because READ_SIG did not get through
+  uint32_t _verified;               // Signatures checked
+  unsigned long _verifyMicrosTotal;
+  unsigned long _verifyMicrosMax;
+};
+
+#endif
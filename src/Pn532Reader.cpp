@@ -0,0 +1,37 @@
+/**
+ * @file    Pn532Reader.cpp
+ * @brief   NfcReader on the in-tree PN532 library over I2C, the default without -DNFC_READER_ADAFRUIT
+ */
+
+#include "Pn532Reader.h"
+
+#ifndef NFC_READER_ADAFRUIT
+
+Pn532Reader::Pn532Reader(TwoWire &wire) : _i2c(wire), _pn532(_i2c) {
+}
+
+void Pn532Reader::begin() {
+  _pn532.begin();
+}
+
+uint32_t Pn532Reader::getFirmwareVersion() {
+  return _pn532.getFirmwareVersion();
+}
+
+bool Pn532Reader::SAMConfig() {
+  return _pn532.SAMConfig();
+}
+
+bool Pn532Reader::readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout) {
+  return _pn532.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, timeout);
+}
+
+bool Pn532Reader::inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength) {
+  return _pn532.inDataExchange(send, sendLength, response, responseLength);
+}
+
+bool Pn532Reader::setRFField(bool on) {
+  return _pn532.setRFField(0, on ? 1 : 0);
+}
+
+#endif
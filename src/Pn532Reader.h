@@ -0,0 +1,39 @@
+/**
+ * @file    Pn532Reader.h
+ * @brief   NfcReader on the in-tree PN532 library over I2C, the default without -DNFC_READER_ADAFRUIT
+ */
+
+#ifndef PN532_READER_H
+#define PN532_READER_H
+
+#ifndef NFC_READER_ADAFRUIT
+
+#include <Wire.h>
+#include <PN532_I2C.h>
+#include <PN532.h>
+#include "NfcReader.h"
+
+class Pn532Reader : public NfcReader {
+public:
+  Pn532Reader(TwoWire &wire);
+
+  void begin();
+  uint32_t getFirmwareVersion();
+  bool SAMConfig();
+  bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout);
+  bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
+  bool setRFField(bool on);
+  int16_t lastError() { return _pn532.lastError(); }
+  const char *name() { return "PN532"; }
+
+  PN532 &driver() { return _pn532; }
+  PN532Interface &interface() { return _i2c; }
+
+private:
+  PN532_I2C _i2c;
+  PN532 _pn532;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file    RfSlots.cpp
+ * @brief   Time-division RF windows for podiums whose fields reach each other
+ */
+
+#include "RfSlots.h"
+
+RfSlots::RfSlots(NfcReader &reader, ClockSync &clock)
+  : _reader(reader), _clock(clock), _slots(0), _slotMs(0), _fixedSlot(RF_SLOT_BY_ID), _podiumId(0), _fieldOn(true),
+    _windowStart(-1), _windows(0), _polls(0), _unsyncedPolls(0), _roughPolls(0), _switches(0), _switchErrors(0), _fieldOffSince(0),
+    _offMsTotal(0) {
+}
+
+/**
+ * @brief Sets the frame.
+ *
+ * @param slots  Windows per frame, 0 or 1 to poll without slots.
+ * @param slotMs Window length, rounded down to RF_SLOT_UNIT_MS.
+ * @param slot   Window of this podium, or RF_SLOT_BY_ID to use the podium ID modulo slots.
+ * @return false if a value is out of range; nothing changes.
+ */
+bool RfSlots::configure(uint8_t slots, uint16_t slotMs, uint8_t slot) {
+  if (slots <= 1) {
+    _slots = 0;
+    return true;
+  }
+  slotMs -= slotMs % RF_SLOT_UNIT_MS;
+  if (slots > RF_SLOT_MAX || slotMs < RF_SLOT_MIN_MS || slotMs > RF_SLOT_MAX_MS ||
+      (slot != RF_SLOT_BY_ID && slot >= slots)) {
+    return false;
+  }
+  _slots = slots;
+  _slotMs = slotMs;
+  _fixedSlot = slot;
+  _windowStart = -1;
+  return true;
+}
+
+uint8_t RfSlots::slot() const {
+  if (!enabled()) { return 0; }
+  return _fixedSlot != RF_SLOT_BY_ID ? _fixedSlot : _podiumId % _slots;
+}
+
+/**
+ * @brief Called before each reader poll. Switches the field for the current window.
+ *
+ * @param timeout The poll timeout without slots, in ms.
+ * @return The timeout to poll with, cut to end a guard before the window does, or 0 to skip the poll
+ *         because the window is closed; the field is then off.
+ */
+uint16_t RfSlots::pollTimeout(uint16_t timeout) {
+  if (!usable()) {
+    if (enabled()) {
+      if (_clock.synced()) { _roughPolls++; }
+      else { _unsyncedPolls++; }
+    }
+    if (!_fieldOn) { setField(true); }
+    return timeout;
+  }
+  int64_t now = _clock.hostTimeNow();
+  int32_t left = windowLeftMs(now, guardUs());
+  if (left < RF_SLOT_MIN_POLL_MS) {
+    if (_fieldOn) { setField(false); }
+    return 0;
+  }
+  if (!_fieldOn) { setField(true); }
+  int64_t frame = (int64_t)_slots * _slotMs * 1000;
+  int64_t windowStart = now - ((now % frame) + frame) % frame;
+  if (windowStart != _windowStart) {
+    _windowStart = windowStart;
+    _windows++;
+  }
+  _polls++;
+  return left < timeout ? left : timeout;
+}
+
+/**
+ * @brief Called after each reader poll. Switches the field off right away if no poll fits the window any more.
+ *
+ * The PN532 keeps polling after a poll times out on the host side, so the field stays on until it is
+ * switched off here or by the next pollTimeout().
+ */
+void RfSlots::polled() {
+  if (!usable() || !_fieldOn) { return; }
+  if (windowLeftMs(_clock.hostTimeNow(), guardUs()) < RF_SLOT_MIN_POLL_MS) { setField(false); }
+}
+
+/**
+ * @brief Field off time at each end of a window: the switch time plus the measured clock sync error.
+ */
+uint32_t RfSlots::guardUs() {
+  uint32_t error = _clock.errorBoundUs();
+  return error > UINT32_MAX - RF_SLOT_SWITCH_MS * 1000 ? UINT32_MAX : error + RF_SLOT_SWITCH_MS * 1000;
+}
+
+/**
+ * @brief Whether slots are set, the clock is synced and the guards still leave a poll in the window.
+ *
+ * A podium whose sync error is too large for its windows polls without slots rather than with
+ * windows that overlap its neighbours'.
+ */
+bool RfSlots::usable() {
+  if (!enabled() || !_clock.synced()) { return false; }
+  return 2 * (uint64_t)guardUs() + RF_SLOT_MIN_POLL_MS * 1000 <= (uint64_t)_slotMs * 1000;
+}
+
+/**
+ * @brief Time left in this podium's window, guards excluded.
+ *
+ * @return ms until the field has to be off, or -1 outside the window.
+ */
+int32_t RfSlots::windowLeftMs(int64_t hostMicros, uint32_t guardUs) const {
+  int64_t frame = (int64_t)_slots * _slotMs * 1000;
+  int64_t phase = ((hostMicros % frame) + frame) % frame;
+  int64_t open = (int64_t)slot() * _slotMs * 1000 + guardUs;
+  int64_t close = (int64_t)(slot() + 1) * _slotMs * 1000 - guardUs;
+  if (phase < open || phase >= close) { return -1; }
+  return (int32_t)((close - phase) / 1000);
+}
+
+void RfSlots::setField(bool on) {
+  _switches++;
+  if (!_reader.setRFField(on)) {
+    _switchErrors++;
+    return;                                           // Retried before the next poll
+  }
+  _fieldOn = on;
+  if (on) { _offMsTotal += millis() - _fieldOffSince; }
+  else { _fieldOffSince = millis(); }
+}
+
+/**
+ * @brief Prints the frame, this podium's slot, and how often the field was switched.
+ */
+void RfSlots::printStats(Print &out) {
+  if (!enabled()) {
+    out.println("RF SLOTS: OFF");
+  } else {
+    uint32_t guardMs = _clock.synced() ? (guardUs() + 999) / 1000 : RF_SLOT_SWITCH_MS;
+    out.println("RF SLOTS: " + String(_slots) + " X " + String(_slotMs) + " MS SLOT " + String(slot()) +
+                (_fixedSlot == RF_SLOT_BY_ID ? " (PODIUM ID)" : "") + " GUARD " + String(guardMs) + " MS" +
+                (usable() ? " DUTY " + String(100 * (_slotMs - 2 * guardMs) / (_slots * _slotMs)) + "%" : "") +
+                (!_clock.synced() ? ", CLOCK NOT SYNCED" : usable() ? "" : ", SYNC ERROR TOO LARGE"));
+  }
+  out.println("WINDOWS: " + String(_windows) + " POLLS: " + String(_polls) + " UNSYNCED POLLS: " + String(_unsyncedPolls) +
+              " ROUGH SYNC POLLS: " + String(_roughPolls));
+  out.println("FIELD SWITCHES: " + String(_switches) + " ERRORS: " + String(_switchErrors) + " OFF MS: " +
+              String(_offMsTotal + (_fieldOn ? 0 : millis() - _fieldOffSince)));
+}
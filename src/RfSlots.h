@@ -0,0 +1,80 @@
+/**
+ * @file    RfSlots.h
+ * @brief   Time-division RF windows for podiums whose fields reach each other
+ *
+ * Adjacent podiums poll at the same time and their 13.56 MHz carriers corrupt
+ * each other's anticollision: polls fail, a cube that stays put is reported
+ * removed and placed again, and detection latency swings with the neighbours'
+ * timing. With slots configured, time is split into frames of `slots` windows
+ * and this podium keeps its field on only in its own window. Every podium that
+ * shares the host clock (see ClockSync) computes the same frame boundaries, so
+ * podiums in different slots never have their fields on at once.
+ *
+ * The slot defaults to the podium ID modulo the slot count, so a controller can
+ * broadcast one "W" line on Serial2 to every podium. Readers far enough apart can
+ * share a slot. A guard at both ends of each window absorbs the time to switch
+ * the field and the clock sync error, as ClockSync::errorBoundUs() measures it:
+ * two podiums each within the bound of host time can disagree by twice the bound,
+ * which the guards of both windows cover. Until the clock is synced, and while the
+ * guards would leave no room for a poll in the window, the podium polls as it did
+ * without slots.
+ */
+
+#ifndef RF_SLOTS_H
+#define RF_SLOTS_H
+
+#include <Arduino.h>
+#include "ClockSync.h"
+#include "NfcReader.h"
+
+#define RF_SLOT_UNIT_MS       (10)        // Slot length is stored in EEPROM in these units
+#define RF_SLOT_MAX           (16)        // Slots per frame
+#define RF_SLOT_SWITCH_MS     (2)         // Part of each guard for RFConfiguration and the poll overrunning
+#define RF_SLOT_MIN_POLL_MS   (10)        // Shortest poll worth starting
+#define RF_SLOT_MIN_MS        (2 * RF_SLOT_SWITCH_MS + RF_SLOT_MIN_POLL_MS)
+#define RF_SLOT_MAX_MS        (2540)      // 0xFF units is erased EEPROM
+#define RF_SLOT_BY_ID         (0xFF)      // Slot = podium ID % slots
+
+class RfSlots {
+public:
+  RfSlots(NfcReader &reader, ClockSync &clock);
+
+  bool configure(uint8_t slots, uint16_t slotMs, uint8_t slot = RF_SLOT_BY_ID);
+  void setPodiumId(uint8_t id) { _podiumId = id; }
+  bool enabled() const { return _slots > 1; }
+  uint8_t slots() const { return _slots; }
+  uint16_t slotMs() const { return _slotMs; }
+  uint8_t fixedSlot() const { return _fixedSlot; }
+  uint8_t slot() const;
+
+  uint16_t pollTimeout(uint16_t timeout);
+  void polled();
+  uint32_t guardUs();
+  bool usable();
+
+  void printStats(Print &out);
+
+private:
+  int32_t windowLeftMs(int64_t hostMicros, uint32_t guardUs) const;
+  void setField(bool on);
+
+  NfcReader &_reader;
+  ClockSync &_clock;
+  uint8_t _slots;                         // 0 or 1 = no slots
+  uint16_t _slotMs;
+  uint8_t _fixedSlot;                     // RF_SLOT_BY_ID unless set explicitly
+  uint8_t _podiumId;
+  bool _fieldOn;                          // As last switched by us; polls leave it on
+
+  int64_t _windowStart;                   // Host time of the window the last poll ran in
+  uint32_t _windows;                      // Windows polled in
+  uint32_t _polls;
+  uint32_t _unsyncedPolls;                // Polls without slots because the clock is not synced
+  uint32_t _roughPolls;                   // Polls without slots because the sync error leaves no room in the window
+  uint32_t _switches;
+  uint32_t _switchErrors;
+  unsigned long _fieldOffSince;           // millis() when the field went off
+  unsigned long _offMsTotal;
+};
+
+#endif
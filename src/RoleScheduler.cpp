@@ -0,0 +1,107 @@
+/**
+ * @file    RoleScheduler.cpp
+ * @brief   Time-multiplexed reader and card emulation roles on one PN532
+ */
+
+#include "RoleScheduler.h"
+
+/**
+ * @param serve Runs one emulation window, 0 if this build cannot emulate.
+ */
+RoleScheduler::RoleScheduler(RoleServeWindow serve)
+  : _serve(serve), _readerMs(0), _emulateMs(0), _readerStart(0), _lastEmptyPoll(0), _emptyPollSeen(false),
+    _lastIdleWindow(0), _idleWindowSeen(false), _detect({0, 0, 0}), _served({0, 0, 0}), _windows(0),
+    _emulateMsTotal(0) {
+}
+
+/**
+ * @brief Sets the duty cycle.
+ *
+ * @param readerMs  Reader window, at least ROLE_READER_MIN_MS.
+ * @param emulateMs Emulation window, 0 to read only.
+ * @return false if a window is out of range or emulation is not built in; nothing changes.
+ */
+bool RoleScheduler::configure(uint16_t readerMs, uint16_t emulateMs) {
+  if (emulateMs == 0) {
+    _emulateMs = 0;
+    return true;
+  }
+  if (_serve == 0 || readerMs < ROLE_READER_MIN_MS || readerMs > ROLE_WINDOW_MAX_MS || emulateMs > ROLE_WINDOW_MAX_MS) {
+    return false;
+  }
+  _readerMs = readerMs;
+  _emulateMs = emulateMs;
+  _readerStart = millis();
+  return true;
+}
+
+/**
+ * @brief Whether the reader window is over and serve() should run instead of readNFC().
+ */
+bool RoleScheduler::emulationDue() {
+  return _emulateMs != 0 && millis() - _readerStart >= _readerMs;
+}
+
+/**
+ * @brief Runs one emulation window, then starts the next reader window.
+ *
+ * Blocks for the window, or longer while a phone is being served.
+ */
+void RoleScheduler::serve() {
+  unsigned long start = millis();
+  bool served = _serve(_emulateMs);
+  unsigned long end = millis();
+  _windows++;
+  _emulateMsTotal += end - start;
+  if (served) {
+    if (_idleWindowSeen) { record(_served, end - _lastIdleWindow); }
+  } else {
+    _lastIdleWindow = end;
+    _idleWindowSeen = true;
+  }
+  _readerStart = end;
+}
+
+/**
+ * @brief Called by readNFC() after each poll.
+ *
+ * @param pollStart millis() when the poll was issued.
+ * @param found     A tag answered.
+ * @param arrival   The tag is new, not one that stayed in the field.
+ */
+void RoleScheduler::readerPolled(unsigned long pollStart, bool found, bool arrival) {
+  if (!found) {
+    _lastEmptyPoll = pollStart;
+    _emptyPollSeen = true;
+  } else if (arrival && _emptyPollSeen) {
+    record(_detect, millis() - _lastEmptyPoll);
+  }
+}
+
+/**
+ * @brief Prints the duty cycle, the cube detection and phone service bounds.
+ */
+void RoleScheduler::printStats(Print &out) {
+  if (_emulateMs == 0) {
+    out.println(String("ROLES: READER ONLY") + (_serve ? "" : ", EMULATION NOT BUILT IN"));
+  } else {
+    out.println("ROLES: READER " + String(_readerMs) + " MS EMULATE " + String(_emulateMs) + " MS DUTY " +
+                String(100 * _readerMs / (_readerMs + _emulateMs)) + "%");
+  }
+  out.println("CUBES: " + timing(_detect));
+  out.println("PHONES: " + timing(_served) + " WINDOWS " + String(_windows) + " EMULATE MS " + String(_emulateMsTotal));
+}
+
+void RoleScheduler::record(Timing &timing, unsigned long elapsed) {
+  timing.count++;
+  timing.msTotal += elapsed;
+  if (elapsed > timing.msMax) { timing.msMax = elapsed; }
+}
+
+String RoleScheduler::timing(const Timing &timing) {
+  String line = String(timing.count);
+  if (timing.count) {
+    line += " MS AVG " + String((float)timing.msTotal / timing.count, 1) + " MAX " + String(timing.msMax);
+  }
+  return line;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file    RoleScheduler.h
+ * @brief   Time-multiplexed reader and card emulation roles on one PN532
+ *
+ * A podium that reads cubes can also present an NDEF tag to visitors' phones.
+ * Reader polls and emulation both block the PN532, so the scheduler splits
+ * time into a reader window, in which readNFC() polls as usual, and an
+ * emulation window, one TgInitAsTarget that waits for a phone and serves it.
+ * Switching roles is only the next command: the PN532 is not reset or
+ * reconfigured, a pending target wait is aborted by the next
+ * InListPassiveTarget.
+ *
+ * Neither arrival time is seen by the podium, so both are reported as upper
+ * bounds. A cube arrived after the last reader poll that found nothing; a
+ * phone arrived after the last emulation window that served nobody.
+ */
+
+#ifndef ROLE_SCHEDULER_H
+#define ROLE_SCHEDULER_H
+
+#include <Arduino.h>
+
+#define ROLE_WINDOW_UNIT_MS   (10)        // Windows are stored in EEPROM in these units
+#define ROLE_WINDOW_MAX_MS    (2540)      // 0xFF units is erased EEPROM
+#define ROLE_READER_MIN_MS    (100)       // At least one full readNFC() poll per cycle
+
+// Waits up to timeout ms for a phone and serves it; returns true if one was served
+typedef bool (*RoleServeWindow)(uint16_t timeout);
+
+class RoleScheduler {
+public:
+  RoleScheduler(RoleServeWindow serve);
+
+  bool configure(uint16_t readerMs, uint16_t emulateMs);
+  uint16_t readerMs() const { return _readerMs; }
+  uint16_t emulateMs() const { return _emulateMs; }
+  bool available() const { return _serve != 0; }
+
+  bool emulationDue();
+  void serve();
+  void readerPolled(unsigned long pollStart, bool found, bool arrival);
+
+  void printStats(Print &out);
+
+private:
+  struct Timing {
+    uint32_t count;
+    unsigned long msTotal;
+    unsigned long msMax;
+  };
+
+  static void record(Timing &timing, unsigned long elapsed);
+  static String timing(const Timing &timing);
+
+  RoleServeWindow _serve;
+  uint16_t _readerMs;
+  uint16_t _emulateMs;                    // 0 = reader only
+  unsigned long _readerStart;             // Start of the current reader window
+
+  unsigned long _lastEmptyPoll;           // Start of the last poll that found no tag
+  bool _emptyPollSeen;
+  unsigned long _lastIdleWindow;          // End of the last window that served nobody
+  bool _idleWindowSeen;
+
+  Timing _detect;                         // Cube arrival bound to detection
+  Timing _served;                         // Phone arrival bound to served
+  uint32_t _windows;
+  unsigned long _emulateMsTotal;
+};
+
+#endif
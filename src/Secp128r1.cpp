@@ -0,0 +1,233 @@
+/**
+ * @file    Secp128r1.cpp
+ * @brief   ECDSA signature verification on the secp128r1 curve
+ */
+
+#include "Secp128r1.h"
+#include <string.h>
+
+namespace {
+
+// 128-bit unsigned integer, least significant limb first
+struct U128 {
+  uint32_t w[4];
+};
+
+struct Point {
+  U128 x, y, z;                   // Jacobian coordinates, z == 0 is the point at infinity
+};
+
+// Curve parameters, limbs least significant first
+const U128 P  = {{ 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFD }};
+const U128 N  = {{ 0x9038A115, 0x75A30D1B, 0x00000000, 0xFFFFFFFE }};
+const U128 GX = {{ 0xA52C5B86, 0x0C28607C, 0x8B899B2D, 0x161FF752 }};
+const U128 GY = {{ 0xDDED7A83, 0xC02DA292, 0x5BAFEB13, 0xCF5AC839 }};
+
+void fromBytes(U128 &r, const uint8_t *be, uint8_t len) {
+  memset(&r, 0, sizeof(r));
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t bit = (len - 1 - i) * 8;
+    r.w[bit / 32] |= (uint32_t)be[i] << (bit % 32);
+  }
+}
+
+bool isZero(const U128 &a) {
+  return (a.w[0] | a.w[1] | a.w[2] | a.w[3]) == 0;
+}
+
+int cmp(const U128 &a, const U128 &b) {
+  for (int i = 3; i >= 0; i--) {
+    if (a.w[i] != b.w[i]) { return a.w[i] > b.w[i] ? 1 : -1; }
+  }
+  return 0;
+}
+
+uint32_t add(U128 &r, const U128 &a, const U128 &b) {
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) {
+    carry += (uint64_t)a.w[i] + b.w[i];
+    r.w[i] = (uint32_t)carry;
+    carry >>= 32;
+  }
+  return (uint32_t)carry;
+}
+
+uint32_t sub(U128 &r, const U128 &a, const U128 &b) {
+  int64_t borrow = 0;
+  for (int i = 0; i < 4; i++) {
+    borrow += (int64_t)a.w[i] - b.w[i];
+    r.w[i] = (uint32_t)borrow;
+    borrow >>= 32;
+  }
+  return borrow ? 1 : 0;
+}
+
+bool bit(const U128 &a, int i) {
+  return (a.w[i / 32] >> (i % 32)) & 1;
+}
+
+void modAdd(U128 &r, const U128 &a, const U128 &b, const U128 &m) {
+  if (add(r, a, b) || cmp(r, m) >= 0) { sub(r, r, m); }
+}
+
+void modSub(U128 &r, const U128 &a, const U128 &b, const U128 &m) {
+  if (sub(r, a, b)) { add(r, r, m); }
+}
+
+// Schoolbook product followed by a bitwise reduction; inputs must be < m
+void modMul(U128 &r, const U128 &a, const U128 &b, const U128 &m) {
+  uint32_t t[8] = { 0 };
+  for (int i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < 4; j++) {
+      carry += (uint64_t)a.w[i] * b.w[j] + t[i + j];
+      t[i + j] = (uint32_t)carry;
+      carry >>= 32;
+    }
+    t[i + 4] = (uint32_t)carry;
+  }
+
+  U128 acc = {{ 0, 0, 0, 0 }};
+  for (int i = 255; i >= 0; i--) {
+    uint32_t top = acc.w[3] >> 31;
+    acc.w[3] = (acc.w[3] << 1) | (acc.w[2] >> 31);
+    acc.w[2] = (acc.w[2] << 1) | (acc.w[1] >> 31);
+    acc.w[1] = (acc.w[1] << 1) | (acc.w[0] >> 31);
+    acc.w[0] = (acc.w[0] << 1) | ((t[i / 32] >> (i % 32)) & 1);
+    if (top || cmp(acc, m) >= 0) { sub(acc, acc, m); }
+  }
+  r = acc;
+}
+
+// Fermat inversion, m must be prime
+void modInv(U128 &r, const U128 &a, const U128 &m) {
+  U128 e;
+  U128 two = {{ 2, 0, 0, 0 }};
+  sub(e, m, two);
+  U128 result = {{ 1, 0, 0, 0 }};
+  for (int i = 127; i >= 0; i--) {
+    modMul(result, result, result, m);
+    if (bit(e, i)) { modMul(result, result, a, m); }
+  }
+  r = result;
+}
+
+// dbl-2001-b, valid for a = -3
+void pointDouble(Point &r, const Point &p) {
+  if (isZero(p.z) || isZero(p.y)) { memset(&r, 0, sizeof(r)); return; }
+  U128 delta, gamma, beta, alpha, t1, t2;
+  modMul(delta, p.z, p.z, P);
+  modMul(gamma, p.y, p.y, P);
+  modMul(beta, p.x, gamma, P);
+  modSub(t1, p.x, delta, P);
+  modAdd(t2, p.x, delta, P);
+  modMul(alpha, t1, t2, P);
+  modAdd(t1, alpha, alpha, P);
+  modAdd(alpha, t1, alpha, P);                          // alpha = 3 (x - delta)(x + delta)
+
+  Point out;
+  modAdd(t1, p.y, p.z, P);
+  modMul(t1, t1, t1, P);
+  modSub(t1, t1, gamma, P);
+  modSub(out.z, t1, delta, P);                          // z3 = (y + z)^2 - gamma - delta
+
+  modAdd(t1, beta, beta, P);
+  modAdd(t1, t1, t1, P);                                // 4 beta
+  modAdd(t2, t1, t1, P);                                // 8 beta
+  modMul(out.x, alpha, alpha, P);
+  modSub(out.x, out.x, t2, P);                          // x3 = alpha^2 - 8 beta
+
+  modSub(t1, t1, out.x, P);
+  modMul(t1, alpha, t1, P);
+  modMul(t2, gamma, gamma, P);
+  modAdd(t2, t2, t2, P);
+  modAdd(t2, t2, t2, P);
+  modAdd(t2, t2, t2, P);                                // 8 gamma^2
+  modSub(out.y, t1, t2, P);                             // y3 = alpha (4 beta - x3) - 8 gamma^2
+  r = out;
+}
+
+void pointAdd(Point &r, const Point &p, const Point &q) {
+  if (isZero(p.z)) { r = q; return; }
+  if (isZero(q.z)) { r = p; return; }
+
+  U128 z1z1, z2z2, u1, u2, s1, s2, h, rr, t;
+  modMul(z1z1, p.z, p.z, P);
+  modMul(z2z2, q.z, q.z, P);
+  modMul(u1, p.x, z2z2, P);
+  modMul(u2, q.x, z1z1, P);
+  modMul(t, q.z, z2z2, P);
+  modMul(s1, p.y, t, P);
+  modMul(t, p.z, z1z1, P);
+  modMul(s2, q.y, t, P);
+  modSub(h, u2, u1, P);
+  modSub(rr, s2, s1, P);
+  if (isZero(h)) {
+    if (isZero(rr)) { pointDouble(r, p); }
+    else { memset(&r, 0, sizeof(r)); }
+    return;
+  }
+
+  Point out;
+  U128 hh, hhh, v;
+  modMul(hh, h, h, P);
+  modMul(hhh, h, hh, P);
+  modMul(v, u1, hh, P);
+  modMul(out.x, rr, rr, P);
+  modSub(out.x, out.x, hhh, P);
+  modSub(out.x, out.x, v, P);
+  modSub(out.x, out.x, v, P);                           // x3 = r^2 - h^3 - 2 u1 h^2
+  modSub(t, v, out.x, P);
+  modMul(t, rr, t, P);
+  modMul(s1, s1, hhh, P);
+  modSub(out.y, t, s1, P);                              // y3 = r (u1 h^2 - x3) - s1 h^3
+  modMul(t, p.z, q.z, P);
+  modMul(out.z, t, h, P);                               // z3 = z1 z2 h
+  r = out;
+}
+
+}  // namespace
+
+bool secp128r1Verify(const uint8_t publicKey[SECP128R1_KEY_SIZE], const uint8_t *message, uint8_t messageLength,
+                     const uint8_t signature[SECP128R1_SIGNATURE_SIZE]) {
+  if (messageLength > 16) { return false; }
+
+  U128 r, s, e;
+  fromBytes(r, signature, 16);
+  fromBytes(s, signature + 16, 16);
+  fromBytes(e, message, messageLength);
+  if (isZero(r) || isZero(s) || cmp(r, N) >= 0 || cmp(s, N) >= 0) { return false; }
+  if (cmp(e, N) >= 0) { sub(e, e, N); }
+
+  U128 w, u1, u2;
+  modInv(w, s, N);
+  modMul(u1, e, w, N);
+  modMul(u2, r, w, N);
+
+  Point g = { GX, GY, {{ 1, 0, 0, 0 }} };
+  Point q;
+  fromBytes(q.x, publicKey, 16);
+  fromBytes(q.y, publicKey + 16, 16);
+  q.z = g.z;
+  Point gq;
+  pointAdd(gq, g, q);
+
+  // Shamir's trick: u1 G + u2 Q in a single pass over the scalar bits
+  Point acc;
+  memset(&acc, 0, sizeof(acc));
+  for (int i = 127; i >= 0; i--) {
+    pointDouble(acc, acc);
+    bool b1 = bit(u1, i), b2 = bit(u2, i);
+    if (b1 && b2) { pointAdd(acc, acc, gq); }
+    else if (b1) { pointAdd(acc, acc, g); }
+    else if (b2) { pointAdd(acc, acc, q); }
+  }
+  if (isZero(acc.z)) { return false; }
+
+  U128 zInv, x;
+  modInv(zInv, acc.z, P);
+  modMul(zInv, zInv, zInv, P);
+  modMul(x, acc.x, zInv, P);
+  if (cmp(x, N) >= 0) { sub(x, x, N); }
+  return cmp(x, r) == 0;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file    Secp128r1.h
+ * @brief   ECDSA signature verification on the secp128r1 curve
+ *
+ * Minimal implementation for checking NXP originality signatures: 128-bit
+ * modular arithmetic on 32-bit limbs, Jacobian point arithmetic and a
+ * Shamir double-scalar multiplication. Verification only, no secrets are
+ * handled, so nothing here needs to run in constant time.
+ */
+
+#ifndef SECP128R1_H
+#define SECP128R1_H
+
+#include <stdint.h>
+
+#define SECP128R1_KEY_SIZE        (32)    // Uncompressed public key without the 0x04 prefix: x || y
+#define SECP128R1_SIGNATURE_SIZE  (32)    // r || s
+
+/**
+ * @brief Verifies an ECDSA signature over an unhashed message.
+ *
+ * The message is used directly as the integer e, as NXP does for UID signatures.
+ *
+ * @param publicKey     Public key x || y, big-endian.
+ * @param message       Message bytes, big-endian, at most 16 bytes.
+ * @param messageLength Length of the message.
+ * @param signature     Signature r || s, big-endian.
+ * @return true if the signature is valid for the message and key.
+ */
+bool secp128r1Verify(const uint8_t publicKey[SECP128R1_KEY_SIZE], const uint8_t *message, uint8_t messageLength,
+                     const uint8_t signature[SECP128R1_SIGNATURE_SIZE]);
+
+#endif
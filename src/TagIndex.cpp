@@ -0,0 +1,57 @@
+/**
+ * @file    TagIndex.cpp
+ * @brief   Hashed lookup from a routing key to its tag table index
+ */
+
+#include "TagIndex.h"
+
+TagIndex::TagIndex() : _keys(NULL) {
+  memset(_slots, TAG_INDEX_EMPTY, sizeof(_slots));
+}
+
+/**
+ * @brief Rebuilds the index over the tag table. Call after any change to the table.
+ *
+ * @param keys  The tag table. It must stay valid for as long as the index is used.
+ * @param count Number of valid entries.
+ */
+void TagIndex::rebuild(const String *keys, uint8_t count) {
+  _keys = keys;
+  memset(_slots, TAG_INDEX_EMPTY, sizeof(_slots));
+  for (uint8_t i = 0; i < count; i++) {
+    if (keys[i].length() == 0 || find(keys[i]) >= 0) { continue; }   // Empty slot or duplicate
+    uint32_t h = hash((const uint8_t *)keys[i].c_str(), keys[i].length());
+    uint8_t slot = h & (TAG_INDEX_SLOTS - 1);
+    while (_slots[slot] != TAG_INDEX_EMPTY) { slot = (slot + 1) & (TAG_INDEX_SLOTS - 1); }
+    _hashes[slot] = h;
+    _slots[slot] = i;
+  }
+}
+
+/**
+ * @brief Looks up a routing key.
+ *
+ * @return The tag table index, or -1 if the key is unknown.
+ */
+int TagIndex::find(const String &key) const {
+  if (_keys == NULL) { return -1; }
+  uint32_t h = hash((const uint8_t *)key.c_str(), key.length());
+  uint8_t slot = h & (TAG_INDEX_SLOTS - 1);
+  while (_slots[slot] != TAG_INDEX_EMPTY) {
+    if (_hashes[slot] == h && _keys[_slots[slot]] == key) { return _slots[slot]; }
+    slot = (slot + 1) & (TAG_INDEX_SLOTS - 1);
+  }
+  return -1;
+}
+
+/**
+ * @brief 32-bit FNV-1a hash.
+ */
+uint32_t TagIndex::hash(const uint8_t *data, uint16_t length) {
+  uint32_t h = 2166136261UL;
+  for (uint16_t i = 0; i < length; i++) {
+    h ^= data[i];
+    h *= 16777619UL;
+  }
+  return h;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file    TagIndex.h
+ * @brief   Hashed lookup from a routing key to its tag table index
+ *
+ * Replaces the linear String comparison over the tag table. Keys are hashed
+ * with 32-bit FNV-1a into an open-addressing table; a String comparison is only
+ * made when the hashes match. The first index holding a key wins, as with the
+ * linear scan it replaces.
+ */
+
+#ifndef TAG_INDEX_H
+#define TAG_INDEX_H
+
+#include <Arduino.h>
+
+#define TAG_INDEX_SLOTS   (64)    // Power of two, at least twice the tag table size
+#define TAG_INDEX_EMPTY   (0xFF)
+
+class TagIndex {
+public:
+  TagIndex();
+
+  void rebuild(const String *keys, uint8_t count);
+  int find(const String &key) const;
+
+  static uint32_t hash(const uint8_t *data, uint16_t length);
+
+private:
+  const String *_keys;
+  uint32_t _hashes[TAG_INDEX_SLOTS];
+  uint8_t _slots[TAG_INDEX_SLOTS];  // Tag table index, TAG_INDEX_EMPTY if free
+};
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file    TagTable.cpp
+ * @brief   A/B tag table image in a dedicated flash partition, mapped through the flash cache
+ */
+
+#include "TagTable.h"
+#include <rom/crc.h>
+
+TagTable::TagTable()
+  : _partition(NULL), _slotSize(0), _activeSlot(TAG_TABLE_NO_SLOT), _mapHandle(0), _updating(false),
+    _updateSlot(0), _updateSize(0), _updateOffset(0), _updateReceived(0), _mountMicros(0), _lookups(0), _hits(0),
+    _lookupMicros(0), _decodes(0), _decodeMicros(0), _decodeMicrosMax(0) {
+}
+
+/**
+ * @brief Locates the tag table partition and maps the slot holding the newest valid image.
+ *
+ * Only the two headers are read, the image itself stays in flash.
+ *
+ * @return false if there is no partition or no valid image; lookups then find nothing.
+ */
+bool TagTable::begin() {
+  unsigned long start = micros();
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)TAG_TABLE_PARTITION_SUBTYPE,
+                                        TAG_TABLE_PARTITION_LABEL);
+  if (_partition == NULL) { return false; }
+  // Each slot starts on a flash MMU page so it can be mapped on its own
+  _slotSize = (_partition->size / 2) & ~(uint32_t)(SPI_FLASH_MMU_PAGE_SIZE - 1);
+  if (_slotSize > TAG_TABLE_MAX_SLOT_SECTORS * SPI_FLASH_SEC_SIZE) { _slotSize = TAG_TABLE_MAX_SLOT_SECTORS * SPI_FLASH_SEC_SIZE; }
+
+  TagTableHeader a, b;
+  bool validA = readHeader(0, a);
+  bool validB = readHeader(1, b);
+  bool mounted = false;
+  if (validA && validB) {
+    uint8_t newest = (b.generation > a.generation) ? 1 : 0;
+    mounted = mountSlot(newest) || mountSlot(1 - newest);
+  } else if (validA || validB) {
+    mounted = mountSlot(validA ? 0 : 1);
+  }
+  _mountMicros = micros() - start;
+  return mounted;
+}
+
+/**
+ * @brief Looks a routing key up in the mapped image.
+ *
+ * @return The entry, in mapped flash, or NULL if the key is unknown or no image is installed.
+ */
+const TagTableEntry *TagTable::find(const String &key) {
+  if (!_image.mounted() || key.length() > 0xFF) { return NULL; }
+  unsigned long start = micros();
+  const TagTableEntry *entry = _image.find(key.c_str(), key.length());
+  _lookupMicros += micros() - start;
+  _lookups++;
+  if (entry) { _hits++; }
+  return entry;
+}
+
+/**
+ * @brief Decodes the command of an entry into out, a buffer of TAG_TABLE_COMMAND_MAX bytes.
+ *
+ * @return Length of the command, 0 if the pool is damaged.
+ */
+uint8_t TagTable::command(const TagTableEntry *entry, char *out) {
+  unsigned long start = micros();
+  uint8_t length = _image.command(entry, out);
+  unsigned long elapsed = micros() - start;
+  _decodes++;
+  _decodeMicros += elapsed;
+  if (elapsed > _decodeMicrosMax) { _decodeMicrosMax = elapsed; }
+  return length;
+}
+
+/**
+ * @brief Starts receiving a new image into the inactive slot.
+ *
+ * The first sector of the slot is erased right away, so a stale header in it can no longer
+ * be taken for a valid image. Later sectors are erased when data first reaches them.
+ *
+ * @param size Size of the complete image, header included.
+ */
+bool TagTable::beginUpdate(uint32_t size) {
+  _updating = false;
+  if (_partition == NULL || size < sizeof(TagTableHeader) || size > _slotSize) { return false; }
+  _updateSlot = (_activeSlot == 0) ? 1 : 0;
+  _updateSize = size;
+  _updateOffset = 0;
+  _updateReceived = 0;
+  memset(_erased, 0, sizeof(_erased));
+  if (esp_partition_erase_range(_partition, _updateSlot * _slotSize, SPI_FLASH_SEC_SIZE) != ESP_OK) { return false; }
+  _erased[0] = 1;
+  memset(&_pendingHeader, 0xFF, sizeof(_pendingHeader));
+  _updating = true;
+  return true;
+}
+
+/**
+ * @brief Appends the next bytes of the image.
+ */
+bool TagTable::writeUpdate(const uint8_t *data, uint16_t length) {
+  if (!writeUpdateAt(_updateOffset, data, length)) { return false; }
+  _updateOffset += length;
+  return true;
+}
+
+/**
+ * @brief Writes image bytes at any offset, for updates that arrive out of order.
+ *
+ * The header is kept in RAM, the rest goes to flash. Each byte must be written once;
+ * the CRC check in commitUpdate() catches anything missing.
+ */
+bool TagTable::writeUpdateAt(uint32_t offset, const uint8_t *data, uint16_t length) {
+  if (!_updating || offset + length > _updateSize) { return false; }
+  _updateReceived += length;
+  while (length && offset < sizeof(TagTableHeader)) {
+    ((uint8_t *)&_pendingHeader)[offset++] = *data++;
+    length--;
+  }
+  if (length == 0) { return true; }
+
+  uint32_t base = _updateSlot * _slotSize;
+  bool ok = true;
+  for (uint32_t sector = offset / SPI_FLASH_SEC_SIZE; ok && sector <= (offset + length - 1) / SPI_FLASH_SEC_SIZE; sector++) {
+    if (_erased[sector / 8] & (1 << (sector % 8))) { continue; }
+    ok = esp_partition_erase_range(_partition, base + sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) == ESP_OK;
+    _erased[sector / 8] |= 1 << (sector % 8);
+  }
+  ok = ok && esp_partition_write(_partition, base + offset, data, length) == ESP_OK;
+  if (!ok) { _updating = false; }                 // The update has to start over
+  return ok;
+}
+
+/**
+ * @brief Verifies the streamed image and makes it the active one.
+ *
+ * The header is written last, with a generation one above the image in use, so until that
+ * write completes the previous image stays active.
+ */
+bool TagTable::commitUpdate() {
+  if (!_updating || _updateReceived < _updateSize) { return false; }
+  _updating = false;
+  if (!TagTableImage::validHeader(_pendingHeader, _slotSize) || _pendingHeader.imageSize != _updateSize) { return false; }
+  if (bodyCrc(_updateSlot, _updateSize) != _pendingHeader.crc) { return false; }
+
+  const TagTableHeader *active = _image.header();
+  _pendingHeader.generation = active ? active->generation + 1 : 1;
+  if (esp_partition_write(_partition, _updateSlot * _slotSize, &_pendingHeader, sizeof(_pendingHeader)) != ESP_OK) {
+    return false;
+  }
+  uint8_t previous = _activeSlot;
+  unsigned long start = micros();
+  unmountSlot();
+  bool mounted = mountSlot(_updateSlot) || (previous != TAG_TABLE_NO_SLOT && mountSlot(previous));
+  _mountMicros = micros() - start;
+  return mounted && _activeSlot == _updateSlot;
+}
+
+/**
+ * @brief Prints the active slot and generation, table size, mount time, lookup and decode timing.
+ */
+void TagTable::printStats(Print &out) {
+  if (_partition == NULL) { out.println("TAG TABLE: NO PARTITION"); return; }
+  const TagTableHeader *header = _image.header();
+  if (header == NULL) {
+    out.println("TAG TABLE: NO IMAGE");
+  } else {
+    out.println("TAG TABLE: SLOT " + String(_activeSlot ? "B" : "A") + " GEN " + String(header->generation) +
+                " TAGS " + String(header->count) + " SIZE " + String(header->imageSize) + "/" + String(_slotSize) +
+                " CONFIG " + String(header->configVersion));
+    out.println("LOAD: " + String(100.0f * header->count / header->slotCount, 1) + "% MOUNT US: " + String(_mountMicros));
+    out.println("COMMANDS: " + String(header->commandCount) + " POOL: " + String(header->imageSize - header->poolOffset));
+  }
+  String line = "LOOKUPS: " + String(_lookups) + " HITS: " + String(_hits);
+  if (_lookups) { line += " US AVG: " + String((float)_lookupMicros / _lookups, 1); }
+  out.println(line);
+  if (_decodes) {
+    out.println("DECODES: " + String(_decodes) + " US AVG: " + String((float)_decodeMicros / _decodes, 1) +
+                " MAX: " + String(_decodeMicrosMax));
+  }
+  if (_updating) { out.println("UPDATE: " + String(_updateReceived) + "/" + String(_updateSize)); }
+}
+
+bool TagTable::readHeader(uint8_t slot, TagTableHeader &header) {
+  if (esp_partition_read(_partition, slot * _slotSize, &header, sizeof(header)) != ESP_OK) { return false; }
+  return TagTableImage::validHeader(header, _slotSize);
+}
+
+bool TagTable::mountSlot(uint8_t slot) {
+  TagTableHeader header;
+  if (!readHeader(slot, header)) { return false; }
+  const void *image;
+  if (esp_partition_mmap(_partition, slot * _slotSize, header.imageSize, ESP_PARTITION_MMAP_DATA, &image,
+                         &_mapHandle) != ESP_OK) {
+    return false;
+  }
+  if (!_image.mount((const uint8_t *)image, header.imageSize)) {
+    spi_flash_munmap(_mapHandle);
+    return false;
+  }
+  _activeSlot = slot;
+  return true;
+}
+
+void TagTable::unmountSlot() {
+  if (_activeSlot == TAG_TABLE_NO_SLOT) { return; }
+  _image.unmount();
+  spi_flash_munmap(_mapHandle);
+  _activeSlot = TAG_TABLE_NO_SLOT;
+}
+
+/**
+ * @brief CRC-32 of everything after the header, read back from flash.
+ */
+uint32_t TagTable::bodyCrc(uint8_t slot, uint32_t size) {
+  uint8_t chunk[TAG_TABLE_CRC_CHUNK];
+  uint32_t crc = 0;
+  for (uint32_t offset = sizeof(TagTableHeader); offset < size; offset += sizeof(chunk)) {
+    uint32_t length = (size - offset < sizeof(chunk)) ? size - offset : sizeof(chunk);
+    esp_partition_read(_partition, slot * _slotSize + offset, chunk, length);
+    crc = crc32_le(crc, chunk, length);
+  }
+  return crc;
+}
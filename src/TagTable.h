@@ -0,0 +1,73 @@
+/**
+ * @file    TagTable.h
+ * @brief   A/B tag table image in a dedicated flash partition, mapped through the flash cache
+ *
+ * The "tagtable" data partition (see partitions.csv) is split into two slots.
+ * The active slot is mapped with esp_partition_mmap and read in place, so the
+ * table costs neither heap nor boot time however many tags it holds. An update
+ * is streamed into the inactive slot, its CRC checked, and its header written
+ * last with the next generation number, which makes it the active slot. A
+ * power loss during an update leaves the previous image in use.
+ */
+
+#ifndef TAG_TABLE_H
+#define TAG_TABLE_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "TagTableImage.h"
+
+#define TAG_TABLE_PARTITION_LABEL   "tagtable"
+#define TAG_TABLE_PARTITION_SUBTYPE (0x41)
+#define TAG_TABLE_NO_SLOT           (0xFF)
+#define TAG_TABLE_CRC_CHUNK         (256)         // Bytes read per step of the install CRC check
+#define TAG_TABLE_MAX_SLOT_SECTORS  (128)         // Slots are capped at 512 KB
+
+class TagTable {
+public:
+  TagTable();
+
+  bool begin();
+  const TagTableEntry *find(const String &key);
+  uint8_t command(const TagTableEntry *entry, char *out);
+
+  bool beginUpdate(uint32_t size);
+  bool writeUpdate(const uint8_t *data, uint16_t length);
+  bool writeUpdateAt(uint32_t offset, const uint8_t *data, uint16_t length);
+  bool commitUpdate();
+  uint32_t updateOffset() const { return _updateOffset; }
+  uint32_t configVersion() const { return _image.mounted() ? _image.header()->configVersion : 0; }
+
+  bool mounted() const { return _image.mounted(); }
+  void printStats(Print &out);
+
+private:
+  const esp_partition_t *_partition;
+  uint32_t _slotSize;
+  uint8_t _activeSlot;                            // 0 = A, 1 = B, TAG_TABLE_NO_SLOT if none
+  spi_flash_mmap_handle_t _mapHandle;
+  TagTableImage _image;
+
+  bool _updating;
+  uint8_t _updateSlot;
+  uint32_t _updateSize;
+  uint32_t _updateOffset;                         // End of the last sequential write
+  uint32_t _updateReceived;                       // Bytes written in any order
+  uint8_t _erased[TAG_TABLE_MAX_SLOT_SECTORS / 8]; // Sectors of the update slot erased so far
+  TagTableHeader _pendingHeader;                  // Held in RAM until the body is verified
+
+  unsigned long _mountMicros;
+  uint32_t _lookups;
+  uint32_t _hits;
+  unsigned long _lookupMicros;
+  uint32_t _decodes;
+  unsigned long _decodeMicros;
+  unsigned long _decodeMicrosMax;
+
+  bool readHeader(uint8_t slot, TagTableHeader &header);
+  bool mountSlot(uint8_t slot);
+  void unmountSlot();
+  uint32_t bodyCrc(uint8_t slot, uint32_t size);
+};
+
+#endif
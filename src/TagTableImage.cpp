@@ -0,0 +1,139 @@
+/**
+ * @file    TagTableImage.cpp
+ * @brief   Binary tag table image, read in place from mapped flash
+ */
+
+#include "TagTableImage.h"
+#include <string.h>
+
+TagTableImage::TagTableImage() : _image(NULL), _header(NULL), _slots(NULL), _pool(NULL), _blocks(NULL), _words(NULL) {
+}
+
+/**
+ * @brief Checks a header for consistency, without touching the rest of the image.
+ *
+ * @param header  The header to check.
+ * @param maxSize Room available for the image.
+ */
+bool TagTableImage::validHeader(const TagTableHeader &header, uint32_t maxSize) {
+  if (header.magic != TAG_TABLE_MAGIC || header.version != TAG_TABLE_VERSION) { return false; }
+  if (header.headerSize != sizeof(TagTableHeader)) { return false; }
+  if (header.count >= header.slotCount) { return false; }           // Probing needs a free slot
+  if (header.imageSize > TAG_TABLE_MAX_IMAGE) { return false; }
+  uint64_t tableEnd = sizeof(TagTableHeader) + (uint64_t)header.slotCount * sizeof(TagTableSlot);
+  uint64_t blocks = ((uint64_t)header.commandCount + TAG_TABLE_POOL_BLOCK - 1) / TAG_TABLE_POOL_BLOCK;
+  uint64_t poolStart = header.poolOffset + blocks * sizeof(uint32_t) + (TAG_TABLE_DICT_WORDS + 1) * sizeof(uint16_t);
+  if (header.poolOffset < tableEnd || (header.poolOffset & 3) != 0) { return false; }
+  return poolStart <= header.imageSize && header.imageSize <= maxSize;
+}
+
+/**
+ * @brief Mounts an image that is already in memory. Only the header is checked; the CRC
+ * is checked once when an image is installed, not on every boot.
+ *
+ * @param image Start of the image, 4-byte aligned. It must stay valid while mounted.
+ * @param size  Bytes available at image.
+ */
+bool TagTableImage::mount(const uint8_t *image, uint32_t size) {
+  unmount();
+  if (image == NULL || size < sizeof(TagTableHeader)) { return false; }
+  const TagTableHeader *header = (const TagTableHeader *)image;
+  if (!validHeader(*header, size)) { return false; }
+  _image = image;
+  _header = header;
+  _slots = (const TagTableSlot *)(image + sizeof(TagTableHeader));
+  _pool = image + header->poolOffset;
+  _blocks = (const uint32_t *)_pool;
+  _words = (const uint16_t *)(_blocks + (header->commandCount + TAG_TABLE_POOL_BLOCK - 1) / TAG_TABLE_POOL_BLOCK);
+  return true;
+}
+
+void TagTableImage::unmount() {
+  _image = NULL;
+  _header = NULL;
+  _slots = NULL;
+  _pool = NULL;
+  _blocks = NULL;
+  _words = NULL;
+}
+
+/**
+ * @brief Looks a routing key up. Touches one slot per probe and one entry per hash match.
+ *
+ * Only the header is checked on mount, so a slot is trusted only if its entry and key
+ * lie between the slot table and the command pool. Offsets are stored / 4, so an entry
+ * is always aligned.
+ *
+ * @return The entry, pointing into the image, or NULL if the key is not in the table.
+ */
+const TagTableEntry *TagTableImage::find(const char *key, uint8_t keyLength) const {
+  if (_header == NULL) { return NULL; }
+  uint32_t h = hash((const uint8_t *)key, keyLength);
+  uint32_t count = _header->slotCount;
+  uint32_t first = sizeof(TagTableHeader) + count * sizeof(TagTableSlot);   // Fits, see validHeader()
+  uint32_t end = _header->poolOffset;
+  uint32_t slot = (uint32_t)(((uint64_t)h * count) >> 32);
+  for (uint32_t probe = 0; probe < count; probe++, slot = slot + 1 == count ? 0 : slot + 1) {
+    const TagTableSlot &s = _slots[slot];
+    if (s.value == TAG_TABLE_SLOT_EMPTY) { return NULL; }
+    uint32_t offset = entryOffset(s);
+    if (s.value >> TAG_TABLE_SLOT_SHIFT != h >> TAG_TABLE_SLOT_SHIFT) { continue; }
+    if (offset < first || offset + sizeof(TagTableEntry) + keyLength > end) { continue; }
+    const TagTableEntry *entry = (const TagTableEntry *)(_image + offset);
+    if (entry->keyLength == keyLength && memcmp(TagTableImage::key(entry), key, keyLength) == 0) { return entry; }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Decodes the command of an entry from the front-coded pool.
+ *
+ * Starts at the head of the command's block and applies each shared prefix and rest in
+ * turn, so the cost is bounded by TAG_TABLE_POOL_BLOCK short runs. Bounds are checked
+ * against the image, as only the header is checked on mount.
+ *
+ * @param entry An entry returned by find().
+ * @param out   Buffer of TAG_TABLE_COMMAND_MAX bytes, not terminated.
+ * @return Length of the command, 0 if the pool is damaged.
+ */
+uint8_t TagTableImage::command(const TagTableEntry *entry, char *out) const {
+  if (_header == NULL || entry->command >= _header->commandCount) { return 0; }
+  uint32_t block = entry->command / TAG_TABLE_POOL_BLOCK;
+  uint32_t poolSize = _header->imageSize - _header->poolOffset;
+  uint32_t pos = _blocks[block];
+  uint16_t length = 0;
+  for (uint32_t i = block * TAG_TABLE_POOL_BLOCK; ; i++) {
+    if (pos + 2 > poolSize) { return 0; }
+    uint8_t shared = _pool[pos], rest = _pool[pos + 1];
+    pos += 2;
+    if (shared > length || pos + rest > poolSize) { return 0; }
+    length = shared;
+    for (uint32_t end = pos + rest; pos < end; pos++) {
+      uint8_t code = _pool[pos];
+      if (code < 0x80 || (code == 0xFF && ++pos < end)) {
+        if (length == TAG_TABLE_COMMAND_MAX) { return 0; }
+        out[length++] = _pool[pos];
+        continue;
+      }
+      if (code == 0xFF) { return 0; }
+      uint16_t start = _words[code - 0x80], stop = _words[code - 0x80 + 1];
+      if (stop < start || stop > poolSize || length + (stop - start) > TAG_TABLE_COMMAND_MAX) { return 0; }
+      memcpy(out + length, _pool + start, stop - start);
+      length += stop - start;
+    }
+    if (i == entry->command) { break; }
+  }
+  return length == entry->commandLength ? length : 0;
+}
+
+/**
+ * @brief 32-bit FNV-1a hash, the same as TagIndex::hash().
+ */
+uint32_t TagTableImage::hash(const uint8_t *data, uint16_t length) {
+  uint32_t h = 2166136261UL;
+  for (uint16_t i = 0; i < length; i++) {
+    h ^= data[i];
+    h *= 16777619UL;
+  }
+  return h;
+}
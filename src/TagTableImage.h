@@ -0,0 +1,108 @@
+/**
+ * @file    TagTableImage.h
+ * @brief   Binary tag table image, read in place from mapped flash
+ *
+ * The image is built on the host (tools/tagtable/build_image.py) in its final
+ * form: a header, an open-addressing hash table of slots, a pool of entries
+ * holding a routing key and the number of its command, and the command pool.
+ * Lookups read the image where it lies, so nothing is copied to RAM and
+ * mounting only checks the header.
+ *
+ * Cue commands are long and share prefixes (SHOW1_SCENE_12_...), so the pool
+ * holds each distinct command once, sorted and front coded: every command
+ * stores how many leading bytes it shares with the one before and the rest,
+ * in which frequent words (_AUDIO_FADE_OUT) are single dictionary codes.
+ * Commands come in blocks of TAG_TABLE_POOL_BLOCK, the first of each stored in
+ * full, so decoding one walks at most a block.
+ * The module has no Arduino dependency so the host benchmark can use it on an
+ * mmap'ed file.
+ *
+ * All fields are little endian and 4-byte aligned, as the ESP32 cannot make
+ * unaligned loads from mapped flash.
+ */
+
+#ifndef TAG_TABLE_IMAGE_H
+#define TAG_TABLE_IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TAG_TABLE_MAGIC       (0x4C425454UL)    // "TTBL"
+#define TAG_TABLE_VERSION     (3)
+#define TAG_TABLE_SLOT_EMPTY  (0xFFFFFFFFUL)    // Erased flash
+#define TAG_TABLE_SLOT_SHIFT  (17)              // Slot bits below the hash tag: entry offset / 4
+#define TAG_TABLE_MAX_IMAGE   ((1UL << TAG_TABLE_SLOT_SHIFT) * 4 - 4)   // Largest entry offset a slot holds
+#define TAG_TABLE_POOL_BLOCK  (16)              // Commands per front-coded block
+#define TAG_TABLE_COMMAND_MAX (255)             // Longest decoded command
+#define TAG_TABLE_DICT_WORDS  (127)             // Codes 0x80-0xFE, 0xFF escapes a literal byte
+
+/**
+ * @brief Image header. 40 bytes, written last so a torn update never looks valid.
+ */
+struct TagTableHeader {
+  uint32_t magic;         // TAG_TABLE_MAGIC
+  uint16_t version;       // TAG_TABLE_VERSION
+  uint16_t headerSize;    // sizeof(TagTableHeader)
+  uint32_t generation;    // The valid A/B slot with the highest generation is active
+  uint32_t count;         // Entries in the pool
+  uint32_t slotCount;     // Hash slots, at most 3/4 full
+  uint32_t imageSize;     // Header, slots, entries and command pool in bytes
+  uint32_t crc;           // CRC-32 of bytes [headerSize, imageSize)
+  uint32_t configVersion;  // Version of a broadcast config push, 0 if installed over the console
+  uint32_t poolOffset;    // Image offset of the command pool
+  uint32_t commandCount;  // Distinct commands in the pool
+};
+
+/**
+ * @brief Hash slot. A key hashes to slot (hash * slotCount) >> 32 and probes on from there.
+ */
+struct TagTableSlot {
+  uint32_t value;         // Top 15 bits of the key's FNV-1a, then the entry's offset / 4; TAG_TABLE_SLOT_EMPTY if free
+};
+
+/**
+ * @brief Entry, followed by the key bytes and padded to 4 bytes. A UID key of 14 hex
+ * digits makes a 20-byte entry.
+ */
+struct TagTableEntry {
+  uint16_t index;         // Tag number given by the host, 0 based
+  uint8_t  keyLength;
+  uint8_t  commandLength; // Decoded length of the command
+  uint16_t command;       // Number of the command in the pool
+};
+
+/*
+ * The command pool starts with one uint32_t per block, the offset of the block from the
+ * start of the pool, then TAG_TABLE_DICT_WORDS + 1 uint16_t pool offsets bounding the
+ * dictionary words. A block is a run of commands, each a byte with the length shared
+ * with the previous command, a byte with the encoded length of the rest, and the rest.
+ * The first command of a block shares nothing.
+ */
+
+class TagTableImage {
+public:
+  TagTableImage();
+
+  bool mount(const uint8_t *image, uint32_t size);
+  void unmount();
+  const TagTableEntry *find(const char *key, uint8_t keyLength) const;
+
+  bool mounted() const { return _header != NULL; }
+  const TagTableHeader *header() const { return _header; }
+
+  static bool validHeader(const TagTableHeader &header, uint32_t maxSize);
+  static uint32_t hash(const uint8_t *data, uint16_t length);
+  static const char *key(const TagTableEntry *entry) { return (const char *)entry + sizeof(TagTableEntry); }
+  static uint32_t entryOffset(const TagTableSlot &slot) { return (slot.value & ((1UL << TAG_TABLE_SLOT_SHIFT) - 1)) * 4; }
+  uint8_t command(const TagTableEntry *entry, char *out) const;
+
+private:
+  const uint8_t *_image;
+  const TagTableHeader *_header;
+  const TagTableSlot *_slots;
+  const uint8_t *_pool;
+  const uint32_t *_blocks;
+  const uint16_t *_words;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file    TimedNfcReader.cpp
+ * @brief   NfcReader decorator that measures driver latency
+ */
+
+#include "TimedNfcReader.h"
+
+TimedNfcReader::TimedNfcReader(NfcReader &reader) : _reader(reader), _exchangeErrors(0) {
+  memset(&_detectHit, 0, sizeof(_detectHit));
+  memset(&_detectMiss, 0, sizeof(_detectMiss));
+  memset(&_exchange, 0, sizeof(_exchange));
+}
+
+bool TimedNfcReader::readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout) {
+  unsigned long start = micros();
+  bool found = _reader.readPassiveTargetID(uid, uidLength, timeout);
+  record(found ? _detectHit : _detectMiss, micros() - start);
+  return found;
+}
+
+bool TimedNfcReader::inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength) {
+  unsigned long start = micros();
+  bool ok = _reader.inDataExchange(send, sendLength, response, responseLength);
+  record(_exchange, micros() - start);
+  if (!ok) { _exchangeErrors++; }
+  return ok;
+}
+
+void TimedNfcReader::record(Timing &timing, unsigned long elapsed) {
+  timing.count++;
+  timing.microsTotal += elapsed;
+  if (elapsed > timing.microsMax) { timing.microsMax = elapsed; }
+}
+
+void TimedNfcReader::printTiming(Print &out, const char *label, const Timing &timing) {
+  String line = String(label) + ": " + String(timing.count);
+  if (timing.count) { line += " US AVG: " + String(timing.microsTotal / timing.count) + " MAX: " + String(timing.microsMax); }
+  out.println(line);
+}
+
+/**
+ * @brief Prints the driver name and the latency of detections and exchanges.
+ */
+void TimedNfcReader::printStats(Print &out) {
+  out.println("READER: " + String(_reader.name()));
+  printTiming(out, "DETECT HIT", _detectHit);
+  printTiming(out, "DETECT MISS", _detectMiss);
+  printTiming(out, "EXCHANGE", _exchange);
+  out.println("EXCHANGE ERRORS: " + String(_exchangeErrors));
+}
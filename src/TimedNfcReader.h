@@ -0,0 +1,47 @@
+/**
+ * @file    TimedNfcReader.h
+ * @brief   NfcReader decorator that measures driver latency
+ *
+ * Wraps the reader in use and times every detection poll and data exchange, so
+ * the in-tree and Adafruit drivers can be compared on the same hardware by
+ * flashing each environment and reading the "LS" report.
+ */
+
+#ifndef TIMED_NFC_READER_H
+#define TIMED_NFC_READER_H
+
+#include "NfcReader.h"
+
+class TimedNfcReader : public NfcReader {
+public:
+  TimedNfcReader(NfcReader &reader);
+
+  void begin() { _reader.begin(); }
+  uint32_t getFirmwareVersion() { return _reader.getFirmwareVersion(); }
+  bool SAMConfig() { return _reader.SAMConfig(); }
+  bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout);
+  bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
+  bool setRFField(bool on) { return _reader.setRFField(on); }
+  int16_t lastError() { return _reader.lastError(); }
+  const char *name() { return _reader.name(); }
+
+  void printStats(Print &out);
+
+private:
+  struct Timing {
+    uint32_t count;
+    unsigned long microsTotal;
+    unsigned long microsMax;
+  };
+
+  static void record(Timing &timing, unsigned long elapsed);
+  static void printTiming(Print &out, const char *label, const Timing &timing);
+
+  NfcReader &_reader;
+  Timing _detectHit;                // Poll that found a tag
+  Timing _detectMiss;               // Poll that timed out
+  Timing _exchange;
+  uint32_t _exchangeErrors;
+};
+
+#endif
@@ -11,7 +11,33 @@
  *    - N<num> - Set number of tags. 'Eg: N10'
  *    - T<index> - Set Last placed tag ID for index. Eg: T1
  *    - C<index><command> - Set command for index. Eg: C1HELLO - Set HELLO command for index 1
- *    - R<command> - Set Tag Remove command. Eg: RREMOVED - Set REMOVED command for tag remove
+ *    - R<command> - Set Tag Remove command, up to 9 characters. Eg: RREMOVED - Set REMOVED command for tag remove
+ *    - D<command> - Set the command of tags that have none of their own. Eg: DPLACE:%S:%U
+ *      Commands may hold %U (UID), %S (slot), %D (dwell ms), %N (event sequence), see CommandTemplate.h
+ *    - J<seq> - Replay journaled events from sequence number. Eg: J120
+ *    - JS - Print event journal statistics
+ *    - Y - Start clock sync with the host on the link the command came from
+ *    - YS - Print clock sync status
+ *    - A<0|1> - Disable/enforce NTAG originality signature check. Eg: A1
+ *    - AS - Print originality check statistics
+ *    - K<0|1> - Route tags by UID/by first NDEF text or URI record. Eg: K1
+ *    - KS - Print routing time-to-action statistics
+ *    - LS - Print NFC driver latency and retry statistics
+ *    - U<size> - Start a flash tag table update of size bytes, followed by UD<hex> lines and UC
+ *    - US - Print flash tag table statistics
+ *    - PS - Print loop() phase timing and the slowest iterations
+ *    - PR - Reset loop() profiling
+ *    - B<baud> - Switch the USB console to baud, confirmed with BOK on USB at the new rate. Eg: B921600
+ *    - BS - Print console rate and command output timing
+ *    - I<id> - Set the podium ID that answers config push acks on Serial2. Eg: I12
+ *    - G... - Broadcast config push lines from the controller, see ConfigBroadcast.h
+ *    - GS - Print config push status
+ *    - E<reader>,<emulate> - Alternate reader and phone emulation windows in ms, E0 to only read. Eg: E300,200
+ *    - EU<uri> - Set the URI served to phones in emulation windows. Eg: EUhttps://example.com
+ *    - ES - Print role duty cycle, cube detection and phone service statistics
+ *    - W<slots>,<ms>[,<slot>] - Keep the RF field on only in this podium's slot of a frame synced to the host
+ *      clock; the slot defaults to the podium ID modulo slots, W0 polls without slots. Eg: W4,50
+ *    - WS - Print RF slot and field switching statistics
  *    - HELP - Get help
  * 
  */
@@ -20,6 +46,12 @@
 
 #define TIMEOUT     100
 
+#define SERIAL2_DRAIN_MS  50                         // Max time readSerial2() spends on buffered lines
+
+#define REMOVE_COMMAND_MAX 9                         // Remove command, stored at EEPROM 400 below the role windows at 410
+#define ROLE_URI_MAX      64                         // Served URI, stored at EEPROM 420
+#define DEFAULT_COMMAND_MAX 24                       // Default command, stored at EEPROM 486
+
 #define PN532_IRQ   (2)
 #define PN532_RESET (3)  // Not connected by default on the NFC Shield
 
@@ -27,25 +59,81 @@
 #include <Arduino.h>
 
 #include <Wire.h>
-#include <Adafruit_PN532.h>
 #include <BluetoothSerial.h>
 #include <EEPROM.h>
-// SCK = 13, MOSI = 11, MISO = 12.  The SS line can be any digital IO pin.
-//Adafruit_PN532 nfc(PN532_SS);
+#include "EventJournal.h"
+#include "ClockSync.h"
+#include "OriginalityCheck.h"
+#include "TagIndex.h"
+#include "TagTable.h"
+#include "LoopProfiler.h"
+#include "ConsoleBaud.h"
+#include "ConfigBroadcast.h"
+#include "CommandTemplate.h"
+#include "NdefKeyReader.h"
+#include "RoleScheduler.h"
+#include "RfSlots.h"
+#include "TimedNfcReader.h"
+#include <retry_policy.h>
+#ifdef NFC_READER_ADAFRUIT
+#include "AdafruitReader.h"
+AdafruitReader nfcDriver(PN532_IRQ, PN532_RESET);
+#else
+#include "Pn532Reader.h"
+Pn532Reader nfcDriver(Wire);                         // In-tree driver, SDA = 21, SCL = 22
+#endif
 
-Adafruit_PN532 nfc(PN532_IRQ, PN532_RESET);
+// Card emulation needs the in-tree driver built with PN532_FEATURE_EMULATION (env:esp32dev_dual)
+#if !defined(NFC_READER_ADAFRUIT) && PN532_FEATURE_EMULATION
+#define ROLE_EMULATION 1
+#include <emulatetag.h>
+EmulateTag emulation(nfcDriver.interface());
+#else
+#define ROLE_EMULATION 0
+#endif
+
+TimedNfcReader nfc(nfcDriver);
+PN532RetryPolicy exchangeRetry;                      // Resends tag reads only on corrupted frames, within 50 ms
 
 BluetoothSerial SerialBT;
+EventJournal journal;
+ClockSync clockSync;
+RfSlots rfSlots(nfc, clockSync);
+OriginalityCheck originality;
+TagIndex tagIndex;
+TagTable tagTable;
+LoopProfiler profiler;
+ConsoleBaud consoleBaud(Serial);
+ConfigBroadcast configBroadcast(tagTable);
+#if ROLE_EMULATION
+bool serveWindow(uint16_t timeout) { return emulation.emulate(timeout); }
+RoleScheduler roles(serveWindow);
+#else
+RoleScheduler roles(0);
+#endif
 
 bool success      = false;
 bool cardPresesnt = false;
 bool mode         = 0;                               // Mode of operation
+bool authMode     = 0;                               // Reject tags without a valid originality signature
+bool routeMode    = 0;                               // Route by first NDEF record (1) or by UID (0)
 uint8_t numTags       = 0;                          // Number of tags
 String removeCommand  = "";                    // Remove command
 String commands[]     = {"", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", ""};     // Commands for tags
 String tags[]         = {"", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", ""};         // Tag IDs
 String tagID          = "";                       // Current Tag ID
 String prevTagID      = "";                       // Previous Tag ID
+String tagUID         = "";                       // UID of the current tag, journaled even when routing by NDEF
+String prevTagUID     = "";                       // UID of the previous tag
+String servedUri      = "";                       // URI served to phones in emulation windows
+String defaultCommand = "";                       // Command of tags without one of their own
+CommandTemplate commandTemplates[20];             // commands[], compiled
+CommandTemplate removeTemplate;                   // removeCommand, compiled
+CommandTemplate defaultTemplate;                  // defaultCommand, compiled
+unsigned long placedAt = 0;                       // millis() of the last placement, for %D
+uint32_t routeCount[2]          = {0, 0};         // Placements routed, per routing mode
+unsigned long routeMicrosTotal[2] = {0, 0};       // Detection to command, per routing mode
+unsigned long routeMicrosMax[2]   = {0, 0};
 
 /**
  * @brief Writes a string to EEPROM starting at the specified address offset.
@@ -84,26 +172,173 @@ String readStringFromEEPROM(int addrOffset) {
     return String(data);
 }
 
+/**
+ * @brief Prints an event timestamp line in host time.
+ *
+ * Hosts only receive the line after they have started a clock sync with "Y", so
+ * hosts that never sync see the output format unchanged.
+ *
+ * @param out      The event output stream.
+ * @param hostTime Host time in microseconds, 0 if the clock is not synced.
+ * @return Bytes written.
+ */
+size_t printTimestamp(Print &out, int64_t hostTime) {
+  if (!hostTime) { return 0; }
+  char line[32];
+  snprintf(line, sizeof(line), "TS:%lld", (long long)hostTime);
+  return out.println(line);
+}
+
+/**
+ * @brief Emits a command on the event output: Serial in Standalone mode, Serial2 in Master mode.
+ *
+ * The command follows a blank line and, once the host clock is synced, a timestamp line.
+ * Console output is timed for the "BS" report.
+ *
+ * @param hostTime Host time in microseconds, 0 if the clock is not synced.
+ * @param command  Command bytes, from RAM or from the mapped flash tag table.
+ * @param length   Length of the command.
+ */
+void emitCommand(int64_t hostTime, const char *command, size_t length) {
+  Print &out = mode ? (Print &)Serial2 : (Print &)Serial;
+  unsigned long start = micros();
+  size_t bytes = out.println();
+  bytes += printTimestamp(out, hostTime);
+  bytes += out.write((const uint8_t *)command, length);
+  bytes += out.println();
+  if (!mode) { consoleBaud.recordEmission(bytes, micros() - start); }
+}
+
+/**
+ * @brief Renders compiled command opcodes for an event into a stack buffer and emits them.
+ */
+void emitTemplate(int64_t hostTime, const uint8_t *code, size_t length, const CommandContext &context) {
+  char out[TEMPLATE_OUTPUT_MAX];
+  emitCommand(hostTime, out, CommandTemplate::render(code, length, context, out, sizeof(out)));
+}
+
 /**
  * @brief Processes the given tag ID and executes the corresponding command if the tag is recognized.
  * 
- * This function compares the provided tag ID with a list of known tags. 
+ * This function looks the provided tag ID up in the hashed index of known tags, then in the flash tag table.
+ * The tags set up over the console take precedence over the flash tag table.
  * If a match is found, it Checks the mode of operation and sends the corresponding command to the Serial or Serial2 output.
+ * Once the host clock is synced, the command is preceded by a "TS:<host time us>" line.
  * If no match is found and debugging is enabled, it prints "UNKNOWN TAG" to the serial output.
  * 
  * @param tagID_ The tag ID to be processed.
  */
 void processTagID(String tagID_){
-  for (int i = 0; i < numTags; i++) {
-    if (tagID_ == tags[i]) {
-      if (!mode){ Serial.println(); Serial.println(commands[i]); }
-      if (mode){ Serial2.println(); Serial2.println(commands[i]); }
-      return;
-    }
+  LoopSite site(profiler, "processTagID");
+  int64_t hostTime = clockSync.hostTimeNow();
+  CommandContext context = { tagUID.c_str(), (uint8_t)tagUID.length(), 0, 0, journal.nextSeq() };
+  int i = tagIndex.find(tagID_);
+  if (i >= 0) {
+    const CommandTemplate &command = commandTemplates[i].empty() ? defaultTemplate : commandTemplates[i];
+    context.slot = i + 1;
+    emitTemplate(hostTime, command.code(), command.length(), context);
+    journal.append(JOURNAL_EVENT_PLACE, i, tagUID, hostTime);
+    return;
+  }
+  const TagTableEntry *entry = tagTable.find(tagID_);
+  if (entry) {
+    char command[TAG_TABLE_COMMAND_MAX];
+    uint8_t length = tagTable.command(entry, command);
+    context.slot = entry->index + 1;
+    if (length) { emitTemplate(hostTime, (const uint8_t *)command, length, context); }
+    else { emitTemplate(hostTime, defaultTemplate.code(), defaultTemplate.length(), context); }
+    journal.append(JOURNAL_EVENT_PLACE, JOURNAL_SLOT_TAG_TABLE, tagUID, hostTime);
+    return;
   }
   if (DEBUG) {Serial.println("UNKNOWN TAG");}
 }
 
+/**
+ * @brief Checks the originality signature of the tag in the field.
+ *
+ * The verdict is looked up in the per-UID cache first. Only a UID seen for the first time
+ * costs a READ_SIG exchange and a signature verification. Only a signature that was read or a
+ * NAK is cached; a READ_SIG lost on the link rejects this placement and is tried again on the next.
+ *
+ * @param uid       The UID returned by readPassiveTargetID().
+ * @param uidLength Length of the UID.
+ * @return true if the tag carries a valid NXP originality signature.
+ */
+bool isGenuineTag(uint8_t *uid, uint8_t uidLength){
+  LoopSite site(profiler, "isGenuineTag");
+  uint8_t verdict = originality.lookup(uid, uidLength);
+  if (verdict == ORIGINALITY_UNKNOWN) {
+    uint8_t readSig[] = { NTAG_CMD_READ_SIG, 0x00 };
+    uint8_t signature[SECP128R1_SIGNATURE_SIZE];
+    uint8_t signatureLength = sizeof(signature);
+    bool read;
+    exchangeRetry.begin();
+    do {
+      signatureLength = sizeof(signature);
+      read = nfc.inDataExchange(readSig, sizeof(readSig), signature, &signatureLength);
+    } while (!read && exchangeRetry.again(nfc.lastError()));
+    exchangeRetry.finish(read);
+    if (read && signatureLength == sizeof(signature)) {
+      verdict = originality.verify(uid, uidLength, signature, true);
+    } else if (read || pn532ErrorClass(nfc.lastError()) == PN532_CLASS_CARD) {
+      verdict = originality.verify(uid, uidLength, signature, false);   // NAK: no READ_SIG on this tag
+    } else {
+      verdict = originality.readFailed();
+    }
+  }
+  return verdict == ORIGINALITY_GENUINE;
+}
+
+/**
+ * @brief Reads one 16-byte block (four pages) of the Type 2 tag in the field.
+ *
+ * A corrupted frame is read again while exchangeRetry allows; a tag that left the field is not.
+ */
+bool readNtagBlock(uint8_t page, uint8_t *block){
+  uint8_t read[] = { NTAG_CMD_READ, page };
+  uint8_t blockLength;
+  bool ok;
+  exchangeRetry.begin();
+  do {
+    blockLength = NDEF_T2_BLOCK_SIZE;
+    ok = nfc.inDataExchange(read, sizeof(read), block, &blockLength);
+  } while (!ok && exchangeRetry.again(nfc.lastError()));
+  return exchangeRetry.finish(ok) && blockLength == NDEF_T2_BLOCK_SIZE;
+}
+
+/**
+ * @brief Prints the exchange errors by class and what the retry policy made of them.
+ */
+void printRetryStats(Print &out){
+  String line = "EXCHANGE ERROR CLASSES:";
+  for (uint8_t c = PN532_CLASS_RETRY; c < PN532_CLASS_COUNT; c++) {
+    line += " " + String(pn532ErrorClassName((PN532ErrorClass)c)) + " " + String(exchangeRetry.errors((PN532ErrorClass)c));
+  }
+  out.println(line);
+  out.println("RETRIES: " + String(exchangeRetry.retries()) + " RECOVERED: " + String(exchangeRetry.recovered()) +
+              " EXHAUSTED: " + String(exchangeRetry.exhausted()) + " NOT RETRIED: " + String(exchangeRetry.gaveUp()));
+}
+
+/**
+ * @brief Builds the routing key from the first NDEF text or URI record of the tag in the field.
+ *
+ * The record payload is hashed to "#" and 8 hex digits so the key fits a tag slot in EEPROM
+ * and cannot be mistaken for a UID.
+ *
+ * @return The routing key, or an empty string if the tag has no text or URI record first.
+ */
+String readNdefRouteKey(){
+  LoopSite site(profiler, "readNdefRouteKey");
+  NdefKeyReader reader(readNtagBlock);
+  uint8_t key[NDEF_KEY_MAX];
+  uint8_t keyLength;
+  if (!reader.readKey(key, &keyLength)) { return ""; }
+  char routeKey[10];
+  snprintf(routeKey, sizeof(routeKey), "#%08lX", (unsigned long)TagIndex::hash(key, keyLength));
+  if (DEBUG) {Serial.println("NDEF KEY: " + String(routeKey) + " BLOCKS READ: " + String(reader.blocksRead()));}
+  return String(routeKey);
+}
+
 /**
  * @brief Reads an NFC tag using the PN532 NFC reader.
  * 
@@ -113,16 +348,27 @@ void processTagID(String tagID_){
  * 3. The card is removed.
  * 
  * When a new card is detected, the UID is stored in the `tagID` variable and processed.
+ * If the originality check is enforced, tags without a valid signature are ignored.
+ * When routing by NDEF, `tagID` is replaced by the key of the first text or URI record; tags
+ * without one fall back to their UID.
  * If the card is removed, it checks if the removed card's UID matches any known tags and performs the necessary actions.
+ *
+ * @param timeout Poll timeout in ms, cut short by RfSlots near the end of this podium's RF window.
  */
-void readNFC(){
+void readNFC(uint16_t timeout){
   uint8_t success;
   uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
   uint8_t uidLength;                        // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
   tagID = "";
   // Wait for an NTAG203 card.  When one is found 'uid' will be populated with
   // the UID, and uidLength will indicate the size of the UUID (normally 7)
-  success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, TIMEOUT);
+  unsigned long pollStart = millis();
+  {
+    LoopSite site(profiler, "readPassiveTargetID");
+    success = nfc.readPassiveTargetID(uid, &uidLength, timeout);
+  }
+  unsigned long detected = micros();
+  roles.readerPolled(pollStart, success, success && !cardPresesnt);
 
   // NO CHANGE IN CARD
   if (success && cardPresesnt){ return; }
@@ -131,43 +377,87 @@ void readNFC(){
   // IF NEW TAG COUND
   if (success & (!cardPresesnt)) {
     cardPresesnt = true;
+    placedAt = millis();
     // Store UID to tagID
     for (uint8_t i = 0; i < uidLength; i++) {
       if (uid[i] < 0x10) { tagID += "0"; }
       tagID += String(uid[i], HEX);
     }
     tagID.toUpperCase();
+    tagUID = tagID;
+    prevTagID = "";                                   // No remove command for a rejected tag
+    if (authMode && !isGenuineTag(uid, uidLength)) {
+      if (DEBUG) {Serial.println("COUNTERFEIT TAG: " + tagID);}
+      return;
+    }
+    if (routeMode) {
+      String routeKey = readNdefRouteKey();
+      if (routeKey.length()) { tagID = routeKey; }
+    }
     prevTagID = tagID;
+    prevTagUID = tagUID;
     if (DEBUG) {
       Serial.println("Found an ISO14443A card");
       Serial.print("  UID Length: ");Serial.print(uidLength, DEC);Serial.println(" bytes");
-      Serial.println("TAG ID: "+ tagID); Serial.print("  UID Value: "); nfc.PrintHex(uid, uidLength);
-      Serial.println("");
+      Serial.println("TAG ID: "+ tagID);
     }
     processTagID(tagID);
+    unsigned long elapsed = micros() - detected;
+    routeCount[routeMode]++;
+    routeMicrosTotal[routeMode] += elapsed;
+    if (elapsed > routeMicrosMax[routeMode]) { routeMicrosMax[routeMode] = elapsed; }
     return;
   }
   // IF CARD REMOVED
   if (!success && cardPresesnt) {
     cardPresesnt = false;
     if(DEBUG) {Serial.println("CARD REMOVED");}
-    for (int i = 0; i < numTags; i++) {
-      if (prevTagID == tags[i]) {
-        if (!mode){ Serial.println(); Serial.println(removeCommand); }
-        if (mode){ Serial2.println(); Serial2.println(removeCommand); }
-        return;
-      }
+    int i = tagIndex.find(prevTagID);
+    uint16_t slot = i + 1;
+    const TagTableEntry *entry = i < 0 ? tagTable.find(prevTagID) : NULL;
+    if (entry) { i = JOURNAL_SLOT_TAG_TABLE; slot = entry->index + 1; }
+    if (i >= 0) {
+      int64_t hostTime = clockSync.hostTimeNow();
+      CommandContext context = { prevTagUID.c_str(), (uint8_t)prevTagUID.length(), slot, millis() - placedAt,
+                                 journal.nextSeq() };
+      emitTemplate(hostTime, removeTemplate.code(), removeTemplate.length(), context);
+      journal.append(JOURNAL_EVENT_REMOVE, i, prevTagUID, hostTime);
     }
   }
 }
 
+/**
+ * @brief Sets the NDEF file served in emulation windows to one URI record.
+ *
+ * The common http and https prefixes are sent as URI identifier codes.
+ */
+void setServedUri(const String &uri){
+  servedUri = uri;
+#if ROLE_EMULATION
+  uint8_t prefix = 0x00;
+  String rest = uri;
+  if (uri.startsWith("https://")) { prefix = 0x04; rest = uri.substring(8); }
+  else if (uri.startsWith("http://")) { prefix = 0x03; rest = uri.substring(7); }
+  uint8_t record[5 + ROLE_URI_MAX];
+  uint8_t length = rest.length();
+  record[0] = 0xD1;                                   // MB, ME, SR, well known
+  record[1] = 1;                                      // Type length
+  record[2] = length + 1;                             // Payload: prefix code and URI
+  record[3] = 'U';
+  record[4] = prefix;
+  memcpy(record + 5, rest.c_str(), length);
+  emulation.setNdefFile(record, 5 + length);
+  emulation.setTagWriteable(false);
+#endif
+}
+
 /**
  * @brief Initializes the NFC module and checks for the PN53x board.
  * 
  * This function begins communication with the NFC module and retrieves the firmware version.
- * If the PN53x board is not found, it halts the program. If the board is found, it prints
- * the chip and firmware version information to the Serial monitor and indicates that it is
- * waiting for an ISO14443A card.
+ * If the PN53x board is not found, it halts the program. If the board is found, it configures
+ * the SAM for normal mode, prints the chip and firmware version information to the Serial
+ * monitor and indicates that it is waiting for an ISO14443A card.
  */
 void nfcInit(){
   nfc.begin();
@@ -178,17 +468,27 @@ void nfcInit(){
     if (DEBUG) { Serial.println("Didn't find PN53x board");}
     while (1); // halt
   }
-  
+  nfc.SAMConfig();
+
   if (DEBUG) {
     // Got ok data, print it out!
     Serial.print("Found chip PN5"); Serial.println((versiondata>>24) & 0xFF, HEX);
     Serial.print("Firmware ver. "); Serial.print((versiondata>>16) & 0xFF, DEC);
     Serial.print('.'); Serial.println((versiondata>>8) & 0xFF, DEC);
 
+    Serial.println(String("Driver: ") + nfc.name());
     Serial.println("Waiting for an ISO14443A Card ...");
   } 
 }
 
+/**
+ * @brief Commits pending EEPROM writes to flash, a sector erase and write that blocks loop().
+ */
+void commitEEPROM(){
+  LoopSite site(profiler, "EEPROM.commit");
+  EEPROM.commit();
+}
+
 /**
  * @brief Processes the input data string and performs various actions based on its prefix.
  * 
@@ -196,21 +496,51 @@ void nfcInit(){
  * - "N<num>": Sets the number of tags and stores it in EEPROM.
  * - "T<index>": Sets the last placed tag ID for the specified index and stores it in EEPROM.
  * - "C<index><command>": Sets a command for the specified index and stores it in EEPROM.
- * - "R<command>": Sets the tag remove command and stores it in EEPROM.
+ * - "R<command>": Sets the tag remove command, up to REMOVE_COMMAND_MAX characters, and stores it in EEPROM.
+ * - "D<command>": Sets the command of tags without one of their own and stores it in EEPROM.
  * - "M<mode>": Sets the mode of operation (Master or Standalone) and stores it in EEPROM.
+ * - "J<seq>": Replays journaled events from the given sequence number to the event output.
+ * - "JS": Prints event journal statistics.
+ * - "Y": Starts a clock sync burst on the source link; "Y<t1>,<t2>,<t3>" lines are the host's replies.
+ * - "YS": Prints clock sync status.
+ * - "A<0|1>": Disables or enforces the NTAG originality signature check and stores it in EEPROM.
+ * - "AS": Prints originality check cache and timing statistics.
+ * - "K<0|1>": Routes tags by UID or by their first NDEF text or URI record and stores it in EEPROM.
+ * - "KS": Prints time-to-action statistics for both routing modes.
+ * - "LS": Prints the NFC driver in use, its detection and exchange latency, and exchange errors by class and retries.
+ * - "U<size>": Starts streaming a flash tag table image of size bytes into the inactive slot.
+ * - "UD<hex>": Appends image bytes, replying "UD:<bytes received>" on the source link.
+ * - "UC": Verifies the image and makes it the active tag table.
+ * - "US": Prints flash tag table statistics.
+ * - "PS": Prints loop() phase percentiles and the slowest iterations with the call site that held them up.
+ * - "PR": Resets loop() profiling.
+ * - "B<baud>": Switches the USB console to a new rate; without "BOK" at that rate it falls back.
+ * - "BOK": Confirms the new console rate and stores it in EEPROM; only accepted on the USB console.
+ * - "BS": Prints the console rate and how long command output takes at it.
+ * - "I<id>": Sets the podium ID for config push acks and stores it in EEPROM.
+ * - "GS": Prints config push status.
+ * - "G<B|D|Q|C>...": Config push lines broadcast by the controller on Serial2.
+ * - "E<reader>,<emulate>": Alternates reader and card emulation windows, "E0" reads only; stored in EEPROM.
+ * - "EU<uri>": Sets the URI served to phones and stores it in EEPROM.
+ * - "ES": Prints the role duty cycle, cube detection and phone service bounds.
+ * - "W<slots>,<ms>[,<slot>]": Polls only in this podium's RF slot, "W0" polls freely; stored in EEPROM.
+ * - "WS": Prints the RF slot, windows polled in and field switches.
  * - "HELP": Prints help information about the available commands.
  * 
  * The function uses EEPROM to store and retrieve data, and communicates via Serial and Serial Bluetooth.
  * 
  * @param data The input data string containing the command and its parameters.
+ * @param source The stream the data was read from.
  */
-void processData(String data) {
+void processData(String data, Stream &source) {
+  LoopSite site(profiler, "processData");
   if (data.startsWith("N")) {
     numTags = data.substring(1, data.length()).toInt();
     if (numTags > 20) numTags = 10;                   // Ensure numTags does not exceed array bounds
     Serial.println(numTags);
     EEPROM.write(0, numTags);
-    EEPROM.commit();
+    commitEEPROM();
+    tagIndex.rebuild(tags, numTags);
     delay(10);
     int num = EEPROM.read(0);
     SerialBT.println("NUM TAGS SET TO: " + String(num));
@@ -221,7 +551,8 @@ void processData(String data) {
     if (index >= 0 && index < 20) {
       tags[index] = prevTagID;
       writeStringToEEPROM(10 + index * 10, prevTagID);
-      EEPROM.commit();
+      commitEEPROM();
+      tagIndex.rebuild(tags, numTags);
       delay(10);
     }
     for (int i = 0; i < numTags; i++) {
@@ -234,8 +565,9 @@ void processData(String data) {
     int index = data.substring(1, data.length()).toInt() - 1;
     if (index >= 0 && index < 20) {
       commands[index] = data.substring(3, data.length());
+      commandTemplates[index].compile(commands[index].c_str(), commands[index].length());
       writeStringToEEPROM(200 + index * 10, commands[index]);
-      EEPROM.commit();
+      commitEEPROM();
       delay(10);
     }
     for (int i = 0; i < numTags; i++) {
@@ -245,31 +577,259 @@ void processData(String data) {
     }
     return;
   } else if (data.startsWith("R")) {
+    if (data.length() - 1 > REMOVE_COMMAND_MAX) { source.println("REMOVE COMMAND: TOO LONG"); return; }
     removeCommand = data.substring(1, data.length());
+    removeTemplate.compile(removeCommand.c_str(), removeCommand.length());
     writeStringToEEPROM(400, removeCommand);
-    EEPROM.commit();
+    commitEEPROM();
     String command = readStringFromEEPROM(400);
     delay(10);
     SerialBT.println("Remove Command: " + command);
     Serial.println("Remove Command: " + command);
     return;
+  } else if (data.startsWith("D")) {
+    data.trim();
+    if (data.length() - 1 > DEFAULT_COMMAND_MAX) { source.println("DEFAULT COMMAND: TOO LONG"); return; }
+    defaultCommand = data.substring(1, data.length());
+    defaultTemplate.compile(defaultCommand.c_str(), defaultCommand.length());
+    writeStringToEEPROM(486, defaultCommand);
+    commitEEPROM();
+    SerialBT.println("Default Command: " + defaultCommand);
+    Serial.println("Default Command: " + defaultCommand);
+    return;
+  } else if (data.startsWith("JS")) {
+    journal.printStats(SerialBT);
+    journal.printStats(Serial);
+    return;
+  } else if (data.startsWith("J")) {
+    uint32_t fromSeq = data.substring(1, data.length()).toInt();
+    if (!mode){ journal.replay(fromSeq, Serial); }
+    if (mode){ journal.replay(fromSeq, Serial2); }
+    return;
+  } else if (data.startsWith("YS")) {
+    clockSync.printStatus(SerialBT);
+    clockSync.printStatus(Serial);
+    return;
+  } else if (data.startsWith("Y")) {
+    if (data.indexOf(',') < 0) { clockSync.start(source); }
+    else { clockSync.handleReply(data); }
+    return;
+  } else if (data.startsWith("AS")) {
+    originality.printStats(SerialBT);
+    originality.printStats(Serial);
+    return;
+  } else if (data.startsWith("A")) {
+    authMode = data.substring(1, data.length()).toInt() != 0;
+    EEPROM.write(6, authMode);
+    commitEEPROM();
+    SerialBT.println("AUTH CHECK: " + String(authMode ? "ON" : "OFF"));
+    Serial.println("AUTH CHECK: " + String(authMode ? "ON" : "OFF"));
+    return;
+  } else if (data.startsWith("KS")) {
+    for (uint8_t m = 0; m < 2; m++) {
+      String line = String(m ? "NDEF" : "UID") + " ROUTED: " + String(routeCount[m]);
+      if (routeCount[m]) { line += " US AVG: " + String(routeMicrosTotal[m] / routeCount[m]) + " MAX: " + String(routeMicrosMax[m]); }
+      SerialBT.println(line);
+      Serial.println(line);
+    }
+    return;
+  } else if (data.startsWith("K")) {
+    routeMode = data.substring(1, data.length()).toInt() != 0;
+    EEPROM.write(7, routeMode);
+    commitEEPROM();
+    SerialBT.println("ROUTING: " + String(routeMode ? "NDEF" : "UID"));
+    Serial.println("ROUTING: " + String(routeMode ? "NDEF" : "UID"));
+    return;
+  } else if (data.startsWith("LS")) {
+    nfc.printStats(SerialBT);
+    nfc.printStats(Serial);
+    printRetryStats(SerialBT);
+    printRetryStats(Serial);
+    return;
+  } else if (data.startsWith("PS")) {
+    profiler.printReport(SerialBT);
+    profiler.printReport(Serial);
+    return;
+  } else if (data.startsWith("PR")) {
+    profiler.reset();
+    SerialBT.println("PROFILER RESET");
+    Serial.println("PROFILER RESET");
+    return;
+  } else if (data.startsWith("BS")) {
+    consoleBaud.printStats(SerialBT);
+    consoleBaud.printStats(Serial);
+    return;
+  } else if (data.startsWith("BOK")) {
+    // Only a BOK read on the console itself proves the host can read the new rate
+    if (&source == &Serial && consoleBaud.confirm()) {
+      EEPROM.write(8, consoleBaud.index());
+      commitEEPROM();
+    }
+    SerialBT.println("BAUD: " + String(consoleBaud.baud()));
+    Serial.println("BAUD: " + String(consoleBaud.baud()));
+    return;
+  } else if (data.startsWith("B")) {
+    consoleBaud.request(data.substring(1, data.length()).toInt(), source);
+    return;
+  } else if (data.startsWith("I")) {
+    configBroadcast.setId(data.substring(1, data.length()).toInt());
+    rfSlots.setPodiumId(configBroadcast.id());
+    EEPROM.write(9, configBroadcast.id());
+    commitEEPROM();
+    SerialBT.println("PODIUM ID: " + String(configBroadcast.id()));
+    Serial.println("PODIUM ID: " + String(configBroadcast.id()));
+    return;
+  } else if (data.startsWith("GS")) {
+    configBroadcast.printStats(SerialBT);
+    configBroadcast.printStats(Serial);
+    return;
+  } else if (data.startsWith("G")) {
+    configBroadcast.handle(data, source);
+    return;
+  } else if (data.startsWith("ES")) {
+    roles.printStats(SerialBT);
+    roles.printStats(Serial);
+    return;
+  } else if (data.startsWith("EU")) {
+    data.trim();
+    if (data.length() - 2 > ROLE_URI_MAX) { source.println("URI: TOO LONG"); return; }
+    setServedUri(data.substring(2, data.length()));
+    writeStringToEEPROM(420, servedUri);
+    commitEEPROM();
+    SerialBT.println("URI: " + servedUri);
+    Serial.println("URI: " + servedUri);
+    return;
+  } else if (data.startsWith("E")) {
+    int comma = data.indexOf(',');
+    uint16_t readerMs = data.substring(1, comma < 0 ? data.length() : comma).toInt();
+    uint16_t emulateMs = comma < 0 ? 0 : data.substring(comma + 1, data.length()).toInt();
+    if (comma < 0 && readerMs != 0) { source.println("ROLES: USE E<reader>,<emulate>"); return; }
+    if (!roles.configure(readerMs, emulateMs)) { source.println("ROLES: FAILED"); return; }
+    EEPROM.write(410, roles.readerMs() / ROLE_WINDOW_UNIT_MS);
+    EEPROM.write(411, roles.emulateMs() / ROLE_WINDOW_UNIT_MS);
+    commitEEPROM();
+    roles.printStats(SerialBT);
+    roles.printStats(Serial);
+    return;
+  } else if (data.startsWith("WS")) {
+    rfSlots.printStats(SerialBT);
+    rfSlots.printStats(Serial);
+    return;
+  } else if (data.startsWith("W")) {
+    int comma = data.indexOf(',');
+    int comma2 = comma < 0 ? -1 : data.indexOf(',', comma + 1);
+    uint8_t slots = data.substring(1, comma < 0 ? data.length() : comma).toInt();
+    uint16_t slotMs = comma < 0 ? 0 : data.substring(comma + 1, comma2 < 0 ? data.length() : comma2).toInt();
+    uint8_t slot = comma2 < 0 ? RF_SLOT_BY_ID : data.substring(comma2 + 1, data.length()).toInt();
+    if (comma < 0 && slots > 1) { source.println("RF SLOTS: USE W<slots>,<ms>[,<slot>]"); return; }
+    if (!rfSlots.configure(slots, slotMs, slot)) { source.println("RF SLOTS: FAILED"); return; }
+    EEPROM.write(1, rfSlots.slots());
+    EEPROM.write(2, rfSlots.slotMs() / RF_SLOT_UNIT_MS);
+    EEPROM.write(3, rfSlots.fixedSlot());
+    commitEEPROM();
+    rfSlots.printStats(SerialBT);
+    rfSlots.printStats(Serial);
+    return;
+  } else if (data.startsWith("US")) {
+    tagTable.printStats(SerialBT);
+    tagTable.printStats(Serial);
+    return;
+  } else if (data.startsWith("UD")) {
+    uint8_t chunk[128];
+    uint16_t length = 0;
+    data.trim();
+    for (unsigned int i = 2; i + 1 < data.length() && length < sizeof(chunk); i += 2) {
+      chunk[length++] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
+    }
+    if (tagTable.writeUpdate(chunk, length)) { source.println("UD:" + String(tagTable.updateOffset())); }
+    else { source.println("UPDATE: FAILED"); }
+    return;
+  } else if (data.startsWith("UC")) {
+    bool installed = tagTable.commitUpdate();
+    SerialBT.println("UPDATE: " + String(installed ? "INSTALLED" : "FAILED"));
+    Serial.println("UPDATE: " + String(installed ? "INSTALLED" : "FAILED"));
+    if (installed) { tagTable.printStats(SerialBT); tagTable.printStats(Serial); }
+    return;
+  } else if (data.startsWith("U")) {
+    bool ready = tagTable.beginUpdate(data.substring(1, data.length()).toInt());
+    source.println("UPDATE: " + String(ready ? "READY" : "FAILED"));
+    return;
   } else if (data.indexOf("HELP")>=0){
     SerialBT.println("RFID Cube Podium PN532 - Firmware v1.0");
     SerialBT.println("N<num> - Set number of tags. 'Eg: N10' ");
     SerialBT.println("T<index> - Set Last placed tag ID for index. Eg: T01");
     SerialBT.println("C<index><command> - Set command for index. Eg: C01HELLO - Set HELLO command for index 1");
-    SerialBT.println("R<command> - Set Tag Remove command. Eg: RREMOVED - Set REMOVED command for tag remove");
+    SerialBT.println("R<command> - Set Tag Remove command, max 9 chars. Eg: RREMOVED - Set REMOVED command for tag remove");
+    SerialBT.println("D<command> - Set the command of tags without one. Eg: DPLACE:%S:%U");
+    SerialBT.println("  Commands may use %U UID, %S slot, %D dwell ms, %N event sequence");
+    SerialBT.println("J<seq> - Replay journaled events from sequence number. Eg: J120");
+    SerialBT.println("JS - Print event journal statistics");
+    SerialBT.println("Y - Start clock sync with the host");
+    SerialBT.println("YS - Print clock sync status");
+    SerialBT.println("A<0|1> - Disable/enforce NTAG originality check. Eg: A1");
+    SerialBT.println("AS - Print originality check statistics");
+    SerialBT.println("K<0|1> - Route tags by UID/by first NDEF record. Eg: K1");
+    SerialBT.println("KS - Print routing time-to-action statistics");
+    SerialBT.println("LS - Print NFC driver latency and retry statistics");
+    SerialBT.println("U<size> - Start a flash tag table update, then UD<hex> lines and UC. Eg: U4096");
+    SerialBT.println("US - Print flash tag table statistics");
+    SerialBT.println("PS - Print loop timing and slowest iterations");
+    SerialBT.println("PR - Reset loop timing");
+    SerialBT.println("B<baud> - Switch USB console rate, then BOK at the new rate. Eg: B921600");
+    SerialBT.println("BS - Print console rate and command output timing");
+    SerialBT.println("I<id> - Set podium ID for config push acks. Eg: I12");
+    SerialBT.println("GS - Print config push status");
+    SerialBT.println("E<reader>,<emulate> - Alternate reader and phone windows in ms, E0 to only read. Eg: E300,200");
+    SerialBT.println("EU<uri> - Set the URI served to phones. Eg: EUhttps://example.com");
+    SerialBT.println("ES - Print role, cube detection and phone service statistics");
+    SerialBT.println("W<slots>,<ms>[,<slot>] - Keep the RF field on only in this podium's slot, W0 to poll freely. Eg: W4,50");
+    SerialBT.println("WS - Print RF slot and field switching statistics");
 
     Serial.println("RFID Cube Podium PN532 - Firmware v1.0"); Serial.println();
     Serial.println("N<num> - Set number of tags. 'Eg: N10' ");
     Serial.println("T<index> - Set Last placed tag ID for index. Eg: T01");
     Serial.println("C<index><command> - Set command for index. Eg: C01HELLO - Set HELLO command for index 1");
-    Serial.println("R<command> - Set Tag Remove command. Eg: RREMOVED - Set REMOVED command for tag remove");
+    Serial.println("R<command> - Set Tag Remove command, max 9 chars. Eg: RREMOVED - Set REMOVED command for tag remove");
+    Serial.println("D<command> - Set the command of tags without one. Eg: DPLACE:%S:%U");
+    Serial.println("  Commands may use %U UID, %S slot, %D dwell ms, %N event sequence");
+    Serial.println("J<seq> - Replay journaled events from sequence number. Eg: J120");
+    Serial.println("JS - Print event journal statistics");
+    Serial.println("Y - Start clock sync with the host");
+    Serial.println("YS - Print clock sync status");
+    Serial.println("A<0|1> - Disable/enforce NTAG originality check. Eg: A1");
+    Serial.println("AS - Print originality check statistics");
+    Serial.println("K<0|1> - Route tags by UID/by first NDEF record. Eg: K1");
+    Serial.println("KS - Print routing time-to-action statistics");
+    Serial.println("LS - Print NFC driver latency and retry statistics");
+    Serial.println("U<size> - Start a flash tag table update, then UD<hex> lines and UC. Eg: U4096");
+    Serial.println("US - Print flash tag table statistics");
+    Serial.println("PS - Print loop timing and slowest iterations");
+    Serial.println("PR - Reset loop timing");
+    Serial.println("B<baud> - Switch USB console rate, then BOK at the new rate. Eg: B921600");
+    Serial.println("BS - Print console rate and command output timing");
+    Serial.println("I<id> - Set podium ID for config push acks. Eg: I12");
+    Serial.println("GS - Print config push status");
+    Serial.println("E<reader>,<emulate> - Alternate reader and phone windows in ms, E0 to only read. Eg: E300,200");
+    Serial.println("EU<uri> - Set the URI served to phones. Eg: EUhttps://example.com");
+    Serial.println("ES - Print role, cube detection and phone service statistics");
+    Serial.println("W<slots>,<ms>[,<slot>] - Keep the RF field on only in this podium's slot, W0 to poll freely. Eg: W4,50");
+    Serial.println("WS - Print RF slot and field switching statistics");
     return;
   }
 }
 
 
+/**
+ * @brief Reads one line from a link. Blocks for up to the stream timeout if the newline is late.
+ *
+ * @param link The link to read.
+ * @param site Name the wait is profiled under.
+ */
+String readLine(Stream &link, const char *site){
+  LoopSite timed(profiler, site);
+  return link.readStringUntil('\n');
+}
+
 /**
  * @brief Reads data from the serial input if available and processes it.
  *
@@ -280,8 +840,8 @@ void processData(String data) {
  */
 void readSerial(){
   if (Serial.available()) {
-    String incoming = Serial.readStringUntil('\n');
-    processData(incoming);
+    String incoming = readLine(Serial, "Serial.readStringUntil");
+    processData(incoming, Serial);
     if (DEBUG) {Serial.println(incoming);}
   }
 }
@@ -296,18 +856,42 @@ void readSerial(){
  */
 void readBTSerial(){
   if (SerialBT.available()) {
-    String incoming = SerialBT.readStringUntil('\n');
-    processData(incoming);
+    String incoming = readLine(SerialBT, "SerialBT.readStringUntil");
+    processData(incoming, SerialBT);
     if (DEBUG) {SerialBT.println(incoming);}
   }
 }
 
+/**
+ * @brief Reads data from the Serial2 (Master mode) connection.
+ *
+ * This function checks if there is any data available on Serial2.
+ * If data is available, it reads the incoming data as a string until a newline character is encountered.
+ * The incoming data is then processed by the processData function, so a controller on Serial2
+ * can sync its clock, request journal replays and push config.
+ * Lines are read for up to SERIAL2_DRAIN_MS per call, so a config push streamed at line rate
+ * does not pile up in the receive buffer while readNFC() blocks.
+ */
+void readSerial2(){
+  unsigned long start = millis();
+  while (Serial2.available() && millis() - start < SERIAL2_DRAIN_MS) {
+    String incoming = readLine(Serial2, "Serial2.readStringUntil");
+    processData(incoming, Serial2);
+  }
+}
+
 /**
  * @brief Initializes the EEPROM and reads stored data.
  *
  * This function initializes the EEPROM with a size of 512 bytes. 
  * It then reads the number of stored tags from the EEPROM at address 0. 
- * It also reads the mode of operation from address 5.
+ * It also reads the mode of operation from address 5, the originality check setting from address 6
+ * and the routing mode from address 7. The console baud rate index at address 8 is read by setup().
+ * The podium ID for config push acks is read from address 9.
+ * The RF slot count, slot length in 10 ms units and fixed slot are read from addresses 1 to 3.
+ * The reader and emulation windows are read from addresses 410 and 411 in 10 ms units, and the
+ * URI served to phones from address 420, and the default command from address 486.
+ * Commands are compiled to templates as they are read.
  * The remove command is read from address 300. For each tag, it reads the tag ID starting from address
  * 10 and increments by 10 for each subsequent tag. Similarly, it reads the commands
  * associated with each tag starting from address 100 and increments by 10 for each
@@ -317,11 +901,28 @@ void eepromInit(){
   EEPROM.begin(512);                                  // eeprom init
   numTags = EEPROM.read(0);                           // read number of tags
   if (numTags > 20) numTags = 10;                     // Ensure numTags does not exceed array bounds
-  removeCommand = readStringFromEEPROM(400);          // read remove command
+  authMode = EEPROM.read(6) == 1;                     // read originality check setting
+  routeMode = EEPROM.read(7) == 1;                    // read routing mode
+  uint8_t podiumId = EEPROM.read(9);                  // read podium ID, 0xFF when erased
+  configBroadcast.setId(podiumId == 0xFF ? 0 : podiumId);
+  rfSlots.setPodiumId(configBroadcast.id());
+  uint8_t rfSlotCount = EEPROM.read(1);               // 0xFF when erased
+  if (rfSlotCount != 0xFF) { rfSlots.configure(rfSlotCount, EEPROM.read(2) * RF_SLOT_UNIT_MS, EEPROM.read(3)); }
+  uint8_t readerUnits = EEPROM.read(410), emulateUnits = EEPROM.read(411);
+  if (readerUnits != 0xFF && emulateUnits != 0xFF) {
+    roles.configure(readerUnits * ROLE_WINDOW_UNIT_MS, emulateUnits * ROLE_WINDOW_UNIT_MS);
+  }
+  setServedUri(EEPROM.read(420) <= ROLE_URI_MAX ? readStringFromEEPROM(420) : String(""));
+  removeCommand = EEPROM.read(400) <= REMOVE_COMMAND_MAX ? readStringFromEEPROM(400) : String("");
+  removeTemplate.compile(removeCommand.c_str(), removeCommand.length());
+  defaultCommand = EEPROM.read(486) <= DEFAULT_COMMAND_MAX ? readStringFromEEPROM(486) : String("");
+  defaultTemplate.compile(defaultCommand.c_str(), defaultCommand.length());
   for (int i = 0; i < numTags; i++) {
     tags[i] = readStringFromEEPROM(10 + i * 10);      // read tagIDs
     commands[i] = readStringFromEEPROM(200 + i * 10); // read commands
+    commandTemplates[i].compile(commands[i].c_str(), commands[i].length());
   }
+  tagIndex.rebuild(tags, numTags);
 }
 
 
@@ -329,18 +930,22 @@ void eepromInit(){
  * @brief Initializes the serial communication, Bluetooth communication, EEPROM, and NFC module.
  * 
  * This function sets up the necessary components for the system to function properly. It begins
- * by initializing the serial communication at a baud rate of 9600 for debugging purposes. 
+ * by initializing the EEPROM to store and retrieve data, then opens the serial console at the rate
+ * stored by the last confirmed "B" command (9600 until one is confirmed).
  * Then Initiate the Serial2 communication at a baud rate of 115200 for Master mode communication.
  * Then, it starts the Bluetooth communication with the device name "RFID_PN532". 
- * After that, it initializes the EEPROM to store and retrieve data. 
+ * After that, it maps the flash tag table and recovers the event journal. 
  * Finally, it initializes the NFC module to enable NFC communication.
  */
 
 void setup() {
-  Serial.begin(9600);
+  eepromInit();
+  consoleBaud.begin(EEPROM.read(8));                  // Negotiated console rate, 9600 by default
+  Serial2.setRxBufferSize(CONFIG_RX_BUFFER);          // Config push chunks arrive while readNFC() blocks
   Serial2.begin(115200);
   SerialBT.begin("RFID_PN532");
-  eepromInit();
+  tagTable.begin();
+  journal.begin();
   nfcInit();
 }
 
@@ -348,12 +953,41 @@ void setup() {
  * @brief Main loop function that continuously reads data from NFC, Bluetooth Serial, and Serial interfaces.
  * 
  * This function is called repeatedly in the main program loop. It performs the following tasks:
- * - Reads data from an NFC reader by calling the readNFC() function.
+ * - Reads data from an NFC reader by calling the readNFC() function, only in this podium's RF slot if slots are set,
+ *   and not while a clock sync reply is due, so the reply is timestamped as it arrives.
  * - Reads data from a Bluetooth Serial interface by calling the readBTSerial() function.
  * - Reads data from a standard Serial interface by calling the readSerial() function.
+ * - Reads data from the Serial2 (Master mode) interface by calling the readSerial2() function.
+ * - Flushes event journal records that have been buffered for too long.
+ * - Sends pending clock sync requests.
+ * - Reverts an unconfirmed console rate change.
+ * Each task is timed as a phase by the loop profiler, see the "PS" command.
  */
 void loop() {
-  readNFC();
+  profiler.beginIteration();
+  profiler.enter(LOOP_PHASE_NFC);
+  if (roles.emulationDue()) {
+    LoopSite site(profiler, "emulate");
+    roles.serve();
+  } else if (clockSync.awaitingReply()) {
+    rfSlots.polled();                                 // No poll, but the field still goes off with the window
+  } else {
+    uint16_t timeout = rfSlots.pollTimeout(TIMEOUT);
+    if (timeout) {
+      readNFC(timeout);
+      rfSlots.polled();
+    }
+  }
+  profiler.enter(LOOP_PHASE_BT);
   readBTSerial();
+  profiler.enter(LOOP_PHASE_SERIAL);
   readSerial();
+  profiler.enter(LOOP_PHASE_SERIAL2);
+  readSerial2();
+  profiler.enter(LOOP_PHASE_JOURNAL);
+  journal.poll();
+  profiler.enter(LOOP_PHASE_CLOCK);
+  clockSync.poll();
+  consoleBaud.poll();
+  profiler.endIteration();
 }
\ No newline at end of file
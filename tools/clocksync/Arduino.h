@@ -0,0 +1,32 @@
+/**
+ * @file    Arduino.h
+ * @brief   Just enough of Arduino.h to build ClockSync on the host, on sim.cpp's simulated clock
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+unsigned long millis();
+
+class String {
+public:
+  String(const char *s = "") : _s(s) {}
+  const char *c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.length(); }
+
+private:
+  std::string _s;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t println(const char *line) = 0;
+};
+
+class Stream : public Print {};
@@ -0,0 +1,9 @@
+/**
+ * @file    esp_timer.h
+ * @brief   The podium's local microsecond clock, on sim.cpp's simulated clock
+ */
+
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
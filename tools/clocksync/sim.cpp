@@ -0,0 +1,251 @@
+/**
+ * @file    sim.cpp
+ * @brief   Accuracy of ClockSync against a host over jittery links, with the loop() of main.cpp around it
+ *
+ *   g++ -O2 -std=c++17 -I. -I../../src sim.cpp ../../src/ClockSync.cpp -o sim
+ *   ./sim                              # 4 podiums, 30 simulated minutes per row
+ *   ./sim --podiums 8 --minutes 60 --seed 2
+ *
+ * Each podium runs the real ClockSync on its own esp_timer clock, with a random offset and a
+ * drift of up to --drift-ppm. Its loop() is modelled as in main.cpp: a reader poll that blocks
+ * for the poll timeout (100 ms) with no card, or until a card is read, then the link reads that
+ * hand replies to handleReply(), then ClockSync::poll(). With "hold", loop() skips the poll while
+ * awaitingReply(), as main.cpp does; "poll" is the loop without it, where a reply waits in the
+ * receive buffer until the poll returns.
+ *
+ * Links, per direction: the line's bytes at the link's byte time, a latency and a jitter.
+ *   serial2    115200 baud, one bus shared by all podiums; every podium sees every reply
+ *   usb        921600 baud through a USB bridge, up to 1 ms of USB frame latency each way
+ *   bluetooth  SPP, 7.5 ms latency and 10 ms mean jitter each way
+ * The host stamps t2 when a request line is in and t3 when its reply is queued, after an
+ * OS scheduling delay.
+ *
+ * Every 100 ms of simulated time, once a podium is synced, its hostTime() is compared with the
+ * true host time. The table gives the mean error, the 99th percentile and largest error, the
+ * 99th percentile spread between the podiums at one instant (what RF slots see), the mean
+ * errorBoundUs(), and how often the error was within it.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include "ClockSync.h"
+
+#define POLL_TIMEOUT_US   (100000)    // TIMEOUT in main.cpp
+#define LOOP_US           (400)       // Serial, Bluetooth, Serial2, journal and clock phases
+#define SAMPLE_US         (100000)
+
+struct Link {
+  const char *name;
+  double byteUs;
+  double latencyUs;                 // Fixed, each way
+  double frameUs;                   // Uniform 0..frameUs, each way
+  double jitterUs;                  // Exponential mean, each way
+  bool shared;
+};
+
+static const Link LINKS[] = {
+  { "serial2", 86.8, 100, 0, 100, true },
+  { "usb", 10.85, 0, 1000, 100, false },
+  { "bluetooth", 10, 7500, 0, 10000, false },
+};
+
+struct Options {
+  int podiums = 4;
+  double driftPpm = 20;
+  double hostUs = 300;              // Host scheduling delay, exponential mean
+  int minutes = 30;
+  unsigned seed = 1;
+};
+
+static Options opt;
+static std::mt19937 rng;
+static double now;                  // True host time, us
+static int current;                 // Podium whose code is running
+
+struct Podium;
+static std::vector<Podium *> podiums;
+
+static double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(rng); }
+static double exponential(double mean) { return mean > 0 ? std::exponential_distribution<double>(1 / mean)(rng) : 0; }
+
+class SimLink : public Stream {
+public:
+  const Link *link;
+  int podium;
+  size_t println(const char *line);
+};
+
+struct Podium {
+  ClockSync sync;
+  SimLink link;
+  double offsetUs, drift;
+  double nextLoop;                  // Time of the next step of loop()
+  bool polling;                     // The next step is the end of a reader poll
+  std::deque<std::pair<double, std::string> > rx;   // Arrival time and line, in arrival order
+  bool card;
+  double cardChange;
+
+  int64_t local(double t) const { return (int64_t)(offsetUs + t * (1 + drift)); }
+};
+
+int64_t esp_timer_get_time() { return podiums[current]->local(now); }
+unsigned long millis() { return (unsigned long)(esp_timer_get_time() / 1000); }
+
+static double hostTxFree;           // The host's transmitter on a shared bus
+
+static double oneWay(const Link &l, size_t bytes) {
+  return bytes * l.byteUs + l.latencyUs + uniform(0, l.frameUs) + exponential(l.jitterUs);
+}
+
+// A request from the podium: the host answers it, on the shared bus to every podium
+size_t SimLink::println(const char *line) {
+  size_t bytes = strlen(line) + 2;
+  double t2 = now + oneWay(*link, bytes);
+  double t3 = t2 + 20 + exponential(opt.hostUs);
+  char reply[64];
+  snprintf(reply, sizeof(reply), "%s,%lld,%lld", line, (long long)t2, (long long)t3);
+  size_t replyBytes = strlen(reply) + 2;
+  double start = t3;
+  if (link->shared) {
+    start = std::max(t3, hostTxFree);
+    hostTxFree = start + replyBytes * link->byteUs;
+  }
+  double arrival = start + oneWay(*link, replyBytes);
+  for (size_t i = 0; i < podiums.size(); i++) {
+    if (i != (size_t)podium && !link->shared) { continue; }
+    std::deque<std::pair<double, std::string> > &rx = podiums[i]->rx;
+    rx.insert(std::upper_bound(rx.begin(), rx.end(), std::make_pair(arrival, std::string())), std::make_pair(arrival, reply));
+  }
+  return bytes;
+}
+
+struct Stats {
+  std::vector<double> error, spread;
+  double boundSum = 0;
+  long within = 0;
+};
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) { return 0; }
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static Stats run(const Link &link, bool hold, double cardShare) {
+  rng.seed(opt.seed);
+  now = 0;
+  hostTxFree = 0;
+  std::vector<Podium> list(opt.podiums);
+  podiums.clear();
+  for (int i = 0; i < opt.podiums; i++) {
+    Podium &p = list[i];
+    p.offsetUs = uniform(1e6, 1e9);
+    p.drift = uniform(-opt.driftPpm, opt.driftPpm) * 1e-6;
+    p.nextLoop = uniform(0, POLL_TIMEOUT_US);
+    p.polling = false;
+    p.link.link = &link;
+    p.link.podium = i;
+    p.card = uniform(0, 1) < cardShare;
+    p.cardChange = exponential(10e6);
+    podiums.push_back(&p);
+  }
+  for (int i = 0; i < opt.podiums; i++) {
+    current = i;
+    list[i].sync.start(list[i].link);               // The host's "Y"
+  }
+
+  Stats stats;
+  double end = opt.minutes * 60e6, nextSample = 0;
+  while (now < end) {
+    int i = 0;
+    for (int j = 1; j < opt.podiums; j++) {
+      if (list[j].nextLoop < list[i].nextLoop) { i = j; }
+    }
+    Podium &p = list[i];
+    while (nextSample <= p.nextLoop) {
+      std::vector<double> errors;
+      for (Podium *q : podiums) {
+        if (!q->sync.synced()) { continue; }
+        double error = q->sync.hostTime(q->local(nextSample)) - nextSample;
+        uint32_t bound = q->sync.errorBoundUs();
+        stats.error.push_back(error);
+        stats.boundSum += bound;
+        if (std::fabs(error) <= bound) { stats.within++; }
+        errors.push_back(error);
+      }
+      if (errors.size() == podiums.size()) {
+        stats.spread.push_back(*std::max_element(errors.begin(), errors.end()) - *std::min_element(errors.begin(), errors.end()));
+      }
+      nextSample += SAMPLE_US;
+    }
+    now = p.nextLoop;
+    current = i;
+    if (now >= p.cardChange) {
+      p.card = uniform(0, 1) < cardShare;
+      p.cardChange = now + exponential(10e6);
+    }
+
+    // readNFC(), or the hold while a reply is due; the rest of loop() runs once it returns
+    if (!p.polling && !(hold && p.sync.awaitingReply())) {
+      p.polling = true;
+      p.nextLoop = now + (p.card ? uniform(8000, 30000) : POLL_TIMEOUT_US);
+      continue;
+    }
+    p.polling = false;
+    // readSerial2(): every complete line, parsed as it is taken
+    p.nextLoop = now + LOOP_US;
+    while (!p.rx.empty() && p.rx.front().first <= now) {
+      String line(p.rx.front().second.c_str());
+      p.rx.pop_front();
+      p.sync.handleReply(line);
+    }
+    p.sync.poll();
+  }
+  return stats;
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--podiums")) { opt.podiums = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--drift-ppm")) { opt.driftPpm = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--host-us")) { opt.hostUs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--minutes")) { opt.minutes = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--seed")) { opt.seed = atoi(argv[i + 1]); }
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+
+  printf("%d podiums, drift up to %.0f ppm, host delay %.0f us, %d minutes per row\n\n", opt.podiums, opt.driftPpm,
+         opt.hostUs, opt.minutes);
+  printf("%-10s %-5s %6s %9s %9s %9s %10s %9s %8s\n", "link", "loop", "cards", "mean us", "p99 us", "max us",
+         "spread us", "bound us", "within");
+  for (const Link &link : LINKS) {
+    for (double cards : { 0.0, 0.5 }) {
+      for (bool hold : { false, true }) {
+        Stats s = run(link, hold, cards);
+        double sum = 0, worst = 0;
+        std::vector<double> magnitude;
+        for (double e : s.error) {
+          sum += e;
+          magnitude.push_back(std::fabs(e));
+          worst = std::max(worst, std::fabs(e));
+        }
+        size_t n = s.error.size();
+        printf("%-10s %-5s %5.0f%% %9.0f %9.0f %9.0f %10.0f %9.0f %7.1f%%\n", link.name, hold ? "hold" : "poll",
+               100 * cards, n ? sum / n : 0, percentile(magnitude, 0.99), worst, percentile(s.spread, 0.99),
+               n ? s.boundSum / n : 0, n ? 100.0 * s.within / n : 0);
+      }
+    }
+    printf("\n");
+  }
+  printf("mean us: mean error of hostTime(), host time minus true time. p99 us, max us: of its magnitude.\n"
+         "spread us: p99 of the largest difference between two podiums at one instant. bound us: mean\n"
+         "errorBoundUs(). within: samples whose error was within the bound.\n");
+  return 0;
+}
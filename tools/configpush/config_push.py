@@ -0,0 +1,258 @@
+"""Pushes a tag table image to every podium on a Serial2 bus at once.
+
+    python3 config_push.py tags.bin --version 7 --port /dev/ttyUSB0 --ids 1-64
+    python3 config_push.py tags.bin --version 7 --simulate 64 --loss 0.01
+
+Build the image with tools/tagtable/build_image.py --config-version 7; the
+version in the image and on the command line must match. The protocol is
+described in src/ConfigBroadcast.h: the image is broadcast once, each podium
+is asked for the chunks it missed, and only the union of those is sent again
+until every podium holds the whole image and installs it.
+
+--simulate runs the same controller against simulated podiums that mirror
+the firmware, on a bus where every line is lost independently per podium
+with the given probability, and reports the distribution time. pyserial is
+only needed with --port.
+"""
+
+import argparse
+import random
+import sys
+import time
+
+CHUNK_SIZE = 128                # CONFIG_CHUNK_SIZE
+MAX_RANGES = 32                 # CONFIG_MAX_RANGES
+QUERY_TIMEOUT = 0.3             # Seconds to wait for a GA line
+MAX_ROUNDS = 50
+MAX_SILENT_ROUNDS = 3           # Rounds without an answer before a podium is given up
+
+
+def crc16_le(data):
+    """crc16_le(0, ...) of the ESP32 ROM."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def chunk_line(image, index):
+    data = image[index * CHUNK_SIZE:(index + 1) * CHUNK_SIZE]
+    return "GD%d,%s,%04X" % (index, data.hex().upper(), crc16_le(data))
+
+
+def parse_ack(line):
+    """GA<id>,<version>,<state>,<have>/<total>[,<missing>] -> (id, version, state, have, total, missing)"""
+    fields = line[2:].split(",")
+    have, total = (int(x) for x in fields[3].split("/"))
+    missing = set()
+    if len(fields) > 4:
+        for part in fields[4].rstrip("+").split(";"):
+            if part:
+                a, _, b = part.partition("-")
+                missing.update(range(int(a), int(b or a) + 1))
+    return int(fields[0]), int(fields[1]), fields[2], have, total, missing
+
+
+def push(link, image, version, ids, log=print):
+    """Runs a push to completion. Returns the set of podium IDs that installed the image."""
+    chunks = (len(image) + CHUNK_SIZE - 1) // CHUNK_SIZE
+    link.send("GB%d,%d" % (version, len(image)))
+    for c in range(chunks):
+        link.send(chunk_line(image, c))
+
+    done, silent, resent = set(), {i: 0 for i in ids}, 0
+    for round_ in range(1, MAX_ROUNDS + 1):
+        missing, ready, restart = set(), False, False
+        for pid in sorted(set(ids) - done):
+            reply = link.query(pid)
+            if reply is None:
+                silent[pid] += 1
+                continue
+            silent[pid] = 0
+            _, v, state, have, total, gaps = parse_ack(reply)
+            if v == version and state == "D":
+                done.add(pid)
+            elif v == version and state == "R" and total == chunks:
+                if have == total:
+                    ready = True
+                missing |= gaps
+            else:                               # Missed GB, or failed: start that podium over
+                restart = True
+                missing |= set(range(chunks))
+        lost = {pid for pid, n in silent.items() if n >= MAX_SILENT_ROUNDS and pid not in done}
+        pending = set(ids) - done - lost
+        log("round %d: %d done, %d pending, %d unreachable, %d chunks to resend"
+            % (round_, len(done), len(pending), len(lost), len(missing)))
+        if not pending:
+            return done
+        if restart:
+            link.send("GB%d,%d" % (version, len(image)))
+        for c in sorted(missing):
+            link.send(chunk_line(image, c))
+        resent += len(missing)
+        if ready or not missing:
+            link.send("GC%d" % version)
+    return done
+
+
+class SerialLink:
+    def __init__(self, port, baud):
+        import serial
+        self.port = serial.Serial(port, baud, timeout=QUERY_TIMEOUT)
+
+    def send(self, line):
+        self.port.write((line + "\n").encode())
+
+    def query(self, pid):
+        self.port.reset_input_buffer()
+        self.send("GQ%d" % pid)
+        deadline = time.time() + QUERY_TIMEOUT
+        prefix = "GA%d," % pid
+        while time.time() < deadline:
+            line = self.port.readline().decode(errors="replace").strip()
+            if line.startswith(prefix):
+                return line
+        return None
+
+
+class SimPodium:
+    """Mirror of ConfigBroadcast on the podium."""
+
+    def __init__(self, pid):
+        self.id, self.state, self.version, self.size, self.chunks = pid, "I", 0, 0, 0
+        self.have, self.active, self.image = set(), 0, {}
+
+    def handle(self, line):
+        if line.startswith("GD"):
+            if self.state != "R":
+                return
+            index, hexdata, crc = line[2:].split(",")
+            index, data = int(index), bytes.fromhex(hexdata)
+            if index < self.chunks and index not in self.have and crc16_le(data) == int(crc, 16):
+                self.have.add(index)
+                self.image[index] = data
+        elif line.startswith("GB"):
+            version, size = (int(x) for x in line[2:].split(","))
+            if self.state == "R" and version == self.version and size == self.size:
+                return
+            self.version, self.size = version, size
+            self.chunks = (size + CHUNK_SIZE - 1) // CHUNK_SIZE
+            self.have, self.image = set(), {}
+            self.state = "D" if version == self.active else "R"
+        elif line.startswith("GC"):
+            if self.state == "R" and int(line[2:]) == self.version and len(self.have) == self.chunks:
+                self.state, self.active = "D", self.version
+
+    def ack(self):
+        line = "GA%d,%d,%s,%d/%d" % (self.id, self.version, self.state, len(self.have), self.chunks)
+        if self.state == "R" and len(self.have) < self.chunks:
+            ranges, c = [], 0
+            while c < self.chunks:
+                if c in self.have:
+                    c += 1
+                    continue
+                if len(ranges) == MAX_RANGES:
+                    ranges.append("+")
+                    break
+                last = c
+                while last + 1 < self.chunks and last + 1 not in self.have:
+                    last += 1
+                ranges.append(str(c) if last == c else "%d-%d" % (c, last))
+                c = last + 1
+            line += "," + ";".join(ranges).replace(";+", "+")
+        return line
+
+
+class SimBus:
+    """Serial2 bus model: 10 bits per character, per-podium line loss, and a turnaround per
+    query that covers the podium's loop() latency (readNFC() blocks up to 100 ms)."""
+
+    def __init__(self, podiums, baud, loss, turnaround, seed=1):
+        self.podiums = {p.id: p for p in podiums}
+        self.baud, self.loss, self.turnaround = baud, loss, turnaround
+        self.rng = random.Random(seed)
+        self.clock = 0.0
+        self.lines = self.bytes = 0
+
+    def wire(self, line):
+        self.clock += (len(line) + 1) * 10.0 / self.baud
+        self.lines += 1
+        self.bytes += len(line) + 1
+
+    def send(self, line):
+        self.wire(line)
+        for p in self.podiums.values():
+            if self.rng.random() >= self.loss:
+                p.handle(line)
+
+    def query(self, pid):
+        self.wire("GQ%d" % pid)
+        p = self.podiums.get(pid)
+        if p is None or self.rng.random() < self.loss:
+            self.clock += QUERY_TIMEOUT
+            return None
+        self.clock += self.rng.uniform(0, self.turnaround)
+        reply = p.ack()
+        self.wire(reply)
+        if self.rng.random() < self.loss:
+            self.clock += QUERY_TIMEOUT - self.turnaround / 2
+            return None
+        return reply
+
+
+def parse_ids(text):
+    ids = set()
+    for part in text.split(","):
+        a, _, b = part.partition("-")
+        ids.update(range(int(a), int(b or a) + 1))
+    return sorted(ids)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image")
+    parser.add_argument("--version", type=int, required=True)
+    parser.add_argument("--port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--ids", default="1-64", help="podium IDs, e.g. 1-64 or 1,3,5-9")
+    parser.add_argument("--simulate", type=int, metavar="N", help="simulate N podiums instead of using --port")
+    parser.add_argument("--loss", type=float, default=0.01, help="simulated per-line loss probability")
+    parser.add_argument("--turnaround", type=float, default=0.12, help="simulated max query turnaround, s")
+    parser.add_argument("--quiet", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    log = (lambda *a: None) if args.quiet else print
+
+    if args.simulate:
+        ids = list(range(1, args.simulate + 1))
+        bus = SimBus([SimPodium(i) for i in ids], args.baud, args.loss, args.turnaround)
+        done = push(bus, image, args.version, ids, log)
+        for p in bus.podiums.values():
+            if p.id in done and b"".join(p.image[c] for c in sorted(p.image)) != image:
+                sys.exit("podium %d installed a corrupt image" % p.id)
+        chunks = (len(image) + CHUNK_SIZE - 1) // CHUNK_SIZE
+        one = (len(chunk_line(image, 0)) + 1) * 10.0 / args.baud * chunks
+        print("%d/%d podiums, %d bytes in %d chunks at %d baud, loss %.1f%%: %.1f s, %d lines, %.0f KB on the bus"
+              % (len(done), len(ids), len(image), chunks, args.baud, args.loss * 100, bus.clock, bus.lines,
+                 bus.bytes / 1024.0))
+        print("one push per podium would take at least %.1f s" % (one * len(ids)))
+        return 0 if len(done) == len(ids) else 1
+
+    if not args.port:
+        parser.error("give --port or --simulate")
+    ids = parse_ids(args.ids)
+    start = time.time()
+    done = push(SerialLink(args.port, args.baud), image, args.version, ids, log)
+    print("%d/%d podiums installed version %d in %.1f s" % (len(done), len(ids), args.version, time.time() - start))
+    missing = sorted(set(ids) - done)
+    if missing:
+        print("not installed: %s" % ",".join(map(str, missing)))
+    return 0 if not missing else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,196 @@
+/**
+ * @file    cache_test.cpp
+ * @brief   Host tests of FelicaCache discovery against a simulated card behind the PN532
+ *
+ *   P=../../lib/PN532-PN532_HSU/PN532 E=../../lib/PN532-PN532_HSU/PN532_errors
+ *   g++ -O2 -std=gnu++17 -I. -I$P -I$E cache_test.cpp $P/PN532.cpp $P/felica_cache.cpp -o cache_test
+ *   ./cache_test
+ *
+ * The fake PN532Interface answers the InDataExchange frames felica_SendCommand() sends the
+ * way a card does. A Read Without Encryption past the last block of a service gets the real
+ * error response: response code, IDm and the two status flags, 11 bytes with no block count
+ * or data. A frame can be made to fail on the bus, as an RF glitch or a card pulled away
+ * does. Each case checks the block counts discover() caches. Exits non-zero on failure.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "PN532.h"
+#include "felica_cache.h"
+
+unsigned long millis() { return 0; }
+void delay(unsigned long) {}
+
+#define SERVICE_READ_ONLY       (0x000B)  // FeliCa Lite-S read-only service
+#define SERVICE_READ_WRITE      (0x0009)
+#define SERVICE_ABSENT          (0x1009)
+
+class FakeFelica : public PN532Interface {
+public:
+  uint16_t serviceCodes[4];
+  uint16_t blockCounts[4];                // Blocks readable without encryption, per service
+  bool present[4];
+  uint8_t numService = 0;
+  int frames = 0;
+  int failAtFrame = 0;                    // Frame that gets no response, 0 for none
+
+  void addService(uint16_t code, uint16_t blocks, bool exists = true) {
+    serviceCodes[numService] = code;
+    blockCounts[numService] = blocks;
+    present[numService++] = exists;
+  }
+
+  void begin() {}
+  void wakeup() {}
+
+  int8_t writeCommand(const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8_t blen) {
+    (void)hlen;
+    _length = 0;
+    if (header[0] != 0x40 || blen == 0) { return 0; }    // Only InDataExchange carries FeliCa frames
+    const uint8_t *idm = body + 1;
+    switch (body[0]) {
+      case 0x0C: {                                       // Request System Code
+        uint8_t r[] = { 0x0D, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0x88, 0xB4 };
+        memcpy(r + 1, idm, 8);
+        respond(r, sizeof(r));
+        break;
+      }
+      case 0x02: {                                       // Request Service
+        uint8_t r[10 + 2 * 32];
+        uint8_t n = body[9];
+        r[0] = 0x03;
+        memcpy(r + 1, idm, 8);
+        r[9] = n;
+        for (uint8_t i = 0; i < n; i++) {
+          uint16_t code = body[10 + 2 * i] | (body[11 + 2 * i] << 8);
+          int s = find(code);
+          uint16_t keyVersion = (s >= 0 && present[s]) ? 0x0000 : 0xFFFF;
+          r[10 + 2 * i] = keyVersion & 0xFF;
+          r[11 + 2 * i] = keyVersion >> 8;
+        }
+        respond(r, 10 + 2 * n);
+        break;
+      }
+      case 0x06: {                                       // Read Without Encryption, one service, one block
+        uint16_t code = body[10] | (body[11] << 8);
+        uint8_t block = body[14];
+        int s = find(code);
+        if (s < 0 || !present[s] || block >= blockCounts[s]) {
+          uint8_t r[] = { 0x07, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xA8 };
+          memcpy(r + 1, idm, 8);
+          respond(r, sizeof(r));
+        } else {
+          uint8_t r[12 + 16];
+          r[0] = 0x07;
+          memcpy(r + 1, idm, 8);
+          r[9] = r[10] = 0;
+          r[11] = 1;
+          memset(r + 12, block, 16);
+          respond(r, sizeof(r));
+        }
+        break;
+      }
+    }
+    return 0;
+  }
+
+  int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout) {
+    (void)timeout;
+    if (++frames == failAtFrame || _length == 0) { return PN532_TIMEOUT; }
+    if (_length > len) { return PN532_NO_SPACE; }
+    memcpy(buf, _response, _length);
+    return _length;
+  }
+
+private:
+  uint8_t _response[64];
+  uint8_t _length = 0;
+
+  int find(uint16_t code) {
+    for (uint8_t i = 0; i < numService; i++) {
+      if (serviceCodes[i] == code) { return i; }
+    }
+    return -1;
+  }
+
+  // InDataExchange status, then the FeliCa frame with its length byte
+  void respond(const uint8_t *frame, uint8_t length) {
+    _response[0] = 0x00;
+    _response[1] = length + 1;
+    memcpy(_response + 2, frame, length);
+    _length = length + 2;
+  }
+};
+
+static const uint8_t IDM[8] = { 0x01, 0x2E, 0x4C, 0xE4, 0x6F, 0x3A, 0x11, 0x22 };
+static const uint8_t PMM[8] = { 0x00, 0xF1, 0x00, 0x00, 0x00, 0x01, 0x43, 0x00 };
+static int failures = 0;
+
+// Discovers the card once, with failFrame failing, then once more, and checks the counts cached
+static void check(const char *name, FakeFelica &card, const uint16_t *services, uint8_t count,
+                  const uint8_t *expected, int failFrame = 0) {
+  PN532 nfc(card);
+  FelicaCache cache(nfc);
+  cache.setServices(services, count);
+  card.frames = 0;
+  card.failAtFrame = failFrame;
+
+  const FelicaCardLayout *layout = cache.discover(IDM, PMM);
+  int firstFrames = cache.lastDiscoveryFrames();
+  bool pass = true;
+  if (failFrame) {
+    // A lost frame fails discovery and caches nothing, so the next placement probes again
+    pass = layout == 0;
+    layout = cache.discover(IDM, PMM);
+    pass = pass && cache.misses() == 2;
+  }
+  for (uint8_t i = 0; pass && i < count; i++) {
+    pass = layout && layout->blockCounts[i] == expected[i];
+  }
+  // A cached card costs no frames
+  pass = pass && cache.discover(IDM, PMM) == layout && cache.lastDiscoveryFrames() == 0;
+
+  printf("%-32s %s (%d frames)", name, pass ? "ok" : "FAIL", firstFrames);
+  if (layout) {
+    for (uint8_t i = 0; i < count; i++) { printf(" %u", layout->blockCounts[i]); }
+  }
+  printf("\n");
+  if (!pass) { failures++; }
+}
+
+int main() {
+  const uint16_t liteS[] = { SERVICE_READ_ONLY };
+  FakeFelica a;
+  a.addService(SERVICE_READ_ONLY, 14);
+  const uint8_t liteSBlocks[] = { 14 };
+  check("Lite-S read-only service", a, liteS, 1, liteSBlocks);
+
+  const uint16_t two[] = { SERVICE_READ_WRITE, SERVICE_READ_ONLY };
+  FakeFelica b;
+  b.addService(SERVICE_READ_WRITE, 1);
+  b.addService(SERVICE_READ_ONLY, FELICA_CACHE_MAX_BLOCKS);
+  const uint8_t twoBlocks[] = { 1, FELICA_CACHE_MAX_BLOCKS };
+  check("one block and the probe limit", b, two, 2, twoBlocks);
+
+  const uint16_t absent[] = { SERVICE_ABSENT, SERVICE_READ_ONLY };
+  FakeFelica c;
+  c.addService(SERVICE_ABSENT, 4, false);
+  c.addService(SERVICE_READ_ONLY, 14);
+  const uint8_t absentBlocks[] = { 0, 14 };
+  check("missing service", c, absent, 2, absentBlocks);
+
+  // Known to the card but not readable without encryption: block 0 already fails with a flag error
+  FakeFelica d;
+  d.addService(SERVICE_READ_ONLY, 0);
+  const uint8_t noBlocks[] = { 0 };
+  check("service needing a key", d, liteS, 1, noBlocks);
+
+  // Frames: 1 system code, 2 service, 3 block 0, 4 block 64 (past the end), 5 block 32
+  FakeFelica e;
+  e.addService(SERVICE_READ_ONLY, 14);
+  check("lost past-the-end probe", e, liteS, 1, liteSBlocks, 4);
+  check("lost in-range probe", e, liteS, 1, liteSBlocks, 3);
+  check("lost Request Service", e, liteS, 1, liteSBlocks, 2);
+
+  return failures ? 1 : 0;
+}
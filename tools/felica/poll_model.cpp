@@ -0,0 +1,144 @@
+/**
+ * @file    poll_model.cpp
+ * @brief   Model of FeliCa detection time for one to four cards, single-slot polls against time slots
+ *
+ *   g++ -O2 -std=c++17 poll_model.cpp -o poll_model
+ *   ./poll_model                       # I2C at 400 kHz, 30% capture, miss limit 4
+ *   ./poll_model --byte-us 90 --capture 0.5 --limit 6
+ *
+ * A poll is one InListPassiveTarget with a FeliCa Polling command, as felica_Polling()
+ * (one slot, one target) and felica_PollTargets() (TSN slots, up to two targets) send it.
+ * Every card answers in a random slot. A slot with one answer is decoded. A slot with
+ * several answers is lost unless the strongest card captures the receiver, which happens
+ * with the --capture probability. The PN532 lists the first decoded answers, up to MaxTg.
+ *
+ * For each configuration and number of cards the table gives the polls and time until every
+ * card has been listed at least once, and how often FelicaPresence would report a card that
+ * never left as departed: runs of --limit polls in a row that do not list it.
+ *
+ * Timing: the command and response frames on the bus at --byte-us per byte, the response
+ * time of slot 0 and the slot width from JIS X 6319-4, and the PN532's processing time.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define SLOT0_US          (2417.0)    // Polling response time of slot 0
+#define SLOT_US           (1208.0)    // Width of each further slot
+#define COMMAND_RF_US     (450.0)     // Preamble, sync and 6 bytes at 212 kbit/s
+#define PN532_US          (300.0)     // Firmware processing around the exchange
+#define FRAME_BYTES       (7)         // Preamble, start code, length, checksums, postamble
+#define ACK_BYTES         (6)
+#define TARGET_BYTES      (19)        // Tg, POL_RES length, 01h, IDm, PMm
+#define MAX_CARDS         (4)
+#define HOUR_US           (3600e6)
+
+struct Config {
+  const char *name;
+  int slots;
+  int maxTargets;
+};
+
+static const Config configs[] = {
+  { "felica_Polling (1 slot, 1 tg)", 1, 1 },
+  { "PollTargets 1 slot, 2 tg", 1, 2 },
+  { "PollTargets 2 slots, 2 tg", 2, 2 },
+  { "PollTargets 4 slots, 2 tg", 4, 2 },
+  { "PollTargets 8 slots, 2 tg", 8, 2 },
+  { "PollTargets 16 slots, 2 tg", 16, 2 },
+};
+
+struct Options {
+  double byteUs = 22.5;
+  double capture = 0.3;
+  int limit = 4;
+  int trials = 100000;
+};
+
+// Duration of one poll that listed `listed` cards, in microseconds
+static double pollUs(const Options &o, const Config &c, int listed) {
+  double bus = (FRAME_BYTES + 8 + ACK_BYTES + FRAME_BYTES + 2 + listed * TARGET_BYTES) * o.byteUs;
+  return bus + PN532_US + COMMAND_RF_US + SLOT0_US + (c.slots - 1) * SLOT_US;
+}
+
+// One poll of `cards` cards: sets listed[i] and returns how many were listed
+static int poll(const Options &o, const Config &c, int cards, bool *listed, std::mt19937_64 &rng) {
+  std::vector<int> bySlot[16];
+  for (int i = 0; i < cards; i++) {
+    listed[i] = false;
+    bySlot[std::uniform_int_distribution<int>(0, c.slots - 1)(rng)].push_back(i);
+  }
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  int count = 0;
+  for (int s = 0; s < c.slots && count < c.maxTargets; s++) {
+    if (bySlot[s].empty()) { continue; }
+    if (bySlot[s].size() > 1 && unit(rng) >= o.capture) { continue; }
+    listed[bySlot[s][std::uniform_int_distribution<size_t>(0, bySlot[s].size() - 1)(rng)]] = true;
+    count++;
+  }
+  return count;
+}
+
+static double percentile(std::vector<double> &v, double p) {
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--byte-us")) { o.byteUs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--capture")) { o.capture = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--limit")) { o.limit = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--trials")) { o.trials = atoi(argv[i + 1]); }
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+
+  printf("byte %.1f us, capture %.0f%%, miss limit %d, %d trials\n\n", o.byteUs, o.capture * 100, o.limit, o.trials);
+  printf("%-30s %5s %8s %9s %9s %12s\n", "config", "cards", "polls", "mean ms", "p95 ms", "false dep/h");
+  for (const Config &c : configs) {
+    for (int cards = 1; cards <= MAX_CARDS; cards++) {
+      std::mt19937_64 rng(cards);
+      std::vector<double> times;
+      double polls = 0;
+      bool listed[MAX_CARDS];
+      for (int t = 0; t < o.trials; t++) {
+        bool seen[MAX_CARDS] = {};
+        int unseen = cards, n = 0;
+        double us = 0;
+        while (unseen && n < 10000) {
+          us += pollUs(o, c, poll(o, c, cards, listed, rng));
+          n++;
+          for (int i = 0; i < cards; i++) {
+            if (listed[i] && !seen[i]) { seen[i] = true; unseen--; }
+          }
+        }
+        polls += n;
+        times.push_back(us / 1000.0);
+      }
+      double mean = 0;
+      for (double v : times) { mean += v; }
+      mean /= times.size();
+
+      // Steady polling with every card present: runs of `limit` polls without a card
+      int missed[MAX_CARDS] = {};
+      long departures = 0;
+      double us = 0;
+      for (int t = 0; t < o.trials * 10; t++) {
+        us += pollUs(o, c, poll(o, c, cards, listed, rng));
+        for (int i = 0; i < cards; i++) {
+          missed[i] = listed[i] ? 0 : missed[i] + 1;
+          if (missed[i] >= o.limit) { departures++; missed[i] = 0; }
+        }
+      }
+      double p95 = percentile(times, 0.95);
+      printf("%-30s %5d %8.2f %9.1f %9.1f %12.1f\n", c.name, cards, polls / o.trials, mean, p95,
+             departures * HOUR_US / us);
+    }
+  }
+  return 0;
+}
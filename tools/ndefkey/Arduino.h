@@ -0,0 +1,9 @@
+/**
+ * @file    Arduino.h
+ * @brief   Just enough of Arduino.h to build NdefKeyReader on the host
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
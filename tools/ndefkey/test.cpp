@@ -0,0 +1,74 @@
+/**
+ * @file    test.cpp
+ * @brief   Host tests of NdefKeyReader on Type 2 user memory images
+ *
+ *   g++ -O2 -I. -I../../src test.cpp ../../src/NdefKeyReader.cpp -o test
+ *   ./test
+ *
+ * Each case loads an image of user memory (page 4 on) and checks the key, or that
+ * readKey() fails, within a bounded number of block reads. Exits non-zero on failure.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "NdefKeyReader.h"
+
+#define MAX_READS (NDEF_T2_MAX_BYTES / NDEF_T2_BLOCK_SIZE + 1)
+
+static uint8_t memory[NDEF_T2_MAX_BYTES];
+static int reads;
+static int failAtRead;                      // Read that fails, 0 for none
+
+static bool readBlock(uint8_t page, uint8_t *block) {
+  if (++reads == failAtRead || reads > MAX_READS) { return false; }
+  uint16_t offset = (page - NDEF_T2_FIRST_PAGE) * 4;
+  memset(block, 0, NDEF_T2_BLOCK_SIZE);
+  memcpy(block, memory + offset, (size_t)offset + NDEF_T2_BLOCK_SIZE <= sizeof(memory) ? NDEF_T2_BLOCK_SIZE : sizeof(memory) - offset);
+  return true;
+}
+
+static int failures = 0;
+
+static void check(const char *name, const uint8_t *image, size_t size, const char *expected, int failRead = 0) {
+  memset(memory, 0, sizeof(memory));
+  memcpy(memory, image, size);
+  reads = 0;
+  failAtRead = failRead;
+  NdefKeyReader reader(readBlock);
+  uint8_t key[NDEF_KEY_MAX];
+  uint8_t keyLength = 0;
+  bool ok = reader.readKey(key, &keyLength);
+  bool pass = expected ? ok && keyLength == strlen(expected) && memcmp(key, expected, keyLength) == 0 : !ok;
+  pass = pass && reads <= MAX_READS;
+  printf("%-28s %s (%d reads)\n", name, pass ? "ok" : "FAIL", reads);
+  if (!pass) { failures++; }
+}
+
+int main() {
+  // Text record "en" "hello"
+  const uint8_t text[] = { 0x03, 0x0C, 0xD1, 0x01, 0x08, 'T', 0x02, 'e', 'n', 'h', 'e', 'l', 'l', 'o', 0xFE };
+  check("text record", text, sizeof(text), "hello");
+
+  // Lock control TLV before a URI record, prefix code kept
+  const uint8_t uri[] = { 0x01, 0x03, 0xA0, 0x10, 0x44, 0x03, 0x08, 0xD1, 0x01, 0x04, 'U', 0x04, 'a', '.', 'b', 0xFE };
+  check("uri after lock TLV", uri, sizeof(uri), "\x04" "a.b");
+
+  // Long TLV length of 0xFFFF wrapped a 16-bit offset back to 7 and spun forever
+  const uint8_t wrap[] = { 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF9 };
+  check("TLV length wraps offset", wrap, sizeof(wrap), 0);
+
+  // Message longer than user memory
+  const uint8_t longMessage[] = { 0x03, 0xFF, 0xFF, 0xF0, 0xD1, 0x01, 0x02, 'T', 0x00, 'x' };
+  check("message past memory", longMessage, sizeof(longMessage), 0);
+
+  // Long-form payload length that would wrap pos + payloadLength
+  const uint8_t longPayload[] = { 0x03, 0x0A, 0xC1, 0x01, 0xFF, 0xFF, 0xFF, 0xFE, 'U', 0x00, 'x', 0xFE };
+  check("payload length wraps", longPayload, sizeof(longPayload), 0);
+
+  check("read failure", text, sizeof(text), 0, 1);
+
+  const uint8_t terminator[] = { 0xFE };
+  check("no NDEF message", terminator, sizeof(terminator), 0);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file    Arduino.h
+ * @brief   Just enough of Arduino.h to build Secp128r1 and OriginalityCheck on the host
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+unsigned long micros();
+
+class String {
+public:
+  String(const char *s = "") : _s(s) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+  String(uint32_t v) : _s(std::to_string(v)) {}
+  String(float v, int decimals) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", decimals, v);
+    _s = text;
+  }
+  const char *c_str() const { return _s.c_str(); }
+  String operator+(const String &other) const { String out(*this); out._s += other._s; return out; }
+  friend String operator+(const char *a, const String &b) { return String(a) + b; }
+
+private:
+  std::string _s;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t println(const String &line) = 0;
+};
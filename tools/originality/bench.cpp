@@ -0,0 +1,81 @@
+/**
+ * @file    bench.cpp
+ * @brief   Host benchmark of originality signature verification and of the per-UID verdict cache
+ *
+ *   g++ -O2 -I. -I../../src bench.cpp ../../src/Secp128r1.cpp ../../src/OriginalityCheck.cpp -o bench
+ *   ./bench
+ *   ./bench --placements 20000 --seed 2
+ *
+ * Times secp128r1Verify() on one signature, then plays placements of a set of cubes through
+ * OriginalityCheck as isGenuineTag() in src/main.cpp does: lookup(), and verify() on a miss.
+ * Cubes are drawn uniformly, or with "show" from a few in use at a time, the way a game
+ * moves through its scenes. The table gives the hit rate and the verify time per placement.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "OriginalityCheck.h"
+
+static const auto epoch = std::chrono::steady_clock::now();
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+static const uint8_t UID[7] = { 0x04, 0xE1, 0x0C, 0x1A, 0x22, 0x5D, 0x80 };
+static const uint8_t SIGNATURE[SECP128R1_SIGNATURE_SIZE] = {
+  0xB0, 0xAA, 0xA8, 0x87, 0x47, 0x14, 0x1F, 0xCE, 0xB2, 0xE6, 0x2F, 0x7C, 0x18, 0x06, 0x8C, 0x26,
+  0x42, 0x27, 0x14, 0x1A, 0xC3, 0xD2, 0xA4, 0x9B, 0x7C, 0x76, 0xDD, 0xA6, 0x96, 0x7A, 0x0E, 0xF6
+};
+static const uint8_t TEST_KEY[SECP128R1_KEY_SIZE] = {
+  0x04, 0xC0, 0x7D, 0x66, 0x27, 0x84, 0xD5, 0x3B, 0xFD, 0x6D, 0x7D, 0x6B, 0xE2, 0x34, 0x7E, 0x26,
+  0x59, 0x58, 0xFA, 0x91, 0xCF, 0x46, 0x3E, 0xF2, 0x1C, 0x27, 0x48, 0x92, 0xEC, 0xE1, 0xBD, 0xF4
+};
+
+int main(int argc, char **argv) {
+  int placements = 3000;
+  unsigned seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--placements")) { placements = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--seed")) { seed = atoi(argv[i + 1]); }
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+
+  const int runs = 100;
+  double total = 0, worst = 0;
+  int valid = 0;
+  for (int i = 0; i < runs; i++) {
+    auto start = std::chrono::steady_clock::now();
+    valid += secp128r1Verify(TEST_KEY, UID, sizeof(UID), SIGNATURE);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    total += us;
+    if (us > worst) { worst = us; }
+  }
+  printf("verify: %.1f us mean, %.1f us max over %d runs (%d valid)\n\n", total / runs, worst, runs, valid);
+
+  printf("%6s %-8s %9s %12s\n", "cubes", "draw", "hit rate", "us/place");
+  for (int cubes : { 8, 16, 24, 32, 64 }) {
+    for (bool show : { false, true }) {
+      std::mt19937 rng(seed);
+      OriginalityCheck check;
+      int hits = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (int p = 0; p < placements; p++) {
+        // show: a scene uses 6 cubes, the next scene moves on by 2
+        int cube = show ? ((p / 200) * 2 + (int)(rng() % 6)) % cubes : (int)(rng() % cubes);
+        uint8_t uid[7];
+        memcpy(uid, UID, sizeof(uid));
+        uid[5] = cube;
+        if (check.lookup(uid, sizeof(uid)) != ORIGINALITY_UNKNOWN) { hits++; continue; }
+        check.verify(uid, sizeof(uid), SIGNATURE, true);
+      }
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      printf("%6d %-8s %8.1f%% %12.2f\n", cubes, show ? "show" : "uniform", 100.0 * hits / placements, us / placements);
+    }
+  }
+  printf("\nThe cache holds %d verdicts, replaced round robin.\n", ORIGINALITY_CACHE_SIZE);
+  return 0;
+}
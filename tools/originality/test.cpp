@@ -0,0 +1,160 @@
+/**
+ * @file    test.cpp
+ * @brief   Host tests of the secp128r1 verifier behind the NTAG originality check
+ *
+ *   g++ -O2 -I. -I../../src test.cpp ../../src/Secp128r1.cpp -o test
+ *   ./test                      # built-in vectors
+ *   ./test signatures.txt       # also real tags: one "UID SIGNATURE" hex pair per line
+ *
+ * NXP signs the UID with a private key only it holds, so the built-in vectors are made
+ * under a test key with python-ecdsa, an implementation independent of this one:
+ *
+ *   sk = ecdsa.SigningKey.from_secret_exponent(0x0123456789ABCDEF0FEDCBA987654321, curve=ecdsa.SECP128r1)
+ *   sk.sign_digest_deterministic(bytes.fromhex(uid), hashfunc=hashlib.sha256, sigencode=sigencode_string)
+ *
+ * The digest is the 7-byte UID itself, used as the integer e as on the tags. Each vector is
+ * checked as signed, with one bit flipped in r and in s, and against the wrong UID. The
+ * NXP NTAG21x key compiled into OriginalityCheck.cpp is checked to be a point of the curve,
+ * which catches a mistyped digit. READ_SIG answers of genuine tags in the file given are
+ * verified against that key. Exits non-zero on failure.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "Secp128r1.h"
+
+typedef unsigned __int128 u128;
+
+// Test key, x || y, of the secret exponent above
+static const uint8_t TEST_KEY[SECP128R1_KEY_SIZE] = {
+  0x04, 0xC0, 0x7D, 0x66, 0x27, 0x84, 0xD5, 0x3B, 0xFD, 0x6D, 0x7D, 0x6B, 0xE2, 0x34, 0x7E, 0x26,
+  0x59, 0x58, 0xFA, 0x91, 0xCF, 0x46, 0x3E, 0xF2, 0x1C, 0x27, 0x48, 0x92, 0xEC, 0xE1, 0xBD, 0xF4
+};
+
+// The same bytes as NXP_NTAG21X_KEY in src/OriginalityCheck.cpp
+static const uint8_t NXP_KEY[SECP128R1_KEY_SIZE] = {
+  0x49, 0x4E, 0x1A, 0x38, 0x6D, 0x3D, 0x3C, 0xFE, 0x3D, 0xC1, 0x0E, 0x5D, 0xE6, 0x8A, 0x49, 0x9B,
+  0x1C, 0x20, 0x2D, 0xB5, 0xB1, 0x32, 0x39, 0x3E, 0x89, 0xED, 0x19, 0xFE, 0x5B, 0xE8, 0xBC, 0x61
+};
+
+struct Vector {
+  const char *uid;
+  const char *signature;
+};
+
+static const Vector VECTORS[] = {
+  { "04E10C1A225D80", "B0AAA88747141FCEB2E62F7C18068C264227141AC3D2A49B7C76DDA6967A0EF6" },
+  { "04A2B3C4D5E681", "ADAFBCA45F0D6BE6B8BCB9C8D4FA55B6FB0E337153C748DE4647D7051F64A6B1" },
+};
+
+static int failures = 0;
+
+static void report(const char *name, bool pass) {
+  printf("%-44s %s\n", name, pass ? "ok" : "FAIL");
+  if (!pass) { failures++; }
+}
+
+static size_t parseHex(const char *text, uint8_t *out, size_t max) {
+  size_t n = 0;
+  unsigned int byte;
+  while (n < max && sscanf(text + 2 * n, "%2x", &byte) == 1) { out[n++] = byte; }
+  return n;
+}
+
+// secp128r1: p = 2^128 - 2^97 - 1, y^2 = x^3 - 3x + b
+static const u128 P = ~(u128)0 - ((u128)1 << 97);
+static const u128 B = ((u128)0xE87579C11079F43DULL << 64) | 0xD824993C2CEE5ED3ULL;
+
+static u128 addMod(u128 a, u128 b) {
+  u128 sum = a + b;
+  return (sum < a || sum >= P) ? sum - P : sum;
+}
+
+static u128 mulMod(u128 a, u128 b) {
+  u128 result = 0;
+  for (int bit = 127; bit >= 0; bit--) {
+    result = addMod(result, result);
+    if ((b >> bit) & 1) { result = addMod(result, a); }
+  }
+  return result;
+}
+
+static u128 load(const uint8_t *bytes) {
+  u128 v = 0;
+  for (int i = 0; i < 16; i++) { v = v << 8 | bytes[i]; }
+  return v;
+}
+
+static bool onCurve(const uint8_t key[SECP128R1_KEY_SIZE]) {
+  u128 x = load(key), y = load(key + 16);
+  if (x >= P || y >= P) { return false; }
+  u128 right = addMod(mulMod(mulMod(x, x), x), B);
+  right = addMod(right, P - addMod(addMod(x, x), x));
+  return mulMod(y, y) == right;
+}
+
+int main(int argc, char **argv) {
+  report("NXP NTAG21x key is on the curve", onCurve(NXP_KEY));
+  report("test key is on the curve", onCurve(TEST_KEY));
+
+  for (const Vector &v : VECTORS) {
+    uint8_t uid[7], signature[SECP128R1_SIGNATURE_SIZE], tampered[SECP128R1_SIGNATURE_SIZE];
+    parseHex(v.uid, uid, sizeof(uid));
+    parseHex(v.signature, signature, sizeof(signature));
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s valid", v.uid);
+    report(name, secp128r1Verify(TEST_KEY, uid, sizeof(uid), signature));
+
+    memcpy(tampered, signature, sizeof(tampered));
+    tampered[5] ^= 0x10;
+    snprintf(name, sizeof(name), "%s bit flipped in r", v.uid);
+    report(name, !secp128r1Verify(TEST_KEY, uid, sizeof(uid), tampered));
+
+    memcpy(tampered, signature, sizeof(tampered));
+    tampered[31] ^= 0x01;
+    snprintf(name, sizeof(name), "%s bit flipped in s", v.uid);
+    report(name, !secp128r1Verify(TEST_KEY, uid, sizeof(uid), tampered));
+
+    uint8_t other[7];
+    memcpy(other, uid, sizeof(other));
+    other[3] ^= 0x01;
+    snprintf(name, sizeof(name), "%s wrong UID", v.uid);
+    report(name, !secp128r1Verify(TEST_KEY, other, sizeof(other), signature));
+
+    snprintf(name, sizeof(name), "%s under the NXP key", v.uid);
+    report(name, !secp128r1Verify(NXP_KEY, uid, sizeof(uid), signature));
+  }
+
+  // r and s must lie in [1, n - 1]
+  uint8_t uid[7], signature[SECP128R1_SIGNATURE_SIZE];
+  parseHex(VECTORS[0].uid, uid, sizeof(uid));
+  memset(signature, 0, sizeof(signature));
+  report("zero signature", !secp128r1Verify(TEST_KEY, uid, sizeof(uid), signature));
+  memset(signature, 0xFF, sizeof(signature));
+  report("r and s above the order", !secp128r1Verify(TEST_KEY, uid, sizeof(uid), signature));
+
+  if (argc > 1) {
+    FILE *f = fopen(argv[1], "r");
+    if (!f) { perror(argv[1]); return 1; }
+    char uidText[32], signatureText[80];
+    int tags = 0, genuine = 0;
+    while (fscanf(f, "%31s %79s", uidText, signatureText) == 2) {
+      uint8_t tagUid[10];
+      size_t uidLength = parseHex(uidText, tagUid, sizeof(tagUid));
+      tags++;
+      if (parseHex(signatureText, signature, sizeof(signature)) == sizeof(signature) &&
+          secp128r1Verify(NXP_KEY, tagUid, uidLength, signature)) {
+        genuine++;
+      } else {
+        printf("  %s does not verify\n", uidText);
+      }
+    }
+    fclose(f);
+    char name[64];
+    snprintf(name, sizeof(name), "%d of %d tags in %s genuine", genuine, tags, argv[1]);
+    report(name, tags > 0 && genuine == tags);
+  }
+
+  return failures ? 1 : 0;
+}
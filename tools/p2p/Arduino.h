@@ -0,0 +1,13 @@
+/**
+ * @file    Arduino.h
+ * @brief   Just enough of Arduino.h to build the LLCP sources on the host, on bench.cpp's simulated clock
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
@@ -0,0 +1,275 @@
+/**
+ * @file    bench.cpp
+ * @brief   Simulated P2P exchange: SNEP PUTs with one activation each against one LLCPSession
+ *
+ *   P=../../lib/PN532-PN532_HSU/PN532 E=../../lib/PN532-PN532_HSU/PN532_errors
+ *   g++ -O2 -std=gnu++17 -I. -I$P -I$E bench.cpp $P/mac_link.cpp $P/llcp.cpp $P/snep.cpp $P/llcp_session.cpp -o bench
+ *   ./bench                                   # 20 messages of 64 bytes, I2C at 400 kHz
+ *   ./bench --messages 50 --size 100 --phone-us 3000 --wakeup-ms 0
+ *
+ * The PN532 target commands the LLCP sources use (begin, SAMConfig, TgInitAsTarget,
+ * TgGetData, TgSetData) are replaced by a simulated PN532 and phone on a simulated clock.
+ * The phone runs the initiator side of LLCP: a SNEP server on SAP 4 and an echo service
+ * reached by name through the SDP. It acknowledges each I PDU with an RR, then sends
+ * the service's response, one PDU per DEP exchange.
+ *
+ * Time is charged for the host frames on the bus, the PN532's processing, the RF frames at
+ * 424 kbit/s, the phone's turnaround and, per activation, the PN532 wakeup delay of
+ * PN532::begin() and the phone's discovery and ATR. The constants are estimates; the
+ * p2p_session example measures the same exchanges on hardware.
+ *
+ * Modes:
+ *   snep      SNEP::write() per message: activate, connect, PUT, disconnect
+ *   session   SNEPClient::put() on one LLCPSession, one activation in total
+ *   multiplex a SNEP PUT and an echo exchange queued together on two links per message
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include "PN532.h"
+#include "snep.h"
+#include "llcp_session.h"
+
+struct Model {
+  double byteUs = 22.5;         // Host bus, I2C at 400 kHz
+  double pn532Us = 200;         // PN532 processing per command
+  double rfByteUs = 8 / 0.424;  // 424 kbit/s
+  double rfFrameUs = 100;       // Preamble, sync, DEP header and CRC
+  double phoneUs = 2000;        // Phone LLCP turnaround
+  double activateMs = 120;      // Phone discovery, ATR_REQ/RES and PSL
+  double wakeupMs = 500;        // PN532_I2C::wakeup() in PN532::begin()
+};
+
+static Model model;
+static uint64_t nowUs;
+unsigned long millis() { return nowUs / 1000; }
+unsigned long micros() { return nowUs; }
+void delay(unsigned long ms) { nowUs += ms * 1000ULL; }
+
+static void bus(size_t bytes) { nowUs += (uint64_t)((bytes + 7 + 6 + 7) * model.byteUs + model.pn532Us); }
+static void rf(size_t bytes) { nowUs += (uint64_t)(bytes * model.rfByteUs + model.rfFrameUs); }
+
+typedef std::vector<uint8_t> Pdu;
+
+static Pdu header(uint8_t dsap, uint8_t type, uint8_t ssap) {
+  return Pdu{ (uint8_t)((dsap << 2) + (type >> 2)), (uint8_t)(((type & 0x3) << 6) + ssap) };
+}
+
+/** Initiator side of the LLCP link, on a phone. */
+struct Phone {
+  struct Connection { uint8_t local, remote, vs, vr; bool echo; };
+  std::vector<Connection> connections;
+  std::deque<Pdu> out;
+  uint32_t pdusIn = 0, aggregated = 0;
+
+  void reset() { connections.clear(); out.clear(); out.push_back(Pdu{ 0, 0 }); }   // The initiator speaks first
+
+  Connection *find(uint8_t local, uint8_t remote) {
+    for (Connection &c : connections) {
+      if (c.local == local && c.remote == remote) { return &c; }
+    }
+    return nullptr;
+  }
+
+  void receive(const uint8_t *pdu, size_t length) {
+    uint8_t type = getPType(pdu), dsap = getDSAP(pdu), ssap = getSSAP(pdu);
+    if (type == PDU_AGF) {
+      aggregated++;
+      for (size_t offset = 2; offset + 2 <= length; ) {
+        size_t n = (pdu[offset] << 8) + pdu[offset + 1];
+        receive(pdu + offset + 2, n);
+        offset += 2 + n;
+      }
+      return;
+    }
+    if (type != PDU_SYMM) { pdusIn++; }
+    if (type == PDU_CONNECT) {
+      bool echo = dsap == LLCP_SAP_SDP && length > 4 && pdu[2] == 0x06 &&
+                  std::string((const char *)pdu + 4, pdu[3]) == "urn:nfc:sn:echo";
+      if (dsap != LLCP_SAP_SNEP && !echo) { Pdu dm = header(ssap, PDU_DM, dsap); dm.push_back(2); out.push_back(dm); return; }
+      uint8_t local = echo ? 0x10 : LLCP_SAP_SNEP;
+      connections.push_back(Connection{ local, ssap, 0, 0, echo });
+      out.push_back(header(ssap, PDU_CC, local));
+    } else if (type == PDU_DISC) {
+      Pdu dm = header(ssap, PDU_DM, dsap);
+      dm.push_back(0);
+      out.push_back(dm);
+    } else if (type == PDU_I) {
+      Connection *c = find(dsap, ssap);
+      if (!c) { return; }
+      c->vr = (c->vr + 1) & 0x0F;
+      Pdu rr = header(ssap, PDU_RR, dsap);
+      rr.push_back(c->vr);
+      out.push_back(rr);
+      Pdu response = header(ssap, PDU_I, dsap);
+      response.push_back((c->vs << 4) + c->vr);
+      c->vs = (c->vs + 1) & 0x0F;
+      if (c->echo) {
+        response.insert(response.end(), pdu + 3, pdu + length);
+      } else {
+        const uint8_t success[] = { SNEP_DEFAULT_VERSION, SNEP_RESPONSE_SUCCESS, 0, 0, 0, 0 };
+        response.insert(response.end(), success, success + sizeof(success));
+      }
+      out.push_back(response);
+    }
+  }
+
+  Pdu next() {
+    if (out.empty()) { return Pdu{ 0, 0 }; }
+    Pdu pdu = out.front();
+    out.pop_front();
+    return pdu;
+  }
+};
+
+static Phone phone;
+static Pdu pending;               // The phone's PDU that the next TgGetData returns
+static uint32_t activations, exchanges;
+
+// The simulated PN532 in target mode
+PN532::PN532(PN532Interface &interface) : _interface(&interface) {}
+void PN532::begin() { delay((unsigned long)model.wakeupMs); }
+bool PN532::SAMConfig() { bus(4); return true; }
+
+int8_t PN532::tgInitAsTarget(uint16_t timeout) {
+  (void)timeout;  // The phone always answers the activation
+  bus(38);
+  nowUs += (uint64_t)(model.activateMs * 1000);
+  activations++;
+  phone.reset();
+  pending = phone.next();
+  return 1;
+}
+
+int16_t PN532::tgGetData(uint8_t *buf, uint8_t len) {
+  nowUs += (uint64_t)model.phoneUs;
+  rf(pending.size());
+  bus(2 + pending.size());
+  exchanges++;
+  if (pending.size() > len) { return -4; }
+  memcpy(buf, pending.data(), pending.size());
+  return pending.size();
+}
+
+bool PN532::tgSetData(const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8_t blen) {
+  Pdu pdu(header, header + hlen);
+  if (blen) { pdu.insert(pdu.end(), body, body + blen); }
+  bus(1 + pdu.size());
+  rf(pdu.size());
+  phone.receive(pdu.data(), pdu.size());
+  pending = phone.next();
+  return true;
+}
+
+// The interface is never called, the PN532 methods above stand in for it
+struct NoInterface : PN532Interface {
+  void begin() {}
+  void wakeup() {}
+  int8_t writeCommand(const uint8_t *, uint8_t, const uint8_t *, uint8_t) { return -1; }
+  int16_t readResponse(uint8_t *, uint8_t, uint16_t) { return -1; }
+};
+
+struct Result {
+  const char *mode;
+  double totalMs, setupMs;
+  std::vector<double> latencyMs;
+  uint32_t activations, exchanges, ok, aggregated;
+};
+
+static void print(const Result &r, int messages, int size) {
+  std::vector<double> l = r.latencyMs;
+  std::sort(l.begin(), l.end());
+  double sum = 0;
+  for (double v : l) { sum += v; }
+  double p99 = l.empty() ? 0 : l[std::min(l.size() - 1, (size_t)(0.99 * l.size()))];
+  printf("%-10s %4u/%-4d %9.1f %8.1f %8.2f %8.2f %7.1f %9.0f %7.1f %5u %4u\n", r.mode, r.ok, messages, r.totalMs,
+         r.setupMs, l.empty() ? 0 : sum / l.size(), p99, r.ok * 1000.0 / r.totalMs, r.ok * size * 1000.0 / r.totalMs,
+         (double)r.exchanges / std::max<uint32_t>(r.ok, 1), r.activations, r.aggregated);
+}
+
+int main(int argc, char **argv) {
+  int messages = 20, size = 64;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--messages")) { messages = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--size")) { size = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--byte-us")) { model.byteUs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--phone-us")) { model.phoneUs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--activate-ms")) { model.activateMs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--wakeup-ms")) { model.wakeupMs = atof(argv[i + 1]); }
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+  if (size < 1 || size > LLCP_SESSION_MIU - 6) { fprintf(stderr, "--size is 1 to %d\n", LLCP_SESSION_MIU - 6); return 1; }
+  std::vector<uint8_t> message(size);
+  for (int i = 0; i < size; i++) { message[i] = i; }
+  NoInterface interface;
+
+  printf("%d messages of %d bytes, bus %.1f us/byte, phone turnaround %.1f ms, activation %.0f ms, wakeup %.0f ms\n\n",
+         messages, size, model.byteUs, model.phoneUs / 1000, model.activateMs, model.wakeupMs);
+  printf("%-10s %9s %9s %8s %8s %8s %7s %9s %7s %5s %4s\n", "mode", "ok", "total ms", "setup ms", "avg ms", "p99 ms",
+         "msg/s", "B/s", "DEP/msg", "acts", "AGF");
+
+  // One activation and connection per message
+  {
+    Result r = { "snep", 0, 0, {}, 0, 0, 0, 0 };
+    nowUs = 0; activations = exchanges = phone.aggregated = 0;
+    for (int i = 0; i < messages; i++) {
+      uint64_t start = nowUs;
+      SNEP snep(interface);
+      if (snep.write(message.data(), size) > 0) { r.ok++; }
+      r.latencyMs.push_back((nowUs - start) / 1000.0);
+      if (i == 0) { r.setupMs = r.latencyMs[0]; }
+    }
+    r.totalMs = nowUs / 1000.0; r.activations = activations; r.exchanges = exchanges; r.aggregated = phone.aggregated;
+    print(r, messages, size);
+  }
+
+  // One activation, one SNEP connection, every PUT on it
+  {
+    Result r = { "session", 0, 0, {}, 0, 0, 0, 0 };
+    nowUs = 0; activations = exchanges = phone.aggregated = 0;
+    LLCPSession session(interface);
+    SNEPClient snep(session);
+    session.open();
+    for (int i = 0; i < messages; i++) {
+      if (snep.put(message.data(), size) > 0) { r.ok++; r.latencyMs.push_back(snep.lastLatency() / 1000.0); }
+    }
+    r.setupMs = session.setupMicros() / 1000.0;
+    r.totalMs = nowUs / 1000.0; r.activations = activations; r.exchanges = exchanges; r.aggregated = phone.aggregated;
+    print(r, messages, size);
+  }
+
+  // A SNEP PUT and an echo exchange per message, on two links of one session
+  {
+    Result r = { "multiplex", 0, 0, {}, 0, 0, 0, 0 };
+    nowUs = 0; activations = exchanges = phone.aggregated = 0;
+    LLCPSession session(interface);
+    session.open();
+    int8_t snepLink = session.connect("urn:nfc:sn:snep");
+    int8_t echoLink = session.connect("urn:nfc:sn:echo");
+    session.wait(snepLink, LLCP_UNTIL_CONNECTED);
+    session.wait(echoLink, LLCP_UNTIL_CONNECTED);
+    r.setupMs = nowUs / 1000.0;
+    uint8_t snepHeader[6] = { SNEP_DEFAULT_VERSION, SNEP_REQUEST_PUT, 0, 0, 0, (uint8_t)size };
+    uint8_t response[LLCP_SESSION_MIU];
+    for (int i = 0; i < messages; i++) {
+      uint64_t start = nowUs;
+      session.send(snepLink, snepHeader, sizeof(snepHeader), message.data(), size);
+      session.send(echoLink, message.data(), size);
+      bool ok = session.wait(snepLink, LLCP_UNTIL_DATA) > 0 && session.receive(snepLink, response, sizeof(response)) >= 6 &&
+                response[1] == SNEP_RESPONSE_SUCCESS;
+      ok = ok && session.wait(echoLink, LLCP_UNTIL_DATA) > 0 && session.receive(echoLink, response, sizeof(response)) == size &&
+           memcmp(response, message.data(), size) == 0;
+      if (ok) { r.ok += 2; r.latencyMs.push_back((nowUs - start) / 1000.0); }
+    }
+    r.totalMs = nowUs / 1000.0; r.activations = activations; r.exchanges = exchanges; r.aggregated = phone.aggregated;
+    print(r, 2 * messages, size);
+  }
+  printf("\nsetup: first message for snep, open() to the first connection otherwise; avg and p99 per message after it\n"
+         "(multiplex: per pair). DEP/msg counts TgGetData exchanges; AGF counts aggregated frames sent.\n");
+  return 0;
+}
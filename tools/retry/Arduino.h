@@ -0,0 +1,15 @@
+/**
+ * @file    Arduino.h
+ * @brief   Just enough of Arduino.h to build PN532.cpp and the retry policy on the host
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+unsigned long millis();
+void delay(unsigned long ms);
@@ -0,0 +1,170 @@
+/**
+ * @file    test.cpp
+ * @brief   Host tests of PN532RetryPolicy around the real PN532 driver
+ *
+ *   P=../../lib/PN532-PN532_HSU/PN532 E=../../lib/PN532-PN532_HSU/PN532_errors
+ *   g++ -O2 -std=gnu++17 -I. -I$P -I$E test.cpp $P/PN532.cpp $E/retry_policy.cpp -o test
+ *   ./test
+ *
+ * The fake PN532Interface plays a script, one step per command: the error byte of an
+ * InDataExchange or InListPassiveTarget answer, or a transport error, and how many ms the
+ * command takes on a clock only it advances. Each case runs the loop readNtagBlock() in
+ * src/main.cpp runs, then checks the result, the attempts sent and the policy counters.
+ * Further cases check that lastError() comes from the command that just failed, not an
+ * earlier one, and that a session without a target is refused before anything is sent.
+ * Exits non-zero on failure.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "PN532.h"
+#include "retry_policy.h"
+
+static unsigned long now;                 // ms, advanced by the fake
+unsigned long millis() { return now; }
+void delay(unsigned long ms) { now += ms; }
+
+struct Step {
+  int16_t error;                          // A PN532Interface.h error, or 0 for an answer
+  uint8_t status;                         // Error byte of the answer
+  unsigned long ms;                       // Time the command takes
+};
+
+class ScriptedPN532 : public PN532Interface {
+public:
+  const Step *steps = 0;
+  int count = 0;
+  int sent = 0;
+
+  void play(const Step *script, int length) { steps = script; count = length; sent = 0; }
+
+  void begin() {}
+  void wakeup() {}
+
+  int8_t writeCommand(const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8_t blen) {
+    (void)hlen; (void)body; (void)blen;
+    _command = header[0];
+    return 0;
+  }
+
+  int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout) {
+    (void)timeout;
+    if (sent >= count) { return PN532_TIMEOUT; }
+    const Step &step = steps[sent++];
+    now += step.ms;
+    if (step.error) { return step.error; }
+    if (_command == PN532_COMMAND_READREGISTER) { memset(buf, 0, len); return len; }
+    if (_command == PN532_COMMAND_INLISTPASSIVETARGET) { buf[0] = 0; return 1; }   // No card
+    buf[0] = step.status;                 // InDataExchange: status, then a 16-byte block
+    memset(buf + 1, 0xA5, 16);
+    return step.status ? 1 : 17;
+  }
+
+private:
+  uint8_t _command = 0;
+};
+
+static ScriptedPN532 bus;
+static PN532 nfc(bus);
+static int failures = 0;
+
+static void report(const char *name, bool pass) {
+  printf("%-40s %s\n", name, pass ? "ok" : "FAIL");
+  if (!pass) { failures++; }
+}
+
+// The READ of readNtagBlock(): resend while the policy says the error can clear up
+static bool readBlock(PN532RetryPolicy &policy) {
+  uint8_t read[] = { 0x30, 4 };
+  uint8_t block[16], length;
+  bool ok;
+  policy.begin();
+  do {
+    length = sizeof(block);
+    ok = nfc.inDataExchange(read, sizeof(read), block, &length);
+  } while (!ok && policy.again(nfc.lastError()));
+  return policy.finish(ok);
+}
+
+int main() {
+  {
+    // Two CRC errors from a noisy field, then the block
+    const Step script[] = { { 0, PN532_STATUS_CRC, 5 }, { 0, PN532_STATUS_CRC, 5 }, { 0, 0, 5 } };
+    PN532RetryPolicy policy;
+    bus.play(script, 3);
+    bool ok = readBlock(policy);
+    report("CRC error recovered on attempt 3", ok && bus.sent == 3 && policy.retries() == 2 &&
+           policy.recovered() == 1 && policy.errors(PN532_CLASS_RETRY) == 2);
+  }
+  {
+    // The card left the field: one attempt, no retry
+    const Step script[] = { { 0, PN532_STATUS_CARD_GONE, 5 }, { 0, 0, 5 } };
+    PN532RetryPolicy policy;
+    bus.play(script, 2);
+    bool ok = readBlock(policy);
+    report("card gone not retried", !ok && bus.sent == 1 && policy.retries() == 0 && policy.gaveUp() == 1 &&
+           policy.errors(PN532_CLASS_CARD_GONE) == 1);
+  }
+  {
+    // The PN532 answers nothing for 1 s: another attempt would overrun the 50 ms budget
+    const Step script[] = { { PN532_TIMEOUT, 0, 1000 }, { 0, 0, 5 } };
+    PN532RetryPolicy policy;
+    bus.play(script, 2);
+    bool ok = readBlock(policy);
+    report("budget exhausted", !ok && bus.sent == 1 && policy.retries() == 0 && policy.exhausted() == 1 &&
+           policy.errors(PN532_CLASS_BUSY) == 1);
+  }
+  {
+    // CRC errors with attempts left but the budget nearly spent: 30 ms per attempt, 50 ms budget
+    const Step script[] = { { 0, PN532_STATUS_CRC, 30 }, { 0, PN532_STATUS_CRC, 30 }, { 0, 0, 5 } };
+    PN532RetryPolicy policy;
+    bus.play(script, 3);
+    bool ok = readBlock(policy);
+    report("budget ends the retries before attempts", !ok && bus.sent == 1 && policy.exhausted() == 1);
+  }
+
+  // lastError() after a failure must be that failure's, never an earlier command's
+  {
+    const Step script[] = { { 0, PN532_STATUS_CRC, 1 }, { PN532_TIMEOUT, 0, 1 } };
+    bus.play(script, 2);
+    uint8_t read[] = { 0x30, 4 }, block[16], length = sizeof(block);
+    nfc.inDataExchange(read, sizeof(read), block, &length);
+    const PN532Register regs[] = { PN532_CIU_TXMODE, PN532_CIU_RXMODE };
+    uint8_t values[2];
+    bool ok = nfc.readRegisters(regs, 2, values);
+    report("readRegisters failure recorded", !ok && nfc.lastError() == PN532_TIMEOUT);
+  }
+  {
+    const Step script[] = { { 0, PN532_STATUS_CRC, 1 }, { PN532_INVALID_FRAME, 0, 1 } };
+    bus.play(script, 2);
+    uint8_t read[] = { 0x30, 4 }, block[16], length = sizeof(block);
+    nfc.inDataExchange(read, sizeof(read), block, &length);
+    const PN532Register regs[] = { PN532_CIU_TXMODE };
+    const uint8_t masks[] = { 0x80 }, values[] = { 0x80 };
+    bool ok = nfc.modifyRegisters(regs, masks, values, 1);
+    report("modifyRegisters failure recorded", !ok && nfc.lastError() == PN532_INVALID_FRAME);
+  }
+  {
+    const Step script[] = { { 0, PN532_STATUS_CRC, 1 }, { 0, 0, 1 } };
+    bus.play(script, 2);
+    uint8_t read[] = { 0x30, 4 }, block[16], length = sizeof(block);
+    nfc.inDataExchange(read, sizeof(read), block, &length);
+    FelicaTarget targets[PN532_MAX_TARGETS];
+    int8_t count = nfc.felica_PollTargets(0xFFFF, 0, 4, targets);
+    report("felica_PollTargets without a card", count == 0 && nfc.lastError() == PN532_NO_TARGET);
+  }
+
+  {
+    // A released session has Tg 0, which InRelease would take as every target
+    const Step script[] = { { 0, 0, 1 } };
+    bus.play(script, 1);
+    PN532Target released;
+    memset(&released, 0, sizeof(released));
+    uint8_t read[] = { 0x30, 4 }, block[16], length = sizeof(block);
+    bool pass = nfc.inRelease(released) == PN532_BAD_PARAMETER && !nfc.inSelect(released) &&
+                !nfc.inDataExchange(released, read, sizeof(read), block, &length);
+    report("released session sends nothing", pass && bus.sent == 0 && nfc.lastError() == PN532_BAD_PARAMETER);
+  }
+
+  return failures ? 1 : 0;
+}
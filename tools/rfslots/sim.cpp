@@ -0,0 +1,279 @@
+/**
+ * @file    sim.cpp
+ * @brief   Simulation of podiums polling side by side, free-running against RF time slots
+ *
+ *   g++ -O2 -std=c++17 sim.cpp -o sim
+ *   ./sim                              # 8 podiums, 4 slots of 50 ms, 10 simulated minutes per row
+ *   ./sim --readers 12 --slot-ms 30 --reach 25 --sync-ms 1
+ *   ./sim --sync-ms 2 --bound-ms 12.5  # podiums synced over Bluetooth
+ *
+ * Podiums stand in a row at a given spacing, each running the readNFC() loop of main.cpp:
+ * a poll of up to 100 ms, then the rest of loop(). Free-running podiums keep their field on
+ * all the time, since the PN532 keeps the carrier up between polls and after a host-side
+ * timeout. With slots, each podium mirrors RfSlots: podium i polls in slot i % slots of a
+ * frame computed from its estimate of host time, which is off by a normal error of --sync-ms,
+ * with a guard of the switch time plus --bound-ms, the ClockSync::errorBoundUs() it would report,
+ * and switches its field off when no poll fits the rest of its window.
+ *
+ * Interference: a poll retries activation every 5 ms while a cube is on the podium. An
+ * attempt fails if any neighbour had its field on during it with probability
+ * 1 / (1 + (d / reach)^4) for a neighbour at distance d, and on its own with --base-fail.
+ * Cubes arrive after an exponential gap and stay for a uniform dwell.
+ *
+ * For each spacing and mode the table gives the share of polls that missed a cube that was
+ * there, false removals (a cube that stayed put reported removed and placed again) per podium
+ * hour, placement and removal detection latency, and placements never reported.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define POLL_TIMEOUT_MS   (100)       // TIMEOUT in main.cpp
+#define ATTEMPT_MS        (5)         // REQA, anticollision and select of one activation attempt
+#define RESPONSE_MS       (1)         // InListPassiveTarget response over I2C
+#define LOOP_MS           (4)         // Serial, Bluetooth, Serial2 and journal phases after a poll
+#define IDLE_LOOP_MS      (1)         // loop() without a poll
+#define SWITCH_MS         (2)         // RFConfiguration over I2C
+#define MIN_POLL_MS       (10)        // RF_SLOT_MIN_POLL_MS
+
+struct Options {
+  int readers = 8;
+  int slotMs = 50;
+  double reach = 20;                // cm, a neighbour there fails half the attempts
+  // tools/clocksync/sim on Serial2 with reader polls held for replies: errors within 1.1 ms at p99,
+  // 1.0 ms between podiums at p99, a mean error bound of 2.3 ms
+  double syncMs = 0.5;              // Standard deviation of each podium's host time error
+  double boundMs = 2.3;             // ClockSync::errorBoundUs()
+  double baseFail = 0.02;
+  double gapS = 8;                  // Mean time without a cube
+  double dwellMinS = 1, dwellMaxS = 15;
+  int minutes = 10;
+  unsigned seed = 1;
+};
+
+static Options opt;
+
+// RfSlots::guardUs()
+static double guardMs() { return SWITCH_MS + opt.boundMs; }
+
+enum Step { STEP_LOOP, STEP_SWITCH_ON, STEP_SWITCH_OFF, STEP_POLL };
+
+struct Reader {
+  double errMs;
+  int slot;
+  bool fieldOn;
+  long lastOn;                      // Last ms the field was on
+
+  Step step;
+  long stepEnd;
+  long pollStart;
+  bool pollFound;
+
+  bool cube;                        // A cube is on the podium
+  long cubeChange;                  // Next arrival or removal
+  long arrivedAt, removedAt;
+  bool detected;                    // This placement was reported
+  bool reported;                    // readNFC()'s cardPresesnt
+};
+
+struct Stats {
+  long cubePolls = 0, cubePollMisses = 0;
+  long falseRemovals = 0;
+  long placements = 0, unreported = 0;
+  std::vector<double> detectMs, removeMs;
+};
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) { return 0; }
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static double mean(const std::vector<double> &v) {
+  double sum = 0;
+  for (double x : v) { sum += x; }
+  return v.empty() ? 0 : sum / v.size();
+}
+
+// ms left in the reader's window at its estimate of host time, -1 outside it, as RfSlots::windowLeftMs()
+static long windowLeft(const Reader &r, long t, int slots) {
+  long frame = (long)slots * opt.slotMs;
+  double local = t + r.errMs;
+  double phase = std::fmod(std::fmod(local, frame) + frame, frame);
+  double open = r.slot * opt.slotMs + guardMs(), close = (r.slot + 1) * opt.slotMs - guardMs();
+  if (phase < open || phase >= close) { return -1; }
+  return (long)(close - phase);
+}
+
+static Stats run(double spacingCm, int slots) {
+  std::mt19937 rng(opt.seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::normal_distribution<double> syncError(0, opt.syncMs);
+  std::exponential_distribution<double> gap(1 / (opt.gapS * 1000));
+  std::uniform_real_distribution<double> dwell(opt.dwellMinS * 1000, opt.dwellMaxS * 1000);
+
+  int n = opt.readers;
+  std::vector<std::vector<double>> coupling(n, std::vector<double>(n, 0));
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (i != j) { coupling[i][j] = 1 / (1 + std::pow(std::abs(i - j) * spacingCm / opt.reach, 4)); }
+    }
+  }
+  std::vector<Reader> readers(n);
+  for (int i = 0; i < n; i++) {
+    Reader &r = readers[i];
+    memset(&r, 0, sizeof(r));
+    r.errMs = slots ? syncError(rng) : 0;
+    r.slot = slots ? i % slots : 0;
+    r.fieldOn = slots == 0;
+    r.lastOn = -1000;
+    r.step = STEP_LOOP;
+    r.stepEnd = (long)(uniform(rng) * POLL_TIMEOUT_MS);   // Podiums booted at different times
+    r.cubeChange = (long)gap(rng);
+  }
+
+  Stats stats;
+  long end = (long)opt.minutes * 60000;
+  for (long t = 0; t < end; t++) {
+    for (Reader &r : readers) {
+      if (r.fieldOn) { r.lastOn = t; }
+    }
+    for (int i = 0; i < n; i++) {
+      Reader &r = readers[i];
+      if (t >= r.cubeChange) {
+        r.cube = !r.cube;
+        if (r.cube) {
+          r.arrivedAt = t;
+          r.detected = false;
+          stats.placements++;
+          r.cubeChange = t + (long)dwell(rng);
+        } else {
+          if (!r.detected) { stats.unreported++; }
+          r.removedAt = t;
+          r.cubeChange = t + (long)gap(rng);
+        }
+      }
+
+      // An activation attempt of a running poll
+      if (r.step == STEP_POLL && !r.pollFound && t > r.pollStart && (t - r.pollStart) % ATTEMPT_MS == 0 && r.cube) {
+        double success = 1 - opt.baseFail;
+        for (int j = 0; j < n; j++) {
+          if (j != i && readers[j].lastOn > t - ATTEMPT_MS) { success *= 1 - coupling[i][j]; }
+        }
+        if (uniform(rng) < success) {
+          r.pollFound = true;
+          r.stepEnd = t + RESPONSE_MS;
+        }
+      }
+      if (t < r.stepEnd) { continue; }
+
+      switch (r.step) {
+        case STEP_POLL: {
+          if (r.cube) {
+            stats.cubePolls++;
+            if (!r.pollFound) { stats.cubePollMisses++; }
+          }
+          if (r.pollFound && !r.reported) {
+            r.reported = true;
+            if (!r.detected) {
+              r.detected = true;
+              stats.detectMs.push_back(t - r.arrivedAt);
+            }
+          } else if (!r.pollFound && r.reported) {
+            r.reported = false;
+            if (r.cube) { stats.falseRemovals++; }
+            else { stats.removeMs.push_back(t - r.removedAt); }
+          }
+          // RfSlots::polled()
+          if (slots && windowLeft(r, t, slots) < MIN_POLL_MS) {
+            r.step = STEP_SWITCH_OFF;
+            r.stepEnd = t + SWITCH_MS;
+          } else {
+            r.step = STEP_LOOP;
+            r.stepEnd = t + LOOP_MS;
+          }
+          break;
+        }
+        case STEP_SWITCH_OFF:
+          r.fieldOn = false;
+          r.step = STEP_LOOP;
+          r.stepEnd = t + LOOP_MS;
+          break;
+        case STEP_SWITCH_ON:
+        case STEP_LOOP: {
+          if (r.step == STEP_SWITCH_ON) { r.fieldOn = true; }
+          // RfSlots::pollTimeout()
+          long timeout = POLL_TIMEOUT_MS;
+          if (slots) {
+            long left = windowLeft(r, t, slots);
+            if (left < MIN_POLL_MS) {
+              r.step = r.fieldOn ? STEP_SWITCH_OFF : STEP_LOOP;
+              r.stepEnd = t + (r.fieldOn ? SWITCH_MS : IDLE_LOOP_MS);
+              break;
+            }
+            if (!r.fieldOn) {
+              r.step = STEP_SWITCH_ON;
+              r.stepEnd = t + SWITCH_MS;
+              break;
+            }
+            timeout = std::min(timeout, left);
+          }
+          r.step = STEP_POLL;
+          r.pollStart = t;
+          r.pollFound = false;
+          r.stepEnd = t + timeout;
+          break;
+        }
+      }
+    }
+  }
+  return stats;
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--readers")) { opt.readers = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--slot-ms")) { opt.slotMs = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--reach")) { opt.reach = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--sync-ms")) { opt.syncMs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--bound-ms")) { opt.boundMs = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--base-fail")) { opt.baseFail = atof(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--minutes")) { opt.minutes = atoi(argv[i + 1]); }
+    else if (!strcmp(argv[i], "--seed")) { opt.seed = atoi(argv[i + 1]); }
+    else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+  }
+  // RfSlots::usable(): podiums whose guards leave no poll in the window poll freely
+  bool usable = opt.slotMs >= 2 * guardMs() + MIN_POLL_MS;
+
+  printf("%d podiums in a row, reach %.0f cm, slots of %d ms, sync error %.1f ms, guard %.1f ms, %d minutes per row\n",
+         opt.readers, opt.reach, opt.slotMs, opt.syncMs, guardMs(), opt.minutes);
+  if (!usable) { printf("The guards leave no poll in a %d ms window: slots are not used\n", opt.slotMs); }
+  printf("\n");
+  printf("%8s %-8s %9s %9s %9s %9s %9s %10s\n", "spacing", "mode", "miss %", "false/h", "place ms", "p99 ms",
+         "remove ms", "unreported");
+  const double spacings[] = { 60, 40, 30, 20, 15, 10 };
+  const int modes[] = { 0, 2, 4, 8 };
+  for (double spacing : spacings) {
+    for (int slots : modes) {
+      if (slots > opt.readers || (slots && !usable)) { continue; }
+      Stats s = run(spacing, slots);
+      char mode[16];
+      if (slots) { snprintf(mode, sizeof(mode), "W%d,%d", slots, opt.slotMs); }
+      else { snprintf(mode, sizeof(mode), "free"); }
+      double hours = opt.readers * opt.minutes / 60.0;
+      printf("%6.0fcm %-8s %9.2f %9.1f %9.1f %9.0f %9.1f %10ld\n", spacing, mode,
+             s.cubePolls ? 100.0 * s.cubePollMisses / s.cubePolls : 0, s.falseRemovals / hours, mean(s.detectMs),
+             percentile(s.detectMs, 0.99), mean(s.removeMs), s.unreported);
+    }
+    printf("\n");
+  }
+  printf("miss %%: polls that did not find a cube that was there. false/h: cubes that stayed put reported\n"
+         "removed, per podium hour. place ms: arrival to detection, avg and p99. remove ms: removal to the\n"
+         "remove event, avg. unreported: placements never detected.\n");
+  return 0;
+}
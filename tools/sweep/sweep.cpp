@@ -0,0 +1,621 @@
+/**
+ * @file    sweep.cpp
+ * @brief   Parallel parameter sweep of readNFC() detection policies over simulated tag traffic
+ *
+ *   g++ -O2 -std=c++17 -pthread sweep.cpp -o sweep
+ *   ./sweep                                   # Default grid, all cores, top 20
+ *   ./sweep --transport i2c400,spi1m --timeout 20,50 --retries 1,16,255 --debounce 1,2 --csv all.csv
+ *
+ * Each configuration is a transport, the readPassiveTargetID() timeout, the PN532
+ * MxRtyPassiveActivation value (255 retries forever) and the number of consecutive
+ * misses that count as a removal. It is run against scenarios of timed tag presentations
+ * through a model of the loop in main.cpp: the command frame and ACK, activation attempts
+ * of the PN532 until a tag answers, the retries run out or the host gives up, the ready
+ * polling of the transport while waiting, and the rest of loop(). Jobs of configuration x
+ * scenario x seed run on a work-stealing pool, one queue per core.
+ *
+ * With --emulate the podium alternates reader windows with card emulation windows as
+ * RoleScheduler does (E<reader>,<emulate>), and visitors' phones arrive among the cubes.
+ * A phone polls every PHONE_POLL_US and is served by the first poll that lands in an
+ * emulation window, unless the visitor gives up first:
+ *
+ *   ./sweep --transport i2c100 --timeout 100 --retries 255 --debounce 2 --reader 200,300,500 --emulate 0,100,200
+ *
+ * The table is sorted by error rate (missed presentations plus removals reported while the
+ * tag was still there), then p99 arrival-to-detection latency, then bus utilization.
+ * Configurations marked * are not beaten on all three at once, b marks the firmware as built.
+ * The model constants are estimates, check them against LS and PS on the podium.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ATTEMPT_US        (3000.0)    // One activation attempt: field settle, REQA and anticollision
+#define LOOP_US           (1000.0)    // Rest of loop(): Bluetooth, serial links, journal, clock
+#define PHONE_POLL_US     (200000.0)  // A phone's reader-mode polling period
+#define PHONE_SERVE_US    (80000.0)   // Phone selects the NDEF application and reads CC and NDEF files
+#define PHONE_PATIENCE_US (4000000.0) // Visitor gives up after holding the phone this long
+#define FRAME_TG_INIT     (47)        // TgInitAsTarget command frame
+#define SERVE_BUS_BYTES   (400)       // TgGetData and TgSetData frames while serving
+#define HIST_PER_OCTAVE   (8)
+#define HIST_BUCKETS      (8 * 28)    // 1 us to ~4.5 min
+
+// Baseline of the firmware in main.cpp: Wire at 100 kHz, TIMEOUT 100, MxRty left at 0xFF, removal on one miss
+#define BASE_TRANSPORT    "i2c100"
+#define BASE_TIMEOUT      (100)
+#define BASE_RETRIES      (255)
+#define BASE_DEBOUNCE     (1)
+
+/**
+ * Bus model of a transport. I2C and SPI poll the status byte after each delay(1) with a
+ * read of pollBytes, HSU waits on the UART and polls nothing.
+ */
+struct Transport {
+  const char *name;
+  double byteUs;              // Wire time of one byte, address and ACK bits included
+  double pollBytes;           // Bytes read by one ready poll, 0 if the transport does not poll
+  double frameOverhead;       // Extra bytes per frame: address, status or direction byte
+};
+
+static const Transport TRANSPORTS[] = {
+  { "i2c100", 90.0,  7, 2 },  // PN532_I2C reads 6 bytes per poll
+  { "i2c400", 22.5,  7, 2 },
+  { "spi1m",   8.0,  2, 1 },
+  { "hsu",    86.8,  0, 0 },  // 115200 baud, 10 bits per byte
+};
+
+// InListPassiveTarget frames, bytes without transport overhead
+#define FRAME_COMMAND     (11)        // 00 00 FF LEN LCS D4 4A 01 00 DCS 00
+#define FRAME_ACK         (6)
+#define FRAME_NACK        (6)
+#define FRAME_TARGET      (22)        // One target with a 7-byte UID
+#define FRAME_NO_TARGET   (10)
+
+/**
+ * A kind of tag traffic: how long tags stay, the gap before the next one, the chance that an
+ * activation attempt on a tag in the field succeeds, and fades (a hand over the antenna)
+ * during which no attempt succeeds.
+ */
+struct Scenario {
+  const char *name;
+  double dwellMinMs, dwellMaxMs;
+  double gapMinMs, gapMaxMs;
+  double pDetect;
+  double fadesPerS;
+  double fadeMs;
+  double phonesPerMin;
+};
+
+static const Scenario SCENARIOS[] = {
+  { "taps",       120,   400,  300,  3000, 0.95, 0.0,   0, 6 },
+  { "placements", 2000, 20000, 500,  5000, 0.97, 0.2,  80, 3 },
+  { "edge",       1000,  8000, 500,  5000, 0.50, 0.5, 150, 3 },
+};
+
+struct Config {
+  int transport;
+  int timeoutMs;
+  int retries;
+  int debounce;
+  int readerMs;               // Reader window, when emulating
+  int emulateMs;              // Emulation window, 0 to only read
+};
+
+/**
+ * Log-bucketed histogram of microsecond values, like LoopProfiler but finer.
+ */
+struct Histogram {
+  uint32_t buckets[HIST_BUCKETS] = {};
+  uint32_t count = 0;
+
+  static int bucket(double us) {
+    if (us < 1) { return 0; }
+    int b = (int)(std::log2(us) * HIST_PER_OCTAVE);
+    return b < HIST_BUCKETS ? b : HIST_BUCKETS - 1;
+  }
+  void add(double us) { buckets[bucket(us)]++; count++; }
+  void merge(const Histogram &other) {
+    for (int i = 0; i < HIST_BUCKETS; i++) { buckets[i] += other.buckets[i]; }
+    count += other.count;
+  }
+  // Geometric middle of the bucket that holds the percentile
+  double percentile(double p) const {
+    if (count == 0) { return 0; }
+    uint32_t rank = (uint32_t)std::ceil(p * count), seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+      seen += buckets[i];
+      if (seen >= rank) { return std::exp2((i + 0.5) / HIST_PER_OCTAVE); }
+    }
+    return std::exp2((double)HIST_BUCKETS / HIST_PER_OCTAVE);
+  }
+};
+
+struct Result {
+  Histogram latency;          // Arrival to detection
+  Histogram removal;          // Departure to removal
+  Histogram block;            // Duration of one readPassiveTargetID() call or emulation window
+  Histogram serve;            // Phone arrival to served
+  uint32_t phones = 0;
+  uint32_t phonesMissed = 0;  // Visitors who gave up
+  uint32_t presented = 0;
+  uint32_t missed = 0;        // Presentations that never produced a tag event
+  uint32_t spurious = 0;      // Removals reported while the tag was in the field
+  double busUs = 0;
+  double totalUs = 0;
+
+  void merge(const Result &other) {
+    latency.merge(other.latency);
+    removal.merge(other.removal);
+    block.merge(other.block);
+    serve.merge(other.serve);
+    phones += other.phones;
+    phonesMissed += other.phonesMissed;
+    presented += other.presented;
+    missed += other.missed;
+    spurious += other.spurious;
+    busUs += other.busUs;
+    totalUs += other.totalUs;
+  }
+  double errorRate() const { return presented ? (double)(missed + spurious) / presented : 0; }
+  double busUtilization() const { return totalUs > 0 ? busUs / totalUs : 0; }
+  double phoneMissRate() const { return phones ? (double)phonesMissed / phones : 0; }
+};
+
+/**
+ * The tag in front of the reader over time. Presentations are generated as time moves on,
+ * queries must not go back in time.
+ */
+class Timeline {
+public:
+  Timeline(const Scenario &scenario, std::mt19937_64 &rng, Result &result)
+    : _s(scenario), _rng(rng), _result(result), _index(-1), _leave(0) {
+    next(uniform(_s.gapMinMs, _s.gapMaxMs) * 1000);
+  }
+
+  // Index of the presentation in the field at t, -1 if none
+  int at(double t) {
+    while (t >= _leave) { next(_leave + uniform(_s.gapMinMs, _s.gapMaxMs) * 1000); }
+    return t >= _arrive ? _index : -1;
+  }
+  // Whether an activation attempt at t finds a tag
+  bool attempt(double t) {
+    if (at(t) < 0) { return false; }
+    for (size_t i = 0; i < _fades.size(); i += 2) {
+      if (t >= _fades[i] && t < _fades[i + 1]) { return false; }
+    }
+    return uniform(0, 1) < _s.pDetect;
+  }
+  void detected(double t) {
+    if (!_detected) { _detected = true; _result.latency.add(t - _arrive); }
+  }
+  int index() const { return _index; }
+  double lastLeave() const { return _prevLeave; }
+
+private:
+  double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(_rng); }
+
+  void next(double arrive) {
+    if (_index >= 0) {
+      _result.presented++;
+      if (!_detected) { _result.missed++; }
+      _prevLeave = _leave;
+    }
+    _index++;
+    _arrive = arrive;
+    _leave = arrive + uniform(_s.dwellMinMs, _s.dwellMaxMs) * 1000;
+    _detected = false;
+    _fades.clear();
+    if (_s.fadesPerS > 0) {
+      std::poisson_distribution<int> fades(_s.fadesPerS * (_leave - _arrive) / 1e6);
+      for (int n = fades(_rng); n > 0; n--) {
+        double start = uniform(_arrive, _leave);
+        _fades.push_back(start);
+        _fades.push_back(start + _s.fadeMs * 1000);
+      }
+    }
+  }
+
+  const Scenario &_s;
+  std::mt19937_64 &_rng;
+  Result &_result;
+  int _index;
+  double _arrive, _leave, _prevLeave = 0;
+  bool _detected = false;
+  std::vector<double> _fades;           // Start and end pairs
+};
+
+/**
+ * Phones held to the podium, independent of the cubes. Each polls with its own phase.
+ */
+class Phones {
+public:
+  Phones(const Scenario &scenario, std::mt19937_64 &rng, Result &result)
+    : _rng(rng), _result(result), _rate(scenario.phonesPerMin / 60e6) {
+    _next = arrival(0);
+  }
+
+  // Earliest time in [from, to) at which a waiting phone polls, or -1; visitors past their
+  // patience by then are counted as missed
+  double firstPoll(double from, double to, double &arrived) {
+    while (_next < to) {
+      _waiting.push_back({ _next, _next + std::uniform_real_distribution<double>(0, PHONE_POLL_US)(_rng) });
+      _next = arrival(_next);
+    }
+    double best = -1;
+    size_t pick = 0;
+    for (size_t i = 0; i < _waiting.size(); ) {
+      Phone &p = _waiting[i];
+      if (p.nextPoll < from) { p.nextPoll += std::ceil((from - p.nextPoll) / PHONE_POLL_US) * PHONE_POLL_US; }
+      if (p.nextPoll > p.arrived + PHONE_PATIENCE_US) {
+        _result.phones++;
+        _result.phonesMissed++;
+        _waiting.erase(_waiting.begin() + i);
+        continue;
+      }
+      if (p.nextPoll < to && (best < 0 || p.nextPoll < best)) {
+        best = p.nextPoll;
+        pick = i;
+      }
+      i++;
+    }
+    if (best >= 0) {
+      arrived = _waiting[pick].arrived;
+      _waiting.erase(_waiting.begin() + pick);
+      _result.phones++;
+    }
+    return best;
+  }
+
+private:
+  struct Phone {
+    double arrived;
+    double nextPoll;
+  };
+
+  double arrival(double after) {
+    return _rate > 0 ? after + std::exponential_distribution<double>(_rate)(_rng) : 1e300;
+  }
+
+  std::mt19937_64 &_rng;
+  Result &_result;
+  double _rate;                         // Arrivals per us
+  double _next;
+  std::vector<Phone> _waiting;
+};
+
+/**
+ * Runs loop() against one scenario until presentations tags have come and gone.
+ */
+static Result simulate(const Config &c, const Scenario &s, uint64_t seed, uint32_t presentations) {
+  const Transport &tr = TRANSPORTS[c.transport];
+  std::mt19937_64 rng(seed);
+  Result r;
+  Timeline tags(s, rng, r);
+  std::mt19937_64 phoneRng(seed ^ 0x5851F42D4C957F2DULL);     // Phones must not change the cube traffic
+  Phones phones(s, phoneRng, r);
+  double readerStart = 0;
+  double frame = tr.frameOverhead;
+  double pollUs = 1000 + tr.pollBytes * tr.byteUs;     // delay(1) plus the status read
+  bool present = false;
+  int misses = 0;
+  double t = 0;
+
+  while (r.presented < presentations) {
+    t += LOOP_US;
+    double start = t;
+
+    // Emulation window: one TgInitAsTarget, answered by the first phone poll in the window.
+    // readNFC() does not run, so the cube state is left as it is
+    if (c.emulateMs && t - readerStart >= c.readerMs * 1000.0) {
+      double bus = (FRAME_TG_INIT + frame + FRAME_ACK + frame) * tr.byteUs;
+      t += bus;
+      r.busUs += bus;
+      double arrived, end = t + c.emulateMs * 1000.0;
+      double poll = phones.firstPoll(t, end, arrived);
+      double waited = (poll >= 0 ? poll : end) - t;
+      if (tr.pollBytes) { r.busUs += std::ceil(waited / pollUs) * tr.pollBytes * tr.byteUs; }
+      t += waited;
+      if (poll >= 0) {
+        t += PHONE_SERVE_US;
+        r.busUs += SERVE_BUS_BYTES * tr.byteUs;
+        r.serve.add(t - arrived);
+      }
+      r.block.add(t - start);
+      tags.at(t);
+      readerStart = t;
+      continue;
+    }
+
+    // Command out, then wait for the ACK frame
+    double bus = (FRAME_COMMAND + frame + FRAME_ACK + frame) * tr.byteUs;
+    t += bus;
+    r.busUs += bus;
+
+    // The PN532 tries until a tag answers or MxRty runs out; the host polls meanwhile and
+    // gives up after timeout polls
+    double deadline = t + c.timeoutMs * (tr.pollBytes ? pollUs : 1000);
+    double pn = t;
+    int attempts = 0;
+    bool found = false, timedOut = false;
+    int tag = -1;
+    while (true) {
+      if (c.retries != 255 && attempts > c.retries) { break; }
+      if (pn + ATTEMPT_US > deadline) { timedOut = true; break; }
+      pn += ATTEMPT_US;
+      attempts++;
+      if (tags.attempt(pn - ATTEMPT_US / 2)) { found = true; tag = tags.index(); break; }
+    }
+    double waited = (timedOut ? deadline : pn) - t;
+    if (tr.pollBytes) {
+      double polls = std::ceil(waited / pollUs);
+      r.busUs += polls * tr.pollBytes * tr.byteUs;
+      waited = polls * pollUs;
+    }
+    t += waited;
+    if (timedOut) {
+      // The next command aborts the pending one; count the ACK it costs here
+      bus = (FRAME_ACK + frame) * tr.byteUs;
+    } else {
+      // Length read, NACK to resend, then the full response
+      bus = (6 + frame + FRAME_NACK + frame + (found ? FRAME_TARGET : FRAME_NO_TARGET) + frame) * tr.byteUs;
+    }
+    t += bus;
+    r.busUs += bus;
+    r.block.add(t - start);
+    tags.at(t);
+
+    // readNFC() state machine, with the removal debounced over consecutive misses
+    if (found) {
+      misses = 0;
+      if (!present) {
+        present = true;
+        if (tag == tags.index()) { tags.detected(t); }
+      }
+    } else if (present && ++misses >= c.debounce) {
+      present = false;
+      if (tags.at(t) >= 0) { r.spurious++; }
+      else { r.removal.add(t - tags.lastLeave()); }
+    }
+  }
+  double arrived;
+  phones.firstPoll(t, t, arrived);          // Count the visitors who gave up while the reader ran
+  r.totalUs = t;
+  return r;
+}
+
+/**
+ * Work-stealing pool: jobs are dealt round robin to one queue per worker, a worker takes from
+ * the back of its own queue and steals from the front of the others once it runs dry.
+ */
+class WorkStealingPool {
+public:
+  explicit WorkStealingPool(unsigned workers) : _queues(workers) {}
+
+  void run(std::vector<std::function<void()>> &jobs) {
+    for (size_t i = 0; i < jobs.size(); i++) { _queues[i % _queues.size()].jobs.push_back(std::move(jobs[i])); }
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < _queues.size(); w++) { threads.emplace_back([this, w] { work(w); }); }
+    for (auto &t : threads) { t.join(); }
+  }
+  uint64_t steals() const { return _steals; }
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  bool take(unsigned q, bool back, std::function<void()> &job) {
+    std::lock_guard<std::mutex> guard(_queues[q].lock);
+    auto &jobs = _queues[q].jobs;
+    if (jobs.empty()) { return false; }
+    if (back) { job = std::move(jobs.back()); jobs.pop_back(); }
+    else { job = std::move(jobs.front()); jobs.pop_front(); }
+    return true;
+  }
+
+  // Jobs never add jobs, so a scan that finds every queue empty means the work is done
+  void work(unsigned self) {
+    std::function<void()> job;
+    while (true) {
+      if (take(self, true, job)) { job(); continue; }
+      bool stole = false;
+      for (unsigned i = 1; i < _queues.size() && !stole; i++) {
+        stole = take((self + i) % _queues.size(), false, job);
+      }
+      if (!stole) { return; }
+      _steals++;
+      job();
+    }
+  }
+
+  std::vector<Queue> _queues;
+  std::atomic<uint64_t> _steals{0};
+};
+
+static std::vector<int> parseInts(const char *text) {
+  std::vector<int> values;
+  for (const char *p = text; *p; ) {
+    values.push_back(atoi(p));
+    while (*p && *p != ',') { p++; }
+    if (*p) { p++; }
+  }
+  return values;
+}
+
+template <typename T, size_t N>
+static std::vector<int> parseNames(const char *text, const T (&table)[N]) {
+  std::vector<int> values;
+  std::string list(text);
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    std::string name = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    size_t i = 0;
+    while (i < N && name != table[i].name) { i++; }
+    if (i == N) { fprintf(stderr, "unknown name: %s\n", name.c_str()); exit(1); }
+    values.push_back((int)i);
+    if (end == std::string::npos) { break; }
+    start = end + 1;
+  }
+  return values;
+}
+
+static std::vector<int> allOf(size_t n) {
+  std::vector<int> values;
+  for (size_t i = 0; i < n; i++) { values.push_back((int)i); }
+  return values;
+}
+
+int main(int argc, char **argv) {
+  std::vector<int> transports = allOf(sizeof(TRANSPORTS) / sizeof(TRANSPORTS[0]));
+  std::vector<int> scenarios = allOf(sizeof(SCENARIOS) / sizeof(SCENARIOS[0]));
+  std::vector<int> timeouts = { 20, 50, 100, 250 };
+  std::vector<int> retries = { 1, 5, 16, 255 };
+  std::vector<int> debounces = { 1, 2, 3 };
+  std::vector<int> readers = { 300 };
+  std::vector<int> emulates = { 0 };
+  uint32_t presentations = 500, seeds = 4;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t top = 20;
+  const char *csv = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i], *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!value) { fprintf(stderr, "usage: %s [--transport a,b] [--scenario a,b] [--timeout ms,..] [--retries n,..] "
+                                  "[--debounce n,..] [--reader ms,..] [--emulate ms,..] [--presentations n] [--seeds n] [--threads n] [--top n] [--csv file]\n",
+                          argv[0]); return 1; }
+    if (!strcmp(arg, "--transport")) { transports = parseNames(value, TRANSPORTS); }
+    else if (!strcmp(arg, "--scenario")) { scenarios = parseNames(value, SCENARIOS); }
+    else if (!strcmp(arg, "--timeout")) { timeouts = parseInts(value); }
+    else if (!strcmp(arg, "--retries")) { retries = parseInts(value); }
+    else if (!strcmp(arg, "--debounce")) { debounces = parseInts(value); }
+    else if (!strcmp(arg, "--reader")) { readers = parseInts(value); }
+    else if (!strcmp(arg, "--emulate")) { emulates = parseInts(value); }
+    else if (!strcmp(arg, "--presentations")) { presentations = atoi(value); }
+    else if (!strcmp(arg, "--seeds")) { seeds = atoi(value); }
+    else if (!strcmp(arg, "--threads")) { threads = std::max(1, atoi(value)); }
+    else if (!strcmp(arg, "--top")) { top = atoi(value); }
+    else if (!strcmp(arg, "--csv")) { csv = value; }
+    else { fprintf(stderr, "unknown option %s\n", arg); return 1; }
+    i++;
+  }
+
+  // Expand the grid
+  std::vector<Config> configs;
+  for (int tr : transports) {
+    for (int to : timeouts) {
+      for (int re : retries) {
+        for (int de : debounces) {
+          for (int em : emulates) {
+            if (em == 0) { configs.push_back({ tr, to, re, de, 0, 0 }); continue; }
+            for (int rd : readers) { configs.push_back({ tr, to, re, de, rd, em }); }
+          }
+        }
+      }
+    }
+  }
+  size_t perConfig = scenarios.size() * seeds;
+  std::vector<Result> results(configs.size() * perConfig);
+  std::vector<std::function<void()>> jobs;
+  for (size_t c = 0; c < configs.size(); c++) {
+    for (size_t s = 0; s < scenarios.size(); s++) {
+      for (uint32_t k = 0; k < seeds; k++) {
+        size_t slot = c * perConfig + s * seeds + k;
+        const Scenario &scenario = SCENARIOS[scenarios[s]];
+        // Same seed for every configuration, so they all see the same traffic
+        uint64_t seed = 0x9E3779B97F4A7C15ULL * (s * 1000 + k + 1);
+        jobs.push_back([&, c, slot, seed] {
+          results[slot] = simulate(configs[c], scenario, seed, presentations);
+        });
+      }
+    }
+  }
+
+  size_t jobCount = jobs.size();
+  auto start = std::chrono::steady_clock::now();
+  WorkStealingPool pool(threads);
+  pool.run(jobs);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Merge scenarios and seeds per configuration
+  std::vector<Result> merged(configs.size());
+  for (size_t c = 0; c < configs.size(); c++) {
+    for (size_t j = 0; j < perConfig; j++) { merged[c].merge(results[c * perConfig + j]); }
+  }
+  auto key = [&](size_t c) {
+    return std::make_tuple(std::round(merged[c].errorRate() * 1e4), merged[c].latency.percentile(0.99),
+                           merged[c].busUtilization());
+  };
+  std::vector<size_t> order;
+  for (size_t c = 0; c < configs.size(); c++) { order.push_back(c); }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key(a) < key(b); });
+
+  auto pareto = [&](size_t c) {
+    for (size_t o = 0; o < configs.size(); o++) {
+      const Result &a = merged[o], &b = merged[c];
+      bool noWorse = a.errorRate() <= b.errorRate() && a.latency.percentile(0.99) <= b.latency.percentile(0.99)
+                     && a.busUtilization() <= b.busUtilization() && a.phoneMissRate() <= b.phoneMissRate();
+      bool better = a.errorRate() < b.errorRate() || a.latency.percentile(0.99) < b.latency.percentile(0.99)
+                    || a.busUtilization() < b.busUtilization() || a.phoneMissRate() < b.phoneMissRate();
+      if (noWorse && better) { return false; }
+    }
+    return true;
+  };
+  auto baseline = [&](const Config &c) {
+    return !strcmp(TRANSPORTS[c.transport].name, BASE_TRANSPORT) && c.timeoutMs == BASE_TIMEOUT
+           && c.retries == BASE_RETRIES && c.debounce == BASE_DEBOUNCE && c.emulateMs == 0;
+  };
+
+  printf("%zu configurations x %zu scenarios x %u seeds = %zu jobs, %u presentations each, "
+         "%u threads, %.2f s, %llu steals\n\n", configs.size(), scenarios.size(), seeds, jobCount,
+         presentations, threads, seconds, (unsigned long long)pool.steals());
+  printf("   transport timeout retries deb    roles   err%%  miss%%  false%%  p50 ms  p99 ms  rm p99  blk p99  bus%%"
+         "  ph p99  ph miss%%\n");
+  for (size_t n = 0; n < order.size(); n++) {
+    size_t c = order[n];
+    bool base = baseline(configs[c]);
+    if (n >= top && !base) { continue; }
+    const Config &cf = configs[c];
+    const Result &r = merged[c];
+    char roles[16] = "-", serve[16] = "-";
+    if (cf.emulateMs) { snprintf(roles, sizeof(roles), "%d/%d", cf.readerMs, cf.emulateMs); }
+    if (r.serve.count) { snprintf(serve, sizeof(serve), "%.1f", r.serve.percentile(0.99) / 1000); }
+    printf("%c%c %-9s %7d %7d %3d %8s %6.2f %6.2f %6.2f %7.1f %7.1f %7.1f %8.1f %5.1f %7s %9.2f\n",
+           pareto(c) ? '*' : ' ', base ? 'b' : ' ', TRANSPORTS[cf.transport].name, cf.timeoutMs, cf.retries,
+           cf.debounce, roles, 100.0 * r.errorRate(), 100.0 * r.missed / r.presented, 100.0 * r.spurious / r.presented,
+           r.latency.percentile(0.5) / 1000, r.latency.percentile(0.99) / 1000, r.removal.percentile(0.99) / 1000,
+           r.block.percentile(0.99) / 1000, 100.0 * r.busUtilization(), serve, 100.0 * r.phoneMissRate());
+  }
+
+  if (csv) {
+    FILE *f = fopen(csv, "w");
+    if (!f) { perror(csv); return 1; }
+    fprintf(f, "transport,timeout_ms,retries,debounce,reader_ms,emulate_ms,presented,missed,spurious,p50_ms,p99_ms,"
+               "removal_p99_ms,block_p99_ms,bus_utilization,phones,phones_missed,serve_p50_ms,serve_p99_ms,pareto\n");
+    for (size_t c : order) {
+      const Config &cf = configs[c];
+      const Result &r = merged[c];
+      fprintf(f, "%s,%d,%d,%d,%d,%d,%u,%u,%u,%.2f,%.2f,%.2f,%.2f,%.4f,%u,%u,%.2f,%.2f,%d\n", TRANSPORTS[cf.transport].name,
+              cf.timeoutMs, cf.retries, cf.debounce, cf.readerMs, cf.emulateMs, r.presented, r.missed, r.spurious,
+              r.latency.percentile(0.5) / 1000, r.latency.percentile(0.99) / 1000, r.removal.percentile(0.99) / 1000,
+              r.block.percentile(0.99) / 1000, r.busUtilization(), r.phones, r.phonesMissed, r.serve.percentile(0.5) / 1000,
+              r.serve.percentile(0.99) / 1000, pareto(c) ? 1 : 0);
+    }
+    fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file    bench.cpp
+ * @brief   Host benchmark of the flash tag table, with the partition emulated by mmap
+ *
+ *   python3 build_image.py --random 10000 tags.bin
+ *   g++ -O2 -I../../src bench.cpp ../../src/TagTableImage.cpp -o bench
+ *   ./bench tags.bin
+ *
+ * Compares mounting the image in place with loading every entry into a RAM map,
+ * times lookups of known and unknown keys, and times decoding commands from the
+ * front-coded pool (python3 build_image.py --cues 16000 tags.bin for cue lists, about
+ * the most that fits a slot of the partition).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TagTableImage.h"
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) { fprintf(stderr, "usage: %s <image>\n", argv[0]); return 1; }
+  int fd = open(argv[1], O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) { perror(argv[1]); return 1; }
+
+  // Boot: map and mount, as TagTable::begin() does with esp_partition_mmap
+  auto start = std::chrono::steady_clock::now();
+  const uint8_t *image = (const uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  TagTableImage table;
+  bool mounted = image != MAP_FAILED && table.mount(image, st.st_size);
+  double mountMicros = microsSince(start);
+  if (!mounted) { fprintf(stderr, "not a valid tag table image\n"); return 1; }
+  const TagTableHeader *header = table.header();
+
+  // The same table copied to RAM, as a config file loader would
+  std::vector<std::string> keys;
+  start = std::chrono::steady_clock::now();
+  std::map<std::string, std::string> ram;
+  std::vector<const TagTableEntry *> entries;
+  char command[TAG_TABLE_COMMAND_MAX];
+  const TagTableSlot *slots = (const TagTableSlot *)(image + sizeof(TagTableHeader));
+  for (uint32_t i = 0; i < header->slotCount; i++) {
+    if (slots[i].value == TAG_TABLE_SLOT_EMPTY) { continue; }
+    const TagTableEntry *entry = (const TagTableEntry *)(image + TagTableImage::entryOffset(slots[i]));
+    std::string key(TagTableImage::key(entry), entry->keyLength);
+    ram[key] = std::string(command, table.command(entry, command));
+    keys.push_back(key);
+    entries.push_back(entry);
+  }
+  double loadMicros = microsSince(start);
+  size_t ramBytes = 0;
+  for (auto &kv : ram) { ramBytes += sizeof(kv) + 32 + kv.first.capacity() + kv.second.capacity(); }
+
+  std::mt19937 rng(2);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  const int rounds = 1000000;
+  uint32_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    const std::string &key = keys[i % keys.size()];
+    found += table.find(key.data(), key.size()) != NULL;
+  }
+  double hitNanos = microsSince(start) * 1000.0 / rounds;
+
+  char unknown[16];
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    snprintf(unknown, sizeof(unknown), "%014X", (unsigned)rng());
+    found += table.find(unknown, 14) != NULL;
+  }
+  double missNanos = microsSince(start) * 1000.0 / rounds;
+
+  // Decode in random order, then only the last command of each block, the longest walk
+  std::shuffle(entries.begin(), entries.end(), rng);
+  uint64_t decoded = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) { decoded += table.command(entries[i % entries.size()], command); }
+  double decodeNanos = microsSince(start) * 1000.0 / rounds;
+  std::vector<const TagTableEntry *> worst;
+  for (const TagTableEntry *entry : entries) {
+    if (entry->command % TAG_TABLE_POOL_BLOCK == TAG_TABLE_POOL_BLOCK - 1) { worst.push_back(entry); }
+  }
+  double worstNanos = 0;
+  if (!worst.empty()) {
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) { decoded += table.command(worst[i % worst.size()], command); }
+    worstNanos = microsSince(start) * 1000.0 / rounds;
+  }
+  size_t rawBytes = 0;
+  for (const TagTableEntry *entry : entries) { rawBytes += entry->commandLength; }
+
+  printf("tags %u, slots %u (%.1f%% full), image %u bytes\n", header->count, header->slotCount,
+         100.0 * header->count / header->slotCount, header->imageSize);
+  printf("mount in place: %.1f us, heap 0 bytes\n", mountMicros);
+  printf("load to RAM:    %.1f us, heap ~%zu bytes\n", loadMicros, ramBytes);
+  printf("lookup hit:  %.1f ns (%u of %d found)\n", hitNanos, found, rounds);
+  printf("lookup miss: %.1f ns (includes key formatting)\n", missNanos);
+  printf("commands %u distinct, pool %u bytes for %zu bytes of commands (%.1fx)\n", header->commandCount,
+         header->imageSize - header->poolOffset, rawBytes, (double)rawBytes / (header->imageSize - header->poolOffset));
+  printf("decode: %.1f ns, last of block %.1f ns (%llu bytes)\n", decodeNanos, worstNanos, (unsigned long long)decoded);
+  return 0;
+}
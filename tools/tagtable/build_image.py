@@ -0,0 +1,234 @@
+"""Builds a flash tag table image for the "tagtable" partition.
+
+    python3 build_image.py tags.csv tags.bin            CSV rows: key,command
+    python3 build_image.py --random 10000 tags.bin      Random UIDs, for benchmarks
+    python3 build_image.py --cues 16000 tags.bin        Random UIDs with generated cue commands
+    python3 build_image.py tags.csv tags.bin --lines    Also print the U/UD/UC console lines
+
+The layout matches src/TagTableImage.h: a 40-byte header, an open-addressing
+table of 4-byte slots (15-bit FNV-1a tag, entry offset / 4) kept at most 3/4
+full, the entries, then the command pool. A tag with a UID key costs about 25
+bytes of slot and entry, so a slot of the partition holds about 16000 tags
+with the generated cue commands, or 15000 with a distinct command each.
+Keys are routing keys as the firmware builds them: upper-case UID hex, or "#"
+and 8 hex digits when routing by NDEF record. Distinct commands are sorted and front coded in blocks of
+POOL_BLOCK, with frequent words replaced by dictionary codes; the compression
+is reported on stderr. Commands are compiled as src/CommandTemplate.h does,
+so %U, %S, %D and %N are stored as opcodes and rendered per event.
+"""
+
+import argparse
+import csv
+import random
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4C425454
+VERSION = 3
+HEADER = struct.Struct("<IHHIIIIIIII")
+SLOT = struct.Struct("<I")
+ENTRY = struct.Struct("<HBBH")
+SLOT_EMPTY = 0xFFFFFFFF
+SLOT_SHIFT = 17                         # TAG_TABLE_SLOT_SHIFT
+SLOT_SIZE = 0x70000                     # Half the tagtable partition
+UD_CHUNK = 128                          # Bytes per UD line, the firmware's buffer size
+POOL_BLOCK = 16                         # TAG_TABLE_POOL_BLOCK
+DICT_WORDS = 127                        # TAG_TABLE_DICT_WORDS
+
+
+TEMPLATE_OPS = {ord("U"): 0x01, ord("S"): 0x02, ord("D"): 0x03, ord("N"): 0x04}
+
+
+def compile_template(text):
+    """Same as CommandTemplate::compile(): placeholders to opcode bytes, control bytes dropped."""
+    out, i = bytearray(), 0
+    while i < len(text):
+        c = text[i]
+        if c < 0x20:
+            i += 1
+            continue
+        if c == ord("%") and i + 1 < len(text):
+            if text[i + 1] in TEMPLATE_OPS:
+                c = TEMPLATE_OPS[text[i + 1]]
+                i += 1
+            elif text[i + 1] == ord("%"):
+                i += 1
+        out.append(c)
+        i += 1
+    return bytes(out)
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def split_rests(commands):
+    """Front codes sorted commands: [(shared, rest)], the first of each block sharing nothing."""
+    out, prev = [], b""
+    for i, command in enumerate(commands):
+        if i % POOL_BLOCK == 0:
+            prev = b""
+        shared = 0
+        while shared < min(len(prev), len(command), 255) and prev[shared] == command[shared]:
+            shared += 1
+        out.append((shared, command[shared:]))
+        prev = command
+    return out
+
+
+def choose_words(rests):
+    """Picks up to DICT_WORDS substrings of the rests worth a one-byte code.
+
+    Candidates run between word boundaries ("_" or the ends of a rest), scored by the
+    bytes a code would save. Good enough for cue names, which are words joined by "_"."""
+    counts = {}
+    for rest in rests:
+        cuts = sorted({0, len(rest)} | {i for i, b in enumerate(rest) if b == 0x5F})
+        for a in range(len(cuts)):
+            for b in range(a + 1, len(cuts)):
+                word = rest[cuts[a]:cuts[b]]
+                if 2 < len(word) <= 32:
+                    counts[word] = counts.get(word, 0) + 1
+    ranked = sorted(counts, key=lambda w: (-(len(w) - 1) * counts[w], w))
+    return [w for w in ranked if counts[w] > 1][:DICT_WORDS]
+
+
+def encode_rest(rest, words):
+    """Greedy longest match against the dictionary; bytes >= 0x80 are escaped."""
+    by_length = sorted(range(len(words)), key=lambda i: -len(words[i]))
+    out, i = bytearray(), 0
+    while i < len(rest):
+        for w in by_length:
+            if rest.startswith(words[w], i):
+                out.append(0x80 + w)
+                i += len(words[w])
+                break
+        else:
+            if rest[i] >= 0x80:
+                out.append(0xFF)
+            out.append(rest[i])
+            i += 1
+    if len(out) > 255:
+        sys.exit("command does not encode in 255 bytes: %r" % rest)
+    return bytes(out)
+
+
+def front_code(commands):
+    """Sorted distinct commands -> pool bytes: block offsets, dictionary bounds and words, then
+    (shared, encoded rest length, encoded rest) runs."""
+    rests = split_rests(commands)
+    words = choose_words([r for _, r in rests])
+    blocks = (len(commands) + POOL_BLOCK - 1) // POOL_BLOCK
+    word_start = blocks * 4 + (DICT_WORDS + 1) * 2
+    bounds, offset = [], word_start
+    for i in range(DICT_WORDS + 1):
+        bounds.append(offset)
+        if i < len(words):
+            offset += len(words[i])
+    if offset > 0xFFFF:
+        sys.exit("too many commands for the dictionary offsets")
+    body, starts = bytearray(), []
+    for i, (shared, rest) in enumerate(rests):
+        if i % POOL_BLOCK == 0:
+            starts.append(offset + len(body))
+        code = encode_rest(rest, words)
+        body += bytes((shared, len(code))) + code
+    return (b"".join(struct.pack("<I", s) for s in starts) + b"".join(struct.pack("<H", b) for b in bounds)
+            + b"".join(words) + body)
+
+
+def build(rows, config_version=0):
+    """Returns (image, stats)."""
+    seen, kept = set(), []
+    for index, (key, command) in enumerate(rows):
+        key, command = key.encode(), compile_template(command.encode())
+        if len(key) > 255 or len(command) > 255:
+            sys.exit("row %d: key and command are limited to 255 bytes" % (index + 1))
+        if key in seen:
+            continue                    # First row wins, as on the console tag table
+        seen.add(key)
+        kept.append((index, key, command))
+
+    commands = sorted(set(c for _, _, c in kept))
+    number = {c: i for i, c in enumerate(commands)}
+    if len(kept) > 0x10000 or len(commands) > 0x10000:
+        sys.exit("an image holds at most 65536 tags and 65536 distinct commands")
+
+    slot_count = max(len(kept) + 1, (len(kept) * 4 + 2) // 3)
+    entries_start = HEADER.size + slot_count * SLOT.size
+
+    slots = [SLOT_EMPTY] * slot_count
+    entries = bytearray()
+    for index, key, command in kept:
+        h = fnv1a(key)
+        slot = (h * slot_count) >> 32
+        while slots[slot] != SLOT_EMPTY:
+            slot = (slot + 1) % slot_count
+        slots[slot] = (h >> SLOT_SHIFT) << SLOT_SHIFT | (entries_start + len(entries)) // 4
+        entries += ENTRY.pack(index, len(key), len(command), number[command]) + key
+        entries += b"\0" * (-len(entries) % 4)
+
+    pool = front_code(commands)
+    pool_offset = entries_start + len(entries)
+    body = b"".join(SLOT.pack(s) for s in slots) + entries + pool
+    size = HEADER.size + len(body)
+    header = HEADER.pack(MAGIC, VERSION, HEADER.size, 0, len(kept), slot_count, size, zlib.crc32(body),
+                         config_version, pool_offset, len(commands))
+    stats = {"tags": len(kept), "commands": len(commands), "pool": len(pool),
+             "distinct": sum(len(c) for c in commands), "raw": sum(len(c) for _, _, c in kept)}
+    return header + body, stats
+
+
+def cue_rows(n, rng):
+    """Cue-list style commands: shows, scenes and a few actions per scene, many tags per cue."""
+    actions = ["LIGHTS_ON", "LIGHTS_OFF", "VIDEO_PLAY", "VIDEO_STOP", "AUDIO_FADE_IN", "AUDIO_FADE_OUT",
+               "DOOR_OPEN", "HAZE_BURST"]
+    cues = ["SHOW%d_SCENE_%03d_%s" % (show, scene, action)
+            for show in range(1, 9) for scene in range(1, 251) for action in actions]
+    return [("%014X" % rng.getrandbits(56), rng.choice(cues)) for _ in range(n)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("csv", nargs="?")
+    parser.add_argument("image")
+    parser.add_argument("--random", type=int, metavar="N", help="generate N random 7-byte UIDs")
+    parser.add_argument("--cues", type=int, metavar="N", help="generate N random UIDs with cue-list commands")
+    parser.add_argument("--lines", action="store_true", help="print the console update lines to stdout")
+    parser.add_argument("--config-version", type=int, default=0, help="version for a broadcast push (config_push.py)")
+    args = parser.parse_args()
+
+    if args.random:
+        rng = random.Random(1)
+        rows = [("%014X" % rng.getrandbits(56), "CMD%d" % i) for i in range(args.random)]
+    elif args.cues:
+        rows = cue_rows(args.cues, random.Random(1))
+    elif args.csv:
+        with open(args.csv, newline="") as f:
+            rows = [(r[0].strip(), r[1].strip()) for r in csv.reader(f) if len(r) >= 2]
+    else:
+        parser.error("give a CSV file, --random N or --cues N")
+
+    image, stats = build(rows, args.config_version)
+    if len(image) > SLOT_SIZE:
+        sys.exit("image is %d bytes, a slot holds %d" % (len(image), SLOT_SIZE))
+    with open(args.image, "wb") as f:
+        f.write(image)
+    print("%d tags, %d bytes" % (stats["tags"], len(image)), file=sys.stderr)
+    print("%d distinct commands: %d bytes as stored per tag, %d once each, %d front coded (%.1fx)"
+          % (stats["commands"], stats["raw"], stats["distinct"], stats["pool"], stats["raw"] / max(stats["pool"], 1)),
+          file=sys.stderr)
+
+    if args.lines:
+        print("U%d" % len(image))
+        for i in range(0, len(image), UD_CHUNK):
+            print("UD" + image[i:i + UD_CHUNK].hex().upper())
+        print("UC")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+/**
+ * @file    test.cpp
+ * @brief   Host test of TagTableImage::find() on images with corrupt slots
+ *
+ *   python3 build_image.py --random 2000 tags.bin
+ *   g++ -O1 -g -fsanitize=address,undefined -I../../src test.cpp ../../src/TagTableImage.cpp -o test
+ *   ./test tags.bin
+ *
+ * Copies the image into a buffer of exactly its size, checks every key is found, then
+ * points each occupied slot at the end of the image, into the header and slot table, and
+ * at the last bytes before the command pool, keeping its hash tag. Where the slot points
+ * past the slot table, the key length there is forged to match the key looked up. Every
+ * lookup must then miss without reading outside the entries, which the sanitizer reports.
+ * Exits non-zero on failure.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "TagTableImage.h"
+
+static int failures = 0;
+
+static void check(const char *name, bool ok) {
+  printf("%-40s %s\n", name, ok ? "ok" : "FAIL");
+  if (!ok) { failures++; }
+}
+
+// Every key in the table, read through the intact slots
+static std::vector<std::string> keys(const uint8_t *image) {
+  const TagTableHeader *header = (const TagTableHeader *)image;
+  const TagTableSlot *slots = (const TagTableSlot *)(image + sizeof(TagTableHeader));
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < header->slotCount; i++) {
+    if (slots[i].value == TAG_TABLE_SLOT_EMPTY) { continue; }
+    const TagTableEntry *entry = (const TagTableEntry *)(image + TagTableImage::entryOffset(slots[i]));
+    keys.push_back(std::string(TagTableImage::key(entry), entry->keyLength));
+  }
+  return keys;
+}
+
+// Points every occupied slot at offset, keeping its hash tag, and looks every key up
+static bool allMiss(uint8_t *image, const uint8_t *original, const std::vector<std::string> &keys, uint32_t offset, bool forge) {
+  const TagTableHeader *header = (const TagTableHeader *)image;
+  TagTableSlot *slots = (TagTableSlot *)(image + sizeof(TagTableHeader));
+  memcpy(image, original, header->imageSize);
+  for (uint32_t i = 0; i < header->slotCount; i++) {
+    if (slots[i].value == TAG_TABLE_SLOT_EMPTY) { continue; }
+    slots[i].value = (slots[i].value >> TAG_TABLE_SLOT_SHIFT) << TAG_TABLE_SLOT_SHIFT | offset / 4;
+  }
+  TagTableImage table;
+  if (!table.mount(image, header->imageSize)) { return false; }
+  for (const std::string &key : keys) {
+    if (forge) { ((TagTableEntry *)(image + offset))->keyLength = key.length(); }
+    if (table.find(key.data(), key.length()) != NULL) { return false; }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) { fprintf(stderr, "usage: %s <image>\n", argv[0]); return 1; }
+  FILE *file = fopen(argv[1], "rb");
+  if (file == NULL) { perror(argv[1]); return 1; }
+  TagTableHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || !TagTableImage::validHeader(header, header.imageSize)) {
+    fprintf(stderr, "%s: not a tag table image\n", argv[1]);
+    return 1;
+  }
+  // malloc aligns to more than 4 bytes, and a buffer of the exact size lets the sanitizer see overreads
+  uint8_t *original = (uint8_t *)malloc(header.imageSize);
+  uint8_t *image = (uint8_t *)malloc(header.imageSize);
+  rewind(file);
+  if (fread(original, 1, header.imageSize, file) != header.imageSize) { fprintf(stderr, "%s: short image\n", argv[1]); return 1; }
+  fclose(file);
+
+  std::vector<std::string> all = keys(original);
+  memcpy(image, original, header.imageSize);
+  TagTableImage table;
+  bool found = table.mount(image, header.imageSize);
+  for (const std::string &key : all) {
+    found = found && table.find(key.data(), key.length()) != NULL;
+  }
+  check("intact image finds every key", found && !all.empty());
+
+  uint32_t last = (header.imageSize - sizeof(TagTableEntry)) & ~3UL;   // Last aligned entry header in the image
+  check("slots at the end of the image", allMiss(image, original, all, last, true));
+  check("slots in the header", allMiss(image, original, all, 0, false));
+  check("slots in the slot table", allMiss(image, original, all, sizeof(TagTableHeader) + 4, false));
+  check("slots at the end of the entries", allMiss(image, original, all, header.poolOffset - 4, true));
+  check("slots in the command pool", allMiss(image, original, all, header.poolOffset, true));
+
+  free(image);
+  free(original);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file    bench.cpp
+ * @brief   Host benchmark of command template rendering against static commands
+ *
+ *   g++ -O2 -I../../src bench.cpp ../../src/CommandTemplate.cpp -o bench
+ *   ./bench
+ *
+ * Times, per event, copying a static command into the output buffer (what a
+ * plain C command costs), rendering a compiled template, compiling and
+ * rendering on every event, and building the same text with std::string
+ * appends the way String concatenation would on the podium.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "CommandTemplate.h"
+
+static const int ROUNDS = 5000000;
+
+static double nanosPerRound(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+}
+
+int main() {
+  const char *uid = "04A1B2C3D4E5F6";
+  const char *templates[] = { "HELLO", "PLACE:%S:%U", "REMOVED:%U:%S:%D:%N", "SHOW1_SCENE_042_LIGHTS_ON:%U" };
+  char out[TEMPLATE_OUTPUT_MAX];
+  volatile size_t sink = 0;
+
+  // Check the rendering once before timing it
+  CommandTemplate check;
+  check.compile("P%S:%U:%D:%N %% %X", 18);
+  CommandContext context = { uid, 14, 3, 1500, 42 };
+  size_t n = check.render(context, out, sizeof(out));
+  if (std::string(out, n) != "P3:04A1B2C3D4E5F6:1500:42 % %X") { printf("render mismatch: %.*s\n", (int)n, out); return 1; }
+  n = check.render(context, out, 10);
+  if (std::string(out, n) != "P3:") { printf("truncation mismatch: %.*s\n", (int)n, out); return 1; }
+
+  printf("%-30s %10s %10s %10s %10s\n", "command", "static", "compiled", "per event", "string");
+  for (const char *text : templates) {
+    size_t length = strlen(text);
+    CommandTemplate compiled;
+    compiled.compile(text, length);
+    char rendered[TEMPLATE_OUTPUT_MAX];
+    size_t renderedLength = compiled.render(context, rendered, sizeof(rendered));
+
+    // Static: the rendered text as a fixed command, copied into the output
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+      memcpy(out, rendered, renderedLength);
+      sink += out[i & 7];
+    }
+    double staticNanos = nanosPerRound(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+      context.seq = i;
+      sink += compiled.render(context, out, sizeof(out));
+    }
+    double compiledNanos = nanosPerRound(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+      uint8_t code[TEMPLATE_CODE_MAX];
+      context.seq = i;
+      size_t codeLength = CommandTemplate::compile(text, length, code, sizeof(code));
+      sink += CommandTemplate::render(code, codeLength, context, out, sizeof(out));
+    }
+    double perEventNanos = nanosPerRound(start);
+
+    // String building: literal pieces and numbers appended one by one, allocating as it grows
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+      std::string s;
+      for (size_t j = 0; j < length; j++) {
+        if (text[j] == '%' && j + 1 < length) {
+          switch (text[++j]) {
+            case 'U': s += uid; break;
+            case 'S': s += std::to_string(context.slot); break;
+            case 'D': s += std::to_string(context.dwellMs); break;
+            case 'N': s += std::to_string(i); break;
+          }
+        } else {
+          s += text[j];
+        }
+      }
+      sink += s.size();
+    }
+    double stringNanos = nanosPerRound(start);
+
+    printf("%-30s %8.1f ns %8.1f ns %8.1f ns %8.1f ns\n", text, staticNanos, compiledNanos, perEventNanos, stringNanos);
+  }
+  return sink == 0;
+}